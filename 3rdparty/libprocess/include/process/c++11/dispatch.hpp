@@ -69,14 +69,14 @@ void dispatch(
     const PID<T>& pid,
     void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase* process) {
             assert(process != NULL);
             T* t = dynamic_cast<T*>(process);
             assert(t != NULL);
             (t->*method)();
-          }));
+          });
 
   internal::dispatch(pid, f, &typeid(method));
 }
@@ -109,14 +109,14 @@ void dispatch(
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
+    std::shared_ptr<std::function<void(ProcessBase*)>> f =              \
+        std::make_shared<std::function<void(ProcessBase*)>>(            \
             [=] (ProcessBase* process) {                                \
               assert(process != NULL);                                  \
               T* t = dynamic_cast<T*>(process);                         \
               assert(t != NULL);                                        \
               (t->*method)(ENUM_PARAMS(N, a));                          \
-            }));                                                        \
+            });                                                         \
                                                                         \
     internal::dispatch(pid, f, &typeid(method));                        \
   }                                                                     \
@@ -154,16 +154,16 @@ Future<R> dispatch(
     const PID<T>& pid,
     Future<R> (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase* process) {
             assert(process != NULL);
             T* t = dynamic_cast<T*>(process);
             assert(t != NULL);
             promise->associate((t->*method)());
-          }));
+          });
 
   internal::dispatch(pid, f, &typeid(method));
 
@@ -196,16 +196,17 @@ Future<R> dispatch(
       Future<R> (T::*method)(ENUM_PARAMS(N, P)),                        \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    std::shared_ptr<Promise<R>> promise =                               \
+      std::make_shared<Promise<R>>();                                   \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
+    std::shared_ptr<std::function<void(ProcessBase*)>> f =              \
+        std::make_shared<std::function<void(ProcessBase*)>>(            \
             [=] (ProcessBase* process) {                                \
               assert(process != NULL);                                  \
               T* t = dynamic_cast<T*>(process);                         \
               assert(t != NULL);                                        \
               promise->associate((t->*method)(ENUM_PARAMS(N, a)));      \
-            }));                                                        \
+            });                                                         \
                                                                         \
     internal::dispatch(pid, f, &typeid(method));                        \
                                                                         \
@@ -247,16 +248,16 @@ Future<R> dispatch(
     const PID<T>& pid,
     R (T::*method)(void))
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase* process) {
             assert(process != NULL);
             T* t = dynamic_cast<T*>(process);
             assert(t != NULL);
             promise->set((t->*method)());
-          }));
+          });
 
   internal::dispatch(pid, f, &typeid(method));
 
@@ -289,16 +290,17 @@ Future<R> dispatch(
       R (T::*method)(ENUM_PARAMS(N, P)),                                \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    std::shared_ptr<Promise<R>> promise =                               \
+      std::make_shared<Promise<R>>();                                   \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
+    std::shared_ptr<std::function<void(ProcessBase*)>> f =              \
+        std::make_shared<std::function<void(ProcessBase*)>>(            \
             [=] (ProcessBase* process) {                                \
               assert(process != NULL);                                  \
               T* t = dynamic_cast<T*>(process);                         \
               assert(t != NULL);                                        \
               promise->set((t->*method)(ENUM_PARAMS(N, a)));            \
-            }));                                                        \
+            });                                                         \
                                                                         \
     internal::dispatch(pid, f, &typeid(method));                        \
                                                                         \
@@ -337,11 +339,11 @@ inline void dispatch(
     const UPID& pid,
     const std::function<void()>& f)
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f_ =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase*) {
             f();
-          }));
+          });
 
   internal::dispatch(pid, f_);
 }
@@ -352,13 +354,13 @@ Future<R> dispatch(
     const UPID& pid,
     const std::function<Future<R>()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f_ =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase*) {
             promise->associate(f());
-          }));
+          });
 
   internal::dispatch(pid, f_);
 
@@ -371,13 +373,13 @@ Future<R> dispatch(
     const UPID& pid,
     const std::function<R()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
+  std::shared_ptr<std::function<void(ProcessBase*)>> f_ =
+      std::make_shared<std::function<void(ProcessBase*)>>(
           [=] (ProcessBase*) {
             promise->set(f());
-          }));
+          });
 
   internal::dispatch(pid, f_);
 
@@ -6,7 +6,10 @@
 
 #include <iostream>
 #include <list>
+#include <memory>
+#include <new>
 #include <set>
+#include <string>
 #if  __cplusplus >= 201103L
 #include <type_traits>
 #endif // __cplusplus >= 201103L
@@ -536,24 +539,187 @@ private:
     DISCARDED,
   };
 
+  // A callback registered on a pending future, tagged with the kind
+  // of transition it is waiting for. This lets a future keep all of
+  // its callbacks in a single list.
+  class Callback
+  {
+  public:
+    enum Kind
+    {
+      NONE,
+      DISCARD,
+      READY,
+      FAILED,
+      DISCARDED,
+      ANY,
+    };
+
+    Callback() : kind(NONE) {}
+
+    Callback(Callback&& that) : kind(that.kind)
+    {
+      switch (kind) {
+        case NONE:
+          break;
+        case DISCARD:
+        case DISCARDED:
+          new (&nullary) DiscardCallback(std::move(that.nullary));
+          break;
+        case READY:
+          new (&ready) ReadyCallback(std::move(that.ready));
+          break;
+        case FAILED:
+          new (&failed) FailedCallback(std::move(that.failed));
+          break;
+        case ANY:
+          new (&any) AnyCallback(std::move(that.any));
+          break;
+      }
+    }
+
+    ~Callback()
+    {
+      switch (kind) {
+        case NONE:
+          break;
+        case DISCARD:
+        case DISCARDED:
+          nullary.~DiscardCallback();
+          break;
+        case READY:
+          ready.~ReadyCallback();
+          break;
+        case FAILED:
+          failed.~FailedCallback();
+          break;
+        case ANY:
+          any.~AnyCallback();
+          break;
+      }
+    }
+
+    Callback& operator = (Callback&& that)
+    {
+      if (this != &that) {
+        this->~Callback();
+        new (this) Callback(std::move(that));
+      }
+      return *this;
+    }
+
+    static Callback onDiscard(DiscardCallback callback)
+    {
+      Callback result(DISCARD);
+      new (&result.nullary) DiscardCallback(std::move(callback));
+      return result;
+    }
+
+    static Callback onReady(ReadyCallback callback)
+    {
+      Callback result(READY);
+      new (&result.ready) ReadyCallback(std::move(callback));
+      return result;
+    }
+
+    static Callback onFailed(FailedCallback callback)
+    {
+      Callback result(FAILED);
+      new (&result.failed) FailedCallback(std::move(callback));
+      return result;
+    }
+
+    static Callback onDiscarded(DiscardedCallback callback)
+    {
+      Callback result(DISCARDED);
+      new (&result.nullary) DiscardedCallback(std::move(callback));
+      return result;
+    }
+
+    static Callback onAny(AnyCallback callback)
+    {
+      Callback result(ANY);
+      new (&result.any) AnyCallback(std::move(callback));
+      return result;
+    }
+
+    // Invokes the callback for a transition of the given future.
+    void operator () (const Future<T>& future) const
+    {
+      switch (kind) {
+        case NONE:
+          break;
+        case DISCARD:
+        case DISCARDED:
+          nullary();
+          break;
+        case READY:
+          ready(future.data->value());
+          break;
+        case FAILED:
+          failed(future.data->message);
+          break;
+        case ANY:
+          any(future);
+          break;
+      }
+    }
+
+    Kind kind;
+
+  private:
+    explicit Callback(Kind _kind) : kind(_kind) {}
+
+    Callback(const Callback&);
+    Callback& operator = (const Callback&);
+
+    // NOTE: DiscardCallback and DiscardedCallback are the same type.
+    union
+    {
+      DiscardCallback nullary;
+      ReadyCallback ready;
+      FailedCallback failed;
+      AnyCallback any;
+    };
+  };
+
   struct Data
   {
     Data();
     ~Data();
 
+    // Returns the value of a READY future.
+    const T& value() const
+    {
+      return *reinterpret_cast<const T*>(&t);
+    }
+
+    // Appends a callback, to be run once by 'run' or dropped by
+    // 'clearAllCallbacks'.
+    void add(Callback&& callback);
+
+    // Runs the callbacks of the given kind, in the order they were
+    // added.
+    void run(typename Callback::Kind kind, const Future<T>& future) const;
+
+    // Removes the callbacks of the given kind and returns them.
+    std::vector<Callback> remove(typename Callback::Kind kind);
+
     void clearAllCallbacks();
 
     int lock;
     State state;
     bool discard;
     bool associated;
-    T* t;
-    std::string* message; // Message associated with failure.
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+
+    // The value is constructed in place when the future becomes READY.
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type t;
+    std::string message; // Message associated with failure.
+
+    // The first callback is kept inline since most futures only ever
+    // get one, the rest (if any) follow in 'callbacks'.
+    Callback callback;
+    std::vector<Callback> callbacks;
   };
 
   // Sets the value for this future, unless the future is already set,
@@ -568,20 +734,6 @@ private:
 };
 
 
-namespace internal {
-
-  // Helper for executing callbacks that have been registered.
-  template <typename C, typename... Arguments>
-  void run(const std::vector<C>& callbacks, Arguments&&... arguments)
-  {
-    for (size_t i = 0; i < callbacks.size(); ++i) {
-      callbacks[i](std::forward<Arguments>(arguments)...);
-    }
-  }
-
-} // namespace internal {
-
-
 // Represents a weak reference to a future. This class is used to
 // break cyclic dependencies between futures.
 template <typename T>
@@ -945,8 +1097,8 @@ bool Promise<T>::discard(Future<T> future)
   // DISCARDED. We don't need a lock because the state is now in
   // DISCARDED so there should not be any concurrent modifications.
   if (result) {
-    internal::run(future.data->onDiscardedCallbacks);
-    internal::run(future.data->onAnyCallbacks, future);
+    future.data->run(Future<T>::Callback::DISCARDED, future);
+    future.data->run(Future<T>::Callback::ANY, future);
 
     future.data->clearAllCallbacks();
   }
@@ -969,38 +1121,95 @@ Future<T>::Data::Data()
   : lock(0),
     state(PENDING),
     discard(false),
-    associated(false),
-    t(NULL),
-    message(NULL) {}
+    associated(false) {}
 
 
 template <typename T>
 Future<T>::Data::~Data()
 {
-  delete t;
-  delete message;
+  if (state == READY) {
+    reinterpret_cast<T*>(&t)->~T();
+  }
+}
+
+
+template <typename T>
+void Future<T>::Data::add(Callback&& _callback)
+{
+  if (callback.kind == Callback::NONE) {
+    callback = std::move(_callback);
+  } else {
+    callbacks.push_back(std::move(_callback));
+  }
+}
+
+
+template <typename T>
+void Future<T>::Data::run(
+    typename Callback::Kind kind,
+    const Future<T>& future) const
+{
+  if (callback.kind == kind) {
+    callback(future);
+  }
+
+  for (size_t i = 0; i < callbacks.size(); ++i) {
+    if (callbacks[i].kind == kind) {
+      callbacks[i](future);
+    }
+  }
+}
+
+
+template <typename T>
+std::vector<typename Future<T>::Callback> Future<T>::Data::remove(
+    typename Callback::Kind kind)
+{
+  std::vector<Callback> removed;
+  std::vector<Callback> remaining;
+
+  if (callback.kind != Callback::NONE) {
+    if (callback.kind == kind) {
+      removed.push_back(std::move(callback));
+    } else {
+      remaining.push_back(std::move(callback));
+    }
+  }
+
+  for (size_t i = 0; i < callbacks.size(); ++i) {
+    if (callbacks[i].kind == kind) {
+      removed.push_back(std::move(callbacks[i]));
+    } else {
+      remaining.push_back(std::move(callbacks[i]));
+    }
+  }
+
+  clearAllCallbacks();
+
+  for (size_t i = 0; i < remaining.size(); ++i) {
+    add(std::move(remaining[i]));
+  }
+
+  return removed;
 }
 
 
 template <typename T>
 void Future<T>::Data::clearAllCallbacks()
 {
-  onAnyCallbacks.clear();
-  onDiscardCallbacks.clear();
-  onDiscardedCallbacks.clear();
-  onFailedCallbacks.clear();
-  onReadyCallbacks.clear();
+  callback = Callback();
+  callbacks.clear();
 }
 
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data()) {}
+  : data(std::make_shared<Data>()) {}
 
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
@@ -1009,7 +1218,7 @@ Future<T>::Future(const T& _t)
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -1017,7 +1226,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -1030,7 +1239,7 @@ Future<T>::Future(const Future<T>& that)
 
 template <typename T>
 Future<T>::Future(const Try<T>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -1080,13 +1289,13 @@ bool Future<T>::discard()
 {
   bool result = false;
 
-  std::vector<DiscardCallback> callbacks;
+  std::vector<Callback> callbacks;
   internal::acquire(&data->lock);
   {
     if (!data->discard && data->state == PENDING) {
       result = data->discard = true;
 
-      // NOTE: We make a copy of the onDiscard callbacks here
+      // NOTE: We move the onDiscard callbacks out of the list here
       // because it is possible that another thread completes this
       // future (ready, failed or discarded) when the current thread
       // is out of this critical section but *before* it executed the
@@ -1094,18 +1303,18 @@ bool Future<T>::discard()
       // be clearing the onDiscard callbacks (via clearAllCallbacks())
       // while the current thread is executing or clearing the
       // onDiscard callbacks, causing thread safety issue.
-      callbacks = data->onDiscardCallbacks;
-      data->onDiscardCallbacks.clear();
+      callbacks = data->remove(Callback::DISCARD);
     }
   }
   internal::release(&data->lock);
 
   // Invoke all callbacks associated with doing a discard on this
   // future. We don't need a lock because 'Data::discard' should now
-  // be set so we won't be adding anything else to
-  // 'Data::onDiscardCallbacks'.
+  // be set so we won't be adding any other onDiscard callbacks.
   if (result) {
-    internal::run(callbacks);
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      callbacks[i](*this);
+    }
   }
 
   return result;
@@ -1180,7 +1389,8 @@ bool Future<T>::await(const Duration& duration) const
   {
     if (data->state == PENDING) {
       pending = true;
-      data->onAnyCallbacks.push_back(lambda::bind(&internal::awaited, latch));
+      data->add(
+          Callback::onAny(lambda::bind(&internal::awaited, latch)));
     }
   }
   internal::release(&data->lock);
@@ -1207,8 +1417,7 @@ const T& Future<T>::get() const
     CHECK(!isDiscarded()) << "Future::get() but state == DISCARDED";
   }
 
-  assert(data->t != NULL);
-  return *data->t;
+  return data->value();
 }
 
 
@@ -1218,7 +1427,7 @@ const std::string& Future<T>::failure() const
   if (data->state != FAILED) {
     ABORT("Future::failure() but state != FAILED");
   }
-  return *(CHECK_NOTNULL(data->message));
+  return data->message;
 }
 
 
@@ -1233,7 +1442,7 @@ const Future<T>& Future<T>::onDiscard(DiscardCallback&& callback) const
     if (data->discard) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardCallbacks.emplace_back(std::move(callback));
+      data->add(Callback::onDiscard(std::move(callback)));
     }
   }
   internal::release(&data->lock);
@@ -1257,14 +1466,14 @@ const Future<T>& Future<T>::onReady(ReadyCallback&& callback) const
     if (data->state == READY) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onReadyCallbacks.emplace_back(std::move(callback));
+      data->add(Callback::onReady(std::move(callback)));
     }
   }
   internal::release(&data->lock);
 
   // TODO(*): Invoke callback in another execution context.
   if (run) {
-    callback(*data->t);
+    callback(data->value());
   }
 
   return *this;
@@ -1281,14 +1490,14 @@ const Future<T>& Future<T>::onFailed(FailedCallback&& callback) const
     if (data->state == FAILED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onFailedCallbacks.emplace_back(std::move(callback));
+      data->add(Callback::onFailed(std::move(callback)));
     }
   }
   internal::release(&data->lock);
 
   // TODO(*): Invoke callback in another execution context.
   if (run) {
-    callback(*data->message);
+    callback(data->message);
   }
 
   return *this;
@@ -1305,7 +1514,7 @@ const Future<T>& Future<T>::onDiscarded(DiscardedCallback&& callback) const
     if (data->state == DISCARDED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardedCallbacks.emplace_back(std::move(callback));
+      data->add(Callback::onDiscarded(std::move(callback)));
     }
   }
   internal::release(&data->lock);
@@ -1327,7 +1536,7 @@ const Future<T>& Future<T>::onAny(AnyCallback&& callback) const
   internal::acquire(&data->lock);
   {
     if (data->state == PENDING) {
-      data->onAnyCallbacks.emplace_back(std::move(callback));
+      data->add(Callback::onAny(std::move(callback)));
     } else {
       run = true;
     }
@@ -1353,7 +1562,7 @@ const Future<T>& Future<T>::onDiscard(const DiscardCallback& callback) const
     if (data->discard) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardCallbacks.push_back(callback);
+      data->add(Callback::onDiscard(callback));
     }
   }
   internal::release(&data->lock);
@@ -1377,14 +1586,14 @@ const Future<T>& Future<T>::onReady(const ReadyCallback& callback) const
     if (data->state == READY) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onReadyCallbacks.push_back(callback);
+      data->add(Callback::onReady(callback));
     }
   }
   internal::release(&data->lock);
 
   // TODO(*): Invoke callback in another execution context.
   if (run) {
-    callback(*data->t);
+    callback(data->value());
   }
 
   return *this;
@@ -1401,14 +1610,14 @@ const Future<T>& Future<T>::onFailed(const FailedCallback& callback) const
     if (data->state == FAILED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onFailedCallbacks.push_back(callback);
+      data->add(Callback::onFailed(callback));
     }
   }
   internal::release(&data->lock);
 
   // TODO(*): Invoke callback in another execution context.
   if (run) {
-    callback(*data->message);
+    callback(data->message);
   }
 
   return *this;
@@ -1426,7 +1635,7 @@ const Future<T>& Future<T>::onDiscarded(
     if (data->state == DISCARDED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardedCallbacks.push_back(callback);
+      data->add(Callback::onDiscarded(callback));
     }
   }
   internal::release(&data->lock);
@@ -1448,7 +1657,7 @@ const Future<T>& Future<T>::onAny(const AnyCallback& callback) const
   internal::acquire(&data->lock);
   {
     if (data->state == PENDING) {
-      data->onAnyCallbacks.push_back(callback);
+      data->add(Callback::onAny(callback));
     } else {
       run = true;
     }
@@ -1620,7 +1829,7 @@ bool Future<T>::set(const T& _t)
   internal::acquire(&data->lock);
   {
     if (data->state == PENDING) {
-      data->t = new T(_t);
+      new (&data->t) T(_t);
       data->state = READY;
       result = true;
     }
@@ -1631,8 +1840,8 @@ bool Future<T>::set(const T& _t)
   // don't need a lock because the state is now in READY so there
   // should not be any concurrent modications.
   if (result) {
-    internal::run(data->onReadyCallbacks, *data->t);
-    internal::run(data->onAnyCallbacks, *this);
+    data->run(Callback::READY, *this);
+    data->run(Callback::ANY, *this);
 
     data->clearAllCallbacks();
   }
@@ -1649,7 +1858,7 @@ bool Future<T>::fail(const std::string& _message)
   internal::acquire(&data->lock);
   {
     if (data->state == PENDING) {
-      data->message = new std::string(_message);
+      data->message = _message;
       data->state = FAILED;
       result = true;
     }
@@ -1660,8 +1869,8 @@ bool Future<T>::fail(const std::string& _message)
   // don't need a lock because the state is now in FAILED so there
   // should not be any concurrent modications.
   if (result) {
-    internal::run(data->onFailedCallbacks, *data->message);
-    internal::run(data->onAnyCallbacks, *this);
+    data->run(Callback::FAILED, *this);
+    data->run(Callback::ANY, *this);
 
     data->clearAllCallbacks();
   }
@@ -529,6 +529,59 @@ Future<Response> post(
     const Option<std::string>& contentType = None());
 
 
+namespace internal {
+
+// Forward declaration.
+class ClientProcess;
+
+} // namespace internal {
+
+
+// Sends HTTP requests over persistent (keep-alive) HTTP/1.1
+// connections, rather than opening and closing a connection for each
+// request like 'get' and 'post' above do. The connections to a host
+// are pooled and reused by subsequent requests: an idle connection is
+// picked if there is one, otherwise a new connection is opened as
+// long as there are less than 'maxConnections' to the host, otherwise
+// the request is pipelined on the least loaded connection. Responses
+// are decoded incrementally as they are read off a connection and
+// each one is returned as soon as it is complete.
+//
+// NOTE: A request that is pipelined behind one which fails the
+// connection (e.g., the server closes it) fails as well, it is not
+// retried.
+class Client
+{
+public:
+  static const size_t DEFAULT_MAX_CONNECTIONS = 4;
+
+  explicit Client(size_t maxConnections = DEFAULT_MAX_CONNECTIONS);
+
+  // Closes all of the connections, failing any outstanding requests.
+  ~Client();
+
+  Future<Response> get(
+      const UPID& upid,
+      const Option<std::string>& path = None(),
+      const Option<std::string>& query = None(),
+      const Option<hashmap<std::string, std::string> >& headers = None());
+
+  Future<Response> post(
+      const UPID& upid,
+      const Option<std::string>& path = None(),
+      const Option<hashmap<std::string, std::string> >& headers = None(),
+      const Option<std::string>& body = None(),
+      const Option<std::string>& contentType = None());
+
+private:
+  // Not copyable, not assignable.
+  Client(const Client&);
+  Client& operator = (const Client&);
+
+  internal::ClientProcess* process;
+};
+
+
 // Status code reason strings, from the HTTP1.1 RFC:
 // http://www.w3.org/Protocols/rfc2616/rfc2616-sec6.html
 extern hashmap<uint16_t, std::string> statuses;
@@ -1,6 +1,8 @@
 #ifndef __PROCESS_IO_HPP__
 #define __PROCESS_IO_HPP__
 
+#include <sys/types.h> // For off_t.
+
 #include <cstring> // For size_t.
 #include <string>
 
@@ -18,6 +20,10 @@ const short WRITE = 0x02;
 // Buffered read chunk size. Roughly 16 pages.
 const size_t BUFFERED_READ_SIZE = 16*4096;
 
+// Number of threads performing the blocking I/O of 'pread', 'pwrite'
+// and 'fsync' below.
+const size_t BLOCKING_IO_THREADS = 4;
+
 // TODO(benh): Add a version which takes multiple file descriptors.
 // Returns the events (a subset of the events specified) that can be
 // performed on the specified file descriptor without blocking.
@@ -66,6 +72,29 @@ Future<size_t> write(int fd, void* data, size_t size);
 Future<Nothing> write(int fd, const std::string& data);
 
 
+// Performs a single read of up to 'size' bytes at 'offset' on one of
+// a pool of dedicated I/O threads. Unlike 'read' above this works for
+// file descriptors that can not be polled, in particular those of
+// regular files, without blocking the calling (actor) thread. The
+// future will become ready with the number of bytes read, zero on
+// end-of-file, or fail if an error is detected. The data must stay
+// valid until the future is completed. Discarding the future before
+// the read is started prevents it from being done.
+Future<size_t> pread(int fd, void* data, size_t size, off_t offset);
+
+
+// Performs a single write of up to 'size' bytes at 'offset' on one of
+// the dedicated I/O threads, see 'pread' above. The future will
+// become ready with the number of bytes written, which may be less
+// than 'size', or fail if an error is detected.
+Future<size_t> pwrite(int fd, const void* data, size_t size, off_t offset);
+
+
+// Flushes the data (and metadata) of the file to its storage device
+// on one of the dedicated I/O threads, see 'pread' above.
+Future<Nothing> fsync(int fd);
+
+
 // Redirect output from 'from' file descriptor to 'to' file descriptor
 // or /dev/null if 'to' is None. Note that depending on how we
 // redirect output we duplicate the 'from' and 'to' file descriptors
@@ -5,14 +5,42 @@
 
 #include <process/pid.hpp>
 
+#include <stout/memory.hpp>
+
 namespace process {
 
+// An in-memory representation of a message body that can be handed
+// to a receiver in the same OS process instead of a serialized body
+// (see ProtobufProcess::send).
+struct Payload
+{
+  virtual ~Payload() {}
+
+  // Returns the serialized message body.
+  virtual std::string serialize() const = 0;
+};
+
+
 struct Message
 {
+  // Serializes the payload (if any) into the body. This needs to be
+  // done before anything but the receiver the payload was meant for
+  // accesses 'body', e.g., a filter, a delegate or a remote process.
+  void encode()
+  {
+    if (payload) {
+      body = payload->serialize();
+      payload.reset();
+    }
+  }
+
   std::string name;
   UPID from;
   UPID to;
   std::string body;
+
+  // If set, 'body' is empty until 'encode()' is invoked.
+  memory::shared_ptr<const Payload> payload;
 };
 
 } // namespace process {
@@ -79,6 +79,23 @@ public:
     return t;
   }
 
+  // Record an event that took the given duration, for events that
+  // were not timed with start() and stop() (e.g., ones that started
+  // in another process).
+  void record(const Duration& duration)
+  {
+    double value;
+
+    process::internal::acquire(&data->lock);
+    {
+      data->lastValue = T(duration).value();
+      value = data->lastValue.get();
+    }
+    process::internal::release(&data->lock);
+
+    push(value);
+  }
+
   // Time an asynchronous event.
   template<typename U>
   Future<U> time(const Future<U>& future)
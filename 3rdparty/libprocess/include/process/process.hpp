@@ -16,6 +16,7 @@
 #include <process/pid.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
 #include <stout/thread.hpp>
@@ -71,6 +72,14 @@ protected:
       const char* data = NULL,
       size_t length = 0);
 
+  // Sends a message to PID whose body gets serialized from 'payload'
+  // only if PID is remote (or something other than PID's message
+  // handler needs the body, see Message::encode).
+  void send(
+      const UPID& to,
+      const std::string& name,
+      const memory::shared_ptr<const Payload>& payload);
+
   // Links with the specified PID. Linking with a process from within
   // the same "operating system process" is gauranteed to give you
   // perfect monitoring of that process. However, linking with a
@@ -214,12 +223,14 @@ private:
   void enqueue(Event* event, bool inject = false);
 
   // Delegates for messages.
-  std::map<std::string, UPID> delegates;
+  hashmap<std::string, UPID> delegates;
 
-  // Handlers for messages and HTTP requests.
+  // Handlers for messages and HTTP requests (keyed by the first
+  // component of the path following the process id). These are hash
+  // tables since every message and request needs a lookup.
   struct {
-    std::map<std::string, MessageHandler> message;
-    std::map<std::string, HttpRequestHandler> http;
+    hashmap<std::string, MessageHandler> message;
+    hashmap<std::string, HttpRequestHandler> http;
   } handlers;
 
   // Definition of a static asset.
@@ -6,15 +6,24 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>
 
+#include <pthread.h>
+
 #include <set>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
+#include <process/message.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/memory.hpp>
 
 
 // Provides an implementation of process::post that for a protobuf.
@@ -38,6 +47,72 @@ inline void post(const process::UPID& from,
   post(from, to, message.GetTypeName(), data.data(), data.size());
 }
 
+
+// A protocol buffer handed to a receiver in the same OS process
+// without serializing it (see ProtobufProcess::send).
+struct ProtobufPayload : Payload
+{
+  explicit ProtobufPayload(const google::protobuf::Message* _message)
+    : message(_message) {}
+
+  virtual std::string serialize() const
+  {
+    std::string data;
+    message->SerializeToString(&data);
+    return data;
+  }
+
+  const memory::shared_ptr<const google::protobuf::Message> message;
+};
+
+
+namespace internal {
+
+// Counters of the protocol buffers of a type that any ProtobufProcess
+// received: how many were parsed (and how many bytes that took) and
+// how many were handed over by a local sender instead.
+struct ProtobufCounters
+{
+  explicit ProtobufCounters(const std::string& type)
+    : decoded("protobuf/" + type + "/decoded"),
+      decoded_bytes("protobuf/" + type + "/decoded_bytes"),
+      handed_over("protobuf/" + type + "/handed_over")
+  {
+    metrics::add(decoded);
+    metrics::add(decoded_bytes);
+    metrics::add(handed_over);
+  }
+
+  metrics::Counter decoded;
+  metrics::Counter decoded_bytes;
+  metrics::Counter handed_over;
+};
+
+
+// Returns the counters of the given type, adding them the first time
+// the type is seen. The counters are shared by all processes and are
+// never removed.
+inline ProtobufCounters* counters(const std::string& type)
+{
+  static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  static hashmap<std::string, ProtobufCounters*>* counters =
+    new hashmap<std::string, ProtobufCounters*>();
+
+  pthread_mutex_lock(&mutex);
+
+  if (!counters->contains(type)) {
+    counters->put(type, new ProtobufCounters(type));
+  }
+
+  ProtobufCounters* result = counters->at(type);
+
+  pthread_mutex_unlock(&mutex);
+
+  return result;
+}
+
+} // namespace internal {
+
 } // namespace process {
 
 
@@ -85,11 +160,24 @@ public:
 protected:
   virtual void visit(const process::MessageEvent& event)
   {
-    if (protobufHandlers.count(event.message->name) > 0) {
+    typename hashmap<std::string, handler>::const_iterator iterator =
+      protobufHandlers.find(event.message->name);
+
+    if (iterator != protobufHandlers.end()) {
       from = event.message->from; // For 'reply'.
-      protobufHandlers[event.message->name](
-          event.message->from, event.message->body);
+      iterator->second(event.message->from, *event.message);
       from = process::UPID();
+
+      // Don't hold on to the memory of an unusually large message
+      // until the next message of the same type comes along.
+      if (event.message->body.size() > 1024 * 1024) {
+        typename hashmap<std::string, Decoder>::iterator decoder =
+          decoders.find(event.message->name);
+
+        if (decoder != decoders.end()) {
+          decoder->second.buffer.reset(decoder->second.buffer->New());
+        }
+      }
     } else {
       process::Process<T>::visit(event);
     }
@@ -98,6 +186,21 @@ protected:
   void send(const process::UPID& to,
             const google::protobuf::Message& message)
   {
+    if (to.node == process::node()) {
+      // Hand a copy of the message to the local receiver, which is
+      // considerably cheaper than serializing it here and parsing it
+      // again in the receiver.
+      google::protobuf::Message* copy = message.New();
+      copy->CopyFrom(message);
+
+      process::Process<T>::send(
+          to,
+          message.GetTypeName(),
+          memory::shared_ptr<const process::Payload>(
+              new process::ProtobufPayload(copy)));
+      return;
+    }
+
     std::string data;
     message.SerializeToString(&data);
     process::Process<T>::send(to, message.GetTypeName(),
@@ -109,8 +212,6 @@ protected:
   void reply(const google::protobuf::Message& message)
   {
     CHECK(from) << "Attempting to reply without a sender";
-    std::string data;
-    message.SerializeToString(&data);
     send(from, message);
   }
 
@@ -125,7 +226,7 @@ protected:
       lambda::bind(&handlerM<M>,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M>
@@ -152,7 +253,7 @@ protected:
       lambda::bind(&handler1<M, P1, P1C>,
                    t, method, param1,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -169,7 +270,7 @@ protected:
       lambda::bind(&handler2<M, P1, P1C, P2, P2C>,
                    t, method, p1, p2,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -188,7 +289,7 @@ protected:
       lambda::bind(&handler3<M, P1, P1C, P2, P2C, P3, P3C>,
                    t, method, p1, p2, p3,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -209,7 +310,7 @@ protected:
       lambda::bind(&handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
                    t, method, p1, p2, p3, p4,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -232,7 +333,7 @@ protected:
       lambda::bind(&handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
                    t, method, p1, p2, p3, p4, p5,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -258,7 +359,7 @@ protected:
                                 P4, P4C, P5, P5C, P6, P6C>,
                    t, method, p1, p2, p3, p4, p5, p6,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   // Installs that do not take the sender.
@@ -271,7 +372,7 @@ protected:
       lambda::bind(&_handlerM<M>,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M>
@@ -298,7 +399,7 @@ protected:
       lambda::bind(&_handler1<M, P1, P1C>,
                    t, method, param1,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -315,7 +416,7 @@ protected:
       lambda::bind(&_handler2<M, P1, P1C, P2, P2C>,
                    t, method, p1, p2,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -334,7 +435,7 @@ protected:
       lambda::bind(&_handler3<M, P1, P1C, P2, P2C, P3, P3C>,
                    t, method, p1, p2, p3,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -355,7 +456,7 @@ protected:
       lambda::bind(&_handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
                    t, method, p1, p2, p3, p4,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -378,7 +479,7 @@ protected:
       lambda::bind(&_handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
                    t, method, p1, p2, p3, p4, p5,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   template <typename M,
@@ -404,22 +505,89 @@ protected:
                                  P4, P4C, P5, P5C, P6, P6C>,
                    t, method, p1, p2, p3, p4, p5, p6,
                    lambda::_1, lambda::_2);
-    delete m;
+    decoders[m->GetTypeName()] = Decoder(m);
   }
 
   using process::Process<T>::install;
 
 private:
+  // Returns the protocol buffer handed over by a local sender, if
+  // any, otherwise parses the message into the decode buffer of its
+  // type. Parsing into the same buffer again and again rather than
+  // into a fresh protocol buffer reuses the repeated elements and
+  // strings allocated by previous messages of the same type.
+  template <typename M>
+  static const M& decode(T* t, const process::Message& message)
+  {
+    ProtobufProcess<T>* process = t;
+
+    typename hashmap<std::string, Decoder>::iterator iterator =
+      process->decoders.find(message.name);
+
+    CHECK(iterator != process->decoders.end());
+    Decoder& decoder = iterator->second;
+
+    if (message.payload) {
+      const process::ProtobufPayload* payload =
+        dynamic_cast<const process::ProtobufPayload*>(message.payload.get());
+
+      if (payload != NULL) {
+        const M* m = dynamic_cast<const M*>(payload->message.get());
+        if (m != NULL) {
+          ++decoder.counters->handed_over;
+          return *m;
+        }
+      }
+    }
+
+    M* m = static_cast<M*>(decoder.buffer.get());
+
+    if (message.payload) {
+      const std::string data = message.payload->serialize();
+      m->ParseFromString(data);
+      decoder.counters->decoded_bytes += data.size();
+    } else {
+      m->ParseFromString(message.body);
+      decoder.counters->decoded_bytes += message.body.size();
+    }
+
+    ++decoder.counters->decoded;
+
+    return *m;
+  }
+
+  // Passes a field to a handler parameter that it converts to, in
+  // particular a repeated field to a 'const RepeatedPtrField<E>&'
+  // without copying any of the elements.
+  template <typename P, typename F>
+  static typename std::enable_if<
+      std::is_convertible<const F&, P>::value, const F&>::type
+  convert(const F& field)
+  {
+    return field;
+  }
+
+  // Copies the elements of a repeated field into a std::vector for
+  // handlers that take one.
+  template <typename P, typename E>
+  static typename std::enable_if<
+      !std::is_convertible<
+          const google::protobuf::RepeatedPtrField<E>&, P>::value,
+      std::vector<E> >::type
+  convert(const google::protobuf::RepeatedPtrField<E>& items)
+  {
+    return google::protobuf::convert(items);
+  }
+
   // Handlers that take the sender as the first argument.
   template <typename M>
   static void handlerM(
       T* t,
       void (T::*method)(const process::UPID&, const M&),
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender, m);
     } else {
@@ -432,7 +600,7 @@ private:
       T* t,
       void (T::*method)(const process::UPID&),
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
     (t->*method)(sender);
   }
@@ -444,12 +612,11 @@ private:
       void (T::*method)(const process::UPID&, P1C),
       P1 (M::*p1)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
+      (t->*method)(sender, convert<P1C>((&m->*p1)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -465,14 +632,13 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
+                   convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -490,15 +656,14 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
+                   convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -518,16 +683,15 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
+                   convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -549,17 +713,16 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
+                   convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()),
+                   convert<P5C>((&m->*p5)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -583,18 +746,17 @@ private:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
+                   convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()),
+                   convert<P5C>((&m->*p5)()),
+                   convert<P6C>((&m->*p6)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -608,10 +770,9 @@ private:
       T* t,
       void (T::*method)(const M&),
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
       (t->*method)(m);
     } else {
@@ -624,7 +785,7 @@ private:
       T* t,
       void (T::*method)(),
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
     (t->*method)();
   }
@@ -636,12 +797,11 @@ private:
       void (T::*method)(P1C),
       P1 (M::*p1)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()));
+      (t->*method)(convert<P1C>((&m->*p1)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -657,13 +817,12 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
+      (t->*method)(convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -681,14 +840,13 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
+      (t->*method)(convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -708,15 +866,14 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
+      (t->*method)(convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -738,16 +895,15 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
+      (t->*method)(convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()),
+                   convert<P5C>((&m->*p5)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -771,17 +927,16 @@ private:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
       const process::UPID&,
-      const std::string& data)
+      const process::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
+    const M& m = decode<M>(t, message);
     if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
+      (t->*method)(convert<P1C>((&m->*p1)()),
+                   convert<P2C>((&m->*p2)()),
+                   convert<P3C>((&m->*p3)()),
+                   convert<P4C>((&m->*p4)()),
+                   convert<P5C>((&m->*p5)()),
+                   convert<P6C>((&m->*p6)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
                    << m.InitializationErrorString();
@@ -789,9 +944,24 @@ private:
   }
 
   typedef lambda::function<
-      void(const process::UPID&, const std::string&)> handler;
+      void(const process::UPID&, const process::Message&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  // Decode buffer and counters of a message type with a handler.
+  struct Decoder
+  {
+    Decoder() : counters(NULL) {}
+
+    explicit Decoder(google::protobuf::Message* _buffer)
+      : buffer(_buffer),
+        counters(process::internal::counters(_buffer->GetTypeName())) {}
+
+    memory::shared_ptr<google::protobuf::Message> buffer;
+    process::internal::ProtobufCounters* counters;
+  };
+
+  hashmap<std::string, Decoder> decoders;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
@@ -9,7 +9,10 @@
 
 namespace process {
 
-// The upper bound for the poll interval in the reaper.
+// The upper bound for the poll interval in the reaper. Only the
+// termination of processes that are not direct children is polled
+// for; the reaper is notified of the termination of its children
+// through SIGCHLD.
 Duration MAX_REAP_INTERVAL();
 
 // Returns the exit status of the specified process if and only if
@@ -17,6 +20,9 @@ Duration MAX_REAP_INTERVAL();
 // Otherwise, returns None once the process has been reaped elsewhere
 // (or does not exist, which is indistinguishable from being reaped
 // elsewhere). This will never discard the returned future.
+// NOTE: The first call installs a SIGCHLD handler (unless SIGCHLD is
+// ignored) which calls any previously installed handler. A handler
+// installed afterwards must do the same.
 Future<Option<int> > reap(pid_t pid);
 
 } // namespace process {
@@ -44,6 +44,11 @@ public:
     bool isPath() const { return mode == PATH; }
     bool isFd() const { return mode == FD; }
 
+    // The file descriptor I/O is redirected to (FD) or the path of
+    // the file I/O is redirected to (PATH).
+    Option<int> descriptor() const { return fd; }
+    Option<std::string> file() const { return path; }
+
   private:
     friend class Subprocess;
 
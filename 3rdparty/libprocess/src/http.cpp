@@ -5,27 +5,39 @@
 #include <cstring>
 #include <deque>
 #include <iostream>
+#include <list>
 #include <string>
 
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "decoder.hpp"
 
 using std::deque;
+using std::list;
 using std::string;
 
 using process::http::Request;
 using process::http::Response;
 
+using process::network::Socket;
+
 namespace process {
 
 namespace http {
@@ -57,37 +69,19 @@ Future<Response> decode(const string& buffer)
 }
 
 
-Future<Response> request(
+// Encodes a request for the process with the given upid. Unless
+// 'keepAlive' is set, the server is told to close the connection once
+// it has sent the response.
+string encode(
     const UPID& upid,
     const string& method,
     const Option<string>& path,
     const Option<string>& query,
     const Option<hashmap<string, string> >& _headers,
     const Option<string>& body,
-    const Option<string>& contentType)
+    const Option<string>& contentType,
+    bool keepAlive)
 {
-  Try<int> socket = network::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
-
-  if (socket.isError()) {
-    return Failure("Failed to create socket: " + socket.error());
-  }
-
-  int s = socket.get();
-
-  Try<Nothing> cloexec = os::cloexec(s);
-  if (!cloexec.isSome()) {
-    os::close(s);
-    return Failure("Failed to cloexec: " + cloexec.error());
-  }
-
-  const string host = stringify(upid.node);
-
-  Try<int> connect = network::connect(s, upid.node);
-  if (connect.isError()) {
-    os::close(s);
-    return Failure(connect.error());
-  }
-
   std::ostringstream out;
 
   out << method << " /" << upid.id;
@@ -110,10 +104,13 @@ Future<Response> request(
   }
 
   // Need to specify the 'Host' header.
-  headers["Host"] = host;
+  headers["Host"] = stringify(upid.node);
 
-  // Tell the server to close the connection when it's done.
-  headers["Connection"] = "close";
+  // Tell the server to close the connection when it's done, HTTP/1.1
+  // connections are persistent otherwise.
+  if (!keepAlive) {
+    headers["Connection"] = "close";
+  }
 
   // Overwrite Content-Type if necessary.
   if (contentType.isSome()) {
@@ -136,6 +133,42 @@ Future<Response> request(
     out << body.get();
   }
 
+  return out.str();
+}
+
+
+Future<Response> request(
+    const UPID& upid,
+    const string& method,
+    const Option<string>& path,
+    const Option<string>& query,
+    const Option<hashmap<string, string> >& headers,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  Try<int> socket = network::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+  if (socket.isError()) {
+    return Failure("Failed to create socket: " + socket.error());
+  }
+
+  int s = socket.get();
+
+  Try<Nothing> cloexec = os::cloexec(s);
+  if (!cloexec.isSome()) {
+    os::close(s);
+    return Failure("Failed to cloexec: " + cloexec.error());
+  }
+
+  Try<int> connect = network::connect(s, upid.node);
+  if (connect.isError()) {
+    os::close(s);
+    return Failure(connect.error());
+  }
+
+  const string data = encode(
+      upid, method, path, query, headers, body, contentType, false);
+
   Try<Nothing> nonblock = os::nonblock(s);
   if (!nonblock.isSome()) {
     os::close(s);
@@ -145,13 +178,224 @@ Future<Response> request(
   // Need to disambiguate the io::read we want when binding below.
   Future<string> (*read)(int) = io::read;
 
-  return io::write(s, out.str())
+  return io::write(s, data)
     .then(lambda::bind(read, s))
     .then(lambda::bind(&internal::decode, lambda::_1))
     .onAny(lambda::bind(&os::close, s));
 }
 
 
+// Writes a request to a (connected) socket. Bound into the chain of
+// writes of a connection, which keeps pipelined requests in order.
+Future<Nothing> send(const Socket& socket, const string& data)
+{
+  return io::write(socket.get(), data);
+}
+
+
+class ClientProcess : public Process<ClientProcess>
+{
+public:
+  explicit ClientProcess(size_t _maxConnections)
+    : ProcessBase(ID::generate("__http_client__")),
+      maxConnections(_maxConnections) {}
+
+  virtual ~ClientProcess() {}
+
+  Future<Response> request(const Node& node, const string& data)
+  {
+    Owned<Connection> connection;
+
+    // Prefer an idle connection, then a new connection, then the
+    // least loaded one.
+    foreach (const Owned<Connection>& candidate, connections[node]) {
+      if (connection.get() == NULL ||
+          candidate->pending.size() < connection->pending.size()) {
+        connection = candidate;
+      }
+    }
+
+    if (connection.get() == NULL ||
+        (!connection->pending.empty() &&
+         connections[node].size() < maxConnections)) {
+      Try<Owned<Connection> > connect = this->connect(node);
+      if (connect.isError()) {
+        return Failure(connect.error());
+      }
+      connection = connect.get();
+    }
+
+    Owned<Promise<Response> > promise(new Promise<Response>());
+    connection->pending.push_back(promise);
+
+    connection->sending = connection->sending
+      .then(lambda::bind(&internal::send, connection->socket, data));
+
+    connection->sending
+      .onFailed(defer(self(), &Self::failed, connection, lambda::_1));
+
+    return promise->future();
+  }
+
+protected:
+  virtual void finalize()
+  {
+    // NOTE: Closing a connection removes it from 'connections'.
+    while (!connections.empty()) {
+      Owned<Connection> connection = connections.begin()->second.front();
+      close(connection, "HTTP client terminated");
+    }
+  }
+
+private:
+  struct Connection
+  {
+    Connection(const Node& _node, const Socket& _socket)
+      : node(_node), socket(_socket), closed(false) {}
+
+    const Node node;
+    Socket socket;
+
+    ResponseDecoder decoder;
+
+    // Chain of connecting and then writing the requests, in order.
+    Future<Nothing> sending;
+
+    // The outstanding recv, if any.
+    Future<size_t> receiving;
+    char buffer[4096];
+
+    // The requests that are awaiting a response, in the order they
+    // were sent.
+    deque<Owned<Promise<Response> > > pending;
+
+    bool closed;
+  };
+
+  typedef ClientProcess Self;
+
+  Try<Owned<Connection> > connect(const Node& node)
+  {
+    Try<Socket> socket = Socket::create();
+    if (socket.isError()) {
+      return Error("Failed to create socket: " + socket.error());
+    }
+
+    Owned<Connection> connection(new Connection(node, socket.get()));
+    connection->sending = connection->socket.connect(node);
+
+    connection->sending
+      .onReady(defer(self(), &Self::receive, connection));
+
+    connections[node].push_back(connection);
+
+    return connection;
+  }
+
+  void receive(const Owned<Connection>& connection)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    connection->receiving = connection->socket.recv(
+        connection->buffer, sizeof(connection->buffer));
+
+    connection->receiving
+      .onAny(defer(self(), &Self::received, connection, lambda::_1));
+  }
+
+  void received(
+      const Owned<Connection>& connection,
+      const Future<size_t>& length)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    if (!length.isReady()) {
+      close(connection,
+            "Failed to read from connection: " +
+            (length.isFailed() ? length.failure() : "discarded"));
+      return;
+    }
+
+    // A read of zero bytes signals the end of the stream to the
+    // decoder, which completes a response delimited by it (if any).
+    deque<Response*> responses =
+      connection->decoder.decode(connection->buffer, length.get());
+
+    bool persistent = true;
+
+    while (!responses.empty()) {
+      Owned<Response> response(responses.front());
+      responses.pop_front();
+
+      if (connection->pending.empty()) {
+        LOG(ERROR) << "Received an unexpected HTTP response from "
+                   << connection->node;
+        continue;
+      }
+
+      Option<string> header = response->headers.get("Connection");
+      if (header.isSome() && strings::lower(header.get()) == "close") {
+        persistent = false;
+      }
+
+      connection->pending.front()->set(*response);
+      connection->pending.pop_front();
+    }
+
+    if (connection->decoder.failed()) {
+      close(connection, "Failed to decode HTTP response");
+    } else if (length.get() == 0) {
+      close(connection, "Connection closed");
+    } else if (!persistent) {
+      close(connection, "Connection closed by the server");
+    } else {
+      receive(connection);
+    }
+  }
+
+  void failed(const Owned<Connection>& connection, const string& message)
+  {
+    close(connection, "Failed to send to connection: " + message);
+  }
+
+  // Removes the connection from the pool and fails the requests that
+  // are still awaiting a response on it.
+  void close(const Owned<Connection>& connection, const string& message)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    connection->closed = true;
+
+    // NOTE: The socket is only closed once the last reference to the
+    // connection is gone, i.e., after the callbacks for the discarded
+    // futures have run.
+    connection->sending.discard();
+    connection->receiving.discard();
+
+    foreach (const Owned<Promise<Response> >& promise, connection->pending) {
+      promise->fail(message);
+    }
+    connection->pending.clear();
+
+    if (connections.contains(connection->node)) {
+      connections[connection->node].remove(connection);
+      if (connections[connection->node].empty()) {
+        connections.erase(connection->node);
+      }
+    }
+  }
+
+  const size_t maxConnections;
+
+  hashmap<Node, list<Owned<Connection> > > connections;
+};
+
 } // namespace internal {
 
 
@@ -182,5 +426,57 @@ Future<Response> post(
 }
 
 
+Client::Client(size_t maxConnections)
+{
+  CHECK_GT(maxConnections, 0u);
+
+  process = new internal::ClientProcess(maxConnections);
+  spawn(process);
+}
+
+
+Client::~Client()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<Response> Client::get(
+    const UPID& upid,
+    const Option<string>& path,
+    const Option<string>& query,
+    const Option<hashmap<string, string> >& headers)
+{
+  return dispatch(
+      process,
+      &internal::ClientProcess::request,
+      upid.node,
+      internal::encode(
+          upid, "GET", path, query, headers, None(), None(), true));
+}
+
+
+Future<Response> Client::post(
+    const UPID& upid,
+    const Option<string>& path,
+    const Option<hashmap<string, string> >& headers,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  if (body.isNone() && contentType.isSome()) {
+    return Failure("Attempted to do a POST with a Content-Type but no body");
+  }
+
+  return dispatch(
+      process,
+      &internal::ClientProcess::request,
+      upid.node,
+      internal::encode(
+          upid, "POST", path, None(), headers, body, contentType, true));
+}
+
+
 } // namespace http {
 } // namespace process {
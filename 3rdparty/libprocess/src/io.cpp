@@ -1,9 +1,14 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include <queue>
 #include <string>
 
 #include <boost/shared_array.hpp>
 
 #include <process/future.hpp>
 #include <process/io.hpp>
+#include <process/once.hpp>
 #include <process/process.hpp> // For process::initialize.
 
 #include <stout/lambda.hpp>
@@ -574,6 +579,196 @@ Future<Nothing> write(int fd, const std::string& data)
 }
 
 
+namespace internal {
+
+// A pool of threads that perform blocking I/O. Regular files are
+// always "ready" as far as polling is concerned, so reading, writing
+// or syncing them blocks the calling thread, and when done by an
+// actor, one of the (few) threads that run all actors. Instead, the
+// operations are queued to these threads, which complete the promise
+// of each operation once it is done.
+class BlockingIO
+{
+public:
+  explicit BlockingIO(size_t threads)
+  {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+
+    for (size_t i = 0; i < threads; i++) {
+      pthread_t thread; // For now, not saving handles on our threads.
+      if (pthread_create(&thread, NULL, &BlockingIO::run, this) != 0) {
+        LOG(FATAL) << "Failed to create blocking I/O thread";
+      }
+    }
+  }
+
+  void enqueue(const lambda::function<void(void)>& operation)
+  {
+    pthread_mutex_lock(&mutex);
+    operations.push(operation);
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+  }
+
+private:
+  static void* run(void* arg)
+  {
+    BlockingIO* io = reinterpret_cast<BlockingIO*>(arg);
+
+    while (true) {
+      pthread_mutex_lock(&io->mutex);
+      while (io->operations.empty()) {
+        pthread_cond_wait(&io->cond, &io->mutex);
+      }
+      lambda::function<void(void)> operation = io->operations.front();
+      io->operations.pop();
+      pthread_mutex_unlock(&io->mutex);
+
+      operation();
+    }
+
+    return NULL;
+  }
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  std::queue<lambda::function<void(void)> > operations;
+};
+
+
+static BlockingIO* blocking()
+{
+  static BlockingIO* io = NULL;
+  static Once* initialized = new Once();
+
+  if (!initialized->once()) {
+    io = new BlockingIO(BLOCKING_IO_THREADS);
+    initialized->done();
+  }
+
+  return CHECK_NOTNULL(io);
+}
+
+
+void pread(
+    int fd,
+    void* data,
+    size_t size,
+    off_t offset,
+    const memory::shared_ptr<Promise<size_t> >& promise)
+{
+  // Ignore this function if the read operation has been discarded.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  ssize_t length;
+  do {
+    length = ::pread(fd, data, size, offset);
+  } while (length < 0 && errno == EINTR);
+
+  if (length < 0) {
+    promise->fail(strerror(errno));
+  } else {
+    promise->set(length);
+  }
+}
+
+
+void pwrite(
+    int fd,
+    const void* data,
+    size_t size,
+    off_t offset,
+    const memory::shared_ptr<Promise<size_t> >& promise)
+{
+  // Ignore this function if the write operation has been discarded.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  ssize_t length;
+  do {
+    length = ::pwrite(fd, data, size, offset);
+  } while (length < 0 && errno == EINTR);
+
+  if (length < 0) {
+    promise->fail(strerror(errno));
+  } else {
+    promise->set(length);
+  }
+}
+
+
+void fsync(int fd, const memory::shared_ptr<Promise<Nothing> >& promise)
+{
+  // Ignore this function if the sync operation has been discarded.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  int result;
+  do {
+    result = ::fsync(fd);
+  } while (result < 0 && errno == EINTR);
+
+  if (result < 0) {
+    promise->fail(strerror(errno));
+  } else {
+    promise->set(Nothing());
+  }
+}
+
+} // namespace internal {
+
+
+Future<size_t> pread(int fd, void* data, size_t size, off_t offset)
+{
+  memory::shared_ptr<Promise<size_t> > promise(new Promise<size_t>());
+
+  if (size == 0) {
+    promise->set(0);
+    return promise->future();
+  }
+
+  internal::blocking()->enqueue(
+      lambda::bind(&internal::pread, fd, data, size, offset, promise));
+
+  return promise->future();
+}
+
+
+Future<size_t> pwrite(int fd, const void* data, size_t size, off_t offset)
+{
+  memory::shared_ptr<Promise<size_t> > promise(new Promise<size_t>());
+
+  if (size == 0) {
+    promise->set(0);
+    return promise->future();
+  }
+
+  internal::blocking()->enqueue(
+      lambda::bind(&internal::pwrite, fd, data, size, offset, promise));
+
+  return promise->future();
+}
+
+
+Future<Nothing> fsync(int fd)
+{
+  memory::shared_ptr<Promise<Nothing> > promise(new Promise<Nothing>());
+
+  internal::blocking()->enqueue(
+      lambda::bind(&internal::fsync, fd, promise));
+
+  return promise->future();
+}
+
+
 Future<Nothing> redirect(int from, Option<int> to, size_t chunk)
 {
   // Make sure we've got "valid" file descriptors.
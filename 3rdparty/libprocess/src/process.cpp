@@ -67,6 +67,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/memory.hpp> // TODO(benh): Replace shared_ptr with unique_ptr.
 #include <stout/net.hpp>
@@ -1017,7 +1018,10 @@ void HttpProxy::handle(Future<Response>* future, const Request& request)
 {
   items.push(new Item(request, future));
 
-  if (items.size() == 1) {
+  // NOTE: If a response is being streamed the next one is processed
+  // once it is done (see HttpProxy::stream), otherwise a pipelined
+  // response could be sent in the middle of the stream.
+  if (items.size() == 1 && pipe.isNone()) {
     next();
   }
 }
@@ -2195,6 +2199,8 @@ void ProcessManager::resume(ProcessBase* process)
 
             virtual void visit(const MessageEvent& event)
             {
+              // Filters expect to see the serialized body.
+              event.message->encode();
               *filter = filterer->filter(event);
             }
 
@@ -2591,7 +2597,9 @@ Future<Response> ProcessManager::__processes__(const Request&)
           object.values["name"] = message.name;
           object.values["from"] = string(message.from);
           object.values["to"] = string(message.to);
-          object.values["body"] = message.body;
+          object.values["body"] = message.payload
+            ? message.payload->serialize()
+            : message.body;
 
           events->values.push_back(object);
         }
@@ -2738,17 +2746,48 @@ void ProcessBase::send(
 }
 
 
+void ProcessBase::send(
+    const UPID& to,
+    const string& name,
+    const memory::shared_ptr<const Payload>& payload)
+{
+  if (!to) {
+    return;
+  }
+
+  Message* message = encode(pid, to, name);
+  message->payload = payload;
+
+  // Only local messages can be delivered without serializing them.
+  if (message->to.node != __node__) {
+    message->encode();
+  }
+
+  transport(message, this);
+}
+
+
 void ProcessBase::visit(const MessageEvent& event)
 {
-  if (handlers.message.count(event.message->name) > 0) {
-    handlers.message[event.message->name](
-        event.message->from,
-        event.message->body);
-  } else if (delegates.count(event.message->name) > 0) {
+  // Message handlers (and delegates) need the serialized body.
+  event.message->encode();
+
+  hashmap<string, MessageHandler>::const_iterator handler =
+    handlers.message.find(event.message->name);
+
+  if (handler != handlers.message.end()) {
+    handler->second(event.message->from, event.message->body);
+    return;
+  }
+
+  hashmap<string, UPID>::const_iterator delegate =
+    delegates.find(event.message->name);
+
+  if (delegate != delegates.end()) {
     VLOG(1) << "Delegating message '" << event.message->name
-            << "' to " << delegates[event.message->name];
+            << "' to " << delegate->second;
     Message* message = new Message(*event.message);
-    message->to = delegates[event.message->name];
+    message->to = delegate->second;
     transport(message, this);
   }
 }
@@ -2774,7 +2813,10 @@ void ProcessBase::visit(const HttpEvent& event)
 
   const string& name = tokens.size() > 1 ? tokens[1] : "";
 
-  if (handlers.http.count(name) > 0) {
+  hashmap<string, HttpRequestHandler>::const_iterator handler =
+    handlers.http.find(name);
+
+  if (handler != handlers.http.end()) {
     // Create the promise to link with whatever gets returned, as well
     // as a future to wait for the response.
     memory::shared_ptr<Promise<Response> > promise(new Promise<Response>());
@@ -2788,7 +2830,7 @@ void ProcessBase::visit(const HttpEvent& event)
     dispatch(proxy, &HttpProxy::handle, future, *event.request);
 
     // Now call the handler and associate the response with the promise.
-    promise->associate(handlers.http[name](*event.request));
+    promise->associate(handler->second(*event.request));
   } else if (assets.count(name) > 0) {
     OK response;
     response.type = Response::PATH;
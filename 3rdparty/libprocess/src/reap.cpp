@@ -1,35 +1,46 @@
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
+#include <stout/utils.hpp>
 
 namespace process {
 
-
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
-//
-// Simple bounded linear model for computing the poll interval.
-// Values were chosen such that at (50 pids, 100 ms) the CPU usage is
-// less than approx. 0.5% of a single core, and at (500 pids, 1000 ms)
-// less than approx. 1.0% of single core. Tested on Linux 3.10 with
-// Intel Xeon E5620 and OSX 10.9 with Intel i7 4980HQ.
+// The reaper is notified of the termination of its children through
+// SIGCHLD, but the termination of a process that is not its child
+// can only be noticed by polling for its existence. The poll interval
+// follows a simple bounded linear model. Values were chosen such that
+// at (50 pids, 100 ms) the CPU usage is less than approx. 0.5% of a
+// single core, and at (500 pids, 1000 ms) less than approx. 1.0% of
+// single core. Tested on Linux 3.10 with Intel Xeon E5620 and OSX
+// 10.9 with Intel i7 4980HQ.
 //
 //              1000ms          _____
 //                             /
@@ -47,28 +58,215 @@ const size_t HIGH_PID_COUNT = 500;
 Duration MAX_REAP_INTERVAL() { return Seconds(1); }
 
 
+namespace internal {
+
+// The pipe the SIGCHLD handler writes to in order to wake up the
+// reaper, and the SIGCHLD disposition the handler replaced.
+static int sigchld[2] = { -1, -1 };
+static struct sigaction previous;
+
+
+static void handler(int signal, siginfo_t* info, void* context)
+{
+  int saved = errno;
+
+  // The pipe is non-blocking; if it is full a wake up is pending
+  // anyway.
+  char dummy = 0;
+  while (::write(sigchld[1], &dummy, sizeof(dummy)) == -1 &&
+         errno == EINTR);
+
+  errno = saved;
+
+  // Chain to the handler installed before ours, if any.
+  if ((previous.sa_flags & SA_SIGINFO) != 0) {
+    if (previous.sa_sigaction != NULL) {
+      previous.sa_sigaction(signal, info, context);
+    }
+  } else if (previous.sa_handler != SIG_DFL &&
+             previous.sa_handler != SIG_IGN) {
+    previous.sa_handler(signal);
+  }
+}
+
+
+// Installs the SIGCHLD handler and returns the read end of the pipe
+// it writes to.
+static Try<int> install()
+{
+  struct sigaction current;
+  if (::sigaction(SIGCHLD, NULL, &current) == -1) {
+    return ErrnoError("Failed to get the SIGCHLD disposition");
+  }
+
+  // If SIGCHLD is ignored the children are reaped by the kernel and
+  // installing a handler would change that for the application.
+  if ((current.sa_flags & SA_SIGINFO) == 0 &&
+      current.sa_handler == SIG_IGN) {
+    return Error("SIGCHLD is ignored");
+  }
+
+  if (::pipe(sigchld) == -1) {
+    return ErrnoError("Failed to create pipe");
+  }
+
+  os::cloexec(sigchld[0]);
+  os::cloexec(sigchld[1]);
+  os::nonblock(sigchld[0]);
+  os::nonblock(sigchld[1]);
+
+  previous = current;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = handler;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  // We only care about terminated children, so unless the previous
+  // handler wants to know about stopped children as well, neither
+  // do we.
+  if ((current.sa_flags & SA_SIGINFO) == 0 &&
+      current.sa_handler == SIG_DFL) {
+    action.sa_flags |= SA_NOCLDSTOP;
+  } else {
+    action.sa_flags |= (current.sa_flags & SA_NOCLDSTOP);
+  }
+
+  if (::sigaction(SIGCHLD, &action, NULL) == -1) {
+    ErrnoError error("Failed to install SIGCHLD handler");
+    os::close(sigchld[0]);
+    os::close(sigchld[1]);
+    return error;
+  }
+
+  return sigchld[0];
+}
+
+} // namespace internal {
+
+
 class ReaperProcess : public Process<ReaperProcess>
 {
 public:
-  ReaperProcess() : ProcessBase(ID::generate("reaper")) {}
+  ReaperProcess() : ProcessBase(ID::generate("reaper")), polling(false) {}
 
   Future<Option<int> > reap(pid_t pid)
   {
     // Check to see if this pid exists.
-    if (os::exists(pid)) {
-      Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
-      promises.put(pid, promise);
-      return promise->future();
-    } else {
+    if (!os::exists(pid)) {
       return None();
     }
+
+    Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
+    promises.put(pid, promise);
+
+    Future<Option<int> > future = promise->future();
+
+    // A process that can be waited on is our child, in which case we
+    // are notified of its termination through SIGCHLD. Otherwise it
+    // has to be polled for.
+    int status;
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result > 0) {
+      // The child had already terminated.
+      notify(pid, status);
+    } else if (result == 0 && fd.isSome()) {
+      children.insert(pid);
+    } else {
+      others.insert(pid);
+      poll();
+    }
+
+    return future;
   }
 
 protected:
-  virtual void initialize() { wait(); }
+  virtual void initialize()
+  {
+    Try<int> install = internal::install();
+    if (install.isError()) {
+      LOG(WARNING) << "Polling for the termination of all processes "
+                   << "because SIGCHLD can not be handled: "
+                   << install.error();
+      return;
+    }
+
+    fd = install.get();
+
+    io::poll(fd.get(), io::READ)
+      .onAny(defer(self(), &ReaperProcess::signaled, lambda::_1));
+  }
+
+  // Invoked when the SIGCHLD handler wrote to the pipe, i.e., after
+  // one or more of our children terminated.
+  void signaled(const Future<short>& future)
+  {
+    CHECK_SOME(fd);
+
+    if (!future.isReady()) {
+      LOG(ERROR) << "Failed to poll for SIGCHLD: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+    }
+
+    // Drain the pipe before reaping so that a SIGCHLD that arrives
+    // while reaping wakes us up again.
+    char buffer[64];
+    while (::read(fd.get(), buffer, sizeof(buffer)) > 0);
+
+    // Wait for the terminated children one at a time, for as long as
+    // they are ones we are monitoring. This makes the work done
+    // proportional to the number of terminations, rather than to the
+    // number of monitored children.
+    bool waited = false;
+    while (!children.empty()) {
+      siginfo_t info;
+      memset(&info, 0, sizeof(info));
+
+      // NOTE: WNOWAIT leaves the child waitable, so that the children
+      // we are not monitoring can still be waited on by someone else.
+      if (waitid(P_ALL, 0, &info, WEXITED | WNOHANG | WNOWAIT) == -1 ||
+          info.si_pid == 0) {
+        // If there was no terminated child to wait for at all, the
+        // child that terminated was already reaped by someone else
+        // and it might have been one we are monitoring.
+        if (!waited) {
+          scan();
+        }
+        break;
+      }
+
+      if (!children.contains(info.si_pid)) {
+        // A child we are not monitoring is blocking the way.
+        scan();
+        break;
+      }
+
+      check(info.si_pid);
+      waited = true;
+    }
+
+    io::poll(fd.get(), io::READ)
+      .onAny(defer(self(), &ReaperProcess::signaled, lambda::_1));
+  }
+
+  // Polls for the termination of the processes we are not notified
+  // about, i.e., the ones that are not our children (or all of them
+  // if SIGCHLD can not be handled).
+  void poll()
+  {
+    if (polling) {
+      return;
+    }
+
+    polling = true;
+    delay(interval(), self(), &ReaperProcess::_poll);
+  }
 
-  void wait()
+  void _poll()
   {
+    polling = false;
+
     // There are two cases to consider for each pid when it terminates:
     //   1) The process is our child. In this case, we will reap the process and
     //      notify with the exit status.
@@ -79,7 +277,7 @@ protected:
     // NOTE: A child can only be reaped by us, the parent. If a child exits
     // between waitpid and the (!exists) conditional it will still exist as a
     // zombie; it will be reaped by us on the next loop.
-    foreach (pid_t pid, promises.keys()) {
+    foreach (pid_t pid, utils::copy(others)) {
       int status;
       if (waitpid(pid, &status, WNOHANG) > 0) {
         // We have reaped a child.
@@ -90,7 +288,30 @@ protected:
       }
     }
 
-    delay(interval(), self(), &ReaperProcess::wait); // Reap forever!
+    if (!others.empty()) {
+      poll();
+    }
+  }
+
+  // Checks each of the monitored children.
+  void scan()
+  {
+    foreach (pid_t pid, utils::copy(children)) {
+      check(pid);
+    }
+  }
+
+  // Waits for the monitored child 'pid' if it has terminated.
+  void check(pid_t pid)
+  {
+    int status;
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result > 0) {
+      notify(pid, status);
+    } else if (result == -1) {
+      // The child was reaped by someone else.
+      notify(pid, None());
+    }
   }
 
   void notify(pid_t pid, Result<int> status)
@@ -105,12 +326,14 @@ protected:
       }
     }
     promises.remove(pid);
+    children.erase(pid);
+    others.erase(pid);
   }
 
 private:
   const Duration interval()
   {
-    size_t count = promises.size();
+    size_t count = others.size();
 
     if (count <= LOW_PID_COUNT) {
       return MIN_REAP_INTERVAL();
@@ -127,6 +350,17 @@ private:
   }
 
   multihashmap<pid_t, Owned<Promise<Option<int> > > > promises;
+
+  // The read end of the pipe the SIGCHLD handler writes to, if the
+  // handler could be installed.
+  Option<int> fd;
+
+  // The monitored pids we are notified about through SIGCHLD, and
+  // the ones we poll for.
+  hashset<pid_t> children;
+  hashset<pid_t> others;
+
+  bool polling;
 };
 
 
@@ -20,19 +20,38 @@
 
 #include <gmock/gmock.h>
 
+#include <google/protobuf/descriptor.pb.h>
+
 #include <iostream>
 #include <memory>
 #include <unordered_set>
 #include <vector>
 
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/protobuf.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/gtest.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 using namespace process;
 
+using google::protobuf::DescriptorProto;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::FileDescriptorProto;
+
 using std::cout;
 using std::endl;
 using std::function;
@@ -386,3 +405,542 @@ TEST(Process, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// Returns a message with a fair number of nested and repeated fields.
+static FileDescriptorProto createFileDescriptorProto(int types)
+{
+  FileDescriptorProto message;
+  message.set_name("benchmark.proto");
+  message.set_package("process.benchmark");
+
+  for (int i = 0; i < types; i++) {
+    DescriptorProto* type = message.add_message_type();
+    type->set_name("Message" + stringify(i));
+
+    for (int j = 0; j < 10; j++) {
+      FieldDescriptorProto* field = type->add_field();
+      field->set_name("field" + stringify(j));
+      field->set_number(j + 1);
+      field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+      field->set_type(FieldDescriptorProto::TYPE_STRING);
+      field->set_default_value(string(16, 'x'));
+    }
+  }
+
+  return message;
+}
+
+
+// Sends a protocol buffer to another process and, once it is echoed
+// back, sends it again. Messages are either handed over through
+// ProtobufProcess::send or serialized as for a remote process.
+class PingPongProcess : public ProtobufProcess<PingPongProcess>
+{
+public:
+  explicit PingPongProcess(bool _serialize)
+    : serialize(_serialize), remaining(0) {}
+
+  Future<Nothing> run(
+      const UPID& _that,
+      const FileDescriptorProto& message,
+      int iterations)
+  {
+    that = _that;
+    remaining = iterations;
+
+    transmit(that, message);
+
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<FileDescriptorProto>(&PingPongProcess::receive);
+  }
+
+private:
+  void receive(const UPID& from, const FileDescriptorProto& message)
+  {
+    if (from != that) {
+      // Echo the message back.
+      transmit(from, message);
+    } else if (--remaining > 0) {
+      transmit(that, message);
+    } else {
+      promise.set(Nothing());
+    }
+  }
+
+  void transmit(const UPID& to, const FileDescriptorProto& message)
+  {
+    if (serialize) {
+      string data;
+      message.SerializeToString(&data);
+      send(to, message.GetTypeName(), data.data(), data.size());
+    } else {
+      send(to, message);
+    }
+  }
+
+  const bool serialize;
+
+  UPID that;
+  int remaining;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the round trip of protocol buffers between processes in
+// the same OS process, with and without serializing them.
+TEST(Process, Process_BENCHMARK_LocalProtobufMessages)
+{
+  const int iterations = 10000;
+
+  const FileDescriptorProto message = createFileDescriptorProto(20);
+
+  foreach (bool serialize, vector<bool>({true, false})) {
+    PingPongProcess ping(serialize);
+    PingPongProcess pong(serialize);
+
+    spawn(ping);
+    spawn(pong);
+
+    Stopwatch watch;
+    watch.start();
+
+    Future<Nothing> done = dispatch(
+        ping, &PingPongProcess::run, pong.self(), message, iterations);
+
+    AWAIT_READY_FOR(done, Minutes(5));
+
+    cout << "Round trips of a " << message.ByteSize() << " byte message "
+         << (serialize ? "serialized" : "handed over") << ": "
+         << iterations << " in " << watch.elapsed() << endl;
+
+    terminate(ping);
+    terminate(pong);
+    wait(ping);
+    wait(pong);
+  }
+}
+
+
+// Receives FileDescriptorProtos, passing the message types to the
+// handler either as a 'std::vector<DescriptorProto>' or as the
+// repeated field itself.
+template <typename Types>
+class DecodeProcess : public ProtobufProcess<DecodeProcess<Types> >
+{
+public:
+  explicit DecodeProcess(int _remaining) : remaining(_remaining) {}
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    ProtobufProcess<DecodeProcess<Types> >::template
+      install<FileDescriptorProto>(
+          &DecodeProcess::receive,
+          &FileDescriptorProto::message_type);
+  }
+
+private:
+  void receive(const Types& types)
+  {
+    if (--remaining == 0) {
+      promise.set(Nothing());
+    }
+  }
+
+  int remaining;
+  Promise<Nothing> promise;
+};
+
+
+template <typename Types>
+static void decode(const string& description, const string& data)
+{
+  const int iterations = 1000;
+
+  DecodeProcess<Types> process(iterations);
+
+  spawn(process);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    post(process.self(), FileDescriptorProto().GetTypeName(),
+         data.data(), data.size());
+  }
+
+  AWAIT_READY_FOR(process.done(), Minutes(5));
+
+  cout << "Decoded " << iterations << " " << data.size() << " byte messages "
+       << description << " in " << watch.elapsed() << endl;
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Measures decoding protocol buffers received from a remote sender
+// for handlers that take a repeated field as a std::vector and as a
+// RepeatedPtrField.
+TEST(Process, Process_BENCHMARK_ProtobufDecoding)
+{
+  string data;
+  createFileDescriptorProto(200).SerializeToString(&data);
+
+  decode<vector<DescriptorProto> >("into a vector", data);
+  decode<google::protobuf::RepeatedPtrField<DescriptorProto> >(
+      "into a repeated field", data);
+}
+
+
+static int increment(int i)
+{
+  return i + 1;
+}
+
+
+static void ignore(const Future<int>&) {}
+
+
+// Measures the cost of the future machinery alone: creating promises,
+// registering callbacks on their futures and completing them.
+TEST(Future, Future_BENCHMARK_Callbacks)
+{
+  const int iterations = 1000000;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    Promise<int> promise;
+    promise.future().onAny(lambda::bind(&ignore, lambda::_1));
+    promise.set(i);
+  }
+
+  cout << "Completed " << iterations << " futures with a callback in "
+       << watch.elapsed() << endl;
+
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    Promise<int> promise;
+    Future<int> future =
+      promise.future().then(lambda::bind(&increment, lambda::_1));
+    promise.set(i);
+    CHECK_EQ(i + 1, future.get());
+  }
+
+  cout << "Completed " << iterations << " futures with a continuation in "
+       << watch.elapsed() << endl;
+}
+
+
+class IncrementProcess : public Process<IncrementProcess>
+{
+public:
+  IncrementProcess() : value(0) {}
+
+  int increment()
+  {
+    return ++value;
+  }
+
+  int add(int i)
+  {
+    return i + 1;
+  }
+
+private:
+  int value;
+};
+
+
+// Measures round trips of a dispatch and the future it returns,
+// first on their own and then as continuations deferred to a process.
+TEST(Process, Process_BENCHMARK_DispatchFutures)
+{
+  const int iterations = 100000;
+
+  IncrementProcess process;
+  spawn(process);
+
+  Stopwatch watch;
+  watch.start();
+
+  Future<int> future;
+  for (int i = 0; i < iterations; i++) {
+    future = dispatch(process, &IncrementProcess::increment);
+  }
+
+  AWAIT_EXPECT_EQ(iterations, future);
+
+  cout << "Dispatched " << iterations << " methods returning a future in "
+       << watch.elapsed() << endl;
+
+  watch.start();
+
+  Promise<int> promise;
+  future = promise.future();
+  for (int i = 0; i < iterations / 10; i++) {
+    future = future.then(
+        defer(process, &IncrementProcess::add, lambda::_1));
+  }
+
+  promise.set(0);
+
+  AWAIT_EXPECT_EQ(iterations / 10, future);
+
+  cout << "Completed a chain of " << iterations / 10 << " deferred "
+       << "continuations in " << watch.elapsed() << endl;
+
+  terminate(process);
+  wait(process);
+}
+
+
+class HandlersProcess : public Process<HandlersProcess>
+{
+public:
+  HandlersProcess(const vector<string>& _names, int _remaining)
+    : names(_names), remaining(_remaining) {}
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    foreach (const string& name, names) {
+      install(name, &HandlersProcess::handle);
+    }
+  }
+
+private:
+  void handle(const UPID& from, const string& body)
+  {
+    if (--remaining == 0) {
+      promise.set(Nothing());
+    }
+  }
+
+  const vector<string> names;
+  int remaining;
+  Promise<Nothing> promise;
+};
+
+
+// Measures delivering messages to a process with as many message
+// handlers as the master installs.
+TEST(Process, Process_BENCHMARK_MessageHandlers)
+{
+  const int iterations = 1000000;
+
+  vector<string> names;
+  for (int i = 0; i < 60; i++) {
+    names.push_back("mesos.internal.Message" + stringify(i));
+  }
+
+  HandlersProcess process(names, iterations);
+  spawn(process);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    post(process.self(), names[i % names.size()]);
+  }
+
+  AWAIT_READY_FOR(process.done(), Minutes(5));
+
+  cout << "Delivered " << iterations << " messages to one of "
+       << names.size() << " handlers in " << watch.elapsed() << endl;
+
+  terminate(process);
+  wait(process);
+}
+
+
+class PingProcess : public Process<PingProcess>
+{
+public:
+  PingProcess()
+  {
+    route("/ping", None(), &PingProcess::ping);
+  }
+
+private:
+  Future<http::Response> ping(const http::Request& request)
+  {
+    return http::OK("pong");
+  }
+};
+
+
+// Measures the throughput of HTTP requests to a local process, with
+// up to 'concurrency' requests outstanding at a time, first opening a
+// connection per request and then over the pooled, keep-alive
+// connections of an http::Client.
+TEST(HTTP, HTTP_BENCHMARK_Requests)
+{
+  const size_t requests = 5000;
+  const size_t concurrency = 50;
+
+  PingProcess process;
+  spawn(process);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < requests; i += concurrency) {
+    vector<Future<http::Response> > futures;
+    for (size_t j = 0; j < concurrency; j++) {
+      futures.push_back(http::get(process.self(), "ping"));
+    }
+
+    foreach (const Future<http::Response>& future, futures) {
+      AWAIT_EXPECT_RESPONSE_BODY_EQ("pong", future);
+    }
+  }
+
+  cout << "Completed " << requests << " requests with a connection per "
+       << "request in " << watch.elapsed() << endl;
+
+  foreach (size_t connections, vector<size_t>({1, 4, 16})) {
+    http::Client client(connections);
+
+    watch.start();
+
+    for (size_t i = 0; i < requests; i += concurrency) {
+      vector<Future<http::Response> > futures;
+      for (size_t j = 0; j < concurrency; j++) {
+        futures.push_back(client.get(process.self(), "ping"));
+      }
+
+      foreach (const Future<http::Response>& future, futures) {
+        AWAIT_EXPECT_RESPONSE_BODY_EQ("pong", future);
+      }
+    }
+
+    cout << "Completed " << requests << " requests over " << connections
+         << " keep-alive connection(s) in " << watch.elapsed() << endl;
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
+class FileWriterProcess : public Process<FileWriterProcess>
+{
+public:
+  FileWriterProcess(int _fd, const string& _data, int _iterations)
+    : fd(_fd), data(_data), iterations(_iterations) {}
+
+  // Writes and syncs the data 'iterations' times, either directly on
+  // this process or through io::pwrite and io::fsync. Returns the
+  // time this process was blocked doing so.
+  Future<Duration> run(bool _blocking)
+  {
+    blocking = _blocking;
+    remaining = iterations;
+    blocked = Duration::zero();
+    promise.reset(new Promise<Duration>());
+
+    next();
+
+    return promise->future();
+  }
+
+private:
+  void next()
+  {
+    if (remaining == 0) {
+      promise->set(blocked);
+      return;
+    }
+
+    const off_t offset = (iterations - remaining--) * data.size();
+
+    Stopwatch watch;
+    watch.start();
+
+    if (blocking) {
+      CHECK_EQ((ssize_t) data.size(),
+               ::pwrite(fd, data.data(), data.size(), offset));
+      CHECK_EQ(0, ::fsync(fd));
+
+      dispatch(self(), &FileWriterProcess::next);
+    } else {
+      io::pwrite(fd, data.data(), data.size(), offset)
+        .then(lambda::bind(&io::fsync, fd))
+        .onAny(defer(self(), &FileWriterProcess::next));
+    }
+
+    blocked += watch.elapsed();
+  }
+
+  const int fd;
+  const string data;
+  const int iterations;
+
+  bool blocking;
+  int remaining;
+  Duration blocked;
+  Owned<Promise<Duration> > promise;
+};
+
+
+// Measures how long a process is blocked (i.e., holds on to one of
+// the threads running all processes) writing and syncing a file,
+// when doing so directly and through the io::pwrite and io::fsync
+// primitives.
+TEST(IO, IO_BENCHMARK_BlockingFileIO)
+{
+  const int iterations = 100;
+  const string data(Megabytes(1).bytes(), 'x');
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  Try<int> fd = os::open(path.get(), O_WRONLY | O_CLOEXEC);
+  ASSERT_SOME(fd);
+
+  FileWriterProcess process(fd.get(), data, iterations);
+  spawn(process);
+
+  Stopwatch watch;
+
+  foreach (bool blocking, vector<bool>({true, false})) {
+    watch.start();
+
+    Future<Duration> blocked =
+      dispatch(process, &FileWriterProcess::run, blocking);
+
+    AWAIT_READY_FOR(blocked, Minutes(5));
+
+    cout << "Wrote and synced " << iterations << " x "
+         << Bytes(data.size()) << " "
+         << (blocking ? "directly" : "through io::pwrite and io::fsync")
+         << " in " << watch.elapsed() << ", blocking the process for "
+         << blocked.get() << endl;
+  }
+
+  terminate(process);
+  wait(process);
+
+  ASSERT_SOME(os::close(fd.get()));
+  ASSERT_SOME(os::rm(path.get()));
+}
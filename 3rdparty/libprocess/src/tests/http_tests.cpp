@@ -353,3 +353,82 @@ TEST(HTTP, Post)
   terminate(process);
   wait(process);
 }
+
+
+http::Response validateKeepAlive(const http::Request& request)
+{
+  EXPECT_TRUE(request.keepAlive);
+
+  return http::OK(request.method);
+}
+
+
+TEST(HTTP, Client)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  // Use a single connection so that the requests are pipelined.
+  http::Client client(1);
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.pipe = pipes[0];
+
+  Future<Nothing> pipe;
+  EXPECT_CALL(process, pipe(_))
+    .WillOnce(DoAll(FutureSatisfy(&pipe),
+                    Return(ok)));
+
+  EXPECT_CALL(process, get(_))
+    .WillOnce(Invoke(validateKeepAlive));
+
+  EXPECT_CALL(process, post(_))
+    .WillOnce(Invoke(validateKeepAlive));
+
+  Future<http::Response> future1 = client.get(process.self(), "pipe");
+  Future<http::Response> future2 = client.get(process.self(), "get");
+  Future<http::Response> future3 =
+    client.post(process.self(), "post", None(), "body", "text/plain");
+
+  AWAIT_READY(pipe);
+
+  // The responses are returned in order, so the ones pipelined behind
+  // the streamed response can not be ready before it is.
+  EXPECT_TRUE(future2.isPending());
+  EXPECT_TRUE(future3.isPending());
+
+  ASSERT_SOME(os::write(pipes[1], "Hello World\n"));
+  ASSERT_SOME(os::close(pipes[1]));
+
+  AWAIT_READY(future1);
+  EXPECT_EQ(http::statuses[200], future1.get().status);
+  EXPECT_SOME_EQ("chunked", future1.get().headers.get("Transfer-Encoding"));
+  EXPECT_EQ("Hello World\n", future1.get().body);
+
+  AWAIT_READY(future2);
+  EXPECT_EQ(http::statuses[200], future2.get().status);
+  EXPECT_EQ("GET", future2.get().body);
+
+  AWAIT_READY(future3);
+  EXPECT_EQ(http::statuses[200], future3.get().status);
+  EXPECT_EQ("POST", future3.get().body);
+
+  // The connection is reused by subsequent requests.
+  EXPECT_CALL(process, get(_))
+    .WillOnce(Invoke(validateKeepAlive));
+
+  Future<http::Response> future4 = client.get(process.self(), "get");
+
+  AWAIT_READY(future4);
+  EXPECT_EQ("GET", future4.get().body);
+
+  terminate(process);
+  wait(process);
+}
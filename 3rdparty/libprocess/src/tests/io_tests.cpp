@@ -346,3 +346,47 @@ TEST(IO, redirect)
   ASSERT_SOME(read);
   EXPECT_EQ(data, read.get());
 }
+
+
+TEST(IO, BlockingFileIO)
+{
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  Try<int> fd = os::open(
+      path.get(),
+      O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+
+  const string data = "Hello World!";
+
+  // Write the data at an offset, leaving a hole at the start.
+  AWAIT_EXPECT_EQ(
+      data.size(),
+      io::pwrite(fd.get(), data.data(), data.size(), 10));
+
+  AWAIT_READY(io::fsync(fd.get()));
+
+  char buffer[64];
+
+  AWAIT_EXPECT_EQ(
+      data.size(),
+      io::pread(fd.get(), buffer, sizeof(buffer), 10));
+
+  EXPECT_EQ(data, string(buffer, data.size()));
+
+  // Reading at the end of the file returns zero.
+  AWAIT_EXPECT_EQ(
+      0u,
+      io::pread(fd.get(), buffer, sizeof(buffer), 10 + data.size()));
+
+  ASSERT_SOME(os::close(fd.get()));
+  ASSERT_SOME(os::rm(path.get()));
+
+  // The operations fail on an invalid file descriptor.
+  AWAIT_EXPECT_FAILED(io::pread(-1, buffer, sizeof(buffer), 0));
+  AWAIT_EXPECT_FAILED(io::pwrite(-1, data.data(), data.size(), 0));
+  AWAIT_EXPECT_FAILED(io::fsync(-1));
+}
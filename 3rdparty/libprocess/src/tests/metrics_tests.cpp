@@ -408,6 +408,24 @@ TEST(Metrics, Timer)
 }
 
 
+TEST(Metrics, TimerRecord)
+{
+  metrics::Timer<Milliseconds> timer("test/timer");
+  EXPECT_EQ("test/timer_ms", timer.name());
+
+  AWAIT_READY(metrics::add(timer));
+
+  // Record an event timed elsewhere.
+  timer.record(Seconds(2));
+
+  Future<double> value = timer.value();
+  AWAIT_READY(value);
+  EXPECT_FLOAT_EQ(value.get(), Seconds(2).ms());
+
+  AWAIT_READY(metrics::remove(timer));
+}
+
+
 static Future<int> advanceAndReturn()
 {
   Clock::advance(Seconds(1));
@@ -5,7 +5,10 @@
 
 #include <gtest/gtest.h>
 
+#include <list>
+
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -15,6 +18,7 @@
 #include <stout/gtest.hpp>
 #include <stout/os/fork.hpp>
 #include <stout/os/pstree.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 using namespace process;
@@ -23,6 +27,8 @@ using os::Exec;
 using os::Fork;
 using os::ProcessTree;
 
+using std::list;
+
 using testing::_;
 using testing::DoDefault;
 
@@ -177,3 +183,54 @@ TEST(Reap, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+// This test checks that the reaper is notified of the termination of
+// its children as they happen, rather than by polling for them (which
+// would not happen while the clock is paused).
+TEST(Reap, ChildProcessLatency)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  Clock::pause();
+
+  const size_t count = 10;
+
+  list<pid_t> children;
+  list<Future<Option<int> > > statuses;
+
+  for (size_t i = 0; i < count; i++) {
+    // The child process sleeps and will be killed by the parent.
+    Try<ProcessTree> tree = Fork(None(),
+                                 Exec("sleep 10"))();
+
+    ASSERT_SOME(tree);
+    pid_t child = tree.get();
+
+    children.push_back(child);
+    statuses.push_back(process::reap(child));
+  }
+
+  // Ensure the reaper is monitoring all the children.
+  Clock::settle();
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  foreach (pid_t child, children) {
+    EXPECT_EQ(0, kill(child, SIGKILL));
+  }
+
+  AWAIT_READY(collect(statuses));
+
+  LOG(INFO) << "Reaped " << count << " children in " << stopwatch.elapsed();
+
+  foreach (const Future<Option<int> >& status, statuses) {
+    ASSERT_SOME(status.get());
+    int status_ = status.get().get();
+    ASSERT_TRUE(WIFSIGNALED(status_));
+    ASSERT_EQ(SIGKILL, WTERMSIG(status_));
+  }
+
+  Clock::resume();
+}
@@ -16,11 +16,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <iterator>
+#include <list>
 #include <string>
 #include <vector>
 
 #include <glog/logging.h>
 
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
@@ -28,9 +32,14 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/cache.hpp>
 #include <stout/check.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/try.hpp>
 
@@ -42,176 +51,410 @@ using process::Future;
 using process::Owned;
 using process::dispatch;
 
+using std::list;
 using std::string;
 using std::vector;
 
 namespace mesos {
 
-class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
-{
-public:
-  LocalAuthorizerProcess(const ACLs& _acls)
-    : ProcessBase(process::ID::generate("authorizer")), acls(_acls) {}
+// Maximum number of decisions cached by the LocalAuthorizer.
+static const size_t MAX_CACHED_DECISIONS = 10000;
 
-  Future<bool> authorize(const ACL::RegisterFramework& request)
+
+// An ACL entity with its values hashed.
+struct Entity
+{
+  explicit Entity(const ACL::Entity& entity) : type(entity.type())
   {
-    foreach (const ACL::RegisterFramework& acl, acls.register_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.roles(), acl.roles())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.roles(), acl.roles());
+    foreach (const string& value, entity.values()) {
+      values.insert(value);
+    }
+  }
+
+  ACL::Entity::Type type;
+  hashset<string> values;
+};
+
+
+// Match matrix:
+//
+//                  -----------ACL----------
+//
+//                    SOME    NONE    ANY
+//          -------|-------|-------|-------
+//  |        SOME  | Yes/No|  Yes  |   Yes
+//  |       -------|-------|-------|-------
+// Request   NONE  |  No   |  Yes  |   No
+//  |       -------|-------|-------|-------
+//  |        ANY   |  No   |  Yes  |   Yes
+//          -------|-------|-------|-------
+static bool matches(const ACL::Entity& request, const Entity& acl)
+{
+  // NONE only matches with NONE.
+  if (request.type() == ACL::Entity::NONE) {
+    return acl.type == ACL::Entity::NONE;
+  }
+
+  // ANY matches with ANY or NONE.
+  if (request.type() == ACL::Entity::ANY) {
+    return acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE;
+  }
+
+  if (request.type() == ACL::Entity::SOME) {
+    // SOME matches with ANY or NONE.
+    if (acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE) {
+      return true;
+    }
+
+    // SOME is allowed if the request values are a subset of ACL
+    // values.
+    foreach (const string& value, request.values()) {
+      if (!acl.values.contains(value)) {
+        return false;
       }
     }
+    return true;
+  }
+
+  return false;
+}
+
 
-    return acls.permissive(); // None of the ACLs match.
+// Allow matrix:
+//
+//                 -----------ACL----------
+//
+//                    SOME    NONE    ANY
+//          -------|-------|-------|-------
+//  |        SOME  | Yes/No|  No   |   Yes
+//  |       -------|-------|-------|-------
+// Request   NONE  |  No   |  Yes  |   No
+//  |       -------|-------|-------|-------
+//  |        ANY   |  No   |  No   |   Yes
+//          -------|-------|-------|-------
+static bool allows(const ACL::Entity& request, const Entity& acl)
+{
+  // NONE is only allowed by NONE.
+  if (request.type() == ACL::Entity::NONE) {
+    return acl.type == ACL::Entity::NONE;
   }
 
-  Future<bool> authorize(const ACL::RunTask& request)
-  {
-    foreach (const ACL::RunTask& acl, acls.run_tasks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.users(), acl.users())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.users(), acl.users());
+  // ANY is only allowed by ANY.
+  if (request.type() == ACL::Entity::ANY) {
+    return acl.type == ACL::Entity::ANY;
+  }
+
+  if (request.type() == ACL::Entity::SOME) {
+    // SOME is allowed by ANY.
+    if (acl.type == ACL::Entity::ANY) {
+      return true;
+    }
+
+    // SOME is not allowed by NONE.
+    if (acl.type == ACL::Entity::NONE) {
+      return false;
+    }
+
+    // SOME is allowed if the request values are a subset of ACL
+    // values.
+    foreach (const string& value, request.values()) {
+      if (!acl.values.contains(value)) {
+        return false;
       }
     }
+    return true;
+  }
+
+  return false;
+}
+
 
-    return acls.permissive(); // None of the ACLs match.
+// The ACLs of one kind (e.g., 'run_tasks') in their original order,
+// indexed by the values of their subjects and of their objects. The
+// first ACL that matches a request decides it, hence instead of
+// scanning all the ACLs we only check the ones that can match the
+// request according to the smaller of the two indexes.
+class Rules
+{
+public:
+  void add(const ACL::Entity& subject, const ACL::Entity& object)
+  {
+    index(&subjects, rules.size(), subject);
+    index(&objects, rules.size(), object);
+
+    rules.push_back(Rule(subject, object));
   }
 
-  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  // Returns whether the first ACL that matches the request allows
+  // it, or none if no ACL matches the request.
+  Option<bool> authorize(
+      const ACL::Entity& subject,
+      const ACL::Entity& object) const
   {
-    foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.framework_principals(),
-                  acl.framework_principals())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.framework_principals(),
-                      acl.framework_principals());
+    Option<vector<size_t> > candidates = this->candidates(subjects, subject);
+    Option<vector<size_t> > candidates_ = this->candidates(objects, object);
+
+    if (candidates.isNone() ||
+        (candidates_.isSome() &&
+         candidates_.get().size() < candidates.get().size())) {
+      candidates = candidates_;
+    }
+
+    if (candidates.isSome()) {
+      foreach (size_t i, candidates.get()) {
+        if (matches(subject, rules[i].subject) &&
+            matches(object, rules[i].object)) {
+          return decide(subject, object, rules[i]);
+        }
+      }
+    } else {
+      foreach (const Rule& rule, rules) {
+        if (matches(subject, rule.subject) && matches(object, rule.object)) {
+          return decide(subject, object, rule);
+        }
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
+    return None();
   }
 
 private:
-  // Match matrix:
-  //
-  //                  -----------ACL----------
-  //
-  //                    SOME    NONE    ANY
-  //          -------|-------|-------|-------
-  //  |        SOME  | Yes/No|  Yes  |   Yes
-  //  |       -------|-------|-------|-------
-  // Request   NONE  |  No   |  Yes  |   No
-  //  |       -------|-------|-------|-------
-  //  |        ANY   |  No   |  Yes  |   Yes
-  //          -------|-------|-------|-------
-  bool matches(const ACL::Entity& request, const ACL::Entity& acl)
+  struct Rule
   {
-    // NONE only matches with NONE.
-    if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
-    }
+    Rule(const ACL::Entity& _subject, const ACL::Entity& _object)
+      : subject(_subject), object(_object) {}
 
-    // ANY matches with ANY or NONE.
-    if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE;
-    }
+    Entity subject;
+    Entity object;
+  };
 
-    if (request.type() == ACL::Entity::SOME) {
-      // SOME matches with ANY or NONE.
-      if (acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE) {
-        return true;
-      }
+  // Positions of the ACLs by the values of one of their entities.
+  struct Index
+  {
+    // ACLs whose entity is of type SOME, by each of its values.
+    hashmap<string, vector<size_t> > values;
 
-      // SOME is allowed if the request values are a subset of ACL
-      // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
+    // ACLs whose entity is of type ANY or NONE.
+    vector<size_t> wildcards;
+  };
 
-        if (!found) {
-          return false;
+  static void index(Index* index, size_t i, const ACL::Entity& entity)
+  {
+    if (entity.type() == ACL::Entity::SOME) {
+      foreach (const string& value, entity.values()) {
+        vector<size_t>& positions = index->values[value];
+
+        // Skip duplicate values.
+        if (positions.empty() || positions.back() != i) {
+          positions.push_back(i);
         }
       }
-      return true;
+    } else {
+      index->wildcards.push_back(i);
+    }
+  }
+
+  // Returns the positions (in increasing order) of the ACLs that can
+  // match the request entity, or none if any ACL can match it.
+  static Option<vector<size_t> > candidates(
+      const Index& index,
+      const ACL::Entity& request)
+  {
+    // Only the ACLs with ANY or NONE match a request with ANY or
+    // NONE. A request with SOME values only matches the ACLs which
+    // contain all the values, in particular the first one (or with
+    // ANY or NONE). A request with SOME but without values matches
+    // any ACL.
+    if (request.type() == ACL::Entity::SOME && request.values_size() == 0) {
+      return None();
+    }
+
+    if (request.type() != ACL::Entity::SOME ||
+        !index.values.contains(request.values(0))) {
+      return index.wildcards;
     }
 
-    return false;
+    const vector<size_t>& values =
+      index.values.find(request.values(0))->second;
+
+    vector<size_t> candidates;
+    candidates.reserve(values.size() + index.wildcards.size());
+
+    std::merge(
+        values.begin(),
+        values.end(),
+        index.wildcards.begin(),
+        index.wildcards.end(),
+        std::back_inserter(candidates));
+
+    return candidates;
+  }
+
+  static bool decide(
+      const ACL::Entity& subject,
+      const ACL::Entity& object,
+      const Rule& rule)
+  {
+    // ACL is allowed if both subjects and objects are allowed.
+    return allows(subject, rule.subject) && allows(object, rule.object);
   }
 
-  // Allow matrix:
-  //
-  //                 -----------ACL----------
-  //
-  //                    SOME    NONE    ANY
-  //          -------|-------|-------|-------
-  //  |        SOME  | Yes/No|  No   |   Yes
-  //  |       -------|-------|-------|-------
-  // Request   NONE  |  No   |  Yes  |   No
-  //  |       -------|-------|-------|-------
-  //  |        ANY   |  No   |  No   |   Yes
-  //          -------|-------|-------|-------
-  bool allows(const ACL::Entity& request, const ACL::Entity& acl)
+  vector<Rule> rules;
+
+  Index subjects;
+  Index objects;
+};
+
+
+class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
+{
+public:
+  LocalAuthorizerProcess(const ACLs& _acls)
+    : ProcessBase(process::ID::generate("authorizer")),
+      acls(_acls),
+      decisions(MAX_CACHED_DECISIONS)
   {
-    // NONE is only allowed by NONE.
-    if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
+    foreach (const ACL::RegisterFramework& acl, acls.register_frameworks()) {
+      registerFrameworks.add(acl.principals(), acl.roles());
     }
 
-    // ANY is only allowed by ANY.
-    if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY;
+    foreach (const ACL::RunTask& acl, acls.run_tasks()) {
+      runTasks.add(acl.principals(), acl.users());
     }
 
-    if (request.type() == ACL::Entity::SOME) {
-      // SOME is allowed by ANY.
-      if (acl.type() == ACL::Entity::ANY) {
-        return true;
-      }
+    foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
+      shutdownFrameworks.add(acl.principals(), acl.framework_principals());
+    }
+  }
 
-      // SOME is not allowed by NONE.
-      if (acl.type() == ACL::Entity::NONE) {
-        return false;
-      }
+  Future<bool> authorize(const ACL::RegisterFramework& request)
+  {
+    return _authorize(request);
+  }
 
-      // SOME is allowed if the request values are a subset of ACL
-      // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
+  Future<bool> authorize(const ACL::RunTask& request)
+  {
+    return _authorize(request);
+  }
 
-        if (!found) {
-          return false;
-        }
-      }
-      return true;
+  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  {
+    return _authorize(request);
+  }
+
+  Future<list<bool> > authorize(const list<ACL::RunTask>& requests)
+  {
+    list<bool> results;
+    foreach (const ACL::RunTask& request, requests) {
+      results.push_back(_authorize(request));
+    }
+
+    return results;
+  }
+
+private:
+  bool _authorize(const ACL::RegisterFramework& request)
+  {
+    return decide(
+        "register_frameworks",
+        request,
+        registerFrameworks,
+        request.principals(),
+        request.roles());
+  }
+
+  bool _authorize(const ACL::RunTask& request)
+  {
+    return decide(
+        "run_tasks",
+        request,
+        runTasks,
+        request.principals(),
+        request.users());
+  }
+
+  bool _authorize(const ACL::ShutdownFramework& request)
+  {
+    return decide(
+        "shutdown_frameworks",
+        request,
+        shutdownFrameworks,
+        request.principals(),
+        request.framework_principals());
+  }
+
+  // Returns the cached decision for the request if there is one,
+  // otherwise decides the request and caches the decision. Since the
+  // ACLs never change, cached decisions never need to be invalidated.
+  bool decide(
+      const string& action,
+      const google::protobuf::Message& request,
+      const Rules& rules,
+      const ACL::Entity& subject,
+      const ACL::Entity& object)
+  {
+    const string key = action + ":" + request.SerializeAsString();
+
+    Option<bool> decision = decisions.get(key);
+    if (decision.isSome()) {
+      ++metrics.cache_hits;
+      return decision.get();
+    }
+
+    ++metrics.cache_misses;
+
+    decision = rules.authorize(subject, object);
+    if (decision.isNone()) {
+      decision = acls.permissive(); // None of the ACLs match.
     }
 
-    return false;
+    decisions.put(key, decision.get());
+
+    return decision.get();
   }
 
   ACLs acls;
+
+  Rules registerFrameworks;
+  Rules runTasks;
+  Rules shutdownFrameworks;
+
+  // Cached decisions keyed by the action and the serialized request.
+  Cache<string, bool> decisions;
+
+  struct Metrics
+  {
+    Metrics()
+      : cache_hits("authorizer/cache_hits"),
+        cache_misses("authorizer/cache_misses")
+    {
+      process::metrics::add(cache_hits);
+      process::metrics::add(cache_misses);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(cache_hits);
+      process::metrics::remove(cache_misses);
+    }
+
+    process::metrics::Counter cache_hits;
+    process::metrics::Counter cache_misses;
+  } metrics;
 };
 
 
+Future<list<bool> > Authorizer::authorize(const list<ACL::RunTask>& requests)
+{
+  list<Future<bool> > futures;
+  foreach (const ACL::RunTask& request, requests) {
+    futures.push_back(authorize(request));
+  }
+
+  return process::collect(futures);
+}
+
+
 Try<Owned<Authorizer> > Authorizer::create(const ACLs& acls)
 {
   Try<Owned<LocalAuthorizer> > authorizer = LocalAuthorizer::create(acls);
@@ -277,4 +520,16 @@ Future<bool> LocalAuthorizer::authorize(const ACL::ShutdownFramework& request)
       process, static_cast<F>(&LocalAuthorizerProcess::authorize), request);
 }
 
+
+Future<list<bool> > LocalAuthorizer::authorize(
+    const list<ACL::RunTask>& requests)
+{
+  // Necessary to disambiguate.
+  typedef Future<list<bool> >(LocalAuthorizerProcess::*F)(
+      const list<ACL::RunTask>&);
+
+  return dispatch(
+      process, static_cast<F>(&LocalAuthorizerProcess::authorize), requests);
+}
+
 } // namespace mesos {
@@ -19,6 +19,8 @@
 #ifndef __AUTHORIZER_AUTHORIZER_HPP__
 #define __AUTHORIZER_AUTHORIZER_HPP__
 
+#include <list>
+
 #include <glog/logging.h>
 
 #include <process/future.hpp>
@@ -54,6 +56,13 @@ public:
   virtual process::Future<bool> authorize(
       const ACL::ShutdownFramework& request) = 0;
 
+  // Authorizes a batch of requests, returning the results in the
+  // same order. A failed future indicates a transient failure of any
+  // of the requests. The default implementation authorizes each
+  // request on its own.
+  virtual process::Future<std::list<bool> > authorize(
+      const std::list<ACL::RunTask>& requests);
+
 protected:
   Authorizer() {}
 };
@@ -74,6 +83,8 @@ public:
       const ACL::RunTask& request);
   virtual process::Future<bool> authorize(
       const ACL::ShutdownFramework& request);
+  virtual process::Future<std::list<bool> > authorize(
+      const std::list<ACL::RunTask>& requests);
 
 private:
   LocalAuthorizer(const ACLs& acls);
@@ -0,0 +1,1474 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <deque>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_array.hpp>
+
+#include <process/clock.hpp>
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/memory.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/unreachable.hpp>
+
+#include "docker/remote.hpp"
+
+#ifdef __linux__
+#include "linux/cgroups.hpp"
+#endif // __linux__
+
+#include "slave/containerizer/isolators/cgroups/cpushare.hpp"
+#include "slave/containerizer/isolators/cgroups/mem.hpp"
+
+using namespace mesos;
+
+using namespace mesos::slave;
+
+using namespace process;
+
+using std::deque;
+using std::list;
+using std::map;
+using std::string;
+using std::vector;
+
+
+const string DOCKER_API_VERSION = "v1.15";
+
+const Duration DOCKER_LOGS_FLUSH_DELAY = Seconds(10);
+
+
+// A response from the Docker daemon.
+struct ApiResponse
+{
+  ApiResponse(int _code, const string& _body) : code(_code), body(_body) {}
+
+  int code;
+  string body;
+};
+
+
+// Incremental decoder for the HTTP/1.1 responses sent by the Docker
+// daemon. Handles 'Content-Length', chunked and read-until-close
+// bodies which covers everything the daemon sends. Responses can be
+// pipelined, i.e., a single call to 'decode' may complete more than
+// one response.
+class ApiResponseDecoder
+{
+public:
+  ApiResponseDecoder() : state(STATUS_LINE), code(0), remaining(0) {}
+
+  Try<deque<ApiResponse> > decode(const char* data, size_t length);
+
+  // Completes a response whose body is delimited by the connection
+  // being closed (i.e., neither 'Content-Length' nor chunked).
+  Option<ApiResponse> eof();
+
+  // Returns the status code of the last response whose status line
+  // has been decoded.
+  int status() const { return code; }
+
+  // Returns whether the status line and headers of the response in
+  // progress have been decoded, i.e., whether we're decoding its body.
+  bool decodingBody() const
+  {
+    return state != STATUS_LINE && state != HEADERS;
+  }
+
+  // The part of the body of the response in progress that has been
+  // decoded so far. The caller may consume (clear) it in order to
+  // stream a response that is never expected to complete.
+  string body;
+
+private:
+  void complete(deque<ApiResponse>* responses)
+  {
+    responses->push_back(ApiResponse(code, body));
+    body.clear();
+    state = STATUS_LINE;
+  }
+
+  enum {
+    STATUS_LINE,
+    HEADERS,
+    BODY,
+    CHUNK_SIZE,
+    CHUNK,
+    CHUNK_END,
+    TRAILERS,
+    UNTIL_CLOSE
+  } state;
+
+  int code;
+  bool chunked;
+  Option<size_t> contentLength;
+
+  // Bytes left in the current body or chunk.
+  size_t remaining;
+
+  // Data that has not been decoded yet.
+  string buffer;
+};
+
+
+Try<deque<ApiResponse> > ApiResponseDecoder::decode(
+    const char* data,
+    size_t length)
+{
+  buffer.append(data, length);
+
+  deque<ApiResponse> responses;
+
+  while (true) {
+    if (state == BODY || state == CHUNK) {
+      size_t size = std::min(remaining, buffer.size());
+      body.append(buffer, 0, size);
+      buffer.erase(0, size);
+      remaining -= size;
+
+      if (remaining > 0) {
+        break; // Need more data.
+      } else if (state == BODY) {
+        complete(&responses);
+      } else {
+        state = CHUNK_END;
+      }
+      continue;
+    }
+
+    if (state == UNTIL_CLOSE) {
+      body.append(buffer);
+      buffer.clear();
+      break;
+    }
+
+    // The remaining states are all line oriented.
+    size_t eol = buffer.find("\r\n");
+    if (eol == string::npos) {
+      break; // Need more data.
+    }
+
+    const string line = buffer.substr(0, eol);
+    buffer.erase(0, eol + 2);
+
+    switch (state) {
+      case STATUS_LINE: {
+        // For example: 'HTTP/1.1 200 OK'.
+        vector<string> tokens = strings::tokenize(line, " ");
+        if (tokens.size() < 2 || !strings::startsWith(tokens[0], "HTTP/")) {
+          return Error("Malformed status line '" + line + "'");
+        }
+
+        Try<int> number = numify<int>(tokens[1]);
+        if (number.isError()) {
+          return Error("Malformed status code '" + tokens[1] + "'");
+        }
+
+        code = number.get();
+        chunked = false;
+        contentLength = None();
+        state = HEADERS;
+        break;
+      }
+      case HEADERS: {
+        if (!line.empty()) {
+          size_t colon = line.find(':');
+          if (colon == string::npos) {
+            return Error("Malformed header '" + line + "'");
+          }
+
+          const string name =
+            strings::lower(strings::trim(line.substr(0, colon)));
+          const string value = strings::trim(line.substr(colon + 1));
+
+          if (name == "content-length") {
+            Try<size_t> number = numify<size_t>(value);
+            if (number.isError()) {
+              return Error("Malformed Content-Length '" + value + "'");
+            }
+            contentLength = number.get();
+          } else if (name == "transfer-encoding") {
+            chunked = strings::contains(strings::lower(value), "chunked");
+          }
+          break;
+        }
+
+        // End of the headers, 1xx, 204 and 304 responses have no body.
+        if ((code >= 100 && code < 200) || code == 204 || code == 304) {
+          complete(&responses);
+        } else if (chunked) {
+          state = CHUNK_SIZE;
+        } else if (contentLength.isSome()) {
+          remaining = contentLength.get();
+          state = BODY;
+        } else {
+          state = UNTIL_CLOSE;
+        }
+        break;
+      }
+      case CHUNK_SIZE: {
+        // Ignore any chunk extensions.
+        const string size = strings::trim(line.substr(0, line.find(';')));
+
+        char* end = NULL;
+        errno = 0;
+        unsigned long value = ::strtoul(size.c_str(), &end, 16);
+        if (size.empty() || *end != '\0' || errno != 0) {
+          return Error("Malformed chunk size '" + line + "'");
+        }
+
+        if (value == 0) {
+          state = TRAILERS;
+        } else {
+          remaining = value;
+          state = CHUNK;
+        }
+        break;
+      }
+      case CHUNK_END: {
+        if (!line.empty()) {
+          return Error("Malformed chunk, expecting CRLF");
+        }
+        state = CHUNK_SIZE;
+        break;
+      }
+      case TRAILERS: {
+        if (line.empty()) {
+          complete(&responses);
+        }
+        break;
+      }
+      default:
+        UNREACHABLE();
+    }
+  }
+
+  return responses;
+}
+
+
+Option<ApiResponse> ApiResponseDecoder::eof()
+{
+  if (state != UNTIL_CLOSE) {
+    return None();
+  }
+
+  deque<ApiResponse> responses;
+  complete(&responses);
+  return responses.front();
+}
+
+
+// Returns a connected, non-blocking socket to the daemon listening on
+// the UNIX socket at 'path'.
+static Try<int> connect(const string& path)
+{
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return Error("Socket path '" + path + "' is too long");
+  }
+
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  Try<int> s = network::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (s.isError()) {
+    return Error("Failed to create socket: " + s.error());
+  }
+
+  if (::connect(s.get(), (sockaddr*) &addr, sizeof(addr)) < 0) {
+    ErrnoError error("Failed to connect to '" + path + "'");
+    os::close(s.get());
+    return error;
+  }
+
+  Try<Nothing> cloexec = os::cloexec(s.get());
+  if (cloexec.isError()) {
+    os::close(s.get());
+    return Error("Failed to cloexec: " + cloexec.error());
+  }
+
+  Try<Nothing> nonblock = os::nonblock(s.get());
+  if (nonblock.isError()) {
+    os::close(s.get());
+    return Error("Failed to set nonblock: " + nonblock.error());
+  }
+
+  return s.get();
+}
+
+
+static string encode(
+    const string& method,
+    const string& path,
+    const Option<string>& body)
+{
+  std::ostringstream out;
+
+  out << method << " /" << DOCKER_API_VERSION << path << " HTTP/1.1\r\n"
+      << "Host: docker\r\n";
+
+  if (body.isSome()) {
+    out << "Content-Type: application/json\r\n"
+        << "Content-Length: " << body.get().size() << "\r\n";
+  } else if (method != "GET") {
+    out << "Content-Length: 0\r\n";
+  }
+
+  out << "\r\n";
+
+  if (body.isSome()) {
+    out << body.get();
+  }
+
+  return out.str();
+}
+
+
+template <typename T>
+static Future<T> failure(const string& request, const ApiResponse& response)
+{
+  // The daemon describes errors in plain text in the body.
+  return Failure(
+      "Failed to '" + request + "': status code = " +
+      stringify(response.code) + " body = " + strings::trim(response.body));
+}
+
+
+// Manages a keep-alive connection to the Docker daemon over which
+// requests are pipelined, i.e., requests are written back to back
+// without waiting for the previous responses and the responses are
+// matched with the requests in order. The connection is (re)opened
+// lazily, so a connection closed by the daemon only fails the
+// requests that were outstanding at the time.
+class RemoteDockerProcess : public Process<RemoteDockerProcess>
+{
+public:
+  explicit RemoteDockerProcess(const string& _socket)
+    : ProcessBase(ID::generate("docker")),
+      socket(_socket),
+      connection(0),
+      writing(false),
+      data(new char[io::BUFFERED_READ_SIZE]) {}
+
+  virtual ~RemoteDockerProcess() {}
+
+  Future<ApiResponse> request(
+      const string& method,
+      const string& path,
+      const Option<string>& body)
+  {
+    if (fd.isNone()) {
+      Try<int> s = connect(socket);
+      if (s.isError()) {
+        return Failure(s.error());
+      }
+
+      fd = s.get();
+      decoder = ApiResponseDecoder();
+
+      read();
+    }
+
+    Owned<Promise<ApiResponse> > promise(new Promise<ApiResponse>());
+    promises.push_back(promise);
+
+    outgoing.push_back(encode(method, path, body));
+
+    if (!writing) {
+      write();
+    }
+
+    return promise->future();
+  }
+
+protected:
+  virtual void finalize()
+  {
+    fail("Docker client terminated");
+  }
+
+private:
+  void write()
+  {
+    CHECK_SOME(fd);
+
+    // Coalesce all queued requests into a single write.
+    string requests;
+    foreach (const string& request, outgoing) {
+      requests += request;
+    }
+    outgoing.clear();
+
+    writing = true;
+    written = io::write(fd.get(), requests);
+    written.onAny(defer(self(), &Self::_write, connection, lambda::_1));
+  }
+
+  void _write(uint64_t _connection, const Future<Nothing>& future)
+  {
+    if (_connection != connection) {
+      return; // Stale connection.
+    }
+
+    writing = false;
+
+    if (!future.isReady()) {
+      fail("Failed to write request: " +
+           (future.isFailed() ? future.failure() : "discarded"));
+      return;
+    }
+
+    if (!outgoing.empty()) {
+      write();
+    }
+  }
+
+  void read()
+  {
+    CHECK_SOME(fd);
+
+    reading = io::read(fd.get(), data.get(), io::BUFFERED_READ_SIZE);
+    reading.onAny(defer(self(), &Self::_read, connection, lambda::_1));
+  }
+
+  void _read(uint64_t _connection, const Future<size_t>& future)
+  {
+    if (_connection != connection) {
+      return; // Stale connection.
+    }
+
+    if (!future.isReady()) {
+      fail("Failed to read response: " +
+           (future.isFailed() ? future.failure() : "discarded"));
+      return;
+    }
+
+    if (future.get() == 0) {
+      Option<ApiResponse> response = decoder.eof();
+      if (response.isSome() && !promises.empty()) {
+        promises.front()->set(response.get());
+        promises.pop_front();
+      }
+
+      fail("Connection closed by the Docker daemon");
+      return;
+    }
+
+    Try<deque<ApiResponse> > responses =
+      decoder.decode(data.get(), future.get());
+
+    if (responses.isError()) {
+      fail("Failed to decode response: " + responses.error());
+      return;
+    }
+
+    foreach (const ApiResponse& response, responses.get()) {
+      if (promises.empty()) {
+        fail("Received an unexpected response");
+        return;
+      }
+
+      promises.front()->set(response);
+      promises.pop_front();
+    }
+
+    read();
+  }
+
+  // Fails all outstanding requests and closes the connection.
+  void fail(const string& message)
+  {
+    foreach (const Owned<Promise<ApiResponse> >& promise, promises) {
+      promise->fail(message);
+    }
+    promises.clear();
+    outgoing.clear();
+
+    writing = false;
+    written.discard();
+    reading.discard();
+
+    if (fd.isSome()) {
+      os::close(fd.get());
+      fd = None();
+    }
+
+    // Invalidate callbacks that are still pending on the closed
+    // connection (the file descriptor might get reused).
+    connection++;
+  }
+
+  const string socket;
+
+  Option<int> fd;
+  uint64_t connection;
+
+  ApiResponseDecoder decoder;
+
+  deque<string> outgoing;
+  bool writing;
+  Future<Nothing> written;
+
+  boost::shared_array<char> data;
+  Future<size_t> reading;
+
+  deque<Owned<Promise<ApiResponse> > > promises;
+};
+
+
+// Sends a request over the pipelined connection.
+static Future<ApiResponse> pipelined(
+    const PID<RemoteDockerProcess>& pid,
+    const string& method,
+    const string& path,
+    const Option<string>& body = None())
+{
+  return dispatch(pid, &RemoteDockerProcess::request, method, path, body);
+}
+
+
+static void _exclusive(const PID<RemoteDockerProcess>& pid)
+{
+  terminate(pid);
+}
+
+
+// Sends a request over a connection of its own which is closed once
+// the response has been received or the request has been discarded.
+static Future<ApiResponse> exclusive(
+    const string& socket,
+    const string& method,
+    const string& path,
+    const Option<string>& body = None())
+{
+  PID<RemoteDockerProcess> pid = spawn(new RemoteDockerProcess(socket), true);
+
+  return dispatch(pid, &RemoteDockerProcess::request, method, path, body)
+    .onDiscard(lambda::bind(&_exclusive, pid))
+    .onAny(lambda::bind(&_exclusive, pid));
+}
+
+
+Try<Docker*> RemoteDocker::create(
+    const string& path,
+    const string& socket,
+    bool validate)
+{
+  Owned<RemoteDocker> docker(new RemoteDocker(path, socket));
+
+  if (!validate) {
+    return docker.release();
+  }
+
+#ifdef __linux__
+  // Make sure that cgroups are mounted, and at least the 'cpu'
+  // subsystem is attached.
+  Result<string> hierarchy = cgroups::hierarchy("cpu");
+
+  if (hierarchy.isNone()) {
+    return Error("Failed to find a mounted cgroups hierarchy "
+                 "for the 'cpu' subsystem; you probably need "
+                 "to mount cgroups manually!");
+  }
+#endif // __linux__
+
+  // Validate the version (and that we can reach the daemon at all).
+  Future<ApiResponse> version =
+    pipelined(docker->process->self(), "GET", "/version");
+
+  if (!version.await(Seconds(5))) {
+    return Error("Timed out waiting for the Docker daemon at '" + socket + "'");
+  } else if (version.isFailed()) {
+    return Error("Failed to query the Docker daemon at '" + socket + "': " +
+                 version.failure());
+  } else if (version.get().code != 200) {
+    // The daemon rejects API versions newer than its own.
+    return Error("Insufficient version of Docker! The Docker Remote API "
+                 "requires Docker >= 1.3.0 (API " + DOCKER_API_VERSION + ")");
+  }
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(version.get().body);
+  if (parse.isError()) {
+    return Error("Failed to parse Docker version: " + parse.error());
+  }
+
+  Result<JSON::String> server = parse.get().find<JSON::String>("Version");
+  if (server.isSome()) {
+    VLOG(1) << "Using Docker " << server.get().value << " at '" << socket
+            << "' through the Remote API";
+  }
+
+  return docker.release();
+}
+
+
+RemoteDocker::RemoteDocker(const string& path, const string& _socket)
+  : Docker(path),
+    socket(_socket),
+    process(new RemoteDockerProcess(_socket))
+{
+  spawn(process.get());
+}
+
+
+RemoteDocker::~RemoteDocker()
+{
+  terminate(process.get());
+  process::wait(process.get());
+}
+
+
+static Future<Nothing> __run(const string& name, const ApiResponse& response)
+{
+  // A 304 means the container was already started.
+  if (response.code != 204 && response.code != 304) {
+    return failure<Nothing>("start " + name, response);
+  }
+
+  return Nothing();
+}
+
+
+static Future<Nothing> _run(
+    const PID<RemoteDockerProcess>& pid,
+    const string& name,
+    const ApiResponse& response)
+{
+  if (response.code != 201) {
+    return failure<Nothing>("create " + name, response);
+  }
+
+  // NOTE: The host configuration was already passed when creating
+  // the container so the container is started without a body.
+  return pipelined(pid, "POST", "/containers/" + name + "/start")
+    .then(lambda::bind(&__run, name, lambda::_1));
+}
+
+
+Future<Nothing> RemoteDocker::run(
+    const ContainerInfo& containerInfo,
+    const CommandInfo& commandInfo,
+    const string& name,
+    const string& sandboxDirectory,
+    const string& mappedDirectory,
+    const Option<Resources>& resources,
+    const Option<map<string, string> >& env) const
+{
+  if (!containerInfo.has_docker()) {
+    return Failure("No docker info found in container info");
+  }
+
+  const ContainerInfo::DockerInfo& dockerInfo = containerInfo.docker();
+
+  // Arbitrary parameters are expressed as CLI flags which have no
+  // general mapping onto the Remote API.
+  if (dockerInfo.parameters().size() > 0) {
+    VLOG(1) << "Using the Docker CLI to run '" << name
+            << "' since docker parameters were specified";
+
+    return Docker::run(
+        containerInfo,
+        commandInfo,
+        name,
+        sandboxDirectory,
+        mappedDirectory,
+        resources,
+        env);
+  }
+
+  JSON::Object config;
+  JSON::Object hostConfig;
+
+  config.values["Image"] = dockerInfo.image();
+
+  if (dockerInfo.privileged()) {
+    hostConfig.values["Privileged"] = JSON::True();
+  }
+
+  if (resources.isSome()) {
+    // TODO(yifan): Support other resources (e.g. disk).
+    Option<double> cpus = resources.get().cpus();
+    if (cpus.isSome()) {
+      uint64_t cpuShare =
+        std::max((uint64_t) (CPU_SHARES_PER_CPU * cpus.get()), MIN_CPU_SHARES);
+      config.values["CpuShares"] = cpuShare;
+    }
+
+    Option<Bytes> mem = resources.get().mem();
+    if (mem.isSome()) {
+      Bytes memLimit = std::max(mem.get(), MIN_MEMORY);
+      config.values["Memory"] = memLimit.bytes();
+    }
+  }
+
+  JSON::Array environment;
+
+  if (env.isSome()) {
+    foreachpair (const string& key, const string& value, env.get()) {
+      environment.values.push_back(key + "=" + value);
+    }
+  }
+
+  foreach (const Environment::Variable& variable,
+           commandInfo.environment().variables()) {
+    environment.values.push_back(variable.name() + "=" + variable.value());
+  }
+
+  environment.values.push_back("MESOS_SANDBOX=" + mappedDirectory);
+
+  config.values["Env"] = environment;
+
+  JSON::Object volumes;
+  JSON::Array binds;
+
+  foreach (const Volume& volume, containerInfo.volumes()) {
+    if (!volume.has_host_path()) {
+      if (volume.has_mode()) {
+        return Failure("Host path is required with mode");
+      }
+
+      volumes.values[volume.container_path()] = JSON::Object();
+      continue;
+    }
+
+    string bind = volume.host_path() + ":" + volume.container_path();
+    if (volume.has_mode()) {
+      switch (volume.mode()) {
+        case Volume::RW: bind += ":rw"; break;
+        case Volume::RO: bind += ":ro"; break;
+        default: return Failure("Unsupported volume mode");
+      }
+    }
+
+    binds.values.push_back(bind);
+  }
+
+  // Mapping sandbox directory into the container mapped directory.
+  binds.values.push_back(sandboxDirectory + ":" + mappedDirectory);
+
+  config.values["Volumes"] = volumes;
+  hostConfig.values["Binds"] = binds;
+
+  string network;
+  switch (dockerInfo.network()) {
+    case ContainerInfo::DockerInfo::HOST: network = "host"; break;
+    case ContainerInfo::DockerInfo::BRIDGE: network = "bridge"; break;
+    case ContainerInfo::DockerInfo::NONE: network = "none"; break;
+    default: return Failure("Unsupported Network mode: " +
+                            stringify(dockerInfo.network()));
+  }
+
+  hostConfig.values["NetworkMode"] = network;
+
+  if (containerInfo.has_hostname()) {
+    if (network == "host") {
+      return Failure("Unable to set hostname with host network mode");
+    }
+
+    config.values["Hostname"] = containerInfo.hostname();
+  }
+
+  if (dockerInfo.port_mappings().size() > 0) {
+    if (network != "bridge") {
+      return Failure("Port mappings are only supported for bridge network");
+    }
+
+    if (!resources.isSome()) {
+      return Failure("Port mappings require resources");
+    }
+
+    Option<Value::Ranges> portRanges = resources.get().ports();
+
+    if (!portRanges.isSome()) {
+      return Failure("Port mappings require port resources");
+    }
+
+    JSON::Object exposedPorts;
+    JSON::Object portBindings;
+
+    foreach (const ContainerInfo::DockerInfo::PortMapping& mapping,
+             dockerInfo.port_mappings()) {
+      bool found = false;
+      foreach (const Value::Range& range, portRanges.get().range()) {
+        if (mapping.host_port() >= range.begin() &&
+            mapping.host_port() <= range.end()) {
+          found = true;
+          break;
+        }
+      }
+
+      if (!found) {
+        return Failure("Port [" + stringify(mapping.host_port()) + "] not " +
+                       "included in resources");
+      }
+
+      const string port = stringify(mapping.container_port()) + "/" +
+        (mapping.has_protocol() ? strings::lower(mapping.protocol()) : "tcp");
+
+      JSON::Object hostPort;
+      hostPort.values["HostPort"] = stringify(mapping.host_port());
+
+      JSON::Array hostPorts;
+      if (portBindings.values.count(port) > 0) {
+        hostPorts = portBindings.values[port].as<JSON::Array>();
+      }
+      hostPorts.values.push_back(hostPort);
+
+      exposedPorts.values[port] = JSON::Object();
+      portBindings.values[port] = hostPorts;
+    }
+
+    config.values["ExposedPorts"] = exposedPorts;
+    hostConfig.values["PortBindings"] = portBindings;
+  }
+
+  JSON::Array cmd;
+
+  if (commandInfo.shell()) {
+    if (!commandInfo.has_value()) {
+      return Failure("Shell specified but no command value provided");
+    }
+
+    // We override the entrypoint if shell is enabled because we
+    // assume the user intends to run the command within /bin/sh
+    // and not the default entrypoint of the image. View MESOS-1770
+    // for more details.
+    JSON::Array entrypoint;
+    entrypoint.values.push_back("/bin/sh");
+    config.values["Entrypoint"] = entrypoint;
+
+    cmd.values.push_back("-c");
+    cmd.values.push_back(commandInfo.value());
+  } else {
+    if (commandInfo.has_value()) {
+      cmd.values.push_back(commandInfo.value());
+    }
+
+    foreach (const string& argument, commandInfo.arguments()) {
+      cmd.values.push_back(argument);
+    }
+  }
+
+  if (!cmd.values.empty()) {
+    config.values["Cmd"] = cmd;
+  }
+
+  config.values["HostConfig"] = hostConfig;
+
+  VLOG(1) << "Creating container '" << name << "' with " << stringify(config);
+
+  return pipelined(
+      process->self(),
+      "POST",
+      "/containers/create?name=" + http::encode(name),
+      stringify(config))
+    .then(lambda::bind(&_run, process->self(), name, lambda::_1));
+}
+
+
+static Future<Nothing> _remove(
+    const string& container,
+    const ApiResponse& response)
+{
+  if (response.code != 204) {
+    return failure<Nothing>("rm " + container, response);
+  }
+
+  return Nothing();
+}
+
+
+static Future<Nothing> remove(
+    const PID<RemoteDockerProcess>& pid,
+    const string& container,
+    bool force)
+{
+  return pipelined(
+      pid,
+      "DELETE",
+      "/containers/" + container + (force ? "?force=1" : ""))
+    .then(lambda::bind(&_remove, container, lambda::_1));
+}
+
+
+static Future<Nothing> _stop(
+    const PID<RemoteDockerProcess>& pid,
+    const string& container,
+    bool remove,
+    const ApiResponse& response)
+{
+  // A 304 means the container was already stopped.
+  bool stopped = response.code == 204 || response.code == 304;
+
+  if (remove) {
+    return ::remove(pid, container, !stopped);
+  } else if (!stopped) {
+    return failure<Nothing>("stop " + container, response);
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> RemoteDocker::stop(
+    const string& container,
+    const Duration& timeout,
+    bool remove) const
+{
+  int timeoutSecs = (int) timeout.secs();
+  if (timeoutSecs < 0) {
+    return Failure("A negative timeout can not be applied to docker stop: " +
+                   stringify(timeoutSecs));
+  }
+
+  VLOG(1) << "Stopping container '" << container << "'";
+
+  // The daemon only responds once the container has stopped, which
+  // takes up to 'timeout', hence a connection of its own.
+  return exclusive(
+      socket,
+      "POST",
+      "/containers/" + container + "/stop?t=" + stringify(timeoutSecs))
+    .then(lambda::bind(
+        &::_stop, process->self(), container, remove, lambda::_1));
+}
+
+
+Future<Nothing> RemoteDocker::rm(const string& container, bool force) const
+{
+  VLOG(1) << "Removing container '" << container << "'";
+
+  return remove(process->self(), container, force);
+}
+
+
+static Future<Docker::Container> _inspect(const ApiResponse& response)
+{
+  if (response.code != 200) {
+    return failure<Docker::Container>("inspect", response);
+  }
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.body);
+  if (parse.isError()) {
+    return Failure("Failed to parse JSON: " + parse.error());
+  }
+
+  Try<Docker::Container> container = Docker::Container::create(parse.get());
+  if (container.isError()) {
+    return Failure("Unable to create container: " + container.error());
+  }
+
+  return container.get();
+}
+
+
+static Future<Docker::Container> inspect(
+    const PID<RemoteDockerProcess>& pid,
+    const string& container)
+{
+  return pipelined(pid, "GET", "/containers/" + container + "/json")
+    .then(lambda::bind(&_inspect, lambda::_1));
+}
+
+
+Future<Docker::Container> RemoteDocker::inspect(const string& container) const
+{
+  return ::inspect(process->self(), container);
+}
+
+
+static Future<list<Docker::Container> > _ps(
+    const PID<RemoteDockerProcess>& pid,
+    const Option<string>& prefix,
+    const ApiResponse& response)
+{
+  if (response.code != 200) {
+    return failure<list<Docker::Container> >("ps", response);
+  }
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.body);
+  if (parse.isError()) {
+    return Failure("Failed to parse JSON: " + parse.error());
+  }
+
+  // All the inspects are pipelined over the same connection rather
+  // than forking a 'docker inspect' per container.
+  list<Future<Docker::Container> > futures;
+
+  foreach (const JSON::Value& value, parse.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Failure("Unexpected container entry: " + stringify(value));
+    }
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("Id");
+    if (!id.isSome()) {
+      return Failure("Unable to find Id in container");
+    }
+
+    // Inspect the containers that we are interested in depending on
+    // whether or not a 'prefix' was specified. A container has a
+    // name (with a leading '/') plus one per link.
+    bool matched = prefix.isNone();
+
+    Result<JSON::Array> names = object.find<JSON::Array>("Names");
+    if (prefix.isSome() && names.isSome()) {
+      foreach (const JSON::Value& name, names.get().values) {
+        if (name.is<JSON::String>() &&
+            strings::startsWith(
+                strings::remove(
+                    name.as<JSON::String>().value, "/", strings::PREFIX),
+                prefix.get())) {
+          matched = true;
+        }
+      }
+    }
+
+    if (matched) {
+      futures.push_back(inspect(pid, id.get().value));
+    }
+  }
+
+  return collect(futures);
+}
+
+
+Future<list<Docker::Container> > RemoteDocker::ps(
+    bool all,
+    const Option<string>& prefix) const
+{
+  return pipelined(
+      process->self(),
+      "GET",
+      all ? "/containers/json?all=1" : "/containers/json")
+    .then(lambda::bind(&::_ps, process->self(), prefix, lambda::_1));
+}
+
+
+// State of a followed logs stream.
+struct Logs
+{
+  Logs(int _socket, int _out, int _err)
+    : socket(_socket),
+      out(_out),
+      err(_err),
+      data(new char[io::BUFFERED_READ_SIZE]) {}
+
+  ~Logs()
+  {
+    os::close(socket);
+    os::close(out);
+    os::close(err);
+  }
+
+  const int socket;
+  const int out;
+  const int err;
+
+  ApiResponseDecoder decoder;
+
+  // Stream data that has not been demultiplexed yet.
+  string frames;
+
+  boost::shared_array<char> data;
+
+  Promise<Nothing> promise;
+};
+
+
+// Writes the frames of a multiplexed stream, each an 8 byte header
+// (stream type, 3 bytes of padding, and the big-endian size of the
+// payload) followed by the payload, into 'out' or 'err', keeping an
+// incomplete trailing frame around for later.
+//
+// NOTE: The stream is only multiplexed for containers without a TTY,
+// which is the case for all the containers we run.
+static Try<Nothing> demultiplex(Logs* logs)
+{
+  while (logs->frames.size() >= 8) {
+    const unsigned char* header = (const unsigned char*) logs->frames.data();
+
+    size_t size =
+      ((uint32_t) header[4] << 24) |
+      ((uint32_t) header[5] << 16) |
+      ((uint32_t) header[6] << 8) |
+      (uint32_t) header[7];
+
+    if (logs->frames.size() < 8 + size) {
+      break;
+    }
+
+    Try<Nothing> write = os::write(
+        header[0] == 2 ? logs->err : logs->out,
+        logs->frames.substr(8, size));
+
+    if (write.isError()) {
+      return Error(write.error());
+    }
+
+    logs->frames.erase(0, 8 + size);
+  }
+
+  return Nothing();
+}
+
+
+// Decodes the data read from the stream and writes out the logs.
+// Returns true once the stream has ended.
+static Try<bool> decode(Logs* logs, size_t length)
+{
+  deque<ApiResponse> responses;
+
+  if (length == 0) { // EOF.
+    Option<ApiResponse> response = logs->decoder.eof();
+    if (response.isSome()) {
+      responses.push_back(response.get());
+    }
+  } else {
+    Try<deque<ApiResponse> > decode =
+      logs->decoder.decode(logs->data.get(), length);
+
+    if (decode.isError()) {
+      return Error("Failed to decode logs: " + decode.error());
+    }
+
+    responses = decode.get();
+  }
+
+  // A read might end in the middle of the status line or headers, in
+  // which case we don't know the status yet.
+  if (!responses.empty() && responses.front().code != 200) {
+    return Error(failure<Nothing>("logs", responses.front()).failure());
+  } else if (responses.empty() && logs->decoder.decodingBody()) {
+    if (logs->decoder.status() != 200) {
+      return Error("Failed to 'logs': status code = " +
+                   stringify(logs->decoder.status()));
+    }
+  } else if (responses.empty() && length == 0) {
+    return Error("Failed to 'logs': connection closed");
+  }
+
+  // Demultiplex whatever part of the body has been decoded so far.
+  logs->frames += logs->decoder.body;
+  logs->decoder.body.clear();
+
+  foreach (const ApiResponse& response, responses) {
+    logs->frames += response.body;
+  }
+
+  Try<Nothing> demultiplex = ::demultiplex(logs);
+  if (demultiplex.isError()) {
+    return Error("Failed to write logs: " + demultiplex.error());
+  }
+
+  // The daemon ends the stream once the container has terminated.
+  return length == 0 || !responses.empty();
+}
+
+
+// Forward declaration.
+static void _logs(const memory::shared_ptr<Logs>& logs);
+
+
+static void __logs(
+    const memory::shared_ptr<Logs>& logs,
+    const Future<size_t>& read)
+{
+  if (logs->promise.future().hasDiscard() || read.isDiscarded()) {
+    logs->promise.discard();
+    return;
+  } else if (read.isFailed()) {
+    logs->promise.fail("Failed to read logs: " + read.failure());
+    return;
+  }
+
+  Try<bool> decode = ::decode(logs.get(), read.get());
+  if (decode.isError()) {
+    logs->promise.fail(decode.error());
+  } else if (decode.get()) {
+    logs->promise.set(Nothing());
+  } else {
+    _logs(logs);
+  }
+}
+
+
+// Reads the next part of the stream. Rather than chaining a future
+// for each read we pass around a single promise (see io::splice) so
+// that following a stream doesn't use more memory the longer it
+// lasts.
+static void _logs(const memory::shared_ptr<Logs>& logs)
+{
+  io::read(logs->socket, logs->data.get(), io::BUFFERED_READ_SIZE)
+    .onAny(lambda::bind(&__logs, logs, lambda::_1));
+}
+
+
+// Starts reading the logs stream once the request has been sent.
+static Future<Nothing> follow(const memory::shared_ptr<Logs>& logs)
+{
+  _logs(logs);
+  return logs->promise.future();
+}
+
+
+// Invoked when the logs stream gets discarded. Shutting down the
+// connection ends the read in progress, after which we stop reading.
+static void interrupt(const memory::weak_ptr<Logs>& logs)
+{
+  memory::shared_ptr<Logs> _logs = logs.lock();
+  if (_logs) {
+    ::shutdown(_logs->socket, SHUT_RDWR);
+  }
+}
+
+
+// Stops following the logs of a container some time after it has
+// terminated, see RemoteDocker::logs.
+static void unfollow(Future<Nothing> following, const string& container)
+{
+  if (!following.isPending()) {
+    return;
+  }
+
+  VLOG(1) << "Stopping to follow logs of container '" << container << "'";
+
+  following.discard();
+}
+
+
+static void _unfollow(
+    const Future<Nothing>& following,
+    const string& container)
+{
+  // Give the daemon some time to flush the logs.
+  Clock::timer(DOCKER_LOGS_FLUSH_DELAY,
+               lambda::bind(&unfollow, following, container));
+}
+
+
+Future<Nothing> RemoteDocker::logs(
+    const string& container,
+    const string& directory) const
+{
+  Try<int> s = connect(socket);
+  if (s.isError()) {
+    return Failure("Unable to follow docker logs: " + s.error());
+  }
+
+  const int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+  const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+  Try<int> out = os::open(path::join(directory, "stdout"), flags, mode);
+  if (out.isError()) {
+    os::close(s.get());
+    return Failure("Failed to open 'stdout': " + out.error());
+  }
+
+  Try<int> err = os::open(path::join(directory, "stderr"), flags, mode);
+  if (err.isError()) {
+    os::close(s.get());
+    os::close(out.get());
+    return Failure("Failed to open 'stderr': " + err.error());
+  }
+
+  memory::shared_ptr<Logs> logs(new Logs(s.get(), out.get(), err.get()));
+
+  logs->promise.future()
+    .onDiscard(lambda::bind(&interrupt, memory::weak_ptr<Logs>(logs)));
+
+  VLOG(1) << "Following logs of container '" << container << "'";
+
+  Future<Nothing> following = io::write(
+      s.get(),
+      encode(
+          "GET",
+          "/containers/" + container + "/logs?follow=1&stdout=1&stderr=1",
+          None()))
+    .then(lambda::bind(&follow, logs));
+
+  // The daemon might not end the stream if we started following the
+  // logs after the container had already terminated, in which case
+  // we would leak the connection and the files. Thus, we wait for the
+  // container to terminate, give the daemon some time to flush the
+  // logs and then stop following them ourselves (discarding the read
+  // closes the connection and the files). For more information,
+  // please see: https://github.com/docker/docker/issues/7020
+  Future<ApiResponse> waiting =
+    exclusive(socket, "POST", "/containers/" + container + "/wait");
+
+  waiting
+    .onAny(lambda::bind(&_unfollow, following, container));
+
+  // Stop waiting for the container if the stream ended on its own.
+  following
+    .onAny(lambda::bind(&Future<ApiResponse>::discard, waiting));
+
+  return following;
+}
+
+
+static Future<Docker::Image> image(const ApiResponse& response)
+{
+  if (response.code != 200) {
+    return failure<Docker::Image>("inspect image", response);
+  }
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.body);
+  if (parse.isError()) {
+    return Failure("Failed to parse JSON: " + parse.error());
+  }
+
+  Try<Docker::Image> image = Docker::Image::create(parse.get());
+  if (image.isError()) {
+    return Failure("Unable to create image: " + image.error());
+  }
+
+  return image.get();
+}
+
+
+static Future<Docker::Image> ___pull(
+    const PID<RemoteDockerProcess>& pid,
+    const string& image,
+    const ApiResponse& response)
+{
+  if (response.code != 200) {
+    return failure<Docker::Image>("pull " + image, response);
+  }
+
+  // The body is a stream of JSON progress messages, a failed pull is
+  // reported by a message with an 'error' (the status code is
+  // already sent by then).
+  foreach (const string& line, strings::tokenize(response.body, "\r\n")) {
+    Try<JSON::Object> message = JSON::parse<JSON::Object>(line);
+    if (message.isError()) {
+      continue;
+    }
+
+    Result<JSON::String> error = message.get().find<JSON::String>("error");
+    if (error.isSome()) {
+      return Failure(
+          "Failed to 'pull " + image + "': " + error.get().value);
+    }
+  }
+
+  return pipelined(pid, "GET", "/images/" + image + "/json")
+    .then(lambda::bind(&::image, lambda::_1));
+}
+
+
+static Future<Docker::Image> __pull(
+    const string& socket,
+    const PID<RemoteDockerProcess>& pid,
+    const string& image)
+{
+  // The image always has a tag, see RemoteDocker::pull.
+  size_t colon = image.find_last_of(':');
+  CHECK_NE(string::npos, colon);
+
+  VLOG(1) << "Pulling image '" << image << "'";
+
+  // Pulling can take a long time for large images, hence a
+  // connection of its own. Discarding the pull closes it.
+  return exclusive(
+      socket,
+      "POST",
+      "/images/create?fromImage=" + http::encode(image.substr(0, colon)) +
+      "&tag=" + http::encode(image.substr(colon + 1)))
+    .then(lambda::bind(&___pull, pid, image, lambda::_1));
+}
+
+
+static Future<Docker::Image> _pull(
+    const string& socket,
+    const PID<RemoteDockerProcess>& pid,
+    const string& image,
+    const ApiResponse& response)
+{
+  if (response.code == 404) {
+    return __pull(socket, pid, image);
+  }
+
+  return ::image(response);
+}
+
+
+Future<Docker::Image> RemoteDocker::pull(
+    const string& directory,
+    const string& image,
+    bool force) const
+{
+  // Registry credentials are only understood by the CLI which picks
+  // up the '.dockercfg' from $HOME (see Docker::pull).
+  if (os::exists(path::join(directory, ".dockercfg"))) {
+    return Docker::pull(directory, image, force);
+  }
+
+  string dockerImage = image;
+
+  // Check if the specified image has a tag. Also split on "/" in case
+  // the user specified a registry server (ie: localhost:5000/image)
+  // to get the actual image name. If no tag was given we add a
+  // 'latest' tag to avoid pulling down the repository.
+  vector<string> parts = strings::split(image, "/");
+
+  if (!strings::contains(parts.back(), ":")) {
+    dockerImage += ":latest";
+  }
+
+  if (force) {
+    return ::__pull(socket, process->self(), dockerImage);
+  }
+
+  return pipelined(process->self(), "GET", "/images/" + dockerImage + "/json")
+    .then(lambda::bind(
+        &::_pull, socket, process->self(), dockerImage, lambda::_1));
+}
@@ -0,0 +1,137 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DOCKER_REMOTE_HPP__
+#define __DOCKER_REMOTE_HPP__
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "docker/docker.hpp"
+
+#include "mesos/resources.hpp"
+
+
+// Version of the Docker Remote API we speak (Docker >= 1.3).
+extern const std::string DOCKER_API_VERSION;
+
+// Time we keep following the logs of a container after it has
+// terminated, to let the daemon flush them (see RemoteDocker::logs).
+extern const Duration DOCKER_LOGS_FLUSH_DELAY;
+
+
+// Forward declaration.
+class RemoteDockerProcess;
+
+
+// Abstraction for working with Docker through the Docker Remote API
+// spoken directly over the daemon's UNIX socket (e.g.,
+// '/var/run/docker.sock') rather than by forking the Docker CLI.
+//
+// Short requests are pipelined over a single keep-alive connection.
+// Requests that can block for a long time ('stop', 'pull' and
+// 'logs') are sent over a connection of their own so that they don't
+// stall the pipeline.
+class RemoteDocker : public Docker
+{
+public:
+  // Create a Docker abstraction that talks to the daemon listening
+  // on 'socket' and optionally validate the Remote API version. The
+  // CLI at 'path' is only used for requests the Remote API client
+  // does not support (see 'run' and 'pull' below).
+  static Try<Docker*> create(
+      const std::string& path,
+      const std::string& socket,
+      bool validate = true);
+
+  virtual ~RemoteDocker();
+
+  // Performs 'POST /containers/create' followed by
+  // 'POST /containers/(id)/start'. Falls back to the CLI if the
+  // DockerInfo contains arbitrary 'parameters' since those are
+  // expressed as CLI flags.
+  virtual process::Future<Nothing> run(
+      const mesos::ContainerInfo& containerInfo,
+      const mesos::CommandInfo& commandInfo,
+      const std::string& name,
+      const std::string& sandboxDirectory,
+      const std::string& mappedDirectory,
+      const Option<mesos::Resources>& resources = None(),
+      const Option<std::map<std::string, std::string> >& env = None()) const;
+
+  // Performs 'POST /containers/(id)/stop?t=TIMEOUT'.
+  virtual process::Future<Nothing> stop(
+      const std::string& container,
+      const Duration& timeout = Seconds(0),
+      bool remove = false) const;
+
+  // Performs 'DELETE /containers/(id)?force=1'.
+  virtual process::Future<Nothing> rm(
+      const std::string& container,
+      bool force = false) const;
+
+  // Performs 'GET /containers/(id)/json'.
+  virtual process::Future<Container> inspect(
+      const std::string& container) const;
+
+  // Performs 'GET /containers/json' followed by one pipelined
+  // 'GET /containers/(id)/json' per matching container, all over the
+  // same connection.
+  virtual process::Future<std::list<Container> > ps(
+      bool all = false,
+      const Option<std::string>& prefix = None()) const;
+
+  // Performs 'GET /containers/(id)/logs?follow=1' and demultiplexes
+  // the stream into a 'stdout' and 'stderr' file in the specified
+  // directory. The future is satisfied once the daemon closes the
+  // stream, i.e., after the container has terminated, or discarded
+  // if the daemon did not close the stream within
+  // DOCKER_LOGS_FLUSH_DELAY after the container terminated.
+  virtual process::Future<Nothing> logs(
+      const std::string& container,
+      const std::string& directory) const;
+
+  // Performs 'GET /images/(name)/json' and, if the image is not
+  // present (or 'force' is set), 'POST /images/create'. Falls back
+  // to the CLI if 'directory' contains a '.dockercfg' since the
+  // registry credentials are only understood by the CLI.
+  virtual process::Future<Image> pull(
+      const std::string& directory,
+      const std::string& image,
+      bool force = false) const;
+
+private:
+  RemoteDocker(const std::string& path, const std::string& socket);
+
+  const std::string socket;
+
+  // Connection used for pipelined requests.
+  process::Owned<RemoteDockerProcess> process;
+};
+
+#endif // __DOCKER_REMOTE_HPP__
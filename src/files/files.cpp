@@ -1,7 +1,14 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <algorithm>
 #include <map>
 #include <string>
@@ -9,16 +16,22 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
@@ -53,6 +66,11 @@ using std::vector;
 
 namespace mesos {
 
+// How often the files that can not be watched (e.g., when inotify is
+// not available) are checked for appended data while streaming them.
+static const Duration STREAM_POLL_INTERVAL = Seconds(1);
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -64,8 +82,38 @@ public:
 
 protected:
   virtual void initialize();
+  virtual void finalize();
 
 private:
+  // A file that is being followed by a stream (see 'stream' below).
+  struct Follower
+  {
+    Follower(const string& _name, int _fd, int _pipe, off_t _offset)
+      : name(_name), fd(_fd), pipe(_pipe), offset(_offset) {}
+
+    // The virtual path of the file.
+    const string name;
+
+    // The file and the write end of the pipe the response is
+    // streamed from.
+    const int fd;
+    const int pipe;
+
+    // The offset in the file up to which it has been streamed.
+    off_t offset;
+
+    // The inotify watch of the file, if it is being watched rather
+    // than polled.
+    Option<int> wd;
+
+    // Set while waiting for the (full) pipe to become writable.
+    Option<Future<short> > writing;
+
+    // Satisfied once the read end of the pipe got closed, i.e., the
+    // client went away (see 'closed' below).
+    Future<short> closing;
+  };
+
   // Resolves the virtual path to an actual path.
   // Returns the actual path if found.
   // Returns None if the file is not found.
@@ -91,15 +139,63 @@ private:
   //   path: The directory to browse. Required.
   Future<Response> download(const Request& request);
 
+  // Streams the raw contents of a file from a given offset and keeps
+  // following the file, i.e., the data appended to the file gets
+  // streamed as well (using "chunked" encoding) until either the
+  // file is removed or the client goes away. This avoids having to
+  // repeatedly poll 'read.json' in order to tail a file.
+  // Requests have the following parameters:
+  //   path: The file to stream. Required.
+  //   offset: The offset to start streaming from. Optional, the
+  //           default is the current end of the file.
+  Future<Response> stream(const Request& request);
+
+  // Streams the data that has been appended to the file followed
+  // through the given pipe since it was last streamed, as much as
+  // the pipe can take.
+  void transfer(int pipe);
+
+  // Invoked once the pipe of a follower has become writable again.
+  void writable(const Future<short>& future, int pipe);
+
+  // Invoked once the read end of the pipe of a follower got closed.
+  void closed(const Future<short>& future, int pipe);
+
+  // Stops following a file, which ends the stream.
+  void unfollow(int pipe);
+
+  // Starts polling the files that are not watched, unless already
+  // polling.
+  void poll();
+  void _poll();
+
+#ifdef __linux__
+  // Waits for and handles inotify events for the watched files.
+  void notify();
+  void _notify();
+#endif // __linux__
+
   // Returns the internal virtual path mapping.
   Future<Response> debug(const Request& request);
 
   hashmap<string, string> paths;
+
+  // The files being followed, keyed by the pipe they are streamed
+  // through.
+  hashmap<int, Owned<Follower> > followers;
+
+  // The inotify instance used to watch the followed files, if it
+  // could be created.
+  Option<int> inotify;
+  Future<short> notifying;
+
+  bool polling;
 };
 
 
 FilesProcess::FilesProcess()
-  : ProcessBase("files")
+  : ProcessBase("files"),
+    polling(false)
 {}
 
 
@@ -108,7 +204,32 @@ void FilesProcess::initialize()
   route("/browse.json", None(), &FilesProcess::browse);
   route("/read.json", None(), &FilesProcess::read);
   route("/download.json", None(), &FilesProcess::download);
+  route("/stream", None(), &FilesProcess::stream);
   route("/debug.json", None(), &FilesProcess::debug);
+
+#ifdef __linux__
+  int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd == -1) {
+    PLOG(WARNING) << "Failed to initialize inotify, streamed files will "
+                  << "be polled every " << STREAM_POLL_INTERVAL;
+  } else {
+    inotify = fd;
+    notify();
+  }
+#endif // __linux__
+}
+
+
+void FilesProcess::finalize()
+{
+  foreach (int pipe, followers.keys()) {
+    unfollow(pipe);
+  }
+
+  if (inotify.isSome()) {
+    notifying.discard();
+    os::close(inotify.get());
+  }
 }
 
 
@@ -145,6 +266,13 @@ Future<Nothing> FilesProcess::attach(const string& path, const string& name)
 void FilesProcess::detach(const string& name)
 {
   paths.erase(name);
+
+  // Stop streaming the files that are no longer accessible.
+  foreach (int pipe, followers.keys()) {
+    if (!resolve(followers[pipe]->name).isSome()) {
+      unfollow(pipe);
+    }
+  }
 }
 
 
@@ -368,6 +496,379 @@ Future<Response> FilesProcess::download(const Request& request)
 }
 
 
+Future<Response> FilesProcess::stream(const Request& request)
+{
+  Option<string> path = request.query.get("path");
+
+  if (!path.isSome() || path.get().empty()) {
+    return BadRequest("Expecting 'path=value' in query.\n");
+  }
+
+  Option<off_t> offset = None();
+
+  if (request.query.get("offset").isSome()) {
+    Try<off_t> result = numify<off_t>(request.query.get("offset").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse offset: " + result.error() + ".\n");
+    } else if (result.get() < 0) {
+      return BadRequest("Expecting a non-negative offset.\n");
+    }
+    offset = result.get();
+  }
+
+  Result<string> resolvedPath = resolve(path.get());
+
+  if (resolvedPath.isError()) {
+    return BadRequest(resolvedPath.error() + ".\n");
+  } else if (!resolvedPath.isSome()) {
+    return NotFound();
+  }
+
+  // Don't stream directories.
+  if (os::isdir(resolvedPath.get())) {
+    return BadRequest("Cannot stream a directory.\n");
+  }
+
+  Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    string error = strings::format("Failed to open file at '%s': %s",
+        resolvedPath.get(), fd.error()).get();
+    LOG(WARNING) << error;
+    return InternalServerError(error + ".\n");
+  }
+
+  struct stat s;
+  if (::fstat(fd.get(), &s) == -1) {
+    string error = strings::format("Failed to stat file at '%s': %s",
+        resolvedPath.get(), strerror(errno)).get();
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    return InternalServerError(error + ".\n");
+  }
+
+  int pipes[2];
+  if (::pipe(pipes) == -1) {
+    string error = "Failed to create pipe: " + string(strerror(errno));
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    return InternalServerError(error + ".\n");
+  }
+
+  os::cloexec(pipes[0]);
+  os::cloexec(pipes[1]);
+
+  // NOTE: The read end is made nonblocking by libprocess.
+  os::nonblock(pipes[1]);
+
+  Owned<Follower> follower(new Follower(
+      path.get(),
+      fd.get(),
+      pipes[1],
+      offset.isSome() ? offset.get() : s.st_size));
+
+#ifdef __linux__
+  if (inotify.isSome()) {
+    // NOTE: Watches of the same file share the same watch descriptor.
+    int wd = ::inotify_add_watch(
+        inotify.get(),
+        resolvedPath.get().c_str(),
+        IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+
+    if (wd == -1) {
+      PLOG(WARNING) << "Failed to watch '" << resolvedPath.get()
+                    << "', polling it every " << STREAM_POLL_INTERVAL;
+    } else {
+      follower->wd = wd;
+    }
+  }
+#endif // __linux__
+
+  // Notice the client going away even if the file doesn't change,
+  // in which case we'd otherwise never write to the pipe again.
+  // NOTE: Polling the write end of a pipe for reading only fires
+  // with an error, e.g., once the read end is closed, unlike polling
+  // it for writing which fires whenever the pipe isn't full.
+  follower->closing = io::poll(pipes[1], io::READ);
+  follower->closing
+    .onAny(defer(self(), &Self::closed, lambda::_1, pipes[1]));
+
+  followers[pipes[1]] = follower;
+
+  if (follower->wd.isNone()) {
+    poll();
+  }
+
+  // Stream what is already there.
+  transfer(pipes[1]);
+
+  OK response;
+  response.type = response.PIPE;
+  response.pipe = pipes[0];
+  response.headers["Content-Type"] = "text/plain";
+
+  return response;
+}
+
+
+void FilesProcess::transfer(int pipe)
+{
+  if (!followers.contains(pipe)) {
+    return;
+  }
+
+  Follower* follower = followers[pipe].get();
+
+  if (follower->writing.isSome()) {
+    return; // Still waiting for the pipe to drain.
+  }
+
+  struct stat s;
+  if (::fstat(follower->fd, &s) == -1) {
+    PLOG(WARNING) << "Failed to stat '" << follower->name << "'";
+    unfollow(pipe);
+    return;
+  }
+
+  // Start over if the file got truncated.
+  if (s.st_size < follower->offset) {
+    follower->offset = 0;
+  }
+
+  char buffer[64 * 1024];
+
+  while (follower->offset < s.st_size) {
+    size_t size =
+      std::min<off_t>(sizeof(buffer), s.st_size - follower->offset);
+
+    ssize_t length = ::pread(follower->fd, buffer, size, follower->offset);
+
+    if (length == -1 && errno == EINTR) {
+      continue;
+    } else if (length <= 0) {
+      if (length == -1) {
+        PLOG(WARNING) << "Failed to read '" << follower->name << "'";
+        unfollow(pipe);
+        return;
+      }
+      break; // The file got truncated in the meantime.
+    }
+
+    ssize_t written = ::write(pipe, buffer, length);
+
+    if (written == -1 && errno == EINTR) {
+      continue;
+    } else if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      follower->writing = io::poll(pipe, io::WRITE);
+      follower->writing.get()
+        .onAny(defer(self(), &Self::writable, lambda::_1, pipe));
+      return;
+    } else if (written == -1) {
+      // Most likely the client went away and libprocess closed the
+      // read end of the pipe (EPIPE).
+      unfollow(pipe);
+      return;
+    }
+
+    follower->offset += written;
+  }
+
+  // Once a removed file has been streamed completely, it won't grow
+  // anymore.
+  if (s.st_nlink == 0) {
+    unfollow(pipe);
+  }
+}
+
+
+void FilesProcess::writable(const Future<short>& future, int pipe)
+{
+  // NOTE: The poll is discarded if the follower was removed. As the
+  // pipe could since have been reused for another follower, we also
+  // check that the poll is the one of the current follower.
+  if (!future.isReady() ||
+      !followers.contains(pipe) ||
+      followers[pipe]->writing.isNone() ||
+      followers[pipe]->writing.get() != future) {
+    return;
+  }
+
+  followers[pipe]->writing = None();
+
+  transfer(pipe);
+}
+
+
+void FilesProcess::closed(const Future<short>& future, int pipe)
+{
+  // NOTE: The poll is discarded if the follower was removed, but the
+  // dispatch could already be queued (see 'writable' above).
+  if (!future.isReady() ||
+      !followers.contains(pipe) ||
+      followers[pipe]->closing != future) {
+    return;
+  }
+
+  VLOG(1) << "Stopping to stream '" << followers[pipe]->name
+          << "' as the client went away";
+
+  unfollow(pipe);
+}
+
+
+void FilesProcess::unfollow(int pipe)
+{
+  if (!followers.contains(pipe)) {
+    return;
+  }
+
+  Owned<Follower> follower = followers[pipe];
+  followers.erase(pipe);
+
+  if (follower->writing.isSome()) {
+    Future<short> writing = follower->writing.get();
+    writing.discard();
+  }
+
+  follower->closing.discard();
+
+#ifdef __linux__
+  if (follower->wd.isSome()) {
+    bool watched = false;
+    foreachvalue (const Owned<Follower>& other, followers) {
+      if (other->wd == follower->wd) {
+        watched = true;
+        break;
+      }
+    }
+
+    if (!watched) {
+      ::inotify_rm_watch(inotify.get(), follower->wd.get());
+    }
+  }
+#endif // __linux__
+
+  // Closing the write end of the pipe ends the stream.
+  os::close(follower->fd);
+  os::close(follower->pipe);
+}
+
+
+void FilesProcess::poll()
+{
+  if (polling) {
+    return;
+  }
+
+  polling = true;
+  delay(STREAM_POLL_INTERVAL, self(), &Self::_poll);
+}
+
+
+void FilesProcess::_poll()
+{
+  polling = false;
+
+  bool unwatched = false;
+
+  foreach (int pipe, followers.keys()) {
+    if (followers[pipe]->wd.isNone()) {
+      transfer(pipe);
+      unwatched = true;
+    }
+  }
+
+  if (unwatched) {
+    poll();
+  }
+}
+
+
+#ifdef __linux__
+void FilesProcess::notify()
+{
+  CHECK_SOME(inotify);
+
+  notifying = io::poll(inotify.get(), io::READ);
+  notifying.onAny(defer(self(), &Self::_notify));
+}
+
+
+void FilesProcess::_notify()
+{
+  CHECK_SOME(inotify);
+
+  // Large enough for at least one event with the longest name.
+  char buffer[64 * 1024] __attribute__((aligned(8)));
+
+  // The watches with pending changes.
+  hashset<int> changed;
+  bool overflowed = false;
+
+  while (true) {
+    ssize_t length = ::read(inotify.get(), buffer, sizeof(buffer));
+
+    if (length == -1 && errno == EINTR) {
+      continue;
+    } else if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else if (length <= 0) {
+      LOG(ERROR) << "Failed to read inotify events: "
+                 << (length == 0 ? "EOF" : strerror(errno));
+
+      // Fall back to polling all the followed files.
+      foreachvalue (const Owned<Follower>& follower, followers) {
+        follower->wd = None();
+      }
+
+      os::close(inotify.get());
+      inotify = None();
+
+      poll();
+      return;
+    }
+
+    for (ssize_t offset = 0; offset < length;) {
+      const struct inotify_event* event =
+        (const struct inotify_event*) (buffer + offset);
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        overflowed = true;
+      } else if (event->mask & IN_IGNORED) {
+        // The file got removed (which we notice when transferring)
+        // or is no longer watched, so poll its followers instead.
+        foreachvalue (const Owned<Follower>& follower, followers) {
+          if (follower->wd == event->wd) {
+            follower->wd = None();
+            poll();
+          }
+        }
+        changed.insert(event->wd);
+      } else {
+        changed.insert(event->wd);
+      }
+
+      offset += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  foreach (int pipe, followers.keys()) {
+    if (!followers.contains(pipe)) {
+      continue; // Unfollowed while transferring to another follower.
+    }
+
+    const Option<int>& wd = followers[pipe]->wd;
+
+    if (overflowed || wd.isNone() || changed.contains(wd.get())) {
+      transfer(pipe);
+    }
+  }
+
+  notify();
+}
+#endif // __linux__
+
+
 Future<Response> FilesProcess::debug(const Request& request)
 {
   JSON::Object object;
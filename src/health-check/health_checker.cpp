@@ -0,0 +1,536 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <signal.h>
+
+#include <netinet/in.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/node.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
+#include <process/socket.hpp>
+#include <process/subprocess.hpp>
+#include <process/timer.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
+#include "common/type_utils.hpp"
+
+#include "health-check/health_checker.hpp"
+
+#include "messages/messages.hpp"
+
+using namespace process;
+
+using process::metrics::Counter;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace mesos {
+
+const Duration HEALTH_CHECK_COALESCING_WINDOW = Seconds(1);
+
+
+// The durations of a health check are given in (fractional) seconds.
+static Duration seconds(double value)
+{
+  Try<Duration> duration = Duration::create(value);
+  return duration.isSome() ? duration.get() : Duration::max();
+}
+
+
+class HealthCheckerProcess : public ProtobufProcess<HealthCheckerProcess>
+{
+public:
+  HealthCheckerProcess()
+    : ProcessBase(ID::generate("health-checker")) {}
+
+  virtual ~HealthCheckerProcess() {}
+
+  Future<Nothing> start(
+      const TaskID& taskId,
+      const HealthCheck& check,
+      const UPID& executor)
+  {
+    if (checks.contains(taskId)) {
+      return Failure(
+          "Already checking the health of task " + stringify(taskId));
+    }
+
+    if (!check.has_http() && !check.has_tcp() && !check.has_command()) {
+      return Failure("No check found in health check");
+    }
+
+    VLOG(2) << "Health checks of task " << taskId << " starting in "
+            << seconds(check.delay_seconds()) << ", grace period "
+            << seconds(check.grace_period_seconds());
+
+    Owned<Check> _check(new Check(taskId, check, executor));
+    _check->due = _check->started + seconds(check.delay_seconds());
+
+    checks[taskId] = _check;
+
+    schedule();
+
+    return _check->promise.future();
+  }
+
+  void stop(const TaskID& taskId)
+  {
+    if (!checks.contains(taskId)) {
+      return;
+    }
+
+    VLOG(1) << "Stopping the health checks of task " << taskId;
+
+    Owned<Check> check = checks[taskId];
+    checks.erase(taskId);
+
+    // A check that is in progress is ignored once it completes.
+    check->promise.discard();
+  }
+
+protected:
+  virtual void finalize()
+  {
+    foreachvalue (const Owned<Check>& check, checks) {
+      check->promise.discard();
+    }
+    checks.clear();
+
+    if (timer.isSome()) {
+      Clock::cancel(timer.get());
+    }
+  }
+
+private:
+  struct Check
+  {
+    Check(const TaskID& _taskId,
+          const HealthCheck& _check,
+          const UPID& _executor)
+      : taskId(_taskId),
+        check(_check),
+        executor(_executor),
+        started(Clock::now()),
+        checking(false),
+        initializing(true),
+        consecutiveFailures(0) {}
+
+    const TaskID taskId;
+    const HealthCheck check;
+    const UPID executor;
+
+    // When the checks started (for the grace period) and when the
+    // next check is due.
+    const Time started;
+    Time due;
+
+    // Whether a check is in progress.
+    bool checking;
+
+    bool initializing;
+    uint32_t consecutiveFailures;
+
+    Promise<Nothing> promise;
+  };
+
+  // Arms the timer for the earliest due check, unless it is already
+  // armed for an earlier time.
+  void schedule()
+  {
+    Option<Time> next;
+    foreachvalue (const Owned<Check>& check, checks) {
+      if (!check->checking && (next.isNone() || check->due < next.get())) {
+        next = check->due;
+      }
+    }
+
+    if (timer.isSome()) {
+      if (next.isSome() && timer.get().timeout().time() <= next.get()) {
+        return;
+      }
+
+      Clock::cancel(timer.get());
+      timer = None();
+    }
+
+    if (next.isSome()) {
+      Duration duration = next.get() - Clock::now();
+      timer = delay(
+          std::max(duration, Duration::zero()), self(), &Self::expired);
+    }
+  }
+
+  // Runs every check that is due, or almost due, then re-arms the
+  // timer for the next check.
+  void expired()
+  {
+    timer = None();
+
+    const Time now = Clock::now();
+
+    foreachvalue (const Owned<Check>& check, checks) {
+      if (check->checking) {
+        continue;
+      }
+
+      Duration slack = std::min(
+          HEALTH_CHECK_COALESCING_WINDOW,
+          seconds(check->check.interval_seconds()) / 10);
+
+      if (check->due - slack <= now) {
+        perform(check);
+      }
+    }
+
+    schedule();
+  }
+
+  void perform(const Owned<Check>& check)
+  {
+    check->checking = true;
+
+    Future<Nothing> result;
+    if (check->check.has_command()) {
+      result = command(check->check);
+    } else if (check->check.has_http()) {
+      result = http(check->check.http());
+    } else {
+      result = tcp(check->check.tcp());
+    }
+
+    const Duration timeout = seconds(check->check.timeout_seconds());
+
+    metrics.check_latency.time(result)
+      .after(timeout, lambda::bind(&timedout, lambda::_1, timeout))
+      .onAny(defer(self(), &Self::checked, check, lambda::_1));
+  }
+
+  static Future<Nothing> timedout(
+      Future<Nothing> future,
+      const Duration& timeout)
+  {
+    future.discard();
+
+    return Failure("Timed out after " + stringify(timeout));
+  }
+
+  void checked(const Owned<Check>& check, const Future<Nothing>& future)
+  {
+    // Ignore the result if the checks were stopped in the meantime.
+    if (!checks.contains(check->taskId) ||
+        checks[check->taskId].get() != check.get()) {
+      return;
+    }
+
+    check->checking = false;
+
+    if (future.isReady()) {
+      ++metrics.checks_passed;
+      success(check);
+    } else {
+      ++metrics.checks_failed;
+      failure(check, future.isFailed() ? future.failure() : "discarded");
+    }
+
+    if (checks.contains(check->taskId)) {
+      check->due = Clock::now() + seconds(check->check.interval_seconds());
+    }
+
+    schedule();
+  }
+
+  void failure(const Owned<Check>& check, const string& message)
+  {
+    if (check->check.grace_period_seconds() > 0 &&
+        (Clock::now() - check->started).secs() <=
+          check->check.grace_period_seconds()) {
+      LOG(INFO) << "Ignoring failure of health check of task "
+                << check->taskId << " as it is still in grace period";
+      return;
+    }
+
+    check->consecutiveFailures++;
+    VLOG(1) << "#" << check->consecutiveFailures << " health check of task "
+            << check->taskId << " failed: " << message;
+
+    bool killTask =
+      check->consecutiveFailures >= check->check.consecutive_failures();
+
+    TaskHealthStatus taskHealthStatus;
+    taskHealthStatus.set_healthy(false);
+    taskHealthStatus.set_consecutive_failures(check->consecutiveFailures);
+    taskHealthStatus.set_kill_task(killTask);
+    taskHealthStatus.mutable_task_id()->CopyFrom(check->taskId);
+    send(check->executor, taskHealthStatus);
+
+    if (killTask) {
+      checks.erase(check->taskId);
+      check->promise.fail(message);
+    }
+  }
+
+  void success(const Owned<Check>& check)
+  {
+    VLOG(1) << "Health check of task " << check->taskId << " passed";
+
+    // Send a healthy status update on the first success,
+    // and on the first success following failure(s).
+    if (check->initializing || check->consecutiveFailures > 0) {
+      TaskHealthStatus taskHealthStatus;
+      taskHealthStatus.set_healthy(true);
+      taskHealthStatus.mutable_task_id()->CopyFrom(check->taskId);
+      send(check->executor, taskHealthStatus);
+      check->initializing = false;
+    }
+    check->consecutiveFailures = 0;
+  }
+
+  static Future<Nothing> command(const HealthCheck& check)
+  {
+    const CommandInfo& command = check.command();
+
+    if (!command.has_value()) {
+      return Failure(command.shell()
+                     ? "Shell command is not specified"
+                     : "Executable path is not specified");
+    }
+
+    map<string, string> environment;
+    foreach (const Environment_Variable& variable,
+             command.environment().variables()) {
+      environment[variable.name()] = variable.value();
+    }
+
+    // Intentionally not sending STDIN to avoid health check commands
+    // that expect STDIN input to block.
+    Try<Subprocess> external = Error("Not launched");
+
+    if (command.shell()) {
+      VLOG(2) << "Launching health command '" << command.value() << "'";
+
+      external = process::subprocess(
+          command.value(),
+          Subprocess::PATH("/dev/null"),
+          Subprocess::FD(STDERR_FILENO),
+          Subprocess::FD(STDERR_FILENO),
+          environment);
+    } else {
+      vector<string> argv;
+      foreach (const string& arg, command.arguments()) {
+        argv.push_back(arg);
+      }
+
+      VLOG(2) << "Launching health command [" << command.value() << ", "
+              << strings::join(", ", argv) << "]";
+
+      external = process::subprocess(
+          command.value(),
+          argv,
+          Subprocess::PATH("/dev/null"),
+          Subprocess::FD(STDERR_FILENO),
+          Subprocess::FD(STDERR_FILENO),
+          None(),
+          environment);
+    }
+
+    if (external.isError()) {
+      return Failure(
+          "Failed to create subprocess for health command: " +
+          external.error());
+    }
+
+    pid_t pid = external.get().pid();
+
+    // Kill the command if the check is discarded (i.e., timed out).
+    return external.get().status()
+      .onDiscard(lambda::bind(&kill, pid))
+      .then(lambda::bind(&_command, lambda::_1));
+  }
+
+  static void kill(pid_t pid)
+  {
+    // The command is run by a shell, so kill the whole tree.
+    Try<std::list<os::ProcessTree> > trees = os::killtree(pid, SIGKILL);
+    if (trees.isError()) {
+      LOG(ERROR) << "Failed to kill the health command at pid " << pid
+                 << ": " << trees.error();
+    }
+  }
+
+  static Future<Nothing> _command(const Option<int>& status)
+  {
+    if (status.isNone()) {
+      return Failure("Failed to reap the health command");
+    }
+
+    if (status.get() != 0) {
+      return Failure("Health command check " + WSTRINGIFY(status.get()));
+    }
+
+    return Nothing();
+  }
+
+  static Future<Nothing> http(const HealthCheck::HTTP& check)
+  {
+    // The request goes to '/<id>' of the UPID, the path is the id.
+    UPID upid(
+        strings::remove(check.path(), "/", strings::PREFIX),
+        Node(htonl(INADDR_LOOPBACK), check.port()));
+
+    VLOG(2) << "Sending health check request to " << upid;
+
+    vector<uint32_t> statuses;
+    foreach (uint32_t status, check.statuses()) {
+      statuses.push_back(status);
+    }
+
+    return http::get(upid)
+      .then(lambda::bind(&_http, statuses, lambda::_1));
+  }
+
+  static Future<Nothing> _http(
+      const vector<uint32_t>& statuses,
+      const http::Response& response)
+  {
+    if (statuses.empty()) {
+      return Nothing();
+    }
+
+    // The status is of the form "200 OK".
+    Try<uint32_t> code =
+      numify<uint32_t>(strings::split(response.status, " ")[0]);
+
+    if (code.isSome()) {
+      foreach (uint32_t status, statuses) {
+        if (code.get() == status) {
+          return Nothing();
+        }
+      }
+    }
+
+    return Failure("Unexpected HTTP response status '" + response.status + "'");
+  }
+
+  static Future<Nothing> tcp(const HealthCheck::TCP& check)
+  {
+    Try<network::Socket> socket = network::Socket::create();
+    if (socket.isError()) {
+      return Failure("Failed to create socket: " + socket.error());
+    }
+
+    // The socket is closed once the last copy of it goes away, i.e.,
+    // once the connection attempt has completed.
+    network::Socket _socket = socket.get();
+
+    return _socket.connect(Node(htonl(INADDR_LOOPBACK), check.port()))
+      .onAny(lambda::bind(&__tcp, _socket));
+  }
+
+  static void __tcp(const network::Socket&) {}
+
+  struct Metrics
+  {
+    Metrics()
+      : checks_passed("health_checker/checks_passed"),
+        checks_failed("health_checker/checks_failed"),
+        check_latency("health_checker/check_latency", Hours(1))
+    {
+      process::metrics::add(checks_passed);
+      process::metrics::add(checks_failed);
+      process::metrics::add(check_latency);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(checks_passed);
+      process::metrics::remove(checks_failed);
+      process::metrics::remove(check_latency);
+    }
+
+    Counter checks_passed;
+    Counter checks_failed;
+
+    process::metrics::Timer<Milliseconds> check_latency;
+  } metrics;
+
+  hashmap<TaskID, Owned<Check> > checks;
+
+  // The single timer for all the checks, armed for the earliest due.
+  Option<Timer> timer;
+};
+
+
+HealthChecker::HealthChecker()
+{
+  process = new HealthCheckerProcess();
+  spawn(process);
+}
+
+
+HealthChecker::~HealthChecker()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<Nothing> HealthChecker::start(
+    const TaskID& taskId,
+    const HealthCheck& check,
+    const UPID& executor)
+{
+  return dispatch(
+      process, &HealthCheckerProcess::start, taskId, check, executor);
+}
+
+
+void HealthChecker::stop(const TaskID& taskId)
+{
+  dispatch(process, &HealthCheckerProcess::stop, taskId);
+}
+
+} // namespace mesos {
@@ -0,0 +1,76 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HEALTH_CHECKER_HPP__
+#define __HEALTH_CHECKER_HPP__
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/pid.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/nothing.hpp>
+
+namespace mesos {
+
+// Forward declaration.
+class HealthCheckerProcess;
+
+
+// Checks are run at most this much ahead of the time they are due
+// (bounded by a tenth of their interval) so that the checks of
+// different tasks that are due at about the same time are run
+// together, on a single timer.
+extern const Duration HEALTH_CHECK_COALESCING_WINDOW;
+
+
+// Performs the health checks of any number of tasks from a single
+// actor. Command checks are run as a (short lived) subprocess per
+// check, while HTTP and TCP checks are done in-process against the
+// port on localhost. Changes in the health of a task are reported as
+// TaskHealthStatus messages, just like 'mesos-health-check' does.
+class HealthChecker
+{
+public:
+  HealthChecker();
+  ~HealthChecker();
+
+  // Starts checking the health of the task, reporting to 'executor'.
+  // The returned future fails once the task is to be killed because
+  // of failed checks or if the check can not be performed at all.
+  // Returns a failure if the health of the task is already checked.
+  process::Future<Nothing> start(
+      const TaskID& taskId,
+      const HealthCheck& check,
+      const process::UPID& executor);
+
+  // Stops checking the health of the task. The future returned by
+  // 'start' is discarded.
+  void stop(const TaskID& taskId);
+
+private:
+  HealthChecker(const HealthChecker&);
+  HealthChecker& operator = (const HealthChecker&);
+
+  HealthCheckerProcess* process;
+};
+
+} // namespace mesos {
+
+#endif // __HEALTH_CHECKER_HPP__
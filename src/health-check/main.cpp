@@ -16,242 +16,31 @@
  * limitations under the License.
  */
 
-#include <signal.h>
-#include <stdio.h>
-#include <string.h>
-#include <unistd.h>
-
 #include <iostream>
 #include <string>
-#include <vector>
 
 #include <mesos/mesos.hpp>
 
-#include <process/defer.hpp>
-#include <process/delay.hpp>
 #include <process/future.hpp>
-#include <process/io.hpp>
 #include <process/pid.hpp>
-#include <process/process.hpp>
-#include <process/protobuf.hpp>
-#include <process/subprocess.hpp>
 
-#include <stout/duration.hpp>
 #include <stout/flags.hpp>
 #include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
-#include <stout/strings.hpp>
-
-#include "common/status_utils.hpp"
 
-#include "messages/messages.hpp"
+#include "health-check/health_checker.hpp"
 
 using namespace mesos;
 
 using std::cout;
 using std::cerr;
 using std::endl;
-using std::map;
 using std::string;
-using std::vector;
 
 using process::UPID;
 
-namespace mesos {
-
-using namespace process;
-
-class HealthCheckerProcess : public ProtobufProcess<HealthCheckerProcess>
-{
-public:
-  HealthCheckerProcess(
-    const HealthCheck& _check,
-    const UPID& _executor,
-    const TaskID& _taskID)
-    : check(_check),
-      initializing(true),
-      executor(_executor),
-      taskID(_taskID),
-      consecutiveFailures(0) {}
-
-  virtual ~HealthCheckerProcess() {}
-
-  Future<Nothing> healthCheck()
-  {
-    VLOG(2) << "Health checks starting in "
-      << Seconds(check.delay_seconds()) << ", grace period "
-      << Seconds(check.grace_period_seconds());
-
-    startTime = Clock::now();
-
-    delay(Seconds(check.delay_seconds()), self(), &Self::_healthCheck);
-    return promise.future();
-  }
-
-private:
-  void failure(const string& message)
-  {
-    if (check.grace_period_seconds() > 0 &&
-        (Clock::now() - startTime).secs() <= check.grace_period_seconds()) {
-      LOG(INFO) << "Ignoring failure as health check still in grace period";
-      reschedule();
-      return;
-    }
-
-    consecutiveFailures++;
-    VLOG(1) << "#" << consecutiveFailures << " check failed: " << message;
-
-    bool killTask = consecutiveFailures >= check.consecutive_failures();
-
-    TaskHealthStatus taskHealthStatus;
-    taskHealthStatus.set_healthy(false);
-    taskHealthStatus.set_consecutive_failures(consecutiveFailures);
-    taskHealthStatus.set_kill_task(killTask);
-    taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
-    send(executor, taskHealthStatus);
-
-    if (killTask) {
-      promise.fail(message);
-    } else {
-      reschedule();
-    }
-  }
-
-  void success()
-  {
-    VLOG(1) << "Check passed";
-
-    // Send a healthy status update on the first success,
-    // and on the first success following failure(s).
-    if (initializing || consecutiveFailures > 0) {
-      TaskHealthStatus taskHealthStatus;
-      taskHealthStatus.set_healthy(true);
-      taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
-      send(executor, taskHealthStatus);
-      initializing = false;
-    }
-    consecutiveFailures = 0;
-    reschedule();
-  }
-
-  void _healthCheck()
-  {
-    if (check.has_http()) {
-      promise.fail("HTTP health check is not supported");
-      return;
-    }
-
-    if (!check.has_command()) {
-      promise.fail("No check found in health check");
-      return;
-    }
-
-    const CommandInfo& command = check.command();
-
-    map<string, string> environment;
-    foreach (const Environment_Variable& variable,
-             command.environment().variables()) {
-      environment[variable.name()] = variable.value();
-    }
-
-    // Launch the subprocess.
-    Option<Try<Subprocess> > external;
-
-    if (command.shell()) {
-      // Use the shell variant.
-      if (!command.has_value()) {
-        promise.fail("Shell command is not specified");
-        return;
-      }
-
-      VLOG(2) << "Launching health command '" << command.value() << "'";
-
-      external = process::subprocess(
-          command.value(),
-          Subprocess::PATH("/dev/null"),
-          Subprocess::FD(STDERR_FILENO),
-          Subprocess::FD(STDERR_FILENO),
-          environment);
-    } else {
-      // Use the exec variant.
-      if (!command.has_value()) {
-        promise.fail("Executable path is not specified");
-        return;
-      }
-
-      vector<string> argv;
-      foreach (const string& arg, command.arguments()) {
-        argv.push_back(arg);
-      }
-
-      VLOG(2) << "Launching health command [" << command.value() << ", "
-              << strings::join(", ", argv) << "]";
-
-      external = process::subprocess(
-          command.value(),
-          argv,
-          Subprocess::PATH("/dev/null"),
-          Subprocess::FD(STDERR_FILENO),
-          Subprocess::FD(STDERR_FILENO),
-          None(),
-          environment);
-    }
-
-    CHECK_SOME(external);
-
-    if (external.get().isError()) {
-      promise.fail("Error creating subprocess for healthcheck");
-      return;
-    }
-
-    Future<Option<int> > status = external.get().get().status();
-    status.await(Seconds(check.timeout_seconds()));
-
-    if (!status.isReady()) {
-      string msg = "Command check failed with reason: ";
-      if (status.isFailed()) {
-        msg += "failed with error: " + status.failure();
-      } else if (status.isDiscarded()) {
-        msg += "status future discarded";
-      } else {
-        msg += "status still pending after timeout " +
-               stringify(Seconds(check.timeout_seconds()));
-      }
-
-      promise.fail(msg);
-      return;
-    }
-
-    int statusCode = status.get().get();
-    if (statusCode != 0) {
-      string message = "Health command check " + WSTRINGIFY(statusCode);
-      failure(message);
-    } else {
-      success();
-    }
-  }
-
-  void reschedule()
-  {
-    VLOG(1) << "Rescheduling health check in "
-      << Seconds(check.interval_seconds());
-
-    delay(Seconds(check.interval_seconds()), self(), &Self::_healthCheck);
-  }
-
-  Promise<Nothing> promise;
-  HealthCheck check;
-  bool initializing;
-  UPID executor;
-  TaskID taskID;
-  uint32_t consecutiveFailures;
-  process::Time startTime;
-};
-
-} // namespace mesos {
-
 
 class Flags : public virtual flags::FlagsBase
 {
@@ -338,12 +127,16 @@ int main(int argc, char** argv)
     return 0;
   }
 
-  if (check.get().has_http() && check.get().has_command()) {
-    LOG(WARNING) << "Both HTTP and Command check passed in";
+  int strategies = (check.get().has_http() ? 1 : 0) +
+                   (check.get().has_tcp() ? 1 : 0) +
+                   (check.get().has_command() ? 1 : 0);
+
+  if (strategies > 1) {
+    LOG(WARNING) << "More than one of HTTP, TCP and Command check passed in";
     return -1;
   }
 
-  if (!check.get().has_http() && !check.get().has_command()) {
+  if (strategies == 0) {
     LOG(WARNING) << "No health check found";
     return -1;
   }
@@ -357,22 +150,13 @@ int main(int argc, char** argv)
   TaskID taskID;
   taskID.set_value(flags.task_id.get());
 
-  HealthCheckerProcess process(
-    check.get(),
-    flags.executor.get(),
-    taskID);
-
-  process::spawn(&process);
+  HealthChecker checker;
 
   process::Future<Nothing> checking =
-    process::dispatch(
-      process, &HealthCheckerProcess::healthCheck);
+    checker.start(taskID, check.get(), flags.executor.get());
 
   checking.await();
 
-  process::terminate(process);
-  process::wait(process);
-
   if (checking.isFailed()) {
     LOG(WARNING) << "Health check failed " << checking.failure();
     return 1;
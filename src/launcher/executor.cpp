@@ -32,6 +32,7 @@
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 #include <process/subprocess.hpp>
@@ -40,7 +41,6 @@
 
 #include <stout/duration.hpp>
 #include <stout/flags.hpp>
-#include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
@@ -51,6 +51,8 @@
 #include "common/type_utils.hpp"
 #include "common/status_utils.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #include "logging/logging.hpp"
 
 #include "messages/messages.hpp"
@@ -76,16 +78,13 @@ class CommandExecutorProcess : public ProtobufProcess<CommandExecutorProcess>
 public:
   CommandExecutorProcess(
       Option<char**> override,
-      const string& healthCheckDir,
       const Duration& shutdownTimeout)
     : launched(false),
       killed(false),
       killedByHealthCheck(false),
       pid(-1),
-      healthPid(-1),
       shutdownTimeout(shutdownTimeout),
       driver(None()),
-      healthCheckDir(healthCheckDir),
       override(override) {}
 
   virtual ~CommandExecutorProcess() {}
@@ -293,9 +292,8 @@ public:
   void killTask(ExecutorDriver* driver, const TaskID& taskId)
   {
     shutdown(driver);
-    if (healthPid != -1) {
-      // Cleanup health check process.
-      ::kill(healthPid, SIGKILL);
+    if (checker.get() != NULL) {
+      checker->stop(taskId);
     }
   }
 
@@ -461,51 +459,30 @@ private:
   void launchHealthCheck(const TaskInfo& task)
   {
     if (task.has_health_check()) {
-      JSON::Object json = JSON::Protobuf(task.health_check());
-
-      // Launch the subprocess using 'exec' style so that quotes can
-      // be properly handled.
-      vector<string> argv(4);
-      argv[0] = "mesos-health-check";
-      argv[1] = "--executor=" + stringify(self());
-      argv[2] = "--health_check_json=" + stringify(json);
-      argv[3] = "--task_id=" + task.task_id().value();
-
-      cout << "Launching health check process: "
-           << path::join(healthCheckDir, "mesos-health-check")
-           << " " << argv[1] << " " << argv[2] << " " << argv[3] << endl;
-
-      Try<Subprocess> healthProcess =
-        process::subprocess(
-          path::join(healthCheckDir, "mesos-health-check"),
-          argv,
-          // Intentionally not sending STDIN to avoid health check
-          // commands that expect STDIN input to block.
-          Subprocess::PATH("/dev/null"),
-          Subprocess::FD(STDOUT_FILENO),
-          Subprocess::FD(STDERR_FILENO));
-
-      if (healthProcess.isError()) {
-        cerr << "Unable to launch health process: " << healthProcess.error();
-      } else {
-        healthPid = healthProcess.get().pid();
+      cout << "Starting health checks of task " << task.task_id() << endl;
 
-        cout << "Health check process launched at pid: "
-             << stringify(healthPid) << endl;
-      }
+      // The health of the task is checked in-process, the results are
+      // sent to us as TaskHealthStatus messages.
+      checker.reset(new HealthChecker());
+      checker->start(task.task_id(), task.health_check(), self())
+        .onFailed(lambda::bind(&healthCheckFailed, lambda::_1));
     }
   }
 
+  static void healthCheckFailed(const string& message)
+  {
+    cerr << "Health checks failed: " << message << endl;
+  }
+
   bool launched;
   bool killed;
   bool killedByHealthCheck;
   pid_t pid;
-  pid_t healthPid;
   Duration shutdownTimeout;
   Timer escalationTimer;
   Option<ExecutorDriver*> driver;
-  string healthCheckDir;
   Option<char**> override;
+  Owned<HealthChecker> checker;
 };
 
 
@@ -514,13 +491,9 @@ class CommandExecutor: public Executor
 public:
   CommandExecutor(
       Option<char**> override,
-      const string& healthCheckDir,
       const Duration& shutdownTimeout)
   {
-    process = new CommandExecutorProcess(
-        override,
-        healthCheckDir,
-        shutdownTimeout);
+    process = new CommandExecutorProcess(override, shutdownTimeout);
     spawn(process);
   }
 
@@ -677,11 +650,7 @@ int main(int argc, char** argv)
     }
   }
 
-  string path = os::getenv("MESOS_LAUNCHER_DIR", false);
-  if (path.empty()) {
-    path = os::realpath(dirname(argv[0])).get();
-  }
-  mesos::CommandExecutor executor(override, path, shutdownTimeout);
+  mesos::CommandExecutor executor(override, shutdownTimeout);
   mesos::MesosExecutorDriver driver(&executor);
   return driver.run() == mesos::DRIVER_STOPPED ? 0 : 1;
 }
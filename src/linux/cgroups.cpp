@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <sys/inotify.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 
@@ -40,9 +41,13 @@
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/reap.hpp>
 
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
@@ -1442,227 +1447,489 @@ private:
 };
 
 
-// The process used to atomically kill all tasks in a cgroup.
-class TasksKiller : public Process<TasksKiller>
+// Interval at which the Destroyer checks whether the cgroups it is
+// freezing have reached the 'FROZEN' state. The cgroup v1 freezer
+// does not notify us when freezing completes, so unless the kernel
+// provides a 'cgroup.events' file we can watch (see below) we poll,
+// once per interval for the whole batch rather than once per cgroup.
+const Duration FREEZE_POLL_INTERVAL = Milliseconds(100);
+
+
+// Interval at which cgroups that are still freezing are asked to
+// freeze again, which lets (older) kernels retry freezing the tasks
+// that they failed to freeze so far.
+const Duration REFREEZE_INTERVAL = Seconds(1);
+
+
+// The process used to destroy cgroups. Destroy requests that arrive
+// together (e.g., when all the containers of a framework get
+// destroyed at once) are processed as a single batch: all the cgroups
+// in the batch are frozen concurrently, every cgroup of a target is
+// killed in bulk as soon as all of them are frozen and the target is
+// removed once all of its processes have been reaped.
+class Destroyer : public Process<Destroyer>
 {
 public:
-  TasksKiller(const string& _hierarchy, const string& _cgroup)
-    : hierarchy(_hierarchy), cgroup(_cgroup) {}
+  Destroyer()
+    : ProcessBase("__cgroups_destroyer__"),
+      latency("cgroups/destroy_latency", Hours(1)) {}
 
-  virtual ~TasksKiller() {}
+  virtual ~Destroyer() {}
 
-  // Return a future indicating the state of the killer.
-  // Failure occurs if any process in the cgroup is unable to be
-  // killed.
-  Future<Nothing> future() { return promise.future(); }
+  // Returns a future that is satisfied once all tasks in the
+  // specified cgroups have been killed and the cgroups have been
+  // removed (nested cgroups first). Failure occurs if any of the
+  // cgroups fails to be destroyed.
+  Future<Nothing> destroy(
+      const string& hierarchy,
+      const vector<string>& cgroups)
+  {
+    Owned<Target> target(new Target(hierarchy, cgroups));
+
+    // Start a new batch after all the currently queued destroy
+    // requests have been added to it.
+    if (pending.empty()) {
+      dispatch(self(), &Self::batch);
+    }
+
+    pending.push_back(target);
+
+    return target->promise.future();
+  }
 
 protected:
   virtual void initialize()
   {
-    // Stop when no one cares.
-    promise.future().onDiscard(lambda::bind(
-        static_cast<void (*)(const UPID&, bool)>(terminate), self(), true));
-
-    killTasks();
+    process::metrics::add(latency);
+
+    // Kernels with a 'cgroup.events' file generate a modify event on
+    // it once the cgroup is frozen, which saves us from polling.
+    int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+      PLOG(WARNING) << "Failed to initialize inotify, falling back to "
+                    << "polling the freezer state of cgroups";
+    } else {
+      inotify = fd;
+      read();
+    }
   }
 
   virtual void finalize()
   {
-    chain.discard();
+    process::metrics::remove(latency);
 
-    // TODO(jieyu): Wait until 'chain' is in DISCARDED state before
-    // discarding 'promise'.
-    promise.discard();
+    if (inotify.isSome()) {
+      reading.discard();
+      os::close(inotify.get());
+    }
   }
 
 private:
-  static Future<Nothing> freezeTimedout(
-      Future<Nothing> future,
-      const PID<TasksKiller>& pid)
+  struct Target
   {
-    // Cancel the freeze operation.
-    // TODO(jieyu): Wait until 'future' is in DISCARDED state before
-    // starting retry.
-    future.discard();
+    Target(const string& _hierarchy, const vector<string>& _cgroups)
+      : hierarchy(_hierarchy),
+        cgroups(_cgroups),
+        start(Clock::now()),
+        freezing(start),
+        refrozen(start) {}
 
-    // We attempt to kill the processes before we thaw again,
-    // due to a bug in the kernel. See MESOS-1758 for more details.
-    // We thaw the cgroup before trying to freeze again to allow any
-    // pending signals to be delivered. See MESOS-1689 for details.
-    // This is a short term hack until we have PID namespace support.
-    return Future<bool>(true)
-      .then(defer(pid, &Self::kill))
-      .then(defer(pid, &Self::thaw))
-      .then(defer(pid, &Self::freeze));
-  }
+    const string hierarchy;
+    const vector<string> cgroups;
+    const Time start;
 
-  void killTasks() {
-    // Chain together the steps needed to kill all tasks in the cgroup.
-    chain = freeze()                     // Freeze the cgroup.
-      .then(defer(self(), &Self::kill))  // Send kill signal.
-      .then(defer(self(), &Self::thaw))  // Thaw cgroup to deliver signal.
-      .then(defer(self(), &Self::reap)); // Wait until all pids are reaped.
+    // When we (last) started freezing the cgroups.
+    Time freezing;
 
-    chain.onAny(defer(self(), &Self::finished, lambda::_1));
+    // When we last asked the cgroups that are still freezing to
+    // freeze again.
+    Time refrozen;
+
+    // Inotify watches on the 'cgroup.events' file of each cgroup, if
+    // the kernel provides one.
+    vector<int> watches;
+
+    Promise<Nothing> promise;
+
+    // Statuses of the processes in the cgroups.
+    list<Future<Option<int> > > statuses;
+  };
+
+  void batch()
+  {
+    VLOG(1) << "Destroying " << pending.size() << " cgroup(s) in a batch";
+
+    // Start freezing all the cgroups in the batch so that the kernel
+    // freezes them concurrently.
+    foreach (const Owned<Target>& target, pending) {
+      Try<Nothing> freeze = Destroyer::freeze(target);
+      if (freeze.isError()) {
+        target->promise.fail(freeze.error());
+        continue;
+      }
+
+      watch(target);
+
+      frozen.push_back(target);
+    }
+
+    pending.clear();
+
+    check();
   }
 
-  Future<Nothing> freeze()
+  void timeout()
   {
-    // TODO(jieyu): This is a workaround for MESOS-1689. We will move
-    // away from freezer once we have pid namespace support.
-    return cgroups::freezer::freeze(hierarchy, cgroup).after(
-        FREEZE_RETRY_INTERVAL,
-        lambda::bind(&freezeTimedout, lambda::_1, self()));
+    scheduled = None();
+    check();
   }
 
-  Future<Nothing> kill()
+  void check()
   {
-    Try<set<pid_t> > processes = cgroups::processes(hierarchy, cgroup);
-    if (processes.isError()) {
-      return Failure(processes.error());
+    list<Owned<Target> > remaining;
+
+    foreach (const Owned<Target>& target, frozen) {
+      // Stop destroying the target if nobody cares.
+      if (target->promise.future().hasDiscard()) {
+        unwatch(target);
+        target->promise.discard();
+        continue;
+      }
+
+      Try<bool> isFrozen = Destroyer::isFrozen(target);
+      if (isFrozen.isError()) {
+        unwatch(target);
+        target->promise.fail(isFrozen.error());
+        continue;
+      }
+
+      if (isFrozen.get()) {
+        unwatch(target);
+        kill(target);
+        continue;
+      }
+
+      // TODO(jieyu): This is a workaround for MESOS-1689. We will
+      // move away from freezer once we have pid namespace support.
+      Try<Nothing> retry = Nothing();
+      if (Clock::now() - target->freezing >= FREEZE_RETRY_INTERVAL) {
+        retry = Destroyer::retry(target);
+      } else if (Clock::now() - target->refrozen >= REFREEZE_INTERVAL) {
+        retry = Destroyer::refreeze(target);
+      }
+
+      if (retry.isError()) {
+        unwatch(target);
+        target->promise.fail(retry.error());
+        continue;
+      }
+
+      remaining.push_back(target);
     }
 
-    // Reaping the frozen pids before we kill (and thaw) ensures we reap the
-    // correct pids.
-    foreach (const pid_t pid, processes.get()) {
-      statuses.push_back(process::reap(pid));
+    frozen = remaining;
+
+    if (frozen.empty()) {
+      return;
     }
 
-    Try<Nothing> kill = cgroups::kill(hierarchy, cgroup, SIGKILL);
-    if (kill.isError()) {
-      return Failure(kill.error());
+    // Targets we get notified about only need to be checked again
+    // once it is time to ask them to freeze again.
+    Duration interval = REFREEZE_INTERVAL;
+    foreach (const Owned<Target>& target, frozen) {
+      if (target->watches.size() < target->cgroups.size()) {
+        interval = FREEZE_POLL_INTERVAL;
+        break;
+      }
     }
 
-    return Nothing();
+    const Time deadline = Clock::now() + interval;
+    if (scheduled.isNone() || deadline < scheduled.get()) {
+      scheduled = deadline;
+      delay(interval, self(), &Self::timeout);
+    }
   }
 
-  Future<Nothing> thaw()
+  void watch(const Owned<Target>& target)
   {
-    return cgroups::freezer::thaw(hierarchy, cgroup);
+    if (inotify.isNone()) {
+      return;
+    }
+
+    foreach (const string& cgroup, target->cgroups) {
+      const string events =
+        path::join(target->hierarchy, cgroup, "cgroup.events");
+
+      if (!os::exists(events)) {
+        continue;
+      }
+
+      int wd = ::inotify_add_watch(inotify.get(), events.c_str(), IN_MODIFY);
+      if (wd < 0) {
+        PLOG(WARNING) << "Failed to watch '" << events << "'";
+        continue;
+      }
+
+      target->watches.push_back(wd);
+    }
   }
 
-  Future<list<Option<int> > > reap()
+  void unwatch(const Owned<Target>& target)
   {
-    // Wait until we've reaped all processes.
-    return collect(statuses);
+    // NOTE: The watches are removed by the kernel (IN_IGNORED) if
+    // the cgroup got removed in the meantime, in which case this is
+    // a no-op.
+    foreach (int wd, target->watches) {
+      ::inotify_rm_watch(inotify.get(), wd);
+    }
+
+    target->watches.clear();
   }
 
-  void finished(const Future<list<Option<int> > >& future)
+  void read()
   {
-    if (future.isDiscarded()) {
-      promise.fail("Unexpected discard of future");
-      terminate(self());
-      return;
-    } else if (future.isFailed()) {
-      promise.fail(future.failure());
-      terminate(self());
-      return;
-    }
+    reading = io::poll(inotify.get(), io::READ)
+      .onAny(defer(self(), &Self::_read));
+  }
 
-    // Verify the cgroup is now empty.
-    Try<set<pid_t> > processes = cgroups::processes(hierarchy, cgroup);
-    if (processes.isError() || !processes.get().empty()) {
-      promise.fail("Failed to kill all processes in cgroup: " +
-                   (processes.isError() ? processes.error()
-                                        : "processes remain"));
-      terminate(self());
-      return;
+  void _read()
+  {
+    // We only care that something changed, not about the events.
+    char buffer[4096] __attribute__((aligned(8)));
+
+    while (true) {
+      ssize_t length = ::read(inotify.get(), buffer, sizeof(buffer));
+
+      if (length == -1 && errno == EINTR) {
+        continue;
+      } else if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else if (length <= 0) {
+        LOG(ERROR) << "Failed to read inotify events, falling back to "
+                   << "polling the freezer state of cgroups: "
+                   << (length == 0 ? "EOF" : strerror(errno));
+
+        foreach (const Owned<Target>& target, frozen) {
+          target->watches.clear();
+        }
+
+        os::close(inotify.get());
+        inotify = None();
+
+        check();
+        return;
+      }
     }
 
-    promise.set(Nothing());
-    terminate(self());
+    check();
+
+    read();
   }
 
-  const string hierarchy;
-  const string cgroup;
-  Promise<Nothing> promise;
-  list<Future<Option<int> > > statuses; // List of statuses for processes.
-  Future<list<Option<int> > > chain; // Used to discard all operations.
-};
+  static Try<Nothing> freeze(const Owned<Target>& target)
+  {
+    foreach (const string& cgroup, target->cgroups) {
+      Try<Nothing> freeze =
+        internal::freezer::state(target->hierarchy, cgroup, "FROZEN");
+      if (freeze.isError()) {
+        return Error("Failed to freeze cgroup '" + cgroup + "': " +
+                     freeze.error());
+      }
+    }
 
+    target->freezing = Clock::now();
+    target->refrozen = target->freezing;
 
-// The process used to destroy a cgroup.
-class Destroyer : public Process<Destroyer>
-{
-public:
-  Destroyer(const string& _hierarchy, const vector<string>& _cgroups)
-    : hierarchy(_hierarchy), cgroups(_cgroups) {}
+    return Nothing();
+  }
 
-  virtual ~Destroyer() {}
+  // Returns whether all the cgroups of the target are frozen.
+  static Try<bool> isFrozen(const Owned<Target>& target)
+  {
+    foreach (const string& cgroup, target->cgroups) {
+      Try<string> state = internal::freezer::state(target->hierarchy, cgroup);
+      if (state.isError()) {
+        return Error("Failed to read the freezer state of cgroup '" +
+                     cgroup + "': " + state.error());
+      } else if (state.get() != "FROZEN") {
+        return false;
+      }
+    }
 
-  // Return a future indicating the state of the destroyer.
-  // Failure occurs if any cgroup fails to be destroyed.
-  Future<Nothing> future() { return promise.future(); }
+    return true;
+  }
 
-protected:
-  virtual void initialize()
+  // Asks the cgroups of the target that are still freezing to freeze
+  // again, as the per-cgroup freezer used to do.
+  static Try<Nothing> refreeze(const Owned<Target>& target)
   {
-    // Stop when no one cares.
-    promise.future().onDiscard(lambda::bind(
-        static_cast<void (*)(const UPID&, bool)>(terminate), self(), true));
-
-    // Kill tasks in the given cgroups in parallel. Use collect mechanism to
-    // wait until all kill processes finish.
-    foreach (const string& cgroup, cgroups) {
-      internal::TasksKiller* killer =
-        new internal::TasksKiller(hierarchy, cgroup);
-      killers.push_back(killer->future());
-      spawn(killer, true);
+    foreach (const string& cgroup, target->cgroups) {
+      Try<string> state = internal::freezer::state(target->hierarchy, cgroup);
+      if (state.isError()) {
+        return Error("Failed to read the freezer state of cgroup '" +
+                     cgroup + "': " + state.error());
+      } else if (state.get() != "FROZEN") {
+        Try<Nothing> freeze =
+          internal::freezer::state(target->hierarchy, cgroup, "FROZEN");
+        if (freeze.isError()) {
+          return Error("Failed to freeze cgroup '" + cgroup + "': " +
+                       freeze.error());
+        }
+      }
     }
 
-    collect(killers)
-      .onAny(defer(self(), &Destroyer::killed, lambda::_1));
+    target->refrozen = Clock::now();
+
+    return Nothing();
   }
 
-  virtual void finalize()
+  // Freezing a cgroup may get stuck, in which case we thaw the
+  // cgroup(s) to allow any pending signals to be delivered and try
+  // freezing them again. See MESOS-1689 for details. We attempt to
+  // kill the processes before we thaw due to a bug in the kernel,
+  // see MESOS-1758 for more details.
+  static Try<Nothing> retry(const Owned<Target>& target)
   {
-    discard(killers);
-    promise.discard();
+    LOG(WARNING) << "Failed to freeze cgroup(s) "
+                 << stringify(target->cgroups)
+                 << " after " << FREEZE_RETRY_INTERVAL << ", retrying";
+
+    foreach (const string& cgroup, target->cgroups) {
+      Try<Nothing> kill = cgroups::kill(target->hierarchy, cgroup, SIGKILL);
+      if (kill.isError()) {
+        return Error(kill.error());
+      }
+
+      Try<Nothing> thaw =
+        internal::freezer::state(target->hierarchy, cgroup, "THAWED");
+      if (thaw.isError()) {
+        return Error("Failed to thaw cgroup '" + cgroup + "': " +
+                     thaw.error());
+      }
+    }
+
+    return freeze(target);
   }
 
-private:
-  void killed(const Future<list<Nothing> >& kill)
+  void kill(const Owned<Target>& target)
   {
-    if (kill.isReady()) {
-      remove();
-    } else if (kill.isDiscarded()) {
-      promise.discard();
-      terminate(self());
-    } else if (kill.isFailed()) {
-      promise.fail("Failed to kill tasks in nested cgroups: " +
-                   kill.failure());
-      terminate(self());
+    // Reaping the frozen pids before we kill (and thaw) ensures we
+    // reap the correct pids.
+    foreach (const string& cgroup, target->cgroups) {
+      Try<set<pid_t> > processes =
+        cgroups::processes(target->hierarchy, cgroup);
+      if (processes.isError()) {
+        target->promise.fail(processes.error());
+        return;
+      }
+
+      foreach (const pid_t pid, processes.get()) {
+        target->statuses.push_back(process::reap(pid));
+      }
+    }
+
+    // Send the kill signal to all the (frozen) processes and then
+    // thaw all the cgroups to deliver it.
+    foreach (const string& cgroup, target->cgroups) {
+      Try<Nothing> kill = cgroups::kill(target->hierarchy, cgroup, SIGKILL);
+      if (kill.isError()) {
+        target->promise.fail(kill.error());
+        return;
+      }
     }
+
+    foreach (const string& cgroup, target->cgroups) {
+      Try<Nothing> thaw =
+        internal::freezer::state(target->hierarchy, cgroup, "THAWED");
+      if (thaw.isError()) {
+        target->promise.fail("Failed to thaw cgroup '" + cgroup + "': " +
+                             thaw.error());
+        return;
+      }
+    }
+
+    // Wait until we've reaped all processes.
+    collect(target->statuses)
+      .onAny(defer(self(), &Self::killed, target, lambda::_1));
   }
 
-  void remove()
+  void killed(
+      const Owned<Target>& target,
+      const Future<list<Option<int> > >& future)
   {
-    foreach (const string& cgroup, cgroups) {
-      Try<Nothing> remove = internal::remove(hierarchy, cgroup);
+    if (target->promise.future().hasDiscard()) {
+      target->promise.discard();
+      return;
+    } else if (future.isDiscarded()) {
+      target->promise.fail("Unexpected discard of future");
+      return;
+    } else if (future.isFailed()) {
+      target->promise.fail(
+          "Failed to kill tasks in nested cgroups: " + future.failure());
+      return;
+    }
+
+    foreach (const string& cgroup, target->cgroups) {
+      // Verify the cgroup is now empty.
+      Try<set<pid_t> > processes =
+        cgroups::processes(target->hierarchy, cgroup);
+      if (processes.isError() || !processes.get().empty()) {
+        target->promise.fail(
+            "Failed to kill tasks in nested cgroups: "
+            "Failed to kill all processes in cgroup: " +
+            (processes.isError() ? processes.error() : "processes remain"));
+        return;
+      }
+    }
+
+    foreach (const string& cgroup, target->cgroups) {
+      Try<Nothing> remove = internal::remove(target->hierarchy, cgroup);
       if (remove.isError()) {
-        promise.fail(
+        target->promise.fail(
             "Failed to remove cgroup '" + cgroup + "': " + remove.error());
-        terminate(self());
         return;
       }
     }
 
-    promise.set(Nothing());
-    terminate(self());
+    const Duration elapsed = Clock::now() - target->start;
+
+    VLOG(1) << "Destroyed cgroup(s) " << stringify(target->cgroups)
+            << " in " << elapsed;
+
+    latency.record(elapsed);
+
+    target->promise.set(Nothing());
   }
 
-  const string hierarchy;
-  const vector<string> cgroups;
-  Promise<Nothing> promise;
+  // Inotify instance used to watch the 'cgroup.events' files, if any.
+  Option<int> inotify;
+  Future<short> reading;
 
-  // The killer processes used to atomically kill tasks in each cgroup.
-  list<Future<Nothing> > killers;
+  // When the next check is scheduled, if any.
+  Option<Time> scheduled;
+
+  // Targets waiting for the next batch to start.
+  list<Owned<Target> > pending;
+
+  // Targets whose cgroups are being frozen.
+  list<Owned<Target> > frozen;
+
+  // Time it took to destroy each (top level) cgroup, i.e., the
+  // teardown latency of each container.
+  process::metrics::Timer<Milliseconds> latency;
 };
 
-} // namespace internal {
 
+// Returns the (lazily spawned) process used to destroy cgroups.
+static PID<Destroyer> destroyer()
+{
+  static PID<Destroyer> pid = spawn(new Destroyer(), true);
+  return pid;
+}
 
-Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
+
+// Destroys the specified cgroup (and all of its nested cgroups).
+static Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
 {
   // Construct the vector of cgroups to destroy.
   Try<vector<string> > cgroups = cgroups::get(hierarchy, cgroup);
@@ -1683,11 +1950,11 @@ Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
   // If the freezer subsystem is available, destroy the cgroups.
   Option<Error> error = verify(hierarchy, cgroup, "freezer.state");
   if (error.isNone()) {
-    internal::Destroyer* destroyer =
-      new internal::Destroyer(hierarchy, candidates);
-    Future<Nothing> future = destroyer->future();
-    spawn(destroyer, true);
-    return future;
+    return dispatch(
+        destroyer(),
+        &Destroyer::destroy,
+        hierarchy,
+        candidates);
   } else {
     // Otherwise, attempt to remove the cgroups in bottom-up fashion.
     foreach (const string& cgroup, candidates) {
@@ -1701,6 +1968,14 @@ Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
   return Nothing();
 }
 
+} // namespace internal {
+
+
+Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
+{
+  return internal::destroy(hierarchy, cgroup);
+}
+
 
 static void __destroy(
     const Future<Nothing>& future,
@@ -341,6 +341,10 @@ process::Future<uint64_t> listen(
 // of the cgroups.
 // NOTE: If cgroup is "/" (default), all cgroups under the
 // hierarchy are destroyed.
+// NOTE: Concurrent calls are batched: their cgroups are frozen
+// concurrently and the tasks in each cgroup are killed in bulk once
+// all of its nested cgroups are frozen. The time each call takes is
+// exported as the 'cgroups/destroy_latency_ms' metric.
 // TODO(vinod): Add support for killing tasks when freezer subsystem
 // is not present.
 // @param   hierarchy Path to the hierarchy root.
@@ -16,6 +16,14 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/perf_event.h>
+
+#include <sys/syscall.h>
+
 #include <list>
 #include <ostream>
 #include <vector>
@@ -27,6 +35,13 @@
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
 #include "linux/perf.hpp"
@@ -250,6 +265,117 @@ Future<mesos::PerfStatistics> select(
   return statistics.get(key).get();
 }
 
+
+// A perf event that can be counted natively, see Counters.
+struct Event
+{
+  const char* name; // As accepted by 'perf stat'.
+  uint32_t type;
+  uint64_t config;
+};
+
+
+const Event EVENTS[] = {
+  // Hardware events.
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "stalled-cycles-frontend",
+    PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+  { "stalled-cycles-backend",
+    PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+  { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+  { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES },
+  { "ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES },
+
+  // Software events.
+  { "cpu-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK },
+  { "task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+  { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+  { "minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN },
+  { "major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ },
+  { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+  { "cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+  { "alignment-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS },
+  { "emulation-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS },
+};
+
+
+// The maximum number of hardware events that are counted as a group.
+// The kernel only counts a group while all of its events fit on the
+// hardware counters at once, so this should not exceed the number of
+// (general purpose) hardware counters, which is at least 4 on common
+// processors.
+const size_t HARDWARE_GROUP_SIZE = 4;
+
+
+Option<Event> lookup(const string& name)
+{
+  foreach (const Event& event, EVENTS) {
+    if (name == event.name) {
+      return event;
+    }
+  }
+
+  return None();
+}
+
+
+// Reads the values of a counter, see 'read_format' in
+// perf_event_open(2).
+Try<Nothing> read(int fd, vector<uint64_t>* values)
+{
+  const size_t length = values->size() * sizeof(uint64_t);
+
+  ssize_t read = ::read(fd, values->data(), length);
+  if (read == -1) {
+    return ErrnoError();
+  } else if (static_cast<size_t>(read) != length) {
+    return Error("Read " + stringify(read) + " of " + stringify(length) +
+                 " bytes");
+  }
+
+  return Nothing();
+}
+
+
+// Returns the ids of the online cpus.
+Try<vector<int> > cpus()
+{
+  Try<string> read = os::read("/sys/devices/system/cpu/online");
+  if (read.isError()) {
+    return Error("Failed to determine the online cpus: " + read.error());
+  }
+
+  // The format is a list of ranges, e.g., "0-3,5,7-8".
+  vector<int> cpus;
+
+  const string online = strings::trim(read.get());
+
+  foreach (const string& range, strings::tokenize(online, ",")) {
+    vector<string> tokens = strings::tokenize(range, "-");
+    if (tokens.empty() || tokens.size() > 2) {
+      return Error("Unexpected format of online cpus: " + online);
+    }
+
+    Try<int> first = numify<int>(tokens.front());
+    Try<int> last = numify<int>(tokens.back());
+    if (first.isError() || last.isError()) {
+      return Error("Unexpected format of online cpus: " + online);
+    }
+
+    for (int cpu = first.get(); cpu <= last.get(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
 } // namespace internal {
 
 
@@ -408,4 +534,288 @@ Try<hashmap<string, mesos::PerfStatistics> > parse(const string& output)
   return statistics;
 }
 
+
+
+Try<Counters*> Counters::create(
+    const set<string>& events,
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<vector<int> > cpus = internal::cpus();
+  if (cpus.isError()) {
+    return Error(cpus.error());
+  }
+
+  // In cgroup mode, the "pid" is a file descriptor of the cgroup
+  // directory. It can be closed once the counters are opened.
+  Try<int> fd = os::open(path::join(hierarchy, cgroup), O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open cgroup '" + cgroup + "': " + fd.error());
+  }
+
+  Counters* counters = new Counters();
+
+  Try<Nothing> open =
+    counters->open(events, fd.get(), cpus.get(), PERF_FLAG_PID_CGROUP);
+
+  os::close(fd.get());
+
+  if (open.isError()) {
+    delete counters;
+    return Error(open.error());
+  }
+
+  return counters;
+}
+
+
+Try<Counters*> Counters::create(const set<string>& events, pid_t pid)
+{
+  Counters* counters = new Counters();
+
+  Try<Nothing> open = counters->open(events, pid, vector<int>(1, -1), 0);
+
+  if (open.isError()) {
+    delete counters;
+    return Error(open.error());
+  }
+
+  return counters;
+}
+
+
+Counters::~Counters()
+{
+  foreach (const Group& group, groups) {
+    foreach (const vector<int>& fds, group.fds) {
+      foreach (int fd, fds) {
+        os::close(fd);
+      }
+    }
+  }
+}
+
+
+Try<Nothing> Counters::open(
+    const set<string>& events,
+    pid_t pid,
+    const vector<int>& cpus,
+    unsigned long flags)
+{
+  // Count the threads and processes created later on as well (which
+  // is implied for cgroups). Such counters can't be read as a group.
+  const bool inherit = (flags & PERF_FLAG_PID_CGROUP) == 0;
+
+  grouped = !inherit;
+
+  vector<internal::Event> software;
+  vector<internal::Event> hardware;
+
+  foreach (const string& name, events) {
+    Option<internal::Event> event = internal::lookup(name);
+    if (event.isNone()) {
+      return Error("Unsupported perf event '" + name + "'");
+    }
+
+    if (event.get().type == PERF_TYPE_SOFTWARE) {
+      software.push_back(event.get());
+    } else {
+      hardware.push_back(event.get());
+    }
+  }
+
+  // The software events can always be counted together, the hardware
+  // events only as many as there are hardware counters.
+  vector<vector<internal::Event> > sets;
+
+  if (!grouped) {
+    foreach (const internal::Event& event, software) {
+      sets.push_back(vector<internal::Event>(1, event));
+    }
+
+    foreach (const internal::Event& event, hardware) {
+      sets.push_back(vector<internal::Event>(1, event));
+    }
+  } else {
+    if (!software.empty()) {
+      sets.push_back(software);
+    }
+
+    for (size_t i = 0;
+         i < hardware.size();
+         i += internal::HARDWARE_GROUP_SIZE) {
+      sets.push_back(vector<internal::Event>(
+          hardware.begin() + i,
+          hardware.begin() +
+            std::min(i + internal::HARDWARE_GROUP_SIZE, hardware.size())));
+    }
+  }
+
+  foreach (const vector<internal::Event>& members, sets) {
+    groups.push_back(Group());
+
+    Group& group = groups.back();
+
+    foreach (const internal::Event& event, members) {
+      group.events.push_back(event.name);
+      group.previous.push_back(0);
+    }
+
+    foreach (int cpu, cpus) {
+      group.fds.push_back(vector<int>());
+
+      foreach (const internal::Event& event, members) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+
+        // Needed to scale the counts if the counters get multiplexed.
+        attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        if (grouped) {
+          attr.read_format |= PERF_FORMAT_GROUP;
+        }
+
+        attr.inherit = inherit ? 1 : 0;
+
+        // The first event on each cpu leads the group.
+        const int leader =
+          group.fds.back().empty() ? -1 : group.fds.back().front();
+
+        int fd = ::syscall(
+            __NR_perf_event_open, &attr, pid, cpu, leader, flags);
+
+        if (fd == -1) {
+          return ErrnoError(
+              "Failed to open perf event '" + string(event.name) + "'");
+        }
+
+        os::cloexec(fd);
+
+        group.fds.back().push_back(fd);
+      }
+    }
+  }
+
+  previous = Clock::now();
+
+  return Nothing();
+}
+
+
+Try<mesos::PerfStatistics> Counters::sample()
+{
+  const Time now = Clock::now();
+
+  mesos::PerfStatistics statistics;
+  statistics.set_timestamp(previous.secs());
+  statistics.set_duration((now - previous).secs());
+
+  foreach (Group& group, groups) {
+    const size_t size = group.events.size();
+
+    vector<double> totals(size, 0);
+
+    foreach (const vector<int>& fds, group.fds) {
+      if (grouped) {
+        // The number of events, the time enabled, the time running
+        // and the value of each event, read through the leader.
+        vector<uint64_t> values(3 + size);
+
+        Try<Nothing> read = internal::read(fds.front(), &values);
+        if (read.isError()) {
+          return Error("Failed to read perf event '" + group.events.front() +
+                       "': " + read.error());
+        }
+
+        // Scale the counts up to the time the counters were enabled,
+        // in case they were only running part of the time.
+        if (values[2] > 0) {
+          for (size_t i = 0; i < size; i++) {
+            totals[i] +=
+              values[3 + i] * (static_cast<double>(values[1]) / values[2]);
+          }
+        }
+
+        continue;
+      }
+
+      for (size_t i = 0; i < size; i++) {
+        // The value, the time enabled and the time running.
+        vector<uint64_t> values(3);
+
+        Try<Nothing> read = internal::read(fds[i], &values);
+        if (read.isError()) {
+          return Error("Failed to read perf event '" + group.events[i] +
+                       "': " + read.error());
+        }
+
+        if (values[2] > 0) {
+          totals[i] += values[0] * (static_cast<double>(values[1]) / values[2]);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      // NOTE: Scaled counts are estimates which might not be
+      // monotonic.
+      const double count = std::max(totals[i] - group.previous[i], 0.0);
+      group.previous[i] = totals[i];
+
+      const google::protobuf::Reflection* reflection =
+        statistics.GetReflection();
+      const google::protobuf::FieldDescriptor* field =
+        statistics.GetDescriptor()->FindFieldByName(
+            internal::normalize(group.events[i]));
+
+      CHECK_NOTNULL(field);
+
+      switch (field->type()) {
+        case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+          // The clocks are counted in nanoseconds but 'perf stat'
+          // reports them in milliseconds.
+          reflection->SetDouble(&statistics, field, count / 1000000.0);
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_UINT64:
+          reflection->SetUInt64(
+              &statistics, field, static_cast<uint64_t>(count + 0.5));
+          break;
+        default:
+          return Error(
+              "Unsupported perf field type for '" + group.events[i] + "'");
+      }
+    }
+  }
+
+  previous = now;
+
+  return statistics;
+}
+
+
+bool native(const set<string>& events)
+{
+  foreach (const string& event, events) {
+    if (internal::lookup(event).isNone()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+Try<size_t> descriptors(const set<string>& events)
+{
+  Try<vector<int> > cpus = internal::cpus();
+  if (cpus.isError()) {
+    return Error(cpus.error());
+  }
+
+  return events.size() * cpus.get().size();
+}
+
 } // namespace perf {
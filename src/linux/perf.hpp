@@ -23,11 +23,15 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
 
 // For PerfStatistics protobuf.
 #include "mesos/mesos.hpp"
@@ -78,6 +82,84 @@ bool supported();
 Try<hashmap<std::string, mesos::PerfStatistics> > parse(
     const std::string& output);
 
+
+// Counters for perf events that are opened directly using
+// perf_event_open(2) and read periodically, rather than sampled by
+// running 'perf stat' for a duration each time. Only the hardware
+// and software events (see 'perf list') are supported, see 'native'.
+// NOTE: Every counter holds a file descriptor for as long as the
+// Counters exist, see 'descriptors'.
+class Counters
+{
+public:
+  // Opens counters for the processes in the perf_event cgroup, one
+  // per event and online cpu. The counters on a cpu are grouped so
+  // that they are read at once.
+  // NOTE: cgroup should be relative to the perf_event subsystem
+  // mount (the hierarchy), e.g., mesos/test for
+  // /sys/fs/cgroup/perf_event/mesos/test.
+  static Try<Counters*> create(
+      const std::set<std::string>& events,
+      const std::string& hierarchy,
+      const std::string& cgroup);
+
+  // Opens counters for the process pid, including the threads and
+  // processes it creates afterwards.
+  static Try<Counters*> create(
+      const std::set<std::string>& events,
+      pid_t pid);
+
+  ~Counters();
+
+  // Returns the counts since the previous sample (or since the
+  // counters were opened). Counts are scaled up if the kernel had
+  // to multiplex the counters.
+  Try<mesos::PerfStatistics> sample();
+
+private:
+  // Events that are counted together, i.e., the kernel only counts
+  // them while it can count all of them.
+  struct Group
+  {
+    std::vector<std::string> events;
+
+    // The file descriptors of the events on each cpu, the first one
+    // being the group leader.
+    std::vector<std::vector<int> > fds;
+
+    // The (scaled) counts of the events up to the previous sample.
+    std::vector<double> previous;
+  };
+
+  Counters() : grouped(false) {}
+  Counters(const Counters&);
+  Counters& operator = (const Counters&);
+
+  // Opens a counter for each of the events on each of the cpus
+  // (where -1 stands for any cpu), see perf_event_open(2).
+  Try<Nothing> open(
+      const std::set<std::string>& events,
+      pid_t pid,
+      const std::vector<int>& cpus,
+      unsigned long flags);
+
+  // Whether the groups are read at once through their leader, which
+  // is not supported when the counters are inherited.
+  bool grouped;
+
+  std::vector<Group> groups;
+  process::Time previous;
+};
+
+
+// Returns whether all the events can be counted using Counters.
+bool native(const std::set<std::string>& events);
+
+
+// Returns the number of file descriptors that Counters hold for the
+// events in a perf_event cgroup, i.e., one per event and online cpu.
+Try<size_t> descriptors(const std::set<std::string>& events);
+
 } // namespace perf {
 
 #endif // __PERF_HPP__
@@ -18,13 +18,18 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <list>
+#include <map>
+#include <set>
 
 #include <process/collect.hpp>
+#include <process/delay.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/stringify.hpp>
 
@@ -36,10 +41,18 @@
 using namespace process;
 
 using std::list;
+using std::map;
+using std::set;
 
 namespace mesos {
 namespace log {
 
+// The maximum number of positions that are caught-up in one batch,
+// i.e., that the other replicas are asked to send the actions they
+// have learned for at a time.
+static const uint64_t CATCHUP_BATCH_SIZE = 1000;
+
+
 class CatchUpProcess : public Process<CatchUpProcess>
 {
 public:
@@ -166,10 +179,14 @@ static Future<uint64_t> catchup(
 }
 
 
-// TODO(jieyu): Our current implementation catches-up each position in
-// the set sequentially. In the future, we may want to parallelize it
-// to improve the performance. Also, we may want to implement rate
-// control here so that we don't saturate the network or disk.
+// Catches-up an interval of positions in batches. For each batch,
+// the other replicas are first asked for the actions they have
+// learned in it, which are persisted locally in one write. Only the
+// positions that are still missing after that (i.e., that none of
+// the replicas that responded have learned) are caught-up one at a
+// time using Paxos.
+// TODO(jieyu): We may want to implement rate control here so that we
+// don't saturate the network or disk.
 class BulkCatchUpProcess : public Process<BulkCatchUpProcess>
 {
 public:
@@ -202,11 +219,15 @@ protected:
     // Catch-up sequentially.
     current = positions.lower();
 
-    catchup();
+    transfer();
   }
 
   virtual void finalize()
   {
+    broadcasting.discard();
+    discard(responses);
+    learning.discard();
+    checking.discard();
     catching.discard();
 
     // TODO(benh): Discard our promise only after 'catching' has
@@ -220,7 +241,16 @@ private:
     catching.discard();
   }
 
-  void catchup()
+  static void discard(const set<Future<CatchUpResponse> >& futures)
+  {
+    foreach (Future<CatchUpResponse> future, futures) {
+      future.discard();
+    }
+  }
+
+  // Asks the other replicas for the actions they have learned in the
+  // next batch of positions.
+  void transfer()
   {
     if (current >= positions.upper()) {
       // Stop the process if there is nothing left to catch-up. This
@@ -230,9 +260,157 @@ private:
       return;
     }
 
+    // The batch is [current, end).
+    end = std::min(current + CATCHUP_BATCH_SIZE, positions.upper());
+
+    CatchUpRequest request;
+    request.set_from(current);
+    request.set_to(end - 1);
+
+    set<UPID> filter;
+    filter.insert(replica->pid());
+
+    broadcasting = network->broadcast(protocol::catchup, request, filter);
+    broadcasting.onAny(defer(self(), &Self::broadcasted));
+  }
+
+  void broadcasted()
+  {
+    // The future 'broadcasting' can only be discarded in 'finalize'.
+    CHECK(!broadcasting.isDiscarded());
+
+    if (broadcasting.isFailed()) {
+      promise.fail(
+          "Failed to broadcast catch-up request: " +
+          broadcasting.failure());
+      terminate(self());
+      return;
+    }
+
+    responses = broadcasting.get();
+
+    if (responses.empty()) {
+      learn();
+      return;
+    }
+
+    foreach (const Future<CatchUpResponse>& response, responses) {
+      response.onAny(defer(self(), &Self::received, response));
+    }
+
+    // Don't wait for the replicas that do not respond in time, the
+    // positions they could have provided are filled instead.
+    delay(timeout, self(), &Self::expired, current);
+  }
+
+  void received(const Future<CatchUpResponse>& response)
+  {
+    if (responses.count(response) == 0) {
+      return; // A response from an earlier batch.
+    }
+
+    responses.erase(response);
+
+    if (response.isReady()) {
+      // The replica only covered part of the batch to bound the size
+      // of its response, so the batch is shortened and the remaining
+      // positions are asked for in the next one.
+      if (response.get().has_to() && response.get().to() + 1 < end) {
+        end = std::max(response.get().to() + 1, current + 1);
+        actions.erase(actions.lower_bound(end), actions.end());
+      }
+
+      foreach (const Action& action, response.get().actions()) {
+        if (action.has_learned() && action.learned() &&
+            action.position() >= current && action.position() < end) {
+          actions[action.position()] = action;
+        }
+      }
+    }
+
+    // Stop waiting if all of the replicas responded, or if the ones
+    // that did have learned all of the positions in the batch.
+    if (responses.empty() || actions.size() == end - current) {
+      learn();
+    }
+  }
+
+  void expired(uint64_t from)
+  {
+    if (from == current && !responses.empty()) {
+      LOG(INFO) << "Not all replicas responded to the catch-up request "
+                << "for positions " << current << " -> " << end - 1
+                << " in " << timeout;
+
+      learn();
+    }
+  }
+
+  // Persists the learned actions of the batch locally.
+  void learn()
+  {
+    discard(responses);
+    responses.clear();
+
+    list<Action> learned;
+    foreachvalue (const Action& action, actions) {
+      learned.push_back(action);
+    }
+    actions.clear();
+
+    learning = replica->learn(learned);
+    learning.onAny(defer(self(), &Self::learned));
+  }
+
+  void learned()
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
+
+    if (!learning.isReady() || !learning.get()) {
+      promise.fail(
+          "Failed to persist learned actions: " +
+          (learning.isFailed() ? learning.failure() : "not persisted"));
+      terminate(self());
+      return;
+    }
+
+    // Determine the positions of the batch that still need to be
+    // caught-up using Paxos.
+    checking = replica->missing(current, end - 1);
+    checking.onAny(defer(self(), &Self::checked));
+  }
+
+  void checked()
+  {
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      promise.fail("Failed to get missing positions: " + checking.failure());
+      terminate(self());
+      return;
+    }
+
+    missing = checking.get();
+
+    catchup();
+  }
+
+  void catchup()
+  {
+    if (missing.empty()) {
+      // Move on to the next batch.
+      current = end;
+      transfer();
+      return;
+    }
+
+    position = missing.begin()->lower();
+
     // Store the future so that we can discard it if the user wants to
     // cancel the catch-up operation.
-    catching = log::catchup(quorum, replica, network, proposal, current)
+    catching = log::catchup(quorum, replica, network, proposal, position)
       .onDiscarded(defer(self(), &Self::discarded))
       .onFailed(defer(self(), &Self::failed))
       .onReady(defer(self(), &Self::succeeded));
@@ -240,10 +418,9 @@ private:
     Clock::timer(timeout, lambda::bind(&Self::timedout, catching));
   }
 
-
   void discarded()
   {
-    LOG(INFO) << "Unable to catch-up position " << current
+    LOG(INFO) << "Unable to catch-up position " << position
               << " in " << timeout << ", retrying";
 
     catchup();
@@ -252,7 +429,7 @@ private:
   void failed()
   {
     promise.fail(
-        "Failed to catch-up position " + stringify(current) +
+        "Failed to catch-up position " + stringify(position) +
         ": " + catching.failure());
 
     terminate(self());
@@ -260,7 +437,7 @@ private:
 
   void succeeded()
   {
-    ++current;
+    missing -= position;
 
     // The single position catch-up function: 'log::catchup' will
     // return the highest proposal number seen so far. We use this
@@ -279,9 +456,25 @@ private:
   const Duration timeout;
 
   uint64_t proposal;
+
+  // The current batch of positions: [current, end).
   uint64_t current;
+  uint64_t end;
+
+  // The outstanding catch-up responses for the current batch and the
+  // learned actions received so far (ordered by position).
+  set<Future<CatchUpResponse> > responses;
+  map<uint64_t, Action> actions;
+
+  // The positions of the current batch that need to be caught-up
+  // using Paxos, and the one being caught-up.
+  IntervalSet<uint64_t> missing;
+  uint64_t position;
 
   process::Promise<Nothing> promise;
+  Future<set<Future<CatchUpResponse> > > broadcasting;
+  Future<bool> learning;
+  Future<IntervalSet<uint64_t> > checking;
   Future<uint64_t> catching;
 };
 
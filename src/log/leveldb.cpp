@@ -25,8 +25,11 @@
 
 #include <stdint.h>
 
+#include <process/owned.hpp>
+
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -34,6 +37,9 @@
 
 #include "log/leveldb.hpp"
 
+using process::Owned;
+
+using std::list;
 using std::string;
 
 namespace mesos {
@@ -348,58 +354,61 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   if (action.has_type() && action.type() == Action::TRUNCATE &&
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
+    truncate(action.truncate().to());
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const list<Action>& actions)
+{
+  if (actions.empty()) {
+    return Nothing();
+  }
 
-    stopwatch.start(); // Restart the stopwatch.
-
-    // To actually perform the truncation in leveldb we need to remove
-    // all the keys that represent positions no longer in the log. We
-    // do this by attempting to delete all keys that represent the
-    // first position we know is still in leveldb up to (but
-    // excluding) the truncate position. Note that this works because
-    // the semantics of WriteBatch are such that even if the position
-    // doesn't exist (which is possible because this replica has some
-    // holes), we can attempt to delete the key that represents it and
-    // it will just ignore that key. This is *much* cheaper than
-    // actually iterating through the entire database instead (which
-    // was, for posterity, the original implementation). In addition,
-    // caching the "first" position we know is in the database is
-    // cheaper than using an iterator to determine the first position
-    // (which was, for posterity, the second implementation).
-
-    leveldb::WriteBatch batch;
-
-    CHECK_SOME(first);
-
-    // Add positions up to (but excluding) the truncate position to
-    // the batch starting at the first position still in leveldb. It's
-    // likely that the first position is greater than the truncate
-    // position (e.g., during catch-up). In that case, we do nothing
-    // because there is nothing we can truncate.
-    // TODO(jieyu): We might miss a truncation if we do random (i.e.,
-    // out of order) bulk catch-up and the truncate operation is
-    // caught up first.
-    uint64_t index = 0;
-    while ((first.get() + index) < action.truncate().to()) {
-      batch.Delete(encode(first.get() + index));
-      index++;
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  leveldb::WriteBatch batch;
+  size_t size = 0;
+
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
     }
 
-    // If we added any positions, attempt to delete them!
-    if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        LOG(INFO) << "Deleting ~" << index
-                  << " keys from leveldb took " << stopwatch.elapsed();
-      }
+    batch.Put(encode(action.position()), value);
+    size += value.size();
+  }
+
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+  }
+
+  LOG(INFO) << "Persisting " << actions.size() << " actions (" << size
+            << " bytes) to leveldb took " << stopwatch.elapsed();
+
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      CHECK(action.has_truncate());
+      truncate(action.truncate().to());
     }
   }
 
@@ -407,6 +416,64 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
 }
 
 
+void LevelDBStorage::truncate(uint64_t to)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // To actually perform the truncation in leveldb we need to remove
+  // all the keys that represent positions no longer in the log. We
+  // do this by attempting to delete all keys that represent the
+  // first position we know is still in leveldb up to (but
+  // excluding) the truncate position. Note that this works because
+  // the semantics of WriteBatch are such that even if the position
+  // doesn't exist (which is possible because this replica has some
+  // holes), we can attempt to delete the key that represents it and
+  // it will just ignore that key. This is *much* cheaper than
+  // actually iterating through the entire database instead (which
+  // was, for posterity, the original implementation). In addition,
+  // caching the "first" position we know is in the database is
+  // cheaper than using an iterator to determine the first position
+  // (which was, for posterity, the second implementation).
+
+  leveldb::WriteBatch batch;
+
+  CHECK_SOME(first);
+
+  // Add positions up to (but excluding) the truncate position to
+  // the batch starting at the first position still in leveldb. It's
+  // likely that the first position is greater than the truncate
+  // position (e.g., during catch-up). In that case, we do nothing
+  // because there is nothing we can truncate.
+  // TODO(jieyu): We might miss a truncation if we do random (i.e.,
+  // out of order) bulk catch-up and the truncate operation is
+  // caught up first.
+  uint64_t index = 0;
+  while ((first.get() + index) < to) {
+    batch.Delete(encode(first.get() + index));
+    index++;
+  }
+
+  // If we added any positions, attempt to delete them!
+  if (index > 0) {
+    // We do this write asynchronously (e.g., using default options).
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring leveldb batch delete failure: "
+                   << status.ToString();
+    } else {
+      // Save the new first position!
+      CHECK_LT(first.get(), to);
+      first = to;
+
+      LOG(INFO) << "Deleting ~" << index
+                << " keys from leveldb took " << stopwatch.elapsed();
+    }
+  }
+}
+
+
 Try<Action> LevelDBStorage::read(uint64_t position)
 {
   Stopwatch stopwatch;
@@ -439,5 +506,59 @@ Try<Action> LevelDBStorage::read(uint64_t position)
   return record.action();
 }
 
+
+Try<list<Action> > LevelDBStorage::read(uint64_t from, uint64_t to)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  leveldb::ReadOptions options;
+
+  // Don't evict the recently accessed positions from the block cache
+  // while scanning (e.g., when the log is replayed).
+  options.fill_cache = false;
+
+  list<Action> actions;
+
+  if (to < from) {
+    return actions;
+  }
+
+  // NOTE: The positions are encoded such that their byte-wise order
+  // (i.e., the order of the keys in leveldb) is their numeric order.
+  const string last = encode(to);
+
+  Owned<leveldb::Iterator> iterator(db->NewIterator(options));
+
+  for (iterator->Seek(encode(from));
+       iterator->Valid() && iterator->key().compare(last) <= 0;
+       iterator->Next()) {
+    leveldb::Slice value = iterator->value();
+
+    google::protobuf::io::ArrayInputStream stream(value.data(), value.size());
+
+    Record record;
+
+    if (!record.ParseFromZeroCopyStream(&stream)) {
+      return Error("Failed to deserialize record");
+    }
+
+    if (record.type() != Record::ACTION) {
+      return Error("Bad record");
+    }
+
+    actions.push_back(record.action());
+  }
+
+  if (!iterator->status().ok()) {
+    return Error(iterator->status().ToString());
+  }
+
+  LOG(INFO) << "Reading " << actions.size() << " positions from leveldb took "
+            << stopwatch.elapsed();
+
+  return actions;
+}
+
 } // namespace log {
 } // namespace mesos {
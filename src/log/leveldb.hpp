@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include <list>
+
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -40,9 +42,15 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::list<Action>& actions);
   virtual Try<Action> read(uint64_t position);
+  virtual Try<std::list<Action> > read(uint64_t from, uint64_t to);
 
 private:
+  // Deletes the positions before 'to' that are still in leveldb,
+  // after a truncate action has been learned.
+  void truncate(uint64_t to);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
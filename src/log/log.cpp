@@ -48,6 +48,11 @@ using std::string;
 namespace mesos {
 namespace log {
 
+// The maximum number of positions read at once when streaming the
+// entries of the log (see Log::Reader::read).
+static const uint64_t READ_BATCH_SIZE = 1000;
+
+
 class LogProcess : public Process<LogProcess>
 {
 public:
@@ -118,6 +123,11 @@ public:
       const Log::Position& from,
       const Log::Position& to);
 
+  Future<Nothing> stream(
+      const Log::Position& from,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply);
+
 protected:
   virtual void initialize();
   virtual void finalize();
@@ -126,6 +136,12 @@ private:
   // Returns a position from a raw value.
   static Log::Position position(uint64_t value);
 
+  // Returns the last position of the batch starting at 'from' that
+  // is streamed when reading up to 'to'.
+  static Log::Position last(
+      const Log::Position& from,
+      const Log::Position& to);
+
   // Returns a future which gets set when the log recovery has
   // finished (either succeeded or failed).
   Future<Nothing> recover();
@@ -145,6 +161,23 @@ private:
       const Log::Position& to,
       const list<Action>& actions);
 
+  Future<Nothing> _stream(
+      const Log::Position& from,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply);
+
+  Future<Nothing> __stream(
+      const Future<list<Log::Entry> >& reading,
+      const Log::Position& last,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply);
+
+  Future<Nothing> ___stream(
+      const list<Log::Entry>& entries,
+      const Log::Position& last,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply);
+
   Future<Shared<Replica> > recovering;
   list<process::Promise<Nothing>*> promises;
 };
@@ -554,12 +587,84 @@ Future<list<Log::Entry> > LogReaderProcess::__read(
 }
 
 
+Future<Nothing> LogReaderProcess::stream(
+    const Log::Position& from,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply)
+{
+  return recover().then(defer(self(), &Self::_stream, from, to, apply));
+}
+
+
+Future<Nothing> LogReaderProcess::_stream(
+    const Log::Position& from,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply)
+{
+  if (to < from) {
+    return Failure("Bad read range (to < from)");
+  }
+
+  return __stream(_read(from, last(from, to)), last(from, to), to, apply);
+}
+
+
+Future<Nothing> LogReaderProcess::__stream(
+    const Future<list<Log::Entry> >& reading,
+    const Log::Position& last,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply)
+{
+  return reading
+    .then(defer(self(), &Self::___stream, lambda::_1, last, to, apply));
+}
+
+
+Future<Nothing> LogReaderProcess::___stream(
+    const list<Log::Entry>& entries,
+    const Log::Position& last,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply)
+{
+  if (last == to) {
+    return apply(entries);
+  }
+
+  // Start reading the next batch before applying this one so that
+  // reading overlaps with applying.
+  const Log::Position from = last.value + 1;
+
+  Future<list<Log::Entry> > reading = _read(from, Self::last(from, to));
+
+  return apply(entries)
+    .then(defer(self(),
+                &Self::__stream,
+                reading,
+                Self::last(from, to),
+                to,
+                apply));
+}
+
+
 Log::Position LogReaderProcess::position(uint64_t value)
 {
   return Log::Position(value);
 }
 
 
+Log::Position LogReaderProcess::last(
+    const Log::Position& from,
+    const Log::Position& to)
+{
+  // Guard against overflowing at the end of the position space.
+  if (to.value - from.value < READ_BATCH_SIZE) {
+    return to;
+  }
+
+  return Log::Position(from.value + READ_BATCH_SIZE - 1);
+}
+
+
 /////////////////////////////////////////////////
 // Implementation of LogWriterProcess.
 /////////////////////////////////////////////////
@@ -816,6 +921,15 @@ Future<list<Log::Entry> > Log::Reader::read(
 }
 
 
+Future<Nothing> Log::Reader::read(
+    const Log::Position& from,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& apply)
+{
+  return dispatch(process, &LogReaderProcess::stream, from, to, apply);
+}
+
+
 Future<Log::Position> Log::Reader::beginning()
 {
   return dispatch(process, &LogReaderProcess::beginning);
@@ -32,7 +32,9 @@
 #include <process/timeout.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
 
 #include "zookeeper/group.hpp"
@@ -134,6 +136,18 @@ public:
         const Position& from,
         const Position& to);
 
+    // Reads all entries between the specified positions like above,
+    // but in batches of a bounded size, invoking 'apply' for each
+    // batch in order. The next batch is read while the current one
+    // is being applied, so at most two batches are held in memory.
+    // The returned future fails if reading any batch fails, or if a
+    // future returned by 'apply' fails.
+    process::Future<Nothing> read(
+        const Position& from,
+        const Position& to,
+        const lambda::function<
+            process::Future<Nothing>(const std::list<Entry>&)>& apply);
+
     // Returns the beginning position of the log from the perspective
     // of the local replica (which may be out of date if the log has
     // been opened and truncated while this replica was partitioned).
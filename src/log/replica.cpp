@@ -23,6 +23,7 @@
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
@@ -52,10 +53,18 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
 
+// The maximum size of the actions sent in one catch-up response. The
+// actions of a log can be large (e.g., registry snapshots), so a
+// batch of them could otherwise exceed the 64MB limit that protobuf
+// puts on parsing a message.
+static const Bytes CATCHUP_RESPONSE_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
@@ -85,6 +94,11 @@ public:
   // within the specified range [from, to].
   IntervalSet<uint64_t> missing(uint64_t from, uint64_t to);
 
+  // Persists the specified learned actions whose positions are
+  // missing in a single write. Returns true on success and false
+  // otherwise.
+  bool learn(const list<Action>& actions);
+
   // Returns the beginning position of the log.
   uint64_t beginning();
 
@@ -112,6 +126,10 @@ private:
   // Handles a request from a recover process.
   void recover(const RecoverRequest& request);
 
+  // Handles a request from a catch-up process for the actions this
+  // replica has learned within a range of positions.
+  void catchup(const CatchUpRequest& request);
+
   // Handles a message notifying of a learned action.
   void learned(const Action& action);
 
@@ -119,6 +137,11 @@ private:
   // specified argument. Returns true on success and false otherwise.
   bool persist(const Action& action);
 
+  // Helper routine that updates the positions tracked in memory
+  // (i.e., begin, end, holes and unlearned) after the specified
+  // action has been persisted.
+  void track(const Action& action);
+
   // Helper routines that update metadata corresponding to the
   // specified argument. The update will be persisted on the disk.
   // Returns true on success and false otherwise.
@@ -168,6 +191,9 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  install<CatchUpRequest>(
+      &ReplicaProcess::catchup);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
@@ -224,21 +250,17 @@ Future<list<Action> > ReplicaProcess::read(uint64_t from, uint64_t to)
   VLOG(2) << "Starting read from '" << stringify(from) << "' to '"
           << stringify(to) << "'";
 
-  list<Action> actions;
+  // Read the whole range in one pass over the storage. Note that the
+  // holes are not in the storage, so every action read is known.
+  Try<list<Action> > actions = storage->read(from, to);
 
-  for (uint64_t position = from; position <= to; position++) {
-    Result<Action> result = read(position);
-
-    if (result.isError()) {
-      process::Promise<list<Action> > promise;
-      promise.fail(result.error());
-      return promise.future();
-    } else if (result.isSome()) {
-      actions.push_back(result.get());
-    }
+  if (actions.isError()) {
+    process::Promise<list<Action> > promise;
+    promise.fail(actions.error());
+    return promise.future();
   }
 
-  return actions;
+  return actions.get();
 }
 
 
@@ -282,6 +304,41 @@ IntervalSet<uint64_t> ReplicaProcess::missing(uint64_t from, uint64_t to)
 }
 
 
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  // Skip the positions that have been learned (or truncated) in the
+  // meantime, e.g., through a learned message.
+  list<Action> learned;
+  foreach (const Action& action, actions) {
+    CHECK(action.has_learned() && action.learned());
+    if (missing(action.position())) {
+      learned.push_back(action);
+    }
+  }
+
+  if (learned.empty()) {
+    return true;
+  }
+
+  Try<Nothing> persisted = storage->persist(learned);
+
+  if (persisted.isError()) {
+    LOG(ERROR) << "Error writing to log: " << persisted.error();
+    return false;
+  }
+
+  foreach (const Action& action, learned) {
+    track(action);
+  }
+
+  LOG(INFO) << "Replica learned " << learned.size() << " actions from "
+            << learned.front().position() << " to "
+            << learned.back().position();
+
+  return true;
+}
+
+
 uint64_t ReplicaProcess::beginning()
 {
   return begin;
@@ -652,6 +709,48 @@ void ReplicaProcess::recover(const RecoverRequest& request)
 }
 
 
+void ReplicaProcess::catchup(const CatchUpRequest& request)
+{
+  LOG(INFO) << "Replica received catch-up request for positions "
+            << request.from() << " -> " << request.to();
+
+  CatchUpResponse response;
+
+  // Only learned actions are sent back, which are final no matter
+  // the status of this replica. Truncated positions are left out.
+  uint64_t from = std::max(request.from(), begin);
+  uint64_t to = std::min(request.to(), end);
+
+  if (from <= to) {
+    Try<list<Action> > actions = storage->read(from, to);
+
+    if (actions.isError()) {
+      LOG(ERROR) << "Error getting log records " << from << " -> " << to
+                 << ": " << actions.error();
+    } else {
+      Bytes size = 0;
+
+      foreach (const Action& action, actions.get()) {
+        if (action.has_learned() && action.learned()) {
+          // Always send at least one action so that the requester
+          // makes progress, even if that action alone is too large.
+          size += Bytes(action.ByteSize());
+
+          if (response.actions_size() > 0 && size > CATCHUP_RESPONSE_SIZE) {
+            response.set_to(action.position() - 1);
+            break;
+          }
+
+          response.add_actions()->MergeFrom(action);
+        }
+      }
+    }
+  }
+
+  reply(response);
+}
+
+
 void ReplicaProcess::learned(const Action& action)
 {
   LOG(INFO) << "Replica received learned notice for position "
@@ -677,6 +776,14 @@ bool ReplicaProcess::persist(const Action& action)
 
   LOG(INFO) << "Persisted action at " << action.position();
 
+  track(action);
+
+  return true;
+}
+
+
+void ReplicaProcess::track(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -711,8 +818,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -781,6 +886,12 @@ Future<IntervalSet<uint64_t> > Replica::missing(
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 Future<uint64_t> Replica::beginning() const
 {
   return dispatch(process, &ReplicaProcess::beginning);
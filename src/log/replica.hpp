@@ -41,6 +41,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
@@ -78,6 +79,12 @@ public:
       uint64_t from,
       uint64_t to) const;
 
+  // Persists the specified learned actions (e.g., as received from
+  // other replicas while catching up) in a single write, skipping
+  // the ones whose positions are not missing. Returns true on success
+  // and false otherwise.
+  process::Future<bool> learn(const std::list<Action>& actions) const;
+
   // Returns the beginning position of the log.
   process::Future<uint64_t> beginning() const;
 
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <list>
 #include <string>
 
 #include <stout/interval.hpp>
@@ -54,7 +55,17 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists the actions atomically, with a single (synchronous)
+  // write rather than one per action.
+  virtual Try<Nothing> persist(const std::list<Action>& actions) = 0;
+
   virtual Try<Action> read(uint64_t position) = 0;
+
+  // Returns the actions stored at the positions in [from, to]
+  // (ordered by position) using a single pass over the storage,
+  // rather than a lookup per position.
+  virtual Try<std::list<Action> > read(uint64_t from, uint64_t to) = 0;
 };
 
 } // namespace log {
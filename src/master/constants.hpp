@@ -91,6 +91,10 @@ extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 // cache.  TODO(thomasm): Make configurable.
 extern const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK;
 
+// Maximum number of tasks of a framework whose state is sent during
+// implicit reconciliation before the master yields to other events.
+extern const uint32_t IMPLICIT_RECONCILIATION_BATCH_SIZE;
+
 // Time interval to check for updated watchers list.
 extern const Duration WHITELIST_WATCH_INTERVAL;
 
@@ -164,7 +164,9 @@ public:
         "whitelist",
         "Path to a file with a list of slaves\n"
         "(one per line) to advertise offers for.\n"
-        "Path could be of the form 'file:///path/to/file' or '/path/to/file'.",
+        "Path could be of the form 'file:///path/to/file' or '/path/to/file'.\n"
+        "On Linux the file is read again as soon as it is written or\n"
+        "replaced, otherwise it is read again every 5 seconds.",
         "*");
 
     add(&Flags::user_sorter,
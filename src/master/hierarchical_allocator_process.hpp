@@ -31,6 +31,7 @@
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/multihashmap.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
@@ -180,14 +181,19 @@ protected:
     Resources total;
     Resources available;
 
-    bool activated;  // Whether to offer resources.
-    bool checkpoint; // Whether slave supports checkpointing.
+    bool activated;   // Whether to offer resources.
+    bool checkpoint;  // Whether slave supports checkpointing.
+    bool whitelisted; // Whether the hostname is in the whitelist.
 
     std::string hostname;
   };
 
   hashmap<SlaveID, Slave> slaves;
 
+  // The slaves on each host, so that a whitelist update only needs
+  // to touch the slaves on the hosts that were added or removed.
+  multihashmap<std::string, SlaveID> hostnames;
+
   hashmap<std::string, RoleInfo> roles;
 
   // Slaves to send offers for.
@@ -446,6 +452,10 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addSlave(
   slaves[slaveId].activated = true;
   slaves[slaveId].checkpoint = slaveInfo.checkpoint();
   slaves[slaveId].hostname = slaveInfo.hostname();
+  slaves[slaveId].whitelisted =
+    whitelist.isNone() || whitelist.get().contains(slaveInfo.hostname());
+
+  hostnames.put(slaveInfo.hostname(), slaveId);
 
   LOG(INFO) << "Added slave " << slaveId << " (" << slaves[slaveId].hostname
             << ") with " << slaves[slaveId].total
@@ -471,6 +481,8 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::removeSlave(
 
   roleSorter->remove(slaves[slaveId].total.unreserved());
 
+  hostnames.remove(slaves[slaveId].hostname, slaveId);
+
   slaves.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
@@ -517,10 +529,57 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::updateWhitelist(
 {
   CHECK(initialized);
 
-  whitelist = _whitelist;
+  // The slaves that became whitelisted.
+  hashset<SlaveID> whitelisted;
+
+  if (whitelist.isNone() || _whitelist.isNone()) {
+    // All the slaves are affected when the whitelist appears or
+    // goes away.
+    whitelist = _whitelist;
+
+    foreachpair (const SlaveID& slaveId, Slave& slave, slaves) {
+      bool _whitelisted =
+        whitelist.isNone() || whitelist.get().contains(slave.hostname);
+
+      if (_whitelisted && !slave.whitelisted) {
+        whitelisted.insert(slaveId);
+      }
+
+      slave.whitelisted = _whitelisted;
+    }
+  } else {
+    // Otherwise only the slaves on the hosts that were added to or
+    // removed from the whitelist are.
+    size_t added = 0;
+    foreach (const std::string& hostname, _whitelist.get()) {
+      if (!whitelist.get().contains(hostname)) {
+        foreach (const SlaveID& slaveId, hostnames.get(hostname)) {
+          slaves[slaveId].whitelisted = true;
+          whitelisted.insert(slaveId);
+        }
+        ++added;
+      }
+    }
+
+    size_t removed = 0;
+    foreach (const std::string& hostname, whitelist.get()) {
+      if (!_whitelist.get().contains(hostname)) {
+        foreach (const SlaveID& slaveId, hostnames.get(hostname)) {
+          slaves[slaveId].whitelisted = false;
+        }
+        ++removed;
+      }
+    }
+
+    whitelist = _whitelist;
+
+    LOG(INFO) << "Added " << added << " and removed " << removed
+              << " hosts from the slave whitelist";
+  }
 
   if (whitelist.isSome()) {
-    LOG(INFO) << "Updated slave whitelist: " << stringify(whitelist.get());
+    LOG(INFO) << "Updated slave whitelist to " << whitelist.get().size()
+              << " hosts";
 
     if (whitelist.get().empty()) {
       LOG(WARNING) << "Whitelist is empty, no offers will be made!";
@@ -528,6 +587,12 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::updateWhitelist(
   } else {
     LOG(INFO) << "Advertising offers for all slaves";
   }
+
+  // Offer the resources of the newly whitelisted slaves right away
+  // rather than in the next batch allocation.
+  if (!whitelisted.empty()) {
+    allocate(whitelisted);
+  }
 }
 
 
@@ -862,8 +927,7 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::isWhitelisted(
 {
   CHECK(slaves.contains(slaveId));
 
-  return whitelist.isNone() ||
-         whitelist.get().contains(slaves[slaveId].hostname);
+  return slaves[slaveId].whitelisted;
 }
 
 
@@ -52,6 +52,7 @@
 #include <stout/stringify.hpp>
 #include <stout/utils.hpp>
 #include <stout/uuid.hpp>
+#include <stout/version.hpp>
 
 #include "authentication/authenticator.hpp"
 #include "authentication/cram_md5/authenticator.hpp"
@@ -695,10 +696,16 @@ void Master::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Master::statusUpdates,
+      &StatusUpdatesMessage::updates,
+      &StatusUpdatesMessage::pid);
+
   install<ReconcileTasksMessage>(
       &Master::reconcileTasks,
       &ReconcileTasksMessage::framework_id,
-      &ReconcileTasksMessage::statuses);
+      &ReconcileTasksMessage::statuses,
+      &ReconcileTasksMessage::batched);
 
   install<ExitedExecutorMessage>(
       &Master::exitedExecutor,
@@ -798,9 +805,7 @@ void Master::finalize()
     }
 
     // Remove offers.
-    foreach (Offer* offer, utils::copy(slave->offers)) {
-      removeOffer(offer);
-    }
+    removeOffers(utils::copy(slave->offers), false);
 
     // Terminate the slave observer.
     terminate(slave->observer);
@@ -1802,14 +1807,7 @@ void Master::_reregisterFramework(
       // NOTE: We need to do this because the scheduler might have
       // replied to the offers but the driver might have dropped
       // those messages since it wasn't connected to the master.
-      foreach (Offer* offer, utils::copy(framework->offers)) {
-        allocator->recoverResources(
-            offer->framework_id(),
-            offer->slave_id(),
-            offer->resources(),
-            None());
-        removeOffer(offer, true); // Rescind.
-      }
+      removeOffers(utils::copy(framework->offers), true, true); // Rescind.
 
       framework->connected = true;
 
@@ -1959,11 +1957,7 @@ void Master::deactivate(Framework* framework)
   allocator->deactivateFramework(framework->id);
 
   // Remove the framework's offers.
-  foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true); // Rescind.
-  }
+  removeOffers(utils::copy(framework->offers), true, true); // Rescind.
 }
 
 
@@ -1997,12 +1991,7 @@ void Master::deactivate(Slave* slave)
   allocator->deactivateSlave(slave->id);
 
   // Remove and rescind offers.
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    removeOffer(offer, true); // Rescind!
-  }
+  removeOffers(utils::copy(slave->offers), true, true); // Rescind!
 }
 
 
@@ -2037,11 +2026,11 @@ void Master::resourceRequest(
 void Master::launchTasks(
     const UPID& from,
     const FrameworkID& frameworkId,
-    const vector<TaskInfo>& tasks,
+    const google::protobuf::RepeatedPtrField<TaskInfo>& tasks,
     const Filters& filters,
-    const vector<OfferID>& offerIds)
+    const google::protobuf::RepeatedPtrField<OfferID>& offerIds)
 {
-  if (!tasks.empty()) {
+  if (tasks.size() > 0) {
     ++metrics->messages_launch_tasks;
   } else {
     ++metrics->messages_decline_offers;
@@ -2051,7 +2040,8 @@ void Master::launchTasks(
 
   if (framework == NULL) {
     LOG(WARNING)
-      << "Ignoring launch tasks message for offers " << stringify(offerIds)
+      << "Ignoring launch tasks message for offers "
+      << stringify(google::protobuf::convert(offerIds))
       << " of framework " << frameworkId
       << " because the framework cannot be found";
 
@@ -2060,7 +2050,8 @@ void Master::launchTasks(
 
   if (from != framework->pid) {
     LOG(WARNING)
-      << "Ignoring launch tasks message for offers " << stringify(offerIds)
+      << "Ignoring launch tasks message for offers "
+      << stringify(google::protobuf::convert(offerIds))
       << " of framework " << frameworkId << " from '" << from
       << "' because it is not from the registered framework '"
       << framework->pid << "'";
@@ -2074,49 +2065,54 @@ void Master::launchTasks(
   Offer::Operation* operation = message.add_operations();
   operation->set_type(Offer::Operation::LAUNCH);
 
-  foreach (const TaskInfo& task, tasks) {
-    operation->mutable_launch()->add_task_infos()->CopyFrom(task);
-  }
-
-  foreach (const OfferID& offerId, offerIds) {
-    message.add_offer_ids()->CopyFrom(offerId);
-  }
+  operation->mutable_launch()->mutable_task_infos()->CopyFrom(tasks);
+  message.mutable_offer_ids()->CopyFrom(offerIds);
 
   accept(framework, message);
 }
 
 
-Future<bool> Master::authorizeTask(
-    const TaskInfo& task,
+Future<list<bool>> Master::authorizeTasks(
+    const list<TaskInfo>& tasks,
     Framework* framework)
 {
-  if (authorizer.isNone()) {
+  if (authorizer.isNone() || tasks.empty()) {
     // Authorization is disabled.
-    return true;
-  }
-
-  // Authorize the task.
-  string user = framework->info.user(); // Default user.
-  if (task.has_command() && task.command().has_user()) {
-    user = task.command().user();
-  } else if (task.has_executor() && task.executor().command().has_user()) {
-    user = task.executor().command().user();
+    return list<bool>(tasks.size(), true);
   }
 
   LOG(INFO)
     << "Authorizing framework principal '" << framework->info.principal()
-    << "' to launch task " << task.task_id() << " as user '" << user << "'";
+    << "' to launch " << tasks.size() << " tasks";
 
-  mesos::ACL::RunTask request;
-  if (framework->info.has_principal()) {
-    request.mutable_principals()->add_values(framework->info.principal());
-  } else {
-    // Framework doesn't have a principal set.
-    request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  // Authorize the tasks.
+  list<mesos::ACL::RunTask> requests;
+  foreach (const TaskInfo& task, tasks) {
+    string user = framework->info.user(); // Default user.
+    if (task.has_command() && task.command().has_user()) {
+      user = task.command().user();
+    } else if (task.has_executor() && task.executor().command().has_user()) {
+      user = task.executor().command().user();
+    }
+
+    VLOG(1)
+      << "Authorizing framework principal '" << framework->info.principal()
+      << "' to launch task " << task.task_id() << " as user '" << user << "'";
+
+    mesos::ACL::RunTask request;
+    if (framework->info.has_principal()) {
+      request.mutable_principals()->add_values(framework->info.principal());
+    } else {
+      // Framework doesn't have a principal set.
+      request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    }
+    request.mutable_users()->add_values(user);
+
+    requests.push_back(request);
   }
-  request.mutable_users()->add_values(user);
 
-  return authorizer.get()->authorize(request);
+  return metrics->task_authorization.time(
+      authorizer.get()->authorize(requests));
 }
 
 
@@ -2263,14 +2259,14 @@ void Master::accept(
   // TODO(jieyu): Currently, we only do authorization for the LAUNCH
   // operation. In the future, we might want to introduce
   // authorizations for other offer operations as well.
-  list<Future<bool>> futures;
+  list<TaskInfo> tasks;
   foreach (const Offer::Operation& operation, accept.operations()) {
     if (operation.type() != Offer::Operation::LAUNCH) {
       continue;
     }
 
     foreach (const TaskInfo& task, operation.launch().task_infos()) {
-      futures.push_back(authorizeTask(task, framework));
+      tasks.push_back(task);
 
       // Add to pending tasks.
       //
@@ -2288,7 +2284,7 @@ void Master::accept(
   }
 
   // Wait for all the tasks to be authorized.
-  await(futures)
+  authorizeTasks(tasks, framework)
     .onAny(defer(self(),
                  &Master::_accept,
                  framework->id,
@@ -2304,7 +2300,7 @@ void Master::_accept(
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const Future<list<Future<bool>>>& _authorizations)
+    const Future<list<bool>>& authorizations)
 {
   Framework* framework = getFramework(frameworkId);
 
@@ -2367,8 +2363,10 @@ void Master::_accept(
   // launched, we remove its resource from offered resources.
   Resources _offeredResources = offeredResources;
 
-  CHECK_READY(_authorizations);
-  list<Future<bool>> authorizations = _authorizations.get();
+  // Whether each task is authorized, unless authorization failed.
+  CHECK(!authorizations.isDiscarded());
+  list<bool> authorized =
+    authorizations.isReady() ? authorizations.get() : list<bool>();
 
   foreach (const Offer::Operation& operation, accept.operations()) {
     // TODO(jieyu): Validate each operation!
@@ -2441,8 +2439,11 @@ void Master::_accept(
 
       case Offer::Operation::LAUNCH: {
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
-          Future<bool> authorization = authorizations.front();
-          authorizations.pop_front();
+          bool authorization = false;
+          if (authorizations.isReady()) {
+            authorization = authorized.front();
+            authorized.pop_front();
+          }
 
           // NOTE: The task will not be in 'pendingTasks' if
           // 'killTask()' for the task was called before we are here.
@@ -2456,9 +2457,7 @@ void Master::_accept(
           framework->pendingTasks.erase(task.task_id());
 
           // Check authorization result.
-          CHECK(!authorization.isDiscarded());
-
-          if (authorization.isFailed() || !authorization.get()) {
+          if (!authorization) {
             string user = framework->info.user(); // Default user.
             if (task.has_command() && task.command().has_user()) {
               user = task.command().user();
@@ -2473,8 +2472,8 @@ void Master::_accept(
                 task.task_id(),
                 TASK_ERROR,
                 TaskStatus::SOURCE_MASTER,
-                authorization.isFailed() ?
-                    "Authorization failure: " + authorization.failure() :
+                authorizations.isFailed() ?
+                    "Authorization failure: " + authorizations.failure() :
                     "Not authorized to launch as user '" + user + "'",
                 TaskStatus::REASON_TASK_UNAUTHORIZED);
 
@@ -2764,12 +2763,58 @@ void Master::statusUpdateAcknowledgement(
   message.mutable_task_id()->CopyFrom(taskId);
   message.set_uuid(uuid);
 
-  send(slave->pid, message);
+  forward(message, slave);
 
   metrics->valid_status_update_acknowledgements++;
 }
 
 
+void Master::forward(
+    const StatusUpdateAcknowledgementMessage& acknowledgement,
+    Slave* slave)
+{
+  CHECK_NOTNULL(slave);
+
+  // Slaves older than 0.22.0 do not understand batched
+  // acknowledgements.
+  Try<Version> version = slave->version.isSome()
+    ? Version::parse(slave->version.get())
+    : Try<Version>(Error("Slave is older than 0.21.0"));
+
+  if (version.isError() || version.get() < Version(0, 22, 0)) {
+    send(slave->pid, acknowledgement);
+    return;
+  }
+
+  // The acknowledgements are flushed once the master has processed
+  // the messages already in its queue, so that acknowledgements
+  // arriving in a burst (e.g., from a scheduler that just got many
+  // updates) reach each slave in a single message.
+  if (acknowledgements.empty()) {
+    dispatch(self(), &Master::flushAcknowledgements);
+  }
+
+  acknowledgements[slave->pid].add_acknowledgements()->CopyFrom(
+      acknowledgement);
+}
+
+
+void Master::flushAcknowledgements()
+{
+  foreachpair (const UPID& pid,
+               const StatusUpdateAcknowledgementsMessage& message,
+               acknowledgements) {
+    if (message.acknowledgements_size() == 1) {
+      send(pid, message.acknowledgements(0));
+    } else {
+      send(pid, message);
+    }
+  }
+
+  acknowledgements.clear();
+}
+
+
 void Master::schedulerMessage(
     const UPID& from,
     const SlaveID& slaveId,
@@ -3227,6 +3272,24 @@ void Master::statusUpdate(const StatusUpdate& update, const UPID& pid)
 {
   ++metrics->messages_status_update;
 
+  _statusUpdate(update, pid);
+}
+
+
+void Master::statusUpdates(
+    const google::protobuf::RepeatedPtrField<StatusUpdate>& updates,
+    const UPID& pid)
+{
+  ++metrics->messages_status_updates;
+
+  foreach (const StatusUpdate& update, updates) {
+    _statusUpdate(update, pid);
+  }
+}
+
+
+void Master::_statusUpdate(const StatusUpdate& update, const UPID& pid)
+{
   if (slaves.removed.get(update.slave_id()).isSome()) {
     // If the slave is removed, we have already informed
     // frameworks that its tasks were LOST, so the slave should
@@ -3398,7 +3461,8 @@ void Master::shutdownSlave(const SlaveID& slaveId, const string& message)
 void Master::reconcileTasks(
     const UPID& from,
     const FrameworkID& frameworkId,
-    const std::vector<TaskStatus>& statuses)
+    const std::vector<TaskStatus>& statuses,
+    bool batched)
 {
   ++metrics->messages_reconcile_tasks;
 
@@ -3416,75 +3480,46 @@ void Master::reconcileTasks(
     return;
   }
 
-  _reconcileTasks(framework, statuses);
+  _reconcileTasks(framework, statuses, batched);
 }
 
 
 void Master::_reconcileTasks(
     Framework* framework,
-    const vector<TaskStatus>& statuses)
+    const vector<TaskStatus>& statuses,
+    bool batched)
 {
   CHECK_NOTNULL(framework);
 
   if (statuses.empty()) {
     // Implicit reconciliation.
-    LOG(INFO) << "Performing implicit task state reconciliation"
-                 " for framework " << *framework;
-
-    foreachvalue (const TaskInfo& task, framework->pendingTasks) {
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id,
-          task.slave_id(),
-          task.task_id(),
-          TASK_STAGING,
-          TaskStatus::SOURCE_MASTER,
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION);
-
-      VLOG(1) << "Sending implicit reconciliation state "
-              << update.status().state()
-              << " for task " << update.status().task_id()
-              << " of framework " << *framework;
-
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      send(framework->pid, message);
+    LOG(INFO) << "Performing implicit task state reconciliation for "
+              << framework->pendingTasks.size() + framework->tasks.size()
+              << " tasks of framework " << *framework;
+
+    // The tasks are reconciled in batches, so we take a snapshot of
+    // the tasks known now. Tasks launched after this point are not
+    // part of the reconciliation, the framework knows about them.
+    shared_ptr<vector<TaskID>> taskIds(new vector<TaskID>());
+    taskIds->reserve(
+        framework->pendingTasks.size() + framework->tasks.size());
+
+    foreachkey (const TaskID& taskId, framework->pendingTasks) {
+      taskIds->push_back(taskId);
     }
 
-    foreachvalue (Task* task, framework->tasks) {
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
-
-      const Option<ExecutorID>& executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
-
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id,
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task));
-
-      VLOG(1) << "Sending implicit reconciliation state "
-              << update.status().state()
-              << " for task " << update.status().task_id()
-              << " of framework " << *framework;
-
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      send(framework->pid, message);
+    foreachkey (const TaskID& taskId, framework->tasks) {
+      taskIds->push_back(taskId);
     }
 
+    __reconcileTasks(
+        framework->id,
+        framework->pid,
+        batched,
+        taskIds,
+        0,
+        Clock::now());
+
     return;
   }
 
@@ -3588,6 +3623,129 @@ void Master::_reconcileTasks(
 }
 
 
+void Master::__reconcileTasks(
+    const FrameworkID& frameworkId,
+    const UPID& pid,
+    bool batched,
+    const shared_ptr<const vector<TaskID>>& taskIds,
+    size_t offset,
+    const Time& start)
+{
+  // The reconciliation is abandoned if the framework was removed or
+  // failed over in the meantime; a new scheduler instance has to
+  // reconcile again anyway.
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL || framework->pid != pid) {
+    LOG(INFO) << "Abandoning implicit task state reconciliation of "
+              << "framework " << frameworkId << " at " << pid
+              << " after " << offset << " of " << taskIds->size()
+              << " tasks because the framework "
+              << (framework == NULL ? "was removed" : "failed over");
+    return;
+  }
+
+  const size_t end = std::min(
+      offset + IMPLICIT_RECONCILIATION_BATCH_SIZE,
+      taskIds->size());
+
+  StatusUpdatesMessage message;
+
+  for (size_t i = offset; i < end; i++) {
+    const TaskID& taskId = taskIds->at(i);
+
+    // NOTE: Tasks that were removed since the reconciliation began
+    // are skipped, the framework has received their terminal update.
+    Option<StatusUpdate> update = None();
+
+    if (framework->pendingTasks.contains(taskId)) {
+      const TaskInfo& task = framework->pendingTasks[taskId];
+      update = protobuf::createStatusUpdate(
+          framework->id,
+          task.slave_id(),
+          task.task_id(),
+          TASK_STAGING,
+          TaskStatus::SOURCE_MASTER,
+          "Reconciliation: Latest task state",
+          TaskStatus::REASON_RECONCILIATION);
+    } else if (framework->tasks.contains(taskId)) {
+      Task* task = framework->tasks[taskId];
+
+      const TaskState& state = task->has_status_update_state()
+          ? task->status_update_state()
+          : task->state();
+
+      const Option<ExecutorID>& executorId = task->has_executor_id()
+          ? Option<ExecutorID>(task->executor_id())
+          : None();
+
+      update = protobuf::createStatusUpdate(
+          framework->id,
+          task->slave_id(),
+          task->task_id(),
+          state,
+          TaskStatus::SOURCE_MASTER,
+          "Reconciliation: Latest task state",
+          TaskStatus::REASON_RECONCILIATION,
+          executorId,
+          protobuf::getTaskHealth(*task));
+    }
+
+    if (update.isNone()) {
+      continue;
+    }
+
+    VLOG(1) << "Sending implicit reconciliation state "
+            << update.get().status().state()
+            << " for task " << update.get().status().task_id()
+            << " of framework " << *framework;
+
+    if (batched) {
+      message.add_updates()->CopyFrom(update.get());
+    } else {
+      // TODO(bmahler): Consider using forward(); might lead to too
+      // much logging.
+      StatusUpdateMessage message_;
+      message_.mutable_update()->CopyFrom(update.get());
+      send(framework->pid, message_);
+    }
+  }
+
+  if (message.updates_size() > 0) {
+    send(framework->pid, message);
+  }
+
+  if (end < taskIds->size()) {
+    // Yield to the other events queued for the master before
+    // continuing with the next batch.
+    dispatch(self(),
+             &Master::__reconcileTasks,
+             frameworkId,
+             pid,
+             batched,
+             taskIds,
+             end,
+             start);
+    return;
+  }
+
+  const Duration duration = Clock::now() - start;
+
+  LOG(INFO) << "Finished implicit task state reconciliation for "
+            << taskIds->size() << " tasks of framework " << *framework
+            << " in " << duration;
+
+  metrics->implicit_reconciliation.record(duration);
+
+  Option<Option<string>> principal = frameworks.principals.get(pid);
+  if (principal.isSome() &&
+      principal.get().isSome() &&
+      metrics->frameworks.contains(principal.get().get())) {
+    metrics->frameworks[principal.get().get()]->implicit_reconciliation
+      .record(duration);
+  }
+}
+
+
 void Master::frameworkFailoverTimeout(const FrameworkID& frameworkId,
                                       const Time& reregisteredTime)
 {
@@ -3699,11 +3857,14 @@ void Master::offer(const FrameworkID& frameworkId,
 
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
-      offerTimers[offer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::offerTimeout,
-              offer->id());
+      offerExpiries.push_back(
+          std::make_pair(Clock::now() + flags.offer_timeout.get(),
+                         offer->id()));
+
+      if (offerExpiryTimer.isNone()) {
+        offerExpiryTimer =
+          delay(flags.offer_timeout.get(), self(), &Self::expireOffers);
+      }
     }
 
     // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
@@ -4126,11 +4287,7 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
   // We do this after we have updated the pid and sent the framework
   // registered message so that the allocator can immediately re-offer
   // these resources to this framework if it wants.
-  foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer);
-  }
+  removeOffers(utils::copy(framework->offers), true);
 
   framework->connected = true;
 
@@ -4209,14 +4366,7 @@ void Master::removeFramework(Framework* framework)
   }
 
   // Remove the framework's offers (if they weren't removed before).
-  foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(),
-        offer->slave_id(),
-        offer->resources(),
-        None());
-    removeOffer(offer);
-  }
+  removeOffers(utils::copy(framework->offers), true);
 
   // Remove the framework's executors for correct resource accounting.
   foreachkey (const SlaveID& slaveId, utils::copy(framework->executors)) {
@@ -4444,15 +4594,10 @@ void Master::removeSlave(Slave* slave)
     }
   }
 
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    // TODO(vinod): We don't need to call 'Allocator::recoverResources'
-    // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    // Remove and rescind offers.
-    removeOffer(offer, true); // Rescind!
-  }
+  // Remove and rescind offers.
+  // TODO(vinod): We don't need to recover the resources in the
+  // allocator once MESOS-621 is fixed.
+  removeOffers(utils::copy(slave->offers), true, true); // Rescind!
 
   // Mark the slave as being removed.
   slaves.removing.insert(slave->id);
@@ -4694,13 +4839,34 @@ void Master::removeExecutor(
 }
 
 
-void Master::offerTimeout(const OfferID& offerId)
+void Master::expireOffers()
 {
-  Offer* offer = getOffer(offerId);
-  if (offer != NULL) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true);
+  offerExpiryTimer = None();
+
+  const Time now = Clock::now();
+
+  hashset<Offer*> expired;
+  while (!offerExpiries.empty()) {
+    const Time& expiration = offerExpiries.front().first;
+    Offer* offer = getOffer(offerExpiries.front().second);
+
+    // Skip the offers that were already removed.
+    if (offer != NULL) {
+      if (expiration > now) {
+        break;
+      }
+
+      expired.insert(offer);
+    }
+
+    offerExpiries.pop_front();
+  }
+
+  removeOffers(expired, true, true); // Rescind.
+
+  if (!offerExpiries.empty()) {
+    offerExpiryTimer = delay(
+        offerExpiries.front().first - now, self(), &Self::expireOffers);
   }
 }
 
@@ -4731,12 +4897,8 @@ void Master::removeOffer(Offer* offer, bool rescind)
     send(framework->pid, message);
   }
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
-  }
+  // NOTE: The offer is dropped from 'offerExpiries' when it reaches
+  // the front of the queue (see 'expireOffers').
 
   // Delete it.
   offers.erase(offer->id());
@@ -4744,6 +4906,33 @@ void Master::removeOffer(Offer* offer, bool rescind)
 }
 
 
+void Master::removeOffers(
+    const hashset<Offer*>& _offers,
+    bool recover,
+    bool rescind)
+{
+  // The offered resources to recover per framework and slave.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> resources;
+
+  foreach (Offer* offer, _offers) {
+    if (recover) {
+      resources[offer->framework_id()][offer->slave_id()] +=
+        offer->resources();
+    }
+
+    removeOffer(offer, rescind);
+  }
+
+  foreachkey (const FrameworkID& frameworkId, resources) {
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& offered,
+                 resources[frameworkId]) {
+      allocator->recoverResources(frameworkId, slaveId, offered, None());
+    }
+  }
+}
+
+
 void Master::updateCheckpointedResources(
     Slave* slave,
     const Offer::Operation& operation)
@@ -21,8 +21,10 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <list>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/circular_buffer.hpp>
@@ -134,9 +136,9 @@ public:
   void launchTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
-      const std::vector<TaskInfo>& tasks,
+      const google::protobuf::RepeatedPtrField<TaskInfo>& tasks,
       const Filters& filters,
-      const std::vector<OfferID>& offerIds);
+      const google::protobuf::RepeatedPtrField<OfferID>& offerIds);
 
   void reviveOffers(
       const process::UPID& from,
@@ -154,6 +156,10 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  // Forwards the queued acknowledgements (see 'forward' below), one
+  // message per slave.
+  void flushAcknowledgements();
+
   void schedulerMessage(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -184,10 +190,15 @@ public:
       const StatusUpdate& update,
       const process::UPID& pid);
 
+  void statusUpdates(
+      const google::protobuf::RepeatedPtrField<StatusUpdate>& updates,
+      const process::UPID& pid);
+
   void reconcileTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
-      const std::vector<TaskStatus>& statuses);
+      const std::vector<TaskStatus>& statuses,
+      bool batched);
 
   void exitedExecutor(
       const process::UPID& from,
@@ -304,10 +315,26 @@ protected:
   void contended(const process::Future<process::Future<Nothing>>& candidacy);
 
   // Task reconciliation, split from the message handler
-  // to allow re-use.
+  // to allow re-use. If 'batched' is true, the states sent for an
+  // implicit reconciliation are packed into StatusUpdatesMessages.
   void _reconcileTasks(
       Framework* framework,
-      const std::vector<TaskStatus>& statuses);
+      const std::vector<TaskStatus>& statuses,
+      bool batched = false);
+
+  // Continues an implicit reconciliation by sending the states of the
+  // next IMPLICIT_RECONCILIATION_BATCH_SIZE tasks in 'taskIds' (the
+  // tasks of the framework when the reconciliation was requested),
+  // starting at 'offset', and dispatching itself for the rest. This
+  // keeps the master responsive to other events while reconciling
+  // frameworks with a large number of tasks.
+  void __reconcileTasks(
+      const FrameworkID& frameworkId,
+      const process::UPID& pid,
+      bool batched,
+      const memory::shared_ptr<const std::vector<TaskID>>& taskIds,
+      size_t offset,
+      const process::Time& start);
 
   // Handles a known re-registering slave by reconciling the master's
   // view of the slave's tasks and executors.
@@ -363,12 +390,11 @@ protected:
       const std::vector<StatusUpdate>& updates,
       const process::Future<bool>& removed);
 
-  // Authorizes the task.
-  // Returns true if task is authorized.
-  // Returns false if task is not authorized.
+  // Authorizes the tasks with a single call to the authorizer.
+  // Returns whether each task is authorized, in order.
   // Returns failure for transient authorization failures.
-  process::Future<bool> authorizeTask(
-      const TaskInfo& task,
+  process::Future<std::list<bool>> authorizeTasks(
+      const std::list<TaskInfo>& tasks,
       Framework* framework);
 
   // Add the task and its executor (if not already running) to the
@@ -398,18 +424,38 @@ protected:
       Slave* slave,
       const Offer::Operation& operation);
 
+  // Handles a status update from a slave, once it was accounted
+  // for in the metrics of the message that carried it.
+  void _statusUpdate(const StatusUpdate& update, const process::UPID& pid);
+
   // Forwards the update to the framework.
   void forward(
       const StatusUpdate& update,
       const process::UPID& acknowledgee,
       Framework* framework);
 
-  // Remove an offer after specified timeout
-  void offerTimeout(const OfferID& offerId);
+  // Queues the acknowledgement to be forwarded to the slave along
+  // with any others that arrive before the queue is flushed.
+  void forward(
+      const StatusUpdateAcknowledgementMessage& acknowledgement,
+      Slave* slave);
+
+  // Removes and rescinds the offers that have been outstanding for
+  // longer than 'flags.offer_timeout' (see 'offerExpiries').
+  void expireOffers();
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
 
+  // Removes the given offers (e.g., all the offers of a slave or a
+  // framework) in one pass, optionally rescinding them as well. If
+  // 'recover' is true, the offered resources are recovered in the
+  // allocator with a single call per framework and slave.
+  void removeOffers(
+      const hashset<Offer*>& offers,
+      bool recover,
+      bool rescind = false);
+
   Framework* getFramework(const FrameworkID& frameworkId);
   Slave* getSlave(const SlaveID& slaveId);
   Offer* getOffer(const OfferID& offerId);
@@ -445,7 +491,7 @@ private:
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const process::Future<std::list<process::Future<bool>>>& authorizations);
+    const process::Future<std::list<bool>>& authorizations);
 
   bool elected() const
   {
@@ -633,7 +679,20 @@ private:
   } frameworks;
 
   hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
+
+  // The expiration times of the offers in the order they were made.
+  // Since every offer expires 'flags.offer_timeout' after it was
+  // made, this is also the order in which they expire, so a single
+  // timer for the first offer in the queue drives all the expirations
+  // (rather than a timer per offer that has to be canceled when the
+  // offer is removed). Offers removed before they expire are dropped
+  // from the queue lazily, when they reach its front.
+  std::deque<std::pair<process::Time, OfferID>> offerExpiries;
+  Option<process::Timer> offerExpiryTimer;
+
+  // Status update acknowledgements waiting to be forwarded to the
+  // slaves, keyed by slave pid (see 'flushAcknowledgements').
+  hashmap<process::UPID, StatusUpdateAcknowledgementsMessage> acknowledgements;
 
   hashmap<std::string, Role*> roles;
 
@@ -115,6 +115,8 @@ Metrics::Metrics(const Master& master)
         "master/messages_unregister_slave"),
     messages_status_update(
         "master/messages_status_update"),
+    messages_status_updates(
+        "master/messages_status_updates"),
     messages_exited_executor(
         "master/messages_exited_executor"),
     messages_authenticate(
@@ -133,6 +135,10 @@ Metrics::Metrics(const Master& master)
         "master/invalid_status_update_acknowledgements"),
     recovery_slave_removals(
         "master/recovery_slave_removals"),
+    task_authorization(
+        "master/task_authorization"),
+    implicit_reconciliation(
+        "master/implicit_reconciliation"),
     event_queue_messages(
         "master/event_queue_messages",
         defer(master, &Master::_event_queue_messages)),
@@ -199,6 +205,7 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(messages_reregister_slave);
   process::metrics::add(messages_unregister_slave);
   process::metrics::add(messages_status_update);
+  process::metrics::add(messages_status_updates);
   process::metrics::add(messages_exited_executor);
 
   // Messages from both schedulers and slaves.
@@ -215,6 +222,9 @@ Metrics::Metrics(const Master& master)
 
   process::metrics::add(recovery_slave_removals);
 
+  process::metrics::add(task_authorization);
+  process::metrics::add(implicit_reconciliation);
+
   process::metrics::add(event_queue_messages);
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_http_requests);
@@ -301,6 +311,7 @@ Metrics::~Metrics()
   process::metrics::remove(messages_reregister_slave);
   process::metrics::remove(messages_unregister_slave);
   process::metrics::remove(messages_status_update);
+  process::metrics::remove(messages_status_updates);
   process::metrics::remove(messages_exited_executor);
 
   // Messages from both schedulers and slaves.
@@ -317,6 +328,9 @@ Metrics::~Metrics()
 
   process::metrics::remove(recovery_slave_removals);
 
+  process::metrics::remove(task_authorization);
+  process::metrics::remove(implicit_reconciliation);
+
   process::metrics::remove(event_queue_messages);
   process::metrics::remove(event_queue_dispatches);
   process::metrics::remove(event_queue_http_requests);
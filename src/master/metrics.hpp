@@ -25,7 +25,9 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 namespace mesos {
@@ -90,18 +92,27 @@ struct Metrics
     // requested by this message has finished.
     process::metrics::Counter messages_processed;
 
+    // Time from receiving an implicit reconciliation request from a
+    // framework of this principal to sending the state of its last
+    // task.
+    process::metrics::Timer<Milliseconds> implicit_reconciliation;
+
     explicit Frameworks(const std::string& principal)
       : messages_received("frameworks/" + principal + "/messages_received"),
-        messages_processed("frameworks/" + principal + "/messages_processed")
+        messages_processed("frameworks/" + principal + "/messages_processed"),
+        implicit_reconciliation(
+            "frameworks/" + principal + "/implicit_reconciliation")
     {
       process::metrics::add(messages_received);
       process::metrics::add(messages_processed);
+      process::metrics::add(implicit_reconciliation);
     }
 
     ~Frameworks()
     {
       process::metrics::remove(messages_received);
       process::metrics::remove(messages_processed);
+      process::metrics::remove(implicit_reconciliation);
     }
   };
 
@@ -128,6 +139,7 @@ struct Metrics
   process::metrics::Counter messages_reregister_slave;
   process::metrics::Counter messages_unregister_slave;
   process::metrics::Counter messages_status_update;
+  process::metrics::Counter messages_status_updates;
   process::metrics::Counter messages_exited_executor;
 
   // Messages from both schedulers and slaves.
@@ -145,6 +157,13 @@ struct Metrics
   // Recovery counters.
   process::metrics::Counter recovery_slave_removals;
 
+  // Time to authorize the tasks launched by a single call.
+  process::metrics::Timer<Milliseconds> task_authorization;
+
+  // Time to send the states of all the tasks of a framework for an
+  // implicit reconciliation, which is done in batches of tasks.
+  process::metrics::Timer<Milliseconds> implicit_reconciliation;
+
   // Process metrics.
   process::metrics::Gauge event_queue_messages;
   process::metrics::Gauge event_queue_dispatches;
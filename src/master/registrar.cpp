@@ -436,9 +436,37 @@ void RegistrarProcess::update()
     slaveIDs.insert(slave.info().id());
   }
 
+  // Whether any of the operations mutated the registry.
+  bool mutation = false;
+
   foreach (Owned<Operation> operation, operations) {
-    // No need to process the result of the operation.
-    (*operation)(&registry, &slaveIDs, flags.registry_strict);
+    Try<bool> result =
+      (*operation)(&registry, &slaveIDs, flags.registry_strict);
+
+    if (result.isSome() && result.get()) {
+      mutation = true;
+    }
+  }
+
+  // If no operation mutated the registry there is nothing to store
+  // (e.g., when the slaves re-register with a failed over master, in
+  // which case readmitting them is a no-op), so the operations can be
+  // completed right away instead of waiting for a store of the
+  // entire (unchanged) registry.
+  if (!mutation) {
+    LOG(INFO) << "Applied " << operations.size() << " operations in "
+              << stopwatch.elapsed() << "; the 'registry' is unchanged";
+
+    updating = false;
+
+    while (!operations.empty()) {
+      Owned<Operation> operation = operations.front();
+      operations.pop_front();
+
+      operation->set();
+    }
+
+    return;
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
@@ -183,6 +183,11 @@ protected:
         &StatusUpdateMessage::update,
         &StatusUpdateMessage::pid);
 
+    install<StatusUpdatesMessage>(
+        &SchedulerProcess::statusUpdates,
+        &StatusUpdatesMessage::updates,
+        &StatusUpdatesMessage::pid);
+
     install<LostSlaveMessage>(
         &SchedulerProcess::lostSlave,
         &LostSlaveMessage::slave_id);
@@ -720,6 +725,19 @@ protected:
     }
   }
 
+  // Handles the states of several tasks sent by the master at once
+  // (e.g., during implicit reconciliation) like the same number of
+  // StatusUpdateMessages.
+  void statusUpdates(
+      const UPID& from,
+      const vector<StatusUpdate>& updates,
+      const UPID& pid)
+  {
+    foreach (const StatusUpdate& update, updates) {
+      statusUpdate(from, update, pid);
+    }
+  }
+
   void lostSlave(const UPID& from, const SlaveID& slaveId)
   {
     if (!running) {
@@ -1121,6 +1139,7 @@ protected:
 
     ReconcileTasksMessage message;
     message.mutable_framework_id()->MergeFrom(framework.id());
+    message.set_batched(true);
 
     foreach (const TaskStatus& status, statuses) {
       message.add_statuses()->MergeFrom(status);
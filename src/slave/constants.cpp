@@ -31,11 +31,15 @@ const Duration EXECUTOR_SHUTDOWN_GRACE_PERIOD = Seconds(3);
 const Duration GRACE_PERIOD_DELTA = Seconds(1);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN = Seconds(10);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX = Minutes(10);
+const Bytes STATUS_UPDATE_JOURNAL_SEGMENT_SIZE = Megabytes(4);
+const Duration STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL = Minutes(10);
 const Duration REGISTRATION_BACKOFF_FACTOR = Seconds(1);
 const Duration REGISTER_RETRY_INTERVAL_MAX = Minutes(1);
 const Duration GC_DELAY = Weeks(1);
 const double GC_DISK_HEADROOM = 0.1;
+const uint32_t GC_WORKERS = 2;
 const Duration DISK_WATCH_INTERVAL = Minutes(1);
+const Duration DISK_USAGE_RECONCILIATION_INTERVAL = Minutes(15);
 const Duration RECOVERY_TIMEOUT = Minutes(15);
 const Duration RESOURCE_MONITORING_INTERVAL = Seconds(1);
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
@@ -41,8 +41,18 @@ extern const Duration EXECUTOR_REREGISTER_TIMEOUT;
 extern const Duration RECOVERY_TIMEOUT;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX;
+
+// Size at which the status update journal starts a new segment and
+// the interval at which its sealed segments are compacted.
+extern const Bytes STATUS_UPDATE_JOURNAL_SEGMENT_SIZE;
+extern const Duration STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL;
+
 extern const Duration GC_DELAY;
 extern const Duration DISK_WATCH_INTERVAL;
+
+// Interval at which each path tracked by the incremental disk usage
+// tracker of the 'posix/disk' isolator is fully re-scanned.
+extern const Duration DISK_USAGE_RECONCILIATION_INTERVAL;
 extern const Duration RESOURCE_MONITORING_INTERVAL;
 
 // Default parameters for graceful shutdown mechanism for executor. We
@@ -74,6 +84,9 @@ extern const Duration REGISTER_RETRY_INTERVAL_MAX;
 // Minimum free disk capacity enforced by the garbage collector.
 extern const double GC_DISK_HEADROOM;
 
+// Number of paths the garbage collector removes in parallel.
+extern const uint32_t GC_WORKERS;
+
 // Maximum number of completed frameworks to store in memory.
 extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 
@@ -28,6 +28,8 @@
 #include <process/reap.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/fs.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -36,6 +38,7 @@
 #include "common/status_utils.hpp"
 
 #include "docker/docker.hpp"
+#include "docker/remote.hpp"
 
 #ifdef __linux__
 #include "linux/cgroups.hpp"
@@ -106,7 +109,10 @@ Try<DockerContainerizer*> DockerContainerizer::create(
     const Flags& flags,
     Fetcher* fetcher)
 {
-  Try<Docker*> docker = Docker::create(flags.docker);
+  Try<Docker*> docker = flags.docker_socket.isSome()
+    ? RemoteDocker::create(flags.docker, flags.docker_socket.get())
+    : Docker::create(flags.docker);
+
   if (docker.isError()) {
     return Error(docker.error());
   }
@@ -832,6 +838,22 @@ Future<bool> DockerContainerizerProcess::______launch(
 }
 
 
+DockerContainerizerProcess::Metrics::Metrics()
+  : update("containerizer/docker/update"),
+    updates_skipped("containerizer/docker/updates_skipped")
+{
+  process::metrics::add(update);
+  process::metrics::add(updates_skipped);
+}
+
+
+DockerContainerizerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(update);
+  process::metrics::remove(updates_skipped);
+}
+
+
 Future<Nothing> DockerContainerizerProcess::update(
     const ContainerID& containerId,
     const Resources& _resources)
@@ -861,11 +883,17 @@ Future<Nothing> DockerContainerizerProcess::update(
 
   // Skip inspecting the docker container if we already have the pid.
   if (container->pid.isSome()) {
-    return __update(containerId, _resources, container->pid.get());
+    return metrics.update.time(
+        __update(containerId, _resources, container->pid.get()));
   }
 
-  return docker->inspect(containers_[containerId]->name())
-    .then(defer(self(), &Self::_update, containerId, _resources, lambda::_1));
+  return metrics.update.time(
+      docker->inspect(containers_[containerId]->name())
+        .then(defer(self(),
+                    &Self::_update,
+                    containerId,
+                    _resources,
+                    lambda::_1)));
 #else
   return Nothing();
 #endif // __linux__
@@ -918,103 +946,143 @@ Future<Nothing> DockerContainerizerProcess::__update(
                    memoryHierarchy.error());
   }
 
+  CHECK(containers_.contains(containerId));
+
+  Container* container = containers_[containerId];
+
   // We need to find the cgroup(s) this container is currently running
   // in for both the hierarchy with the 'cpu' subsystem attached and
   // the hierarchy with the 'memory' subsystem attached so we can
-  // update the proper cgroup control files.
-
-  // Determine the cgroup for the 'cpu' subsystem (based on the
-  // container's pid).
-  Result<string> cpuCgroup = cgroups::cpu::cgroup(pid);
-
-  if (cpuCgroup.isError()) {
-    return Failure("Failed to determine cgroup for the 'cpu' subsystem: " +
-                   cpuCgroup.error());
-  } else if (cpuCgroup.isNone()) {
-    LOG(WARNING) << "Container " << containerId
-                 << " does not appear to be a member of a cgroup "
-                 << "where the 'cpu' subsystem is mounted";
+  // update the proper cgroup control files. A container does not
+  // move between cgroups while it is running so we only parse
+  // '/proc/<pid>/cgroup' the first time and cache the result.
+  if (container->cpuCgroup.isNone()) {
+    Result<string> cpuCgroup = cgroups::cpu::cgroup(pid);
+
+    if (cpuCgroup.isError()) {
+      return Failure("Failed to determine cgroup for the 'cpu' subsystem: " +
+                     cpuCgroup.error());
+    } else if (cpuCgroup.isNone()) {
+      LOG(WARNING) << "Container " << containerId
+                   << " does not appear to be a member of a cgroup "
+                   << "where the 'cpu' subsystem is mounted";
+    } else {
+      container->cpuCgroup = cpuCgroup.get();
+    }
   }
 
-  // And update the CPU shares (if applicable).
+  if (container->memoryCgroup.isNone()) {
+    Result<string> memoryCgroup = cgroups::memory::cgroup(pid);
+
+    if (memoryCgroup.isError()) {
+      return Failure(
+          "Failed to determine cgroup for the 'memory' subsystem: " +
+          memoryCgroup.error());
+    } else if (memoryCgroup.isNone()) {
+      LOG(WARNING) << "Container " << containerId
+                   << " does not appear to be a member of a cgroup "
+                   << "where the 'memory' subsystem is mounted";
+    } else {
+      container->memoryCgroup = memoryCgroup.get();
+    }
+  }
+
+  // Now compute the new cpu and memory limits up front and only write
+  // the control files whose value actually changed. Resizing a
+  // container with the same resources is then a no-op.
+  Option<uint64_t> shares = None();
   if (cpuHierarchy.isSome() &&
-      cpuCgroup.isSome() &&
+      container->cpuCgroup.isSome() &&
       _resources.cpus().isSome()) {
-    double cpuShares = _resources.cpus().get();
+    shares = std::max(
+        (uint64_t) (CPU_SHARES_PER_CPU * _resources.cpus().get()),
+        MIN_CPU_SHARES);
+
+    if (shares == container->cpuShares) {
+      shares = None();
+    }
+  }
+
+  // TODO(tnachen): investigate and handle OOM with docker.
+  Option<Bytes> limit = None();
+  if (memoryHierarchy.isSome() &&
+      container->memoryCgroup.isSome() &&
+      _resources.mem().isSome()) {
+    limit = std::max(_resources.mem().get(), MIN_MEMORY);
+
+    if (limit == container->memorySoftLimit) {
+      limit = None();
+    }
+  }
 
-    uint64_t shares =
-      std::max((uint64_t) (CPU_SHARES_PER_CPU * cpuShares), MIN_CPU_SHARES);
+  if (shares.isNone() && limit.isNone()) {
+    ++metrics.updates_skipped;
+    return Nothing();
+  }
 
-    Try<Nothing> write =
-      cgroups::cpu::shares(cpuHierarchy.get(), cpuCgroup.get(), shares);
+  if (shares.isSome()) {
+    Try<Nothing> write = cgroups::cpu::shares(
+        cpuHierarchy.get(), container->cpuCgroup.get(), shares.get());
 
     if (write.isError()) {
       return Failure("Failed to update 'cpu.shares': " + write.error());
     }
 
-    LOG(INFO) << "Updated 'cpu.shares' to " << shares
-              << " at " << path::join(cpuHierarchy.get(), cpuCgroup.get())
-              << " for container " << containerId;
-  }
-
-  // Now determine the cgroup for the 'memory' subsystem.
-  Result<string> memoryCgroup = cgroups::memory::cgroup(pid);
+    container->cpuShares = shares.get();
 
-  if (memoryCgroup.isError()) {
-    return Failure("Failed to determine cgroup for the 'memory' subsystem: " +
-                   memoryCgroup.error());
-  } else if (memoryCgroup.isNone()) {
-    LOG(WARNING) << "Container " << containerId
-                 << " does not appear to be a member of a cgroup "
-                 << "where the 'memory' subsystem is mounted";
+    LOG(INFO) << "Updated 'cpu.shares' to " << shares.get() << " at "
+              << path::join(cpuHierarchy.get(), container->cpuCgroup.get())
+              << " for container " << containerId;
   }
 
-  // And update the memory limits (if applicable).
-  if (memoryHierarchy.isSome() &&
-      memoryCgroup.isSome() &&
-      _resources.mem().isSome()) {
-    // TODO(tnachen): investigate and handle OOM with docker.
-    Bytes mem = _resources.mem().get();
-    Bytes limit = std::max(mem, MIN_MEMORY);
-
+  if (limit.isSome()) {
     // Always set the soft limit.
-    Try<Nothing> write =
-      cgroups::memory::soft_limit_in_bytes(
-          memoryHierarchy.get(), memoryCgroup.get(), limit);
+    Try<Nothing> write = cgroups::memory::soft_limit_in_bytes(
+        memoryHierarchy.get(), container->memoryCgroup.get(), limit.get());
 
     if (write.isError()) {
       return Failure("Failed to set 'memory.soft_limit_in_bytes': " +
                      write.error());
     }
 
-    LOG(INFO) << "Updated 'memory.soft_limit_in_bytes' to " << limit
+    container->memorySoftLimit = limit.get();
+
+    LOG(INFO) << "Updated 'memory.soft_limit_in_bytes' to " << limit.get()
               << " for container " << containerId;
 
-    // Read the existing limit.
-    Try<Bytes> currentLimit =
-      cgroups::memory::limit_in_bytes(
-          memoryHierarchy.get(), memoryCgroup.get());
+    // Read the existing limit, unless we've already read (or written)
+    // it before.
+    if (container->memoryLimit.isNone()) {
+      Try<Bytes> currentLimit = cgroups::memory::limit_in_bytes(
+          memoryHierarchy.get(), container->memoryCgroup.get());
 
-    if (currentLimit.isError()) {
-      return Failure("Failed to read 'memory.limit_in_bytes': " +
-                     currentLimit.error());
+      if (currentLimit.isError()) {
+        return Failure("Failed to read 'memory.limit_in_bytes': " +
+                       currentLimit.error());
+      }
+
+      container->memoryLimit = currentLimit.get();
     }
 
     // Only update if new limit is higher.
     // TODO(benh): Introduce a MemoryWatcherProcess which monitors the
     // discrepancy between usage and soft limit and introduces a
     // "manual oom" if necessary.
-    if (limit > currentLimit.get()) {
+    if (limit.get() > container->memoryLimit.get()) {
       write = cgroups::memory::limit_in_bytes(
-          memoryHierarchy.get(), memoryCgroup.get(), limit);
+          memoryHierarchy.get(), container->memoryCgroup.get(), limit.get());
 
       if (write.isError()) {
         return Failure("Failed to set 'memory.limit_in_bytes': " +
                        write.error());
       }
 
-      LOG(INFO) << "Updated 'memory.limit_in_bytes' to " << limit << " at "
-                << path::join(memoryHierarchy.get(), memoryCgroup.get())
+      container->memoryLimit = limit.get();
+
+      LOG(INFO) << "Updated 'memory.limit_in_bytes' to " << limit.get()
+                << " at "
+                << path::join(
+                       memoryHierarchy.get(), container->memoryCgroup.get())
                 << " for container " << containerId;
     }
   }
@@ -21,6 +21,10 @@
 
 #include <process/shared.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/hashset.hpp>
 
 #include "docker/docker.hpp"
@@ -250,6 +254,19 @@ private:
 
   process::Shared<Docker> docker;
 
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Time taken by update(), including a 'docker inspect' if the
+    // pid of the container is not yet known.
+    process::metrics::Timer<Milliseconds> update;
+
+    // Number of updates that did not change any cgroup limits.
+    process::metrics::Counter updates_skipped;
+  } metrics;
+
   struct Container
   {
     static Try<Container*> create(
@@ -431,6 +448,18 @@ private:
     // Once the container is running, this saves the pid of the
     // running container.
     Option<pid_t> pid;
+
+    // The cgroups (relative to the 'cpu' and 'memory' hierarchies)
+    // of the running container, resolved on the first update() so
+    // subsequent updates don't need to parse '/proc/<pid>/cgroup'.
+    Option<std::string> cpuCgroup;
+    Option<std::string> memoryCgroup;
+
+    // The limits we last wrote to (or read from) the cgroups above so
+    // update() only touches the control files that need to change.
+    Option<uint64_t> cpuShares;
+    Option<Bytes> memorySoftLimit;
+    Option<Bytes> memoryLimit;
   };
 
   hashmap<ContainerID, Container*> containers_;
@@ -18,6 +18,9 @@
 
 #include <stdint.h>
 
+#include <sys/resource.h>
+
+#include <limits>
 #include <vector>
 #include <set>
 
@@ -60,6 +63,24 @@ using std::vector;
 namespace mesos {
 namespace slave {
 
+// Returns the number of file descriptors that the perf counters of
+// all containers may hold, i.e., half of the slave's limit so that
+// enough are left for everything else.
+static Try<size_t> budget()
+{
+  struct rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+    return ErrnoError("Failed to get the file descriptor limit");
+  }
+
+  if (limit.rlim_cur == RLIM_INFINITY) {
+    return std::numeric_limits<size_t>::max();
+  }
+
+  return limit.rlim_cur / 2;
+}
+
+
 Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
 {
   LOG(INFO) << "Creating PerfEvent isolator";
@@ -86,7 +107,17 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
+  if (perf::native(events)) {
+    // Make sure the events can actually be counted on this host by
+    // counting them for ourselves.
+    Try<perf::Counters*> counters = perf::Counters::create(events, getpid());
+    if (counters.isError()) {
+      return Error("Failed to create PerfEvent isolator, invalid events: " +
+                   stringify(events) + ": " + counters.error());
+    }
+
+    delete counters.get();
+  } else if (!perf::valid(events)) {
     return Error("Failed to create PerfEvent isolator, invalid events: " +
                  stringify(events));
   }
@@ -100,9 +131,14 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     return Error("Failed to create perf_event cgroup: " + hierarchy.error());
   }
 
-  LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
-            << " every " << flags.perf_interval
-            << " for events: " << stringify(events);
+  if (perf::native(events)) {
+    LOG(INFO) << "PerfEvent isolator will count events every "
+              << flags.perf_interval << ": " << stringify(events);
+  } else {
+    LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
+              << " every " << flags.perf_interval
+              << " for events: " << stringify(events);
+  }
 
   process::Owned<IsolatorProcess> process(
       new CgroupsPerfEventIsolatorProcess(flags, hierarchy.get()));
@@ -123,6 +159,8 @@ CgroupsPerfEventIsolatorProcess::CgroupsPerfEventIsolatorProcess(
            strings::tokenize(flags.perf_events.get(), ",")) {
     events.insert(event);
   }
+
+  native = perf::native(events);
 }
 
 
@@ -335,6 +373,9 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::cleanup(
 
   info->destroying = true;
 
+  // Close the counters now, they hold a reference to the cgroup.
+  info->counters.reset();
+
   return cgroups::destroy(hierarchy, info->cgroup)
     .then(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
                 &CgroupsPerfEventIsolatorProcess::_cleanup,
@@ -374,17 +415,22 @@ Future<hashmap<string, PerfStatistics> > discardSample(
 void CgroupsPerfEventIsolatorProcess::sample()
 {
   set<string> cgroups;
-  foreachvalue (Info* info, infos) {
-    CHECK_NOTNULL(info);
 
-    if (info->destroying) {
-      // Skip cgroups if destroy has started because it's asynchronous
-      // and "perf stat" will fail if the cgroup has been destroyed
-      // by the time we actually run perf.
-      continue;
-    }
+  if (native) {
+    cgroups = count();
+  } else {
+    foreachvalue (Info* info, infos) {
+      CHECK_NOTNULL(info);
+
+      if (info->destroying) {
+        // Skip cgroups if destroy has started because it's
+        // asynchronous and "perf stat" will fail if the cgroup has
+        // been destroyed by the time we actually run perf.
+        continue;
+      }
 
-    cgroups.insert(info->cgroup);
+      cgroups.insert(info->cgroup);
+    }
   }
 
   if (cgroups.size() > 0) {
@@ -414,10 +460,113 @@ void CgroupsPerfEventIsolatorProcess::sample()
 }
 
 
+set<string> CgroupsPerfEventIsolatorProcess::count()
+{
+  set<string> cgroups;
+
+  // The counters hold a file descriptor per event and online cpu, so
+  // only as many containers are counted as fit in the budget and the
+  // others are sampled with 'perf stat' instead.
+  Option<size_t> available;
+
+  foreachvalue (Info* info, infos) {
+    CHECK_NOTNULL(info);
+
+    if (info->destroying) {
+      continue;
+    }
+
+    if (info->counters.get() == NULL) {
+      if (available.isNone()) {
+        Try<size_t> budget = slave::budget();
+        Try<size_t> descriptors = perf::descriptors(events);
+
+        if (budget.isError() || descriptors.isError()) {
+          LOG(ERROR) << "Failed to determine how many perf counters can be "
+                     << "opened: "
+                     << (budget.isError() ? budget.error()
+                                          : descriptors.error());
+
+          available = 0;
+        } else {
+          size_t used = 0;
+          foreachvalue (Info* other, infos) {
+            if (other->counters.get() != NULL) {
+              used += descriptors.get();
+            }
+          }
+
+          available = budget.get() > used
+            ? (budget.get() - used) / descriptors.get()
+            : 0;
+        }
+      }
+
+      if (available.get() == 0) {
+        if (!info->profiled) {
+          LOG(WARNING) << "Sampling perf events for container "
+                       << info->containerId << " with perf stat as "
+                       << "counting them would hold too many file "
+                       << "descriptors";
+
+          info->profiled = true;
+        }
+
+        cgroups.insert(info->cgroup);
+        continue;
+      }
+
+      Try<perf::Counters*> counters =
+        perf::Counters::create(events, hierarchy, info->cgroup);
+
+      if (counters.isError()) {
+        LOG(WARNING) << "Failed to open perf counters for container "
+                     << info->containerId << ": " << counters.error();
+        continue;
+      }
+
+      // NOTE: The first sample is read at the next interval so that
+      // it covers a whole interval.
+      info->counters.reset(counters.get());
+      info->profiled = false;
+      available = available.get() - 1;
+      continue;
+    }
+
+    Try<PerfStatistics> statistics = info->counters->sample();
+
+    if (statistics.isError()) {
+      LOG(ERROR) << "Failed to read perf counters for container "
+                 << info->containerId << ", re-opening them: "
+                 << statistics.error();
+
+      info->counters.reset();
+      continue;
+    }
+
+    info->statistics = statistics.get();
+  }
+
+  return cgroups;
+}
+
+
 void CgroupsPerfEventIsolatorProcess::_sample(
     const Time& next,
     const Future<hashmap<string, PerfStatistics> >& statistics)
 {
+  if (!statistics.isReady() && native) {
+    // Only some of the containers were sampled, keep counting the
+    // events of the others.
+    LOG(ERROR) << "Failed to get perf sample: "
+               << (statistics.isFailed() ? statistics.failure() : "discarded");
+
+    delay(next - Clock::now(),
+          PID<CgroupsPerfEventIsolatorProcess>(this),
+          &CgroupsPerfEventIsolatorProcess::sample);
+    return;
+  }
+
   if (!statistics.isReady()) {
     // Failure can occur for many reasons but all are unexpected and
     // indicate something is not right so we'll stop sampling.
@@ -21,6 +21,7 @@
 
 #include <set>
 
+#include <process/owned.hpp>
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
@@ -77,6 +78,13 @@ private:
 
   void sample();
 
+  // Reads the counters of the containers if the events are counted
+  // natively (see perf::Counters) rather than sampled with 'perf
+  // stat'. Returns the cgroups that are sampled with 'perf stat'
+  // nonetheless, as their counters would hold too many file
+  // descriptors.
+  std::set<std::string> count();
+
   void _sample(
       const process::Time& next,
       const process::Future<hashmap<std::string, PerfStatistics> >& statistics);
@@ -86,7 +94,10 @@ private:
   struct Info
   {
     Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup), destroying(false)
+      : containerId(_containerId),
+        cgroup(_cgroup),
+        destroying(false),
+        profiled(false)
     {
       // Ensure the initial statistics include the required fields.
       // Note the duration is set to zero to indicate no sampling has
@@ -101,6 +112,12 @@ private:
     PerfStatistics statistics;
     // Mark a container when we start destruction so we stop sampling it.
     bool destroying;
+    // The counters of the container's cgroup if the events are
+    // counted natively, once opened.
+    process::Owned<perf::Counters> counters;
+    // Set while the container is sampled with 'perf stat' although
+    // the events are counted natively (see 'count').
+    bool profiled;
   };
 
   const Flags flags;
@@ -109,6 +126,8 @@ private:
   const std::string hierarchy;
   // Set of events to sample.
   std::set<std::string> events;
+  // Whether the events are counted natively.
+  bool native;
 
   hashmap<ContainerID, Info*> infos;
 };
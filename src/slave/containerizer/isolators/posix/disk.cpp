@@ -16,15 +16,24 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
 #include <signal.h>
+#include <string.h>
 
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <deque>
 
 #include <glog/logging.h>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
@@ -33,14 +42,19 @@
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/numify.hpp>
+#include <stout/path.hpp>
 #include <stout/strings.hpp>
 #include <stout/tuple.hpp>
 
+#include <stout/os/close.hpp>
 #include <stout/os/exists.hpp>
 #include <stout/os/killtree.hpp>
 
+#include "slave/constants.hpp"
+
 #include "slave/containerizer/isolators/posix/disk.hpp"
 
 using namespace process;
@@ -57,8 +71,22 @@ Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
   // TODO(jieyu): Check the availability of command 'du'.
 
-  return new Isolator(
-      process::Owned<IsolatorProcess>(new PosixDiskIsolatorProcess(flags)));
+  Option<Owned<DiskUsageTracker>> tracker;
+
+  if (flags.container_disk_watch_incremental) {
+    Try<DiskUsageTracker*> create = DiskUsageTracker::create(
+        flags.container_disk_watch_interval,
+        DISK_USAGE_RECONCILIATION_INTERVAL);
+
+    if (create.isError()) {
+      return Error("Failed to create disk usage tracker: " + create.error());
+    }
+
+    tracker = Owned<DiskUsageTracker>(create.get());
+  }
+
+  return new Isolator(process::Owned<IsolatorProcess>(
+      new PosixDiskIsolatorProcess(flags, tracker)));
 }
 
 
@@ -68,8 +96,12 @@ PosixDiskIsolatorProcess::Info::PathInfo::~PathInfo()
 }
 
 
-PosixDiskIsolatorProcess::PosixDiskIsolatorProcess(const Flags& _flags)
-  : flags(_flags), collector(flags.container_disk_watch_interval) {}
+PosixDiskIsolatorProcess::PosixDiskIsolatorProcess(
+    const Flags& _flags,
+    const Option<Owned<DiskUsageTracker>>& _tracker)
+  : flags(_flags),
+    collector(flags.container_disk_watch_interval),
+    tracker(_tracker) {}
 
 
 PosixDiskIsolatorProcess::~PosixDiskIsolatorProcess() {}
@@ -183,13 +215,8 @@ Future<Nothing> PosixDiskIsolatorProcess::update(
   // the disk usage collection.
   foreachpair (const string& path, const Resources& quota, quotas) {
     if (!info->paths.contains(path)) {
-      info->paths[path].usage = collector.usage(path)
-        .onAny(defer(
-            PID<PosixDiskIsolatorProcess>(this),
-            &PosixDiskIsolatorProcess::_collect,
-            containerId,
-            path,
-            lambda::_1));
+      info->paths[path].tracked = tracker.isSome();
+      collect(containerId, path);
     }
 
     info->paths[path].quota = quota;
@@ -198,6 +225,10 @@ Future<Nothing> PosixDiskIsolatorProcess::update(
   // Remove paths that we no longer interested in.
   foreach (const string& path, info->paths.keys()) {
     if (!quotas.contains(path)) {
+      if (info->paths[path].tracked) {
+        tracker.get()->untrack(path);
+      }
+
       info->paths.erase(path);
     }
   }
@@ -206,6 +237,29 @@ Future<Nothing> PosixDiskIsolatorProcess::update(
 }
 
 
+void PosixDiskIsolatorProcess::collect(
+    const ContainerID& containerId,
+    const string& path)
+{
+  CHECK(infos.contains(containerId));
+  CHECK(infos[containerId]->paths.contains(path));
+
+  Info::PathInfo& pathInfo = infos[containerId]->paths[path];
+
+  Future<Bytes> usage = pathInfo.tracked
+    ? tracker.get()->usage(path)
+    : collector.usage(path);
+
+  pathInfo.usage = usage
+    .onAny(defer(
+        PID<PosixDiskIsolatorProcess>(this),
+        &PosixDiskIsolatorProcess::_collect,
+        containerId,
+        path,
+        lambda::_1));
+}
+
+
 void PosixDiskIsolatorProcess::_collect(
     const ContainerID& containerId,
     const string& path,
@@ -232,6 +286,15 @@ void PosixDiskIsolatorProcess::_collect(
     return;
   }
 
+  // Fall back to 'du' if the path cannot be tracked incrementally.
+  if (future.isFailed() && info->paths[path].tracked) {
+    LOG(WARNING) << "Falling back to 'du' to check disk usage at '"
+                 << path << "' for container " << containerId;
+
+    tracker.get()->untrack(path);
+    info->paths[path].tracked = false;
+  }
+
   // Check if the disk usage exceeds the quota. If yes, report the
   // limitation. We keep collecting the disk usage for 'path' by
   // initiating another round of disk usage check. The check will be
@@ -253,13 +316,7 @@ void PosixDiskIsolatorProcess::_collect(
     }
   }
 
-  info->paths[path].usage = collector.usage(path)
-    .onAny(defer(
-        PID<PosixDiskIsolatorProcess>(this),
-        &PosixDiskIsolatorProcess::_collect,
-        containerId,
-        path,
-        lambda::_1));
+  collect(containerId, path);
 }
 
 
@@ -280,8 +337,9 @@ Future<ResourceStatistics> PosixDiskIsolatorProcess::usage(
 
     result.set_disk_limit_bytes(quota.get().bytes());
 
-    // NOTE: There may be a large delay (# of containers * interval)
-    // until an initial cached value is returned here!
+    // NOTE: Unless the usage is tracked incrementally there may be a
+    // large delay (# of containers * interval) until an initial
+    // cached value is returned here!
     if (info->paths[info->directory].lastUsage.isSome()) {
       result.set_disk_used_bytes(
           info->paths[info->directory].lastUsage.get().bytes());
@@ -300,6 +358,14 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
     return Nothing();
   }
 
+  foreachpair (const string& path,
+               const Info::PathInfo& pathInfo,
+               infos[containerId]->paths) {
+    if (pathInfo.tracked) {
+      tracker.get()->untrack(path);
+    }
+  }
+
   infos.erase(containerId);
 
   return Nothing();
@@ -498,5 +564,724 @@ Future<Bytes> DiskUsageCollector::usage(const string& path)
   return dispatch(process, &DiskUsageCollectorProcess::usage, path);
 }
 
+
+#ifdef __linux__
+class DiskUsageTrackerProcess : public Process<DiskUsageTrackerProcess>
+{
+public:
+  DiskUsageTrackerProcess(
+      int _inotify,
+      const Duration& _interval,
+      const Duration& _reconciliation)
+    : inotify(_inotify),
+      interval(_interval),
+      reconciliation(_reconciliation) {}
+
+  virtual ~DiskUsageTrackerProcess()
+  {
+    // A full scan that is still in progress keeps using the inotify
+    // instance (see 'walk'), so it gets closed once the scan is done.
+    if (walking.isSome() && walking.get().isPending()) {
+      walking.get().onAny(lambda::bind(&os::close, inotify));
+    } else {
+      os::close(inotify);
+    }
+  }
+
+  Future<Bytes> usage(const string& path)
+  {
+    if (!roots.contains(path)) {
+      roots[path] = Owned<Root>(new Root(path));
+
+      // Start the initial scan right away, the usage is reported
+      // with the first report after it is done.
+      rescan(roots[path].get());
+    }
+
+    const Owned<Root>& root = roots[path];
+
+    if (root->error.isSome()) {
+      return Failure(root->error.get());
+    }
+
+    if (root->promise.isNone()) {
+      root->promise = Owned<Promise<Bytes>>(new Promise<Bytes>());
+
+      // Install onDiscard callback.
+      root->promise.get()->future()
+        .onDiscard(defer(self(), &Self::discard, path));
+    }
+
+    return root->promise.get()->future();
+  }
+
+  void untrack(const string& path)
+  {
+    if (!roots.contains(path)) {
+      return;
+    }
+
+    Owned<Root> root = roots[path];
+    roots.erase(path);
+
+    if (root->promise.isSome()) {
+      root->promise.get()->discard();
+    }
+
+    foreachkey (const string& directory, root->sizes) {
+      unwatch(directory);
+    }
+
+    unwatch(path);
+  }
+
+protected:
+  virtual void initialize()
+  {
+    read();
+
+    delay(interval, self(), &Self::report);
+  }
+
+  virtual void finalize()
+  {
+    poll.discard();
+
+    foreachvalue (const Owned<Root>& root, roots) {
+      if (root->promise.isSome()) {
+        root->promise.get()->fail("DiskUsageTracker is destroyed");
+      }
+    }
+  }
+
+private:
+  // The result of fully scanning a path (see 'walk').
+  struct Scan
+  {
+    Scan() : self(0) {}
+
+    // The disk usage of the path itself.
+    uint64_t self;
+
+    // The disk usage of the entries directly within each directory
+    // under (and including) the path, if it is a directory.
+    hashmap<string, uint64_t> sizes;
+
+    // The watches that were added, keyed by the watched path.
+    hashmap<string, int> watches;
+  };
+
+  // A tracked path.
+  struct Root
+  {
+    explicit Root(const string& _path)
+      : path(_path), self(0), total(0), stale(false), scanning(false) {}
+
+    const string path;
+
+    // The disk usage of the entries directly within each directory
+    // under (and including) 'path', if it is a directory.
+    hashmap<string, uint64_t> sizes;
+
+    // The disk usage of 'path' itself.
+    uint64_t self;
+
+    // The sum of 'self' and 'sizes'.
+    uint64_t total;
+
+    // When the path was last fully scanned, none until the initial
+    // scan is done.
+    Option<Time> scanned;
+
+    // Set if we might have missed inotify events for the path (e.g.,
+    // the event queue overflowed), in which case it gets fully
+    // re-scanned as soon as possible. Until then we keep reporting
+    // the usage we track incrementally.
+    bool stale;
+
+    // Set while a full scan of the path is queued or in progress, and
+    // the scan once it is in progress (see 'rescan').
+    bool scanning;
+    Option<Future<Try<Scan>>> walk;
+
+    // Set if tracking the path failed.
+    Option<string> error;
+
+    Option<Owned<Promise<Bytes>>> promise;
+  };
+
+  static const uint32_t MASK =
+    IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO |
+    IN_DELETE_SELF | IN_MOVE_SELF | IN_DONT_FOLLOW | IN_ONLYDIR;
+
+  void discard(const string& path)
+  {
+    if (roots.contains(path) && roots[path]->promise.isSome()) {
+      roots[path]->promise.get()->discard();
+      roots[path]->promise = None();
+    }
+  }
+
+  void read()
+  {
+    poll = io::poll(inotify, io::READ)
+      .onAny(defer(self(), &Self::_read));
+  }
+
+  void _read()
+  {
+    // Large enough for at least one event with the longest name.
+    char buffer[64 * 1024] __attribute__((aligned(8)));
+
+    while (true) {
+      ssize_t length = ::read(inotify, buffer, sizeof(buffer));
+
+      if (length == -1 && errno == EINTR) {
+        continue;
+      } else if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else if (length <= 0) {
+        LOG(ERROR) << "Failed to read inotify events: "
+                   << (length == 0 ? "EOF" : strerror(errno));
+
+        // Make sure we still notice changes, albeit only by
+        // periodically re-scanning all the paths.
+        reconcileAll();
+        return;
+      }
+
+      for (ssize_t offset = 0; offset < length;) {
+        const struct inotify_event* event =
+          (const struct inotify_event*) (buffer + offset);
+
+        handle(event);
+
+        offset += sizeof(struct inotify_event) + event->len;
+      }
+    }
+
+    read();
+  }
+
+  void handle(const struct inotify_event* event)
+  {
+    if (event->mask & IN_Q_OVERFLOW) {
+      LOG(WARNING) << "Inotify event queue overflowed, re-scanning all "
+                   << roots.size() << " tracked paths";
+
+      reconcileAll();
+      return;
+    }
+
+    if (!directories.contains(event->wd)) {
+      // The watch might have just been added by the full scan in
+      // progress, which we then need to catch up on (see 'walked').
+      if (walking.isSome()) {
+        missed.insert(event->wd);
+      }
+      return;
+    }
+
+    const string directory = directories[event->wd];
+
+    if (event->mask & IN_IGNORED) {
+      // The directory got removed, or we stopped watching it.
+      directories.erase(event->wd);
+      watches.erase(directory);
+
+      forget(directory);
+    } else if ((event->mask & IN_ISDIR) &&
+               (event->mask & (IN_DELETE | IN_MOVED_FROM)) &&
+               event->len > 0) {
+      // NOTE: A directory that is moved away keeps its watch, so we
+      // need to forget about it here rather than on IN_IGNORED.
+      forget(path::join(directory, event->name));
+    }
+
+    // New subdirectories and changed entries are picked up by
+    // re-scanning the directory.
+    dirty.insert(directory);
+
+    if (walking.isSome()) {
+      changed.insert(directory);
+    }
+  }
+
+  void report()
+  {
+    foreach (const string& directory, dirty) {
+      foreachvalue (const Owned<Root>& root, roots) {
+        if (root->error.isSome()) {
+          continue;
+        }
+
+        if (root->path == directory) {
+          root->total -= root->self;
+          root->self = blocks(directory);
+          root->total += root->self;
+        }
+
+        if (root->sizes.contains(directory)) {
+          Try<Nothing> scan = this->scan(root.get(), directory);
+          if (scan.isError()) {
+            fail(root.get(), scan.error());
+          }
+        }
+      }
+    }
+
+    dirty.clear();
+
+    // Fully re-scan the path that needs it most, i.e., the least
+    // recently scanned stale path or else the least recently scanned
+    // path due for reconciliation, but at most one per report to
+    // bound the time spent in each report.
+    Option<Owned<Root>> next;
+
+    foreachvalue (const Owned<Root>& root, roots) {
+      if (root->error.isSome()) {
+        continue;
+      }
+
+      if (root->scanning) {
+        continue;
+      }
+
+      // NOTE: A path that is not being scanned has been scanned.
+      CHECK_SOME(root->scanned);
+
+      if (!root->stale &&
+          Clock::now() - root->scanned.get() < reconciliation) {
+        continue;
+      }
+
+      if (next.isNone() ||
+          (root->stale && !next.get()->stale) ||
+          (root->stale == next.get()->stale &&
+           root->scanned.get() < next.get()->scanned.get())) {
+        next = root;
+      }
+    }
+
+    if (next.isSome()) {
+      rescan(next.get().get());
+    }
+
+    foreachvalue (const Owned<Root>& root, roots) {
+      // The usage is not known until the initial scan is done.
+      if (root->promise.isSome() && root->scanned.isSome()) {
+        root->promise.get()->set(Bytes(root->total));
+        root->promise = None();
+      }
+    }
+
+    delay(interval, self(), &Self::report);
+  }
+
+  // Makes every path get fully re-scanned, one per report.
+  void reconcileAll()
+  {
+    foreachvalue (const Owned<Root>& root, roots) {
+      root->stale = true;
+    }
+  }
+
+  // Queues a full scan of 'root'. To not block this process on a
+  // large path for as long as 'du' would take, the path is walked in
+  // the background (see 'walk'), one path at a time, and what we know
+  // about 'root' is only replaced once the walk is done. Until then
+  // we keep tracking the path incrementally.
+  void rescan(Root* root)
+  {
+    if (root->scanning) {
+      return;
+    }
+
+    root->scanning = true;
+    queue.push_back(root->path);
+
+    next();
+  }
+
+  void next()
+  {
+    while (walking.isNone() && !queue.empty()) {
+      const string path = queue.front();
+      queue.pop_front();
+
+      // The path might have been untracked (and tracked again) since.
+      if (!roots.contains(path) || roots[path]->walk.isSome()) {
+        continue;
+      }
+
+      const Owned<Root>& root = roots[path];
+
+      // Events that get lost from now on are caught by this scan.
+      root->stale = false;
+
+      walking = async(&Self::walk, inotify, path);
+      root->walk = walking.get();
+
+      walking.get()
+        .onAny(defer(self(), &Self::walked, path, lambda::_1));
+    }
+  }
+
+  void walked(const string& path, const Future<Try<Scan>>& future)
+  {
+    walking = None();
+
+    // The watches added by the walk are tracked regardless of
+    // whether we still need them so that they can be removed below.
+    Option<Scan> scan;
+    if (future.isReady() && future.get().isSome()) {
+      scan = future.get().get();
+
+      foreachpair (const string& directory, int wd, scan.get().watches) {
+        directories[wd] = directory;
+        watches[directory] = wd;
+      }
+    }
+
+    if (roots.contains(path) && roots[path]->walk == future) {
+      Root* root = roots[path].get();
+
+      root->scanning = false;
+      root->walk = None();
+
+      if (!future.isReady()) {
+        fail(root,
+             "Failed to scan '" + path + "': " +
+             (future.isFailed() ? future.failure() : "discarded"));
+      } else if (future.get().isError()) {
+        fail(root, future.get().error());
+      } else {
+        hashmap<string, uint64_t> sizes = root->sizes;
+
+        root->sizes = scan.get().sizes;
+        root->self = scan.get().self;
+        root->total = root->self;
+        foreachvalue (uint64_t size, root->sizes) {
+          root->total += size;
+        }
+        root->scanned = Clock::now();
+
+        // Stop watching the directories that are gone.
+        foreachkey (const string& directory, sizes) {
+          if (!root->sizes.contains(directory)) {
+            unwatch(directory);
+          }
+        }
+
+        // The walk might have listed a directory before it changed,
+        // so these directories are re-scanned with the next report.
+        foreachpair (const string& directory, int wd, scan.get().watches) {
+          if (changed.contains(directory) || missed.contains(wd)) {
+            dirty.insert(directory);
+          }
+        }
+      }
+    }
+
+    changed.clear();
+    missed.clear();
+
+    if (scan.isSome()) {
+      foreachkey (const string& directory, scan.get().watches) {
+        unwatch(directory);
+      }
+    }
+
+    next();
+  }
+
+  // Re-computes the disk usage of the entries directly within
+  // 'directory' and scans any new subdirectory.
+  Try<Nothing> scan(Root* root, const string& directory)
+  {
+    // The directory might have just been removed while the watch we
+    // would have learned it from was added by a full scan.
+    struct stat s;
+    if (::lstat(directory.c_str(), &s) < 0 || !S_ISDIR(s.st_mode)) {
+      forget(directory);
+      return Nothing();
+    }
+
+    hashmap<string, uint64_t> sizes;
+    hashmap<string, int> watches;
+
+    Try<Nothing> traverse =
+      Self::traverse(inotify, directory, root->sizes, &sizes, &watches);
+
+    foreachpair (const string& path, int wd, watches) {
+      this->directories[wd] = path;
+      this->watches[path] = wd;
+    }
+
+    if (traverse.isError()) {
+      return traverse;
+    }
+
+    foreachpair (const string& path, uint64_t size, sizes) {
+      if (root->sizes.contains(path)) {
+        root->total -= root->sizes[path];
+      }
+
+      root->sizes[path] = size;
+      root->total += size;
+    }
+
+    return Nothing();
+  }
+
+  // Scans 'path' from scratch. This only makes system calls, so that
+  // it can run outside of this process (see 'rescan').
+  static Try<Scan> walk(int inotify, const string& path)
+  {
+    Scan scan;
+    scan.self = blocks(path);
+
+    // Watch the path itself even if it is not a directory so that
+    // we notice it changing.
+    Try<Nothing> watch = Self::watch(inotify, path, false, &scan.watches);
+
+    // NOTE: Like 'du', we do not follow a symbolic link even if it is
+    // the path itself.
+    struct stat s;
+    if (watch.isSome() &&
+        ::lstat(path.c_str(), &s) == 0 &&
+        S_ISDIR(s.st_mode)) {
+      watch = traverse(
+          inotify,
+          path,
+          hashmap<string, uint64_t>(),
+          &scan.sizes,
+          &scan.watches);
+    }
+
+    if (watch.isError()) {
+      return Error(watch.error());
+    }
+
+    return scan;
+  }
+
+  // Computes the disk usage of the entries directly within
+  // 'directory' and within any of its subdirectories not in 'known',
+  // watching each of these directories.
+  static Try<Nothing> traverse(
+      int inotify,
+      const string& directory,
+      const hashmap<string, uint64_t>& known,
+      hashmap<string, uint64_t>* sizes,
+      hashmap<string, int>* watches)
+  {
+    deque<string> pending;
+    pending.push_back(directory);
+
+    while (!pending.empty()) {
+      const string current = pending.front();
+      pending.pop_front();
+
+      // Add the watch before listing the entries so that we don't
+      // miss any entry created in between.
+      Try<Nothing> watch = Self::watch(inotify, current, true, watches);
+      if (watch.isError()) {
+        return Error(watch.error());
+      }
+
+      DIR* dir = ::opendir(current.c_str());
+      if (dir == NULL) {
+        // The directory might have just been removed, in which case
+        // we'll find out through inotify.
+        continue;
+      }
+
+      uint64_t size = 0;
+
+      struct dirent* entry;
+      while ((entry = ::readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 ||
+            strcmp(entry->d_name, "..") == 0) {
+          continue;
+        }
+
+        const string path = path::join(current, entry->d_name);
+
+        struct stat s;
+        if (::lstat(path.c_str(), &s) < 0) {
+          continue;
+        }
+
+        // NOTE: Like 'du', we report the number of blocks allocated
+        // rather than the apparent size.
+        size += s.st_blocks * 512;
+
+        if (S_ISDIR(s.st_mode) && !known.contains(path)) {
+          pending.push_back(path);
+        }
+      }
+
+      ::closedir(dir);
+
+      (*sizes)[current] = size;
+    }
+
+    return Nothing();
+  }
+
+  // Forgets about 'directory' and all the directories under it.
+  void forget(const string& directory)
+  {
+    foreachvalue (const Owned<Root>& root, roots) {
+      foreach (const string& path, root->sizes.keys()) {
+        if (path == directory || strings::startsWith(path, directory + "/")) {
+          root->total -= root->sizes[path];
+          root->sizes.erase(path);
+
+          unwatch(path);
+        }
+      }
+    }
+  }
+
+  void fail(Root* root, const string& message)
+  {
+    root->error = message;
+
+    if (root->promise.isSome()) {
+      root->promise.get()->fail(message);
+      root->promise = None();
+    }
+  }
+
+  static Try<Nothing> watch(
+      int inotify,
+      const string& path,
+      bool directory,
+      hashmap<string, int>* watches)
+  {
+    int wd = ::inotify_add_watch(
+        inotify,
+        path.c_str(),
+        directory ? MASK : (MASK & ~IN_ONLYDIR));
+
+    if (wd < 0) {
+      // The path might have just been removed.
+      if (errno == ENOENT || errno == ENOTDIR) {
+        return Nothing();
+      }
+
+      return ErrnoError("Failed to watch '" + path + "'");
+    }
+
+    (*watches)[path] = wd;
+
+    return Nothing();
+  }
+
+  // Stops watching 'path' unless another tracked path still needs it.
+  void unwatch(const string& path)
+  {
+    if (!watches.contains(path)) {
+      return;
+    }
+
+    foreachvalue (const Owned<Root>& root, roots) {
+      if (root->path == path || root->sizes.contains(path)) {
+        return;
+      }
+    }
+
+    ::inotify_rm_watch(inotify, watches[path]);
+
+    directories.erase(watches[path]);
+    watches.erase(path);
+  }
+
+  static uint64_t blocks(const string& path)
+  {
+    struct stat s;
+    if (::lstat(path.c_str(), &s) < 0) {
+      return 0;
+    }
+
+    return s.st_blocks * 512;
+  }
+
+  const int inotify;
+  const Duration interval;
+  const Duration reconciliation;
+
+  Future<short> poll;
+
+  hashmap<string, Owned<Root>> roots;
+
+  // Watch descriptor to path and back.
+  hashmap<int, string> directories;
+  hashmap<string, int> watches;
+
+  // Directories changed since the last report.
+  hashset<string> dirty;
+
+  // The paths queued for a full scan, and the scan in progress.
+  deque<string> queue;
+  Option<Future<Try<Scan>>> walking;
+
+  // The directories that changed, and the watches that got events
+  // before we knew about them, while the full scan was in progress.
+  hashset<string> changed;
+  hashset<int> missed;
+};
+
+
+const uint32_t DiskUsageTrackerProcess::MASK;
+#endif // __linux__
+
+
+Try<DiskUsageTracker*> DiskUsageTracker::create(
+    const Duration& interval,
+    const Duration& reconciliation)
+{
+#ifdef __linux__
+  int inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify < 0) {
+    return ErrnoError("Failed to initialize inotify");
+  }
+
+  return new DiskUsageTracker(
+      new DiskUsageTrackerProcess(inotify, interval, reconciliation));
+#else
+  return Error("Incremental disk usage tracking is only supported on Linux");
+#endif // __linux__
+}
+
+
+DiskUsageTracker::DiskUsageTracker(DiskUsageTrackerProcess* _process)
+  : process(_process)
+{
+  spawn(process);
+}
+
+
+DiskUsageTracker::~DiskUsageTracker()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<Bytes> DiskUsageTracker::usage(const string& path)
+{
+  return dispatch(process, &DiskUsageTrackerProcess::usage, path);
+}
+
+
+void DiskUsageTracker::untrack(const string& path)
+{
+  dispatch(process, &DiskUsageTrackerProcess::untrack, path);
+}
+
 } // namespace slave {
 } // namespace mesos {
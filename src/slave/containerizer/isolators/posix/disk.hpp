@@ -26,6 +26,8 @@
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
 
 #include "slave/flags.hpp"
 
@@ -36,6 +38,7 @@ namespace slave {
 
 // Forward declarations.
 class DiskUsageCollectorProcess;
+class DiskUsageTrackerProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
@@ -55,19 +58,56 @@ private:
 };
 
 
+// Responsible for tracking disk usage for paths incrementally (Linux
+// only). Each path is scanned once when it is first tracked; after
+// that only the directories in which inotify reports a change get
+// re-scanned. The usage of every tracked path is reported once per
+// interval, independent of the number of paths, and each path is
+// fully re-scanned every 'reconciliation' interval (or when inotify
+// overflows) to correct any drift. Paths awaiting a re-scan keep
+// reporting the usage tracked incrementally in the meantime.
+//
+// NOTE: Usage is accounted per directory (the blocks of the entries
+// directly within it), so we need one inotify watch per directory
+// but no state per file. Unlike 'du', a file with multiple hard
+// links in the tracked path is counted once for every link.
+class DiskUsageTracker
+{
+public:
+  static Try<DiskUsageTracker*> create(
+      const Duration& interval,
+      const Duration& reconciliation);
+
+  ~DiskUsageTracker();
+
+  // Starts tracking 'path' (if it is not tracked yet) and returns its
+  // disk usage as of the next report. The user can discard the
+  // returned future to cancel the check.
+  process::Future<Bytes> usage(const std::string& path);
+
+  // Stops tracking 'path'.
+  void untrack(const std::string& path);
+
+private:
+  explicit DiskUsageTracker(DiskUsageTrackerProcess* process);
+
+  DiskUsageTrackerProcess* process;
+};
+
+
 // This isolator monitors the disk usage for containers, and reports
 // Limitation when a container exceeds its disk quota. This leverages
 // the DiskUsageCollector to ensure that we don't induce too much CPU
 // usage and disk caching effects from running 'du' too often.
 //
-// NOTE: Currently all containers are processed in the same queue,
-// which means that when a container starts, it could take many disk
-// collection intervals until any data is available in the resource
-// usage statistics!
-//
-// TODO(jieyu): Consider handling each container independently, or
-// triggering an initial collection when the container starts, to
-// ensure that we have usage statistics without a large delay.
+// NOTE: With the DiskUsageCollector all containers are processed in
+// the same queue, which means that when a container starts, it could
+// take many disk collection intervals until any data is available in
+// the resource usage statistics! With
+// --container_disk_watch_incremental the DiskUsageTracker is used
+// instead, which reports the usage of every container once per
+// interval. Paths the tracker fails to track (e.g., because we ran
+// out of inotify watches) fall back to the DiskUsageCollector.
 class PosixDiskIsolatorProcess : public IsolatorProcess
 {
 public:
@@ -102,7 +142,12 @@ public:
       const ContainerID& containerId);
 
 private:
-  PosixDiskIsolatorProcess(const Flags& flags);
+  PosixDiskIsolatorProcess(
+      const Flags& flags,
+      const Option<process::Owned<DiskUsageTracker>>& tracker);
+
+  // Initiates the next disk usage check for 'path'.
+  void collect(const ContainerID& containerId, const std::string& path);
 
   void _collect(
       const ContainerID& containerId,
@@ -111,6 +156,7 @@ private:
 
   const Flags flags;
   DiskUsageCollector collector;
+  Option<process::Owned<DiskUsageTracker>> tracker;
 
   struct Info
   {
@@ -127,11 +173,16 @@ private:
     // For each path, we maintain its quota and its last usage.
     struct PathInfo
     {
+      PathInfo() : tracked(false) {}
       ~PathInfo();
 
       Resources quota;
       process::Future<Bytes> usage;
       Option<Bytes> lastUsage;
+
+      // Whether the usage is collected by the DiskUsageTracker rather
+      // than the DiskUsageCollector.
+      bool tracked;
     };
 
     hashmap<std::string, PathInfo> paths;
@@ -21,6 +21,7 @@
 #include <process/process.hpp>
 #include <process/reap.hpp>
 
+#include <stout/path.hpp>
 #include <stout/unreachable.hpp>
 
 #include "mesos/resources.hpp"
@@ -42,7 +43,20 @@ using state::RunState;
 
 Try<Launcher*> PosixLauncher::create(const Flags& flags)
 {
-  return new PosixLauncher();
+  Option<Owned<Zygote> > zygote;
+
+  if (flags.launcher_zygote) {
+    Try<Zygote*> create =
+      Zygote::create(path::join(flags.launcher_dir, "mesos-containerizer"));
+
+    if (create.isError()) {
+      return Error(create.error());
+    }
+
+    zygote = Owned<Zygote>(create.get());
+  }
+
+  return new PosixLauncher(zygote);
 }
 
 
@@ -112,6 +126,7 @@ Try<pid_t> PosixLauncher::fork(
     const Subprocess::IO& err,
     const Option<flags::FlagsBase>& flags,
     const Option<map<string, string> >& environment,
+    const vector<int>& inherit,
     const Option<lambda::function<int()> >& setup)
 {
   if (pids.contains(containerId)) {
@@ -119,27 +134,65 @@ Try<pid_t> PosixLauncher::fork(
                  stringify(containerId));
   }
 
-  Try<Subprocess> child = subprocess(
-      path,
-      argv,
-      in,
-      out,
-      err,
-      flags,
-      environment,
-      lambda::bind(&childSetup, setup));
-
-  if (child.isError()) {
-    return Error("Failed to fork a child process: " + child.error());
+  Option<pid_t> pid;
+
+  // The zygote can't run a 'setup' function on our behalf.
+  if (zygote.isSome() && setup.isNone()) {
+    Result<pid_t> child = zygote.get()->fork(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        inherit);
+
+    if (child.isError()) {
+      return Error("Failed to fork a child process: " + child.error());
+    }
+
+    // The child is forked below if the zygote is no longer running.
+    if (child.isSome()) {
+      pid = child.get();
+    }
   }
 
-  LOG(INFO) << "Forked child with pid '" << child.get().pid()
+  if (pid.isNone()) {
+    Try<Subprocess> child = subprocess(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        lambda::bind(&childSetup, setup));
+
+    if (child.isError()) {
+      return Error("Failed to fork a child process: " + child.error());
+    }
+
+    pid = child.get().pid();
+  }
+
+  LOG(INFO) << "Forked child with pid '" << pid.get()
             << "' for container '" << containerId << "'";
 
   // Store the pid (session id and process group id).
-  pids.put(containerId, child.get().pid());
+  pids.put(containerId, pid.get());
+
+  return pid.get();
+}
+
+
+Future<Option<int> > PosixLauncher::status(pid_t pid)
+{
+  if (zygote.isSome()) {
+    return zygote.get()->status(pid);
+  }
 
-  return child.get().pid();
+  return process::reap(pid);
 }
 
 
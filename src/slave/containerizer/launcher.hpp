@@ -24,6 +24,7 @@
 #include <string>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/flags.hpp>
@@ -34,6 +35,8 @@
 #include "slave/flags.hpp"
 #include "slave/state.hpp"
 
+#include "slave/containerizer/mesos/zygote.hpp"
+
 namespace mesos {
 namespace slave {
 
@@ -49,10 +52,14 @@ public:
   // Fork a new process in the containerized context. The child will
   // exec the binary at the given path with the given argv, flags and
   // environment. The I/O of the child will be redirected according to
-  // the specified I/O descriptors. The user can provide a 'setup'
-  // function which will be invoked in the child process right before
-  // the exec. The 'setup' function has to be async signal safe. The
-  // parent will return the child's pid if the fork is successful.
+  // the specified I/O descriptors. The child inherits the file
+  // descriptors in 'inherit' (which must not be close-on-exec) under
+  // the same numbers; whether it inherits any other descriptor that
+  // is not close-on-exec depends on how it gets forked. The user can
+  // provide a 'setup' function which will be invoked in the child
+  // process right before the exec. The 'setup' function has to be
+  // async signal safe. The parent will return the child's pid if the
+  // fork is successful.
   virtual Try<pid_t> fork(
       const ContainerID& containerId,
       const std::string& path,
@@ -62,8 +69,12 @@ public:
       const process::Subprocess::IO& err,
       const Option<flags::FlagsBase>& flags,
       const Option<std::map<std::string, std::string> >& environment,
+      const std::vector<int>& inherit,
       const Option<lambda::function<int()> >& setup) = 0;
 
+  // Returns the exit status of a process forked by fork().
+  virtual process::Future<Option<int> > status(pid_t pid) = 0;
+
   // Kill all processes in the containerized context.
   virtual process::Future<Nothing> destroy(const ContainerID& containerId) = 0;
 };
@@ -92,16 +103,24 @@ public:
       const process::Subprocess::IO& err,
       const Option<flags::FlagsBase>& flags,
       const Option<std::map<std::string, std::string> >& environment,
+      const std::vector<int>& inherit,
       const Option<lambda::function<int()> >& setup);
 
+  virtual process::Future<Option<int> > status(pid_t pid);
+
   virtual process::Future<Nothing> destroy(const ContainerID& containerId);
 
 private:
-  PosixLauncher() {}
+  explicit PosixLauncher(const Option<process::Owned<Zygote> >& _zygote)
+    : zygote(_zygote) {}
 
   // The 'pid' is the process id of the first process and also the
   // process group id and session id.
   hashmap<ContainerID, pid_t> pids;
+
+  // Used to fork the children if the slave runs with
+  // --launcher_zygote.
+  Option<process::Owned<Zygote> > zygote;
 };
 
 } // namespace slave {
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <process/collect.hpp>
+#include <process/reap.hpp>
 
 #include <stout/abort.hpp>
 #include <stout/hashset.hpp>
@@ -55,10 +56,12 @@ using state::RunState;
 LinuxLauncher::LinuxLauncher(
     const Flags& _flags,
     int _namespaces,
-    const string& _hierarchy)
+    const string& _hierarchy,
+    const Option<Owned<Zygote> >& _zygote)
   : flags(_flags),
     namespaces(_namespaces),
-    hierarchy(_hierarchy) {}
+    hierarchy(_hierarchy),
+    zygote(_zygote) {}
 
 
 // An old glibc might not have this symbol.
@@ -114,7 +117,20 @@ Try<Launcher*> LinuxLauncher::create(const Flags& flags)
     namespaces |= CLONE_NEWNS;
   }
 
-  return new LinuxLauncher(flags, namespaces, hierarchy.get());
+  Option<Owned<Zygote> > zygote;
+
+  if (flags.launcher_zygote) {
+    Try<Zygote*> create =
+      Zygote::create(path::join(flags.launcher_dir, "mesos-containerizer"));
+
+    if (create.isError()) {
+      return Error("Failed to create Linux launcher: " + create.error());
+    }
+
+    zygote = Owned<Zygote>(create.get());
+  }
+
+  return new LinuxLauncher(flags, namespaces, hierarchy.get(), zygote);
 }
 
 
@@ -275,6 +291,7 @@ Try<pid_t> LinuxLauncher::fork(
     const process::Subprocess::IO& err,
     const Option<flags::FlagsBase>& flags,
     const Option<map<string, string> >& environment,
+    const vector<int>& inherit,
     const Option<lambda::function<int()> >& setup)
 {
   // Create a freezer cgroup for this container if necessary.
@@ -300,19 +317,58 @@ Try<pid_t> LinuxLauncher::fork(
   // use CHECK.
   CHECK_EQ(0, ::pipe(pipes));
 
-  Try<Subprocess> child = subprocess(
-      path,
-      argv,
-      in,
-      out,
-      err,
-      flags,
-      environment,
-      lambda::bind(&childSetup, pipes, setup),
-      lambda::bind(&clone, lambda::_1, namespaces));
-
-  if (child.isError()) {
-    return Error("Failed to clone child process: " + child.error());
+  Option<pid_t> pid;
+
+  // The zygote can't run a 'setup' function on our behalf.
+  if (zygote.isSome() && setup.isNone()) {
+    // The child gets the read end of the pipe explicitly, neither end
+    // should be inherited.
+    os::cloexec(pipes[0]);
+    os::cloexec(pipes[1]);
+
+    Result<pid_t> child = zygote.get()->fork(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        inherit,
+        namespaces,
+        pipes[0]);
+
+    if (child.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Error("Failed to clone child process: " + child.error());
+    }
+
+    // The child is cloned below if the zygote is no longer running.
+    if (child.isSome()) {
+      pid = child.get();
+    }
+  }
+
+  if (pid.isNone()) {
+    Try<Subprocess> child = subprocess(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        lambda::bind(&childSetup, pipes, setup),
+        lambda::bind(&clone, lambda::_1, namespaces));
+
+    if (child.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Error("Failed to clone child process: " + child.error());
+    }
+
+    pid = child.get().pid();
   }
 
   // Parent.
@@ -325,14 +381,14 @@ Try<pid_t> LinuxLauncher::fork(
   Try<Nothing> assign = cgroups::assign(
       hierarchy,
       cgroup(containerId),
-      child.get().pid());
+      pid.get());
 
   if (assign.isError()) {
-    LOG(ERROR) << "Failed to assign process " << child.get().pid()
+    LOG(ERROR) << "Failed to assign process " << pid.get()
                 << " of container '" << containerId << "'"
                 << " to its freezer cgroup: " << assign.error();
 
-    ::kill(child.get().pid(), SIGKILL);
+    ::kill(pid.get(), SIGKILL);
     return Error("Failed to contain process");
   }
 
@@ -347,15 +403,25 @@ Try<pid_t> LinuxLauncher::fork(
 
   if (length != sizeof(dummy)) {
     // Ensure the child is killed.
-    ::kill(child.get().pid(), SIGKILL);
+    ::kill(pid.get(), SIGKILL);
     return Error("Failed to synchronize child process");
   }
 
   if (!pids.contains(containerId)) {
-    pids.put(containerId, child.get().pid());
+    pids.put(containerId, pid.get());
+  }
+
+  return pid.get();
+}
+
+
+Future<Option<int> > LinuxLauncher::status(pid_t pid)
+{
+  if (zygote.isSome()) {
+    return zygote.get()->status(pid);
   }
 
-  return child.get().pid();
+  return process::reap(pid);
 }
 
 
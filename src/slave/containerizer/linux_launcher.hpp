@@ -45,21 +45,29 @@ public:
       const process::Subprocess::IO& err,
       const Option<flags::FlagsBase>& flags,
       const Option<std::map<std::string, std::string> >& environment,
+      const std::vector<int>& inherit,
       const Option<lambda::function<int()> >& setup);
 
+  virtual process::Future<Option<int> > status(pid_t pid);
+
   virtual process::Future<Nothing> destroy(const ContainerID& containerId);
 
 private:
   LinuxLauncher(
       const Flags& flags,
       int namespaces,
-      const std::string& hierarchy);
+      const std::string& hierarchy,
+      const Option<process::Owned<Zygote> >& zygote);
 
   static const std::string subsystem;
   const Flags flags;
   const int namespaces;
   const std::string hierarchy;
 
+  // Used to clone the children if the slave runs with
+  // --launcher_zygote.
+  Option<process::Owned<Zygote> > zygote;
+
   std::string cgroup(const ContainerID& containerId);
 
   // The 'pid' is the process id of the child process and also the
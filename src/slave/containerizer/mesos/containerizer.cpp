@@ -624,6 +624,11 @@ Future<bool> MesosContainerizerProcess::_launch(
   argv[0] = "mesos-containerizer";
   argv[1] = MesosContainerizerLaunch::NAME;
 
+  // The launch helper synchronizes with us through the pipe.
+  vector<int> inherit;
+  inherit.push_back(pipes[0]);
+  inherit.push_back(pipes[1]);
+
   Try<pid_t> forked = launcher->fork(
       containerId,
       path::join(flags.launcher_dir, "mesos-containerizer"),
@@ -635,6 +640,7 @@ Future<bool> MesosContainerizerProcess::_launch(
              : Subprocess::PATH(path::join(directory, "stderr"))),
       launchFlags,
       env,
+      inherit,
       None());
 
   if (forked.isError()) {
@@ -667,7 +673,7 @@ Future<bool> MesosContainerizerProcess::_launch(
 
   // Monitor the executor's pid. We keep the future because we'll
   // refer to it again during container destroy.
-  Future<Option<int>> status = process::reap(pid);
+  Future<Option<int>> status = launcher->status(pid);
   status.onAny(defer(self(), &Self::reaped, containerId));
   containers_[containerId]->status = status;
 
@@ -20,6 +20,7 @@
 #include <stout/subcommand.hpp>
 
 #include "slave/containerizer/mesos/launch.hpp"
+#include "slave/containerizer/mesos/zygote.hpp"
 
 using namespace mesos::slave;
 
@@ -30,5 +31,6 @@ int main(int argc, char** argv)
       None(),
       argc,
       argv,
-      new MesosContainerizerLaunch());
+      new MesosContainerizerLaunch(),
+      new MesosContainerizerZygote());
 }
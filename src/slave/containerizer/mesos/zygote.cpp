@@ -0,0 +1,1159 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp>
+#include <process/reap.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/unreachable.hpp>
+
+#include <stout/os/execenv.hpp>
+
+#include "common/lock.hpp"
+
+#include "slave/containerizer/mesos/zygote.hpp"
+
+using namespace process;
+
+// Not defined on OS X, where we set SO_NOSIGPIPE on the sockets
+// instead (see Zygote::create()).
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using std::cerr;
+using std::endl;
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace slave {
+
+const string MesosContainerizerZygote::NAME = "zygote";
+
+
+MesosContainerizerZygote::Flags::Flags()
+{
+  add(&control,
+      "control",
+      "The socket to read fork requests from.");
+
+  add(&status,
+      "status",
+      "The socket to write the exit status of the children to.");
+}
+
+
+// How long Zygote::fork() waits for the helper to reply before it
+// gives up on the helper.
+const Duration FORK_TIMEOUT = Seconds(5);
+
+
+namespace internal {
+
+// The most file descriptors we pass along with a single message
+// (SCM_MAX_FD on Linux).
+const size_t MAX_FDS = 253;
+
+
+// Sends the message, prefixed with its length, over the (stream)
+// socket along with the specified file descriptors. Writing to a
+// socket whose peer has gone away fails with EPIPE rather than
+// raising SIGPIPE (see also Zygote::create()).
+static Try<Nothing> send(int s, const string& message, const vector<int>& fds)
+{
+  if (fds.size() > MAX_FDS) {
+    return Error("Too many file descriptors: " + stringify(fds.size()));
+  }
+
+  const uint32_t length = message.size();
+  const string data =
+    string((const char*) &length, sizeof(length)) + message;
+
+  struct iovec iov;
+  iov.iov_base = (void*) data.data();
+  iov.iov_len = data.size();
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  // The file descriptors are sent as ancillary data of the first
+  // byte(s) of the message.
+  vector<char> control;
+  if (!fds.empty()) {
+    control.resize(CMSG_SPACE(sizeof(int) * fds.size()));
+    msg.msg_control = &control[0];
+    msg.msg_controllen = control.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), &fds[0], sizeof(int) * fds.size());
+  }
+
+  ssize_t length_ = -1;
+  while ((length_ = ::sendmsg(s, &msg, MSG_NOSIGNAL)) == -1 &&
+         errno == EINTR);
+
+  if (length_ == -1) {
+    return ErrnoError("Failed to send message");
+  }
+
+  size_t offset = length_;
+  while (offset < data.size()) {
+    ssize_t length =
+      ::send(s, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+    if (length == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ErrnoError("Failed to send message");
+    }
+    offset += length;
+  }
+
+  return Nothing();
+}
+
+
+// Waits until a message can be received from the socket. Returns
+// false if none arrived before the timeout.
+static Try<bool> poll(int s, const Duration& timeout)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  while (true) {
+    struct pollfd fd;
+    fd.fd = s;
+    fd.events = POLLIN;
+    fd.revents = 0;
+
+    const Duration remaining =
+      std::max(Duration::zero(), timeout - stopwatch.elapsed());
+
+    int result = ::poll(&fd, 1, remaining.ms());
+    if (result == -1 && errno == EINTR) {
+      continue;
+    } else if (result == -1) {
+      return ErrnoError("Failed to poll");
+    }
+
+    return result > 0;
+  }
+}
+
+
+// Receives a message sent by send() from the (blocking) socket and
+// stores any file descriptors received along with it (marked
+// close-on-exec) in 'fds'. Returns None if the socket was closed.
+static Result<string> receive(int s, vector<int>* fds)
+{
+  uint32_t length = 0;
+
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  vector<char> control(CMSG_SPACE(sizeof(int) * MAX_FDS));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = &control[0];
+  msg.msg_controllen = control.size();
+
+  ssize_t length_ = -1;
+  while ((length_ = ::recvmsg(s, &msg, 0)) == -1 && errno == EINTR);
+
+  if (length_ == -1) {
+    return ErrnoError("Failed to receive message");
+  } else if (length_ == 0) {
+    return None();
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+       cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const int* data = (const int*) CMSG_DATA(cmsg);
+      for (size_t i = 0; i < count; i++) {
+        os::cloexec(data[i]);
+        fds->push_back(data[i]);
+      }
+    }
+  }
+
+  if (msg.msg_flags & MSG_CTRUNC) {
+    return Error("Too many file descriptors received");
+  }
+
+  // Read the remainder of the length (if any) and the message.
+  if (length_ < (ssize_t) sizeof(length)) {
+    Result<string> remainder = os::read(s, sizeof(length) - length_);
+    if (!remainder.isSome()) {
+      return Error("Failed to receive message: " +
+                   (remainder.isError() ? remainder.error() : "EOF"));
+    }
+    memcpy((char*) &length + length_, remainder.get().data(),
+           remainder.get().size());
+  }
+
+  if (length == 0) {
+    return string();
+  }
+
+  Result<string> message = os::read(s, length);
+  if (!message.isSome() || message.get().size() != length) {
+    return Error("Failed to receive message: " +
+                 (message.isError() ? message.error() : "EOF"));
+  }
+
+  return message.get();
+}
+
+
+// Describes how the I/O of the child is redirected: to one of the
+// received file descriptors or to a file.
+static JSON::Object encode(const Subprocess::IO& io, vector<int>* fds)
+{
+  JSON::Object object;
+
+  if (io.isFd()) {
+    object.values["fd"] = fds->size();
+    fds->push_back(io.descriptor().get());
+  } else {
+    CHECK(io.isPath());
+    object.values["path"] = io.file().get();
+  }
+
+  return object;
+}
+
+
+// A fork request as decoded by the helper.
+struct Request
+{
+  string path;
+  vector<string> argv;
+  vector<string> environment;
+  int namespaces;
+
+  // Where to redirect stdin, stdout and stderr: a file descriptor
+  // or the path of the file to open.
+  int stdio[3];
+  Option<string> paths[3];
+
+  Option<int> sync;
+
+  // File descriptors the child inherits: (descriptor, number).
+  vector<pair<int, int> > inherit;
+
+  // The NULL terminated 'argv' and 'environment' passed to exec,
+  // constructed right before the fork.
+  vector<char*> _argv;
+  vector<char*> _environment;
+};
+
+
+static Try<Nothing> decode(
+    const JSON::Object& object,
+    int index,
+    const vector<int>& fds,
+    Request* request)
+{
+  const string names[] = {"stdin", "stdout", "stderr"};
+
+  Result<JSON::Number> fd =
+    object.find<JSON::Number>(names[index] + ".fd");
+  Result<JSON::String> path =
+    object.find<JSON::String>(names[index] + ".path");
+
+  request->stdio[index] = -1;
+
+  if (fd.isSome()) {
+    if (fd.get().value < 0 || fd.get().value >= fds.size()) {
+      return Error("Invalid file descriptor for " + names[index]);
+    }
+    request->stdio[index] = fds[(size_t) fd.get().value];
+  } else if (path.isSome()) {
+    request->paths[index] = path.get().value;
+  } else {
+    return Error("Missing " + names[index]);
+  }
+
+  return Nothing();
+}
+
+
+static Try<Request> decode(const string& message, const vector<int>& fds)
+{
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(message);
+  if (object.isError()) {
+    return Error("Failed to parse request: " + object.error());
+  }
+
+  Request request;
+
+  Result<JSON::String> path = object.get().find<JSON::String>("path");
+  if (!path.isSome()) {
+    return Error("Missing path");
+  }
+  request.path = path.get().value;
+
+  Result<JSON::Array> argv = object.get().find<JSON::Array>("argv");
+  if (!argv.isSome()) {
+    return Error("Missing argv");
+  }
+
+  foreach (const JSON::Value& value, argv.get().values) {
+    if (!value.is<JSON::String>()) {
+      return Error("Invalid argv");
+    }
+    request.argv.push_back(value.as<JSON::String>().value);
+  }
+
+  Result<JSON::Array> environment =
+    object.get().find<JSON::Array>("environment");
+  if (!environment.isSome()) {
+    return Error("Missing environment");
+  }
+
+  foreach (const JSON::Value& value, environment.get().values) {
+    if (!value.is<JSON::String>()) {
+      return Error("Invalid environment");
+    }
+    request.environment.push_back(value.as<JSON::String>().value);
+  }
+
+  Result<JSON::Number> namespaces =
+    object.get().find<JSON::Number>("namespaces");
+  request.namespaces = namespaces.isSome() ? namespaces.get().value : 0;
+
+  for (int index = 0; index < 3; index++) {
+    Try<Nothing> decoded = decode(object.get(), index, fds, &request);
+    if (decoded.isError()) {
+      return Error(decoded.error());
+    }
+  }
+
+  Result<JSON::Number> sync = object.get().find<JSON::Number>("sync");
+  if (sync.isSome()) {
+    if (sync.get().value < 0 || sync.get().value >= fds.size()) {
+      return Error("Invalid sync file descriptor");
+    }
+    request.sync = fds[(size_t) sync.get().value];
+  }
+
+  Result<JSON::Array> inherit = object.get().find<JSON::Array>("inherit");
+  if (inherit.isSome()) {
+    foreach (const JSON::Value& value, inherit.get().values) {
+      if (!value.is<JSON::Object>()) {
+        return Error("Invalid inherited file descriptor");
+      }
+
+      Result<JSON::Number> fd =
+        value.as<JSON::Object>().find<JSON::Number>("fd");
+      Result<JSON::Number> number =
+        value.as<JSON::Object>().find<JSON::Number>("number");
+
+      if (!fd.isSome() ||
+          !number.isSome() ||
+          fd.get().value < 0 ||
+          fd.get().value >= fds.size() ||
+          number.get().value <= STDERR_FILENO) {
+        return Error("Invalid inherited file descriptor");
+      }
+
+      request.inherit.push_back(
+          std::make_pair(fds[(size_t) fd.get().value],
+                         (int) number.get().value));
+    }
+  }
+
+  return request;
+}
+
+
+// The main entry of the child forked by the helper.
+static int childMain(void* _request)
+{
+  const Request* request = static_cast<const Request*>(_request);
+
+  // Block until we've been told to continue (e.g., once the slave
+  // has moved us into a freezer cgroup).
+  if (request->sync.isSome()) {
+    char dummy;
+    ssize_t length;
+    while ((length = ::read(request->sync.get(), &dummy, sizeof(dummy))) ==
+           -1 && errno == EINTR);
+
+    if (length != sizeof(dummy)) {
+      ABORT("Failed to synchronize with the slave");
+    }
+
+    while (::close(request->sync.get()) == -1 && errno == EINTR);
+  }
+
+  // Move to a different session (and new process group) so we're
+  // independent from the slave's session.
+  if (::setsid() == -1) {
+    perror("Failed to put child in a new session");
+    return 1;
+  }
+
+  // The file descriptors to install: (source, target).
+  vector<pair<int, int> > installs;
+
+  for (int index = 0; index < 3; index++) {
+    int fd = request->stdio[index];
+
+    if (request->paths[index].isSome()) {
+      const char* path = request->paths[index].get().c_str();
+
+      if (index == STDIN_FILENO) {
+        fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      } else {
+        fd = ::open(
+            path,
+            O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+      }
+
+      if (fd == -1) {
+        perror("Failed to open file for I/O redirection");
+        return 1;
+      }
+    }
+
+    installs.push_back(std::make_pair(fd, index));
+  }
+
+  installs.insert(
+      installs.end(), request->inherit.begin(), request->inherit.end());
+
+  // First move every source above any of the sources and targets so
+  // that installing one file descriptor can't clobber the source of
+  // another one.
+  int minimum = 0;
+  for (size_t i = 0; i < installs.size(); i++) {
+    minimum = std::max(
+        minimum, std::max(installs[i].first, installs[i].second) + 1);
+  }
+
+  for (size_t i = 0; i < installs.size(); i++) {
+    int fd = ::fcntl(installs[i].first, F_DUPFD, minimum);
+    if (fd == -1 || ::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+      perror("Failed to duplicate file descriptor");
+      return 1;
+    }
+    installs[i].first = fd;
+  }
+
+  // Now install them. Note that dup2 clears close-on-exec for the
+  // targets while the (duplicated) sources will be closed on exec.
+  for (size_t i = 0; i < installs.size(); i++) {
+    int result;
+    while ((result = ::dup2(installs[i].first, installs[i].second)) == -1 &&
+           errno == EINTR);
+
+    if (result == -1) {
+      perror("Failed to install file descriptor");
+      return 1;
+    }
+  }
+
+  os::execvpe(
+      request->path.c_str(),
+      (char**) &request->_argv[0],
+      (char**) &request->_environment[0]);
+
+  ABORT("Failed to os::execvpe '" + request->path + "'");
+}
+
+
+#ifdef __linux__
+static pid_t clone(Request* request)
+{
+  // Stack for the child. This is static which is okay because each
+  // child gets its own copy after the clone.
+  static unsigned long long stack[(8*1024*1024)/sizeof(unsigned long long)];
+
+  return ::clone(
+      childMain,
+      &stack[sizeof(stack)/sizeof(stack[0]) - 1],  // stack grows down.
+      request->namespaces | SIGCHLD,
+      (void*) request);
+}
+#endif // __linux__
+
+
+static Try<pid_t> fork(Request* request)
+{
+  request->_argv.clear();
+  foreach (const string& arg, request->argv) {
+    request->_argv.push_back((char*) arg.c_str());
+  }
+  request->_argv.push_back(NULL);
+
+  request->_environment.clear();
+  foreach (const string& variable, request->environment) {
+    request->_environment.push_back((char*) variable.c_str());
+  }
+  request->_environment.push_back(NULL);
+
+  pid_t pid = -1;
+
+  if (request->namespaces != 0) {
+#ifdef __linux__
+    pid = clone(request);
+#else
+    return Error("Namespaces are only supported on Linux");
+#endif // __linux__
+  } else {
+    pid = ::fork();
+
+    if (pid == 0) {
+      ::_exit(childMain(request));
+    }
+  }
+
+  if (pid == -1) {
+    return ErrnoError("Failed to fork");
+  }
+
+  return pid;
+}
+
+
+// Write end of the pipe the SIGCHLD handler of the helper writes to.
+static int sigchld = -1;
+
+
+static void handler(int signal)
+{
+  int saved = errno;
+
+  char dummy = 0;
+  while (::write(sigchld, &dummy, sizeof(dummy)) == -1 && errno == EINTR);
+
+  errno = saved;
+}
+
+
+// Reaps any terminated children of the helper and reports their
+// exit status to the slave.
+static void reap(int s)
+{
+  pid_t pid;
+  int status;
+
+  while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+    JSON::Object object;
+    object.values["pid"] = pid;
+    object.values["status"] = status;
+
+    // The slave may have gone away, nothing we can do about that.
+    send(s, stringify(object), vector<int>());
+  }
+}
+
+} // namespace internal {
+
+
+int MesosContainerizerZygote::execute()
+{
+  if (flags.control.isNone()) {
+    cerr << "Flag --control is not specified" << endl;
+    return 1;
+  }
+
+  if (flags.status.isNone()) {
+    cerr << "Flag --status is not specified" << endl;
+    return 1;
+  }
+
+  const int control = flags.control.get();
+  const int status = flags.status.get();
+
+  // None of our file descriptors should leak into the children.
+  os::cloexec(control);
+  os::cloexec(status);
+
+  int pipes[2];
+  if (::pipe(pipes) == -1) {
+    perror("Failed to create pipe");
+    return 1;
+  }
+
+  os::cloexec(pipes[0]);
+  os::cloexec(pipes[1]);
+  os::nonblock(pipes[0]);
+  os::nonblock(pipes[1]);
+
+  internal::sigchld = pipes[1];
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = internal::handler;
+  action.sa_flags = SA_NOCLDSTOP | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  if (::sigaction(SIGCHLD, &action, NULL) == -1) {
+    perror("Failed to install SIGCHLD handler");
+    return 1;
+  }
+
+  while (true) {
+    struct pollfd fds[2];
+    fds[0].fd = control;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = pipes[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    if (::poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("Failed to poll");
+      return 1;
+    }
+
+    if (fds[1].revents != 0) {
+      char buffer[64];
+      while (::read(pipes[0], buffer, sizeof(buffer)) > 0);
+
+      internal::reap(status);
+    }
+
+    if (fds[0].revents == 0) {
+      continue;
+    }
+
+    vector<int> received;
+    Result<string> message = internal::receive(control, &received);
+
+    if (message.isError()) {
+      cerr << message.error() << endl;
+      return 1;
+    } else if (message.isNone()) {
+      // The slave has closed the control socket; leave any children
+      // running (they get reparented to init).
+      return 0;
+    }
+
+    JSON::Object reply;
+
+    Try<internal::Request> decode =
+      internal::decode(message.get(), received);
+
+    if (decode.isError()) {
+      reply.values["error"] = decode.error();
+    } else {
+      internal::Request request = decode.get();
+
+      Try<pid_t> pid = internal::fork(&request);
+
+      if (pid.isError()) {
+        reply.values["error"] = pid.error();
+      } else {
+        reply.values["pid"] = pid.get();
+      }
+    }
+
+    // Our copies of the file descriptors are no longer needed.
+    foreach (int fd, received) {
+      os::close(fd);
+    }
+
+    Try<Nothing> send =
+      internal::send(control, stringify(reply), vector<int>());
+
+    if (send.isError()) {
+      cerr << send.error() << endl;
+
+      // The slave won't learn about the child (e.g., because it gave
+      // up waiting for us), so don't leave it running.
+      Result<JSON::Number> pid = reply.find<JSON::Number>("pid");
+      if (pid.isSome()) {
+        ::kill((pid_t) pid.get().value, SIGKILL);
+      }
+
+      return 1;
+    }
+  }
+
+  UNREACHABLE();
+}
+
+
+class ZygoteProcess : public Process<ZygoteProcess>
+{
+public:
+  explicit ZygoteProcess(int _socket)
+    : ProcessBase(ID::generate("zygote")),
+      socket(_socket),
+      terminated(false) {}
+
+  virtual ~ZygoteProcess()
+  {
+    os::close(socket);
+  }
+
+  // Invoked after the helper forked the child with the given pid.
+  void forked(pid_t pid)
+  {
+    if (terminated) {
+      return;
+    }
+
+    if (!promises.contains(pid)) {
+      promises[pid] = Owned<Promise<Option<int> > >(
+          new Promise<Option<int> >());
+    }
+
+    // The exit status may have been reported before we learned
+    // about the child.
+    if (statuses.contains(pid)) {
+      promises[pid]->set(Option<int>(statuses[pid]));
+      statuses.erase(pid);
+    }
+  }
+
+  Future<Option<int> > status(pid_t pid)
+  {
+    if (promises.contains(pid)) {
+      Future<Option<int> > future = promises[pid]->future();
+
+      // Don't hold on to the children which have already exited.
+      if (!future.isPending()) {
+        promises.erase(pid);
+      }
+
+      return future;
+    }
+
+    return process::reap(pid);
+  }
+
+protected:
+  virtual void initialize()
+  {
+    os::nonblock(socket);
+
+    read();
+  }
+
+private:
+  void read()
+  {
+    io::poll(socket, io::READ)
+      .onAny(defer(self(), &Self::_read));
+  }
+
+  void _read()
+  {
+    char buffer[4096];
+
+    while (true) {
+      ssize_t length = ::read(socket, buffer, sizeof(buffer));
+
+      if (length == -1 && errno == EINTR) {
+        continue;
+      } else if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else if (length <= 0) {
+        LOG(WARNING) << "Zygote terminated: "
+                     << (length == 0 ? "EOF" : strerror(errno));
+        died();
+        return;
+      }
+
+      data.append(buffer, length);
+    }
+
+    // Process all the complete messages.
+    while (data.size() >= sizeof(uint32_t)) {
+      uint32_t length;
+      memcpy(&length, data.data(), sizeof(length));
+
+      if (data.size() < sizeof(length) + length) {
+        break;
+      }
+
+      const string message = data.substr(sizeof(length), length);
+      data.erase(0, sizeof(length) + length);
+
+      Try<JSON::Object> object = JSON::parse<JSON::Object>(message);
+      if (object.isError()) {
+        LOG(ERROR) << "Failed to parse message from zygote: "
+                   << object.error();
+        continue;
+      }
+
+      Result<JSON::Number> pid = object.get().find<JSON::Number>("pid");
+      Result<JSON::Number> status =
+        object.get().find<JSON::Number>("status");
+
+      if (!pid.isSome() || !status.isSome()) {
+        LOG(ERROR) << "Invalid message from zygote: " << message;
+        continue;
+      }
+
+      exited(pid.get().value, status.get().value);
+    }
+
+    read();
+  }
+
+  void exited(pid_t pid, int status)
+  {
+    if (promises.contains(pid)) {
+      promises[pid]->set(Option<int>(status));
+      promises.erase(pid);
+    } else {
+      statuses[pid] = status;
+    }
+  }
+
+  // Once the helper has terminated we can no longer learn the exit
+  // status of its children, so we wait for them like for any other
+  // process that is not our child.
+  void died()
+  {
+    terminated = true;
+
+    foreachpair (pid_t pid,
+                 const Owned<Promise<Option<int> > >& promise,
+                 promises) {
+      if (promise->future().isPending()) {
+        promise->associate(process::reap(pid));
+      }
+    }
+  }
+
+  const int socket;
+  bool terminated;
+
+  // Buffered data read from the socket.
+  string data;
+
+  hashmap<pid_t, Owned<Promise<Option<int> > > > promises;
+
+  // Exit statuses of children we haven't learned about yet.
+  hashmap<pid_t, int> statuses;
+};
+
+
+Try<Zygote*> Zygote::create(const string& path)
+{
+  int control[2];
+  int status[2];
+
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, control) == -1) {
+    return ErrnoError("Failed to create control socket");
+  }
+
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, status) == -1) {
+    ErrnoError error("Failed to create status socket");
+    os::close(control[0]);
+    os::close(control[1]);
+    return error;
+  }
+
+  // Only the helper gets to keep its ends of the sockets.
+  os::cloexec(control[0]);
+  os::cloexec(status[0]);
+
+#ifdef SO_NOSIGPIPE
+  // Platforms without MSG_NOSIGNAL (e.g., OS X) need to be told on
+  // the socket not to raise SIGPIPE, see internal::send().
+  int sockets[] = {control[0], control[1], status[0], status[1]};
+  foreach (int fd, sockets) {
+    int enable = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+  }
+#endif // SO_NOSIGPIPE
+
+  MesosContainerizerZygote::Flags flags;
+  flags.control = control[1];
+  flags.status = status[1];
+
+  vector<string> argv(2);
+  argv[0] = "mesos-containerizer";
+  argv[1] = MesosContainerizerZygote::NAME;
+
+  Try<Subprocess> helper = subprocess(
+      path,
+      argv,
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      flags);
+
+  os::close(control[1]);
+  os::close(status[1]);
+
+  if (helper.isError()) {
+    os::close(control[0]);
+    os::close(status[0]);
+    return Error("Failed to launch zygote: " + helper.error());
+  }
+
+  LOG(INFO) << "Started zygote with pid " << helper.get().pid();
+
+  return new Zygote(
+      helper.get(),
+      control[0],
+      Owned<ZygoteProcess>(new ZygoteProcess(status[0])));
+}
+
+
+Zygote::Zygote(
+    const Subprocess& _helper,
+    int _control,
+    const Owned<ZygoteProcess>& _process)
+  : helper(_helper),
+    control(_control),
+    running(true),
+    process(_process)
+{
+  pthread_mutex_init(&mutex, NULL);
+
+  spawn(process.get());
+}
+
+
+Zygote::~Zygote()
+{
+  // Closing the control socket makes the helper exit.
+  os::close(control);
+
+  terminate(process.get());
+  wait(process.get());
+
+  pthread_mutex_destroy(&mutex);
+}
+
+
+Result<pid_t> Zygote::fork(
+    const string& path,
+    const vector<string>& _argv,
+    const Subprocess::IO& in,
+    const Subprocess::IO& out,
+    const Subprocess::IO& err,
+    const Option<flags::FlagsBase>& flags,
+    const Option<map<string, string> >& environment,
+    const vector<int>& _inherit,
+    int namespaces,
+    const Option<int>& sync)
+{
+  if (in.isPipe() || out.isPipe() || err.isPipe()) {
+    return Error("Redirecting I/O to a pipe is not supported");
+  }
+
+  JSON::Object request;
+  vector<int> fds;
+
+  request.values["path"] = path;
+
+  // Prepare the arguments the same way as subprocess() does.
+  JSON::Array argv;
+  foreach (const string& arg, _argv) {
+    argv.values.push_back(arg);
+  }
+
+  if (flags.isSome()) {
+    foreachpair (const string& name, const flags::Flag& flag, flags.get()) {
+      Option<string> value = flag.stringify(flags.get());
+      if (value.isSome()) {
+        argv.values.push_back("--" + name + "=" + value.get());
+      }
+    }
+  }
+
+  request.values["argv"] = argv;
+
+  // Send the complete environment (the specified environment merged
+  // into ours, see os::ExecEnv) since that of the helper is only a
+  // snapshot of ours from when it was started.
+  hashmap<string, string> _environment = os::environment();
+  if (environment.isSome()) {
+    foreachpair (const string& key, const string& value, environment.get()) {
+      _environment[key] = value;
+    }
+  }
+
+  JSON::Array variables;
+  foreachpair (const string& key, const string& value, _environment) {
+    variables.values.push_back(key + "=" + value);
+  }
+
+  request.values["environment"] = variables;
+  request.values["namespaces"] = namespaces;
+
+  request.values["stdin"] = internal::encode(in, &fds);
+  request.values["stdout"] = internal::encode(out, &fds);
+  request.values["stderr"] = internal::encode(err, &fds);
+
+  if (sync.isSome()) {
+    request.values["sync"] = fds.size();
+    fds.push_back(sync.get());
+  }
+
+  JSON::Array inherit;
+  foreach (int fd, _inherit) {
+    if (fd <= STDERR_FILENO) {
+      return Error("Invalid file descriptor to inherit: " + stringify(fd));
+    }
+
+    JSON::Object object;
+    object.values["fd"] = fds.size();
+    object.values["number"] = fd;
+    inherit.values.push_back(object);
+
+    fds.push_back(fd);
+  }
+
+  request.values["inherit"] = inherit;
+
+  Lock lock(&mutex);
+
+  // Let the caller fork the child itself if the helper is gone.
+  if (!running || !helper.status().isPending()) {
+    return None();
+  }
+
+  Try<Nothing> send = internal::send(control, stringify(request), fds);
+  if (send.isError()) {
+    // The helper has not (completely) received the request, so it
+    // won't have forked the child.
+    LOG(ERROR) << "Failed to send request to zygote: " << send.error();
+    stop();
+    return None();
+  }
+
+  // Don't wait forever for a helper that is stuck, this blocks the
+  // caller (and any other fork) in the meantime.
+  Try<bool> ready = internal::poll(control, FORK_TIMEOUT);
+  if (ready.isError() || !ready.get()) {
+    stop();
+    return Error("Failed to receive reply from zygote: " +
+                 (ready.isError()
+                  ? ready.error()
+                  : "Timed out after " + stringify(FORK_TIMEOUT)));
+  }
+
+  vector<int> received;
+  Result<string> message = internal::receive(control, &received);
+
+  foreach (int fd, received) {
+    os::close(fd);
+  }
+
+  if (!message.isSome()) {
+    stop();
+    return Error("Failed to receive reply from zygote: " +
+                 (message.isError() ? message.error() : "EOF"));
+  }
+
+  Try<JSON::Object> reply = JSON::parse<JSON::Object>(message.get());
+  if (reply.isError()) {
+    return Error("Failed to parse reply from zygote: " + reply.error());
+  }
+
+  Result<JSON::String> error = reply.get().find<JSON::String>("error");
+  if (error.isSome()) {
+    return Error(error.get().value);
+  }
+
+  Result<JSON::Number> pid = reply.get().find<JSON::Number>("pid");
+  if (!pid.isSome()) {
+    return Error("Invalid reply from zygote: " + message.get());
+  }
+
+  dispatch(process.get(), &ZygoteProcess::forked, (pid_t) pid.get().value);
+
+  return (pid_t) pid.get().value;
+}
+
+
+void Zygote::stop()
+{
+  LOG(WARNING) << "Stopped forking children from the zygote, "
+               << "they will be forked by the slave instead";
+
+  running = false;
+
+  // The requests and replies on the control socket may be out of
+  // sync now. Shutting it down makes the helper exit once it gets
+  // to it (see MesosContainerizerZygote::execute()), while we keep
+  // the socket open until we're destructed.
+  ::shutdown(control, SHUT_RDWR);
+}
+
+
+Future<Option<int> > Zygote::status(pid_t pid)
+{
+  return dispatch(process.get(), &ZygoteProcess::status, pid);
+}
+
+} // namespace slave {
+} // namespace mesos {
@@ -0,0 +1,147 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MESOS_CONTAINERIZER_ZYGOTE_HPP__
+#define __MESOS_CONTAINERIZER_ZYGOTE_HPP__
+
+#include <pthread.h>
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/flags.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+#include <stout/result.hpp>
+#include <stout/subcommand.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace slave {
+
+// The helper process started by Zygote::create(). It forks (or
+// clones) and execs the processes requested on the control socket
+// and reports the exit status of each of them on the status socket.
+// The helper exits once the slave closes the control socket, leaving
+// the processes it forked running.
+class MesosContainerizerZygote : public Subcommand
+{
+public:
+  static const std::string NAME;
+
+  struct Flags : public flags::FlagsBase
+  {
+    Flags();
+
+    Option<int> control;
+    Option<int> status;
+  };
+
+  MesosContainerizerZygote() : Subcommand(NAME) {}
+
+  Flags flags;
+
+protected:
+  virtual int execute();
+  virtual flags::FlagsBase* getFlags() { return &flags; }
+};
+
+
+// Forward declaration.
+class ZygoteProcess;
+
+
+// Forks processes on behalf of the slave from a small helper process
+// ('mesos-containerizer zygote') started when the slave boots. Forking
+// from the helper rather than the slave keeps copying the (possibly
+// multi-gigabyte) address space of the slave off the critical path
+// of launching an executor.
+class Zygote
+{
+public:
+  // Starts the helper using the 'mesos-containerizer' binary at the
+  // given path.
+  static Try<Zygote*> create(const std::string& path);
+
+  ~Zygote();
+
+  // Like process::subprocess(), except that the child is forked by
+  // the helper, PIPE is not supported for I/O redirection and there
+  // is no 'setup' function. Besides stdin, stdout and stderr, the
+  // child only inherits the file descriptors in 'inherit' (under the
+  // same numbers). The child is cloned into the given 'namespaces'
+  // (Linux only), waits until it can read a byte from 'sync' (if
+  // specified) and then puts itself in a new session before exec'ing
+  // 'path'. Returns None if the helper is no longer running (or
+  // stopped responding earlier), in which case the caller should
+  // fork the child itself.
+  Result<pid_t> fork(
+      const std::string& path,
+      const std::vector<std::string>& argv,
+      const process::Subprocess::IO& in,
+      const process::Subprocess::IO& out,
+      const process::Subprocess::IO& err,
+      const Option<flags::FlagsBase>& flags,
+      const Option<std::map<std::string, std::string> >& environment,
+      const std::vector<int>& inherit,
+      int namespaces = 0,
+      const Option<int>& sync = None());
+
+  // Returns the exit status of a child forked by the helper. For any
+  // other pid (or once the helper has terminated) this falls back to
+  // process::reap().
+  process::Future<Option<int> > status(pid_t pid);
+
+private:
+  Zygote(
+      const process::Subprocess& helper,
+      int control,
+      const process::Owned<ZygoteProcess>& process);
+
+  Zygote(const Zygote&);
+  Zygote& operator = (const Zygote&);
+
+  // Stops sending requests to the helper.
+  void stop();
+
+  const process::Subprocess helper;
+
+  // Socket used to send fork requests to the helper and read back
+  // the pid (or error) of each; 'mutex' serializes the requests.
+  const int control;
+  pthread_mutex_t mutex;
+
+  // Whether we still send requests to the helper (protected by
+  // 'mutex').
+  bool running;
+
+  // Reads the exit statuses from the status socket.
+  process::Owned<ZygoteProcess> process;
+};
+
+} // namespace slave {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_ZYGOTE_HPP__
@@ -93,6 +93,14 @@ public:
         "Directory path of Mesos binaries",
         PKGLIBEXECDIR);
 
+    add(&Flags::launcher_zygote,
+        "launcher_zygote",
+        "Whether the mesos containerizer forks executors from a small\n"
+        "helper process ('mesos-containerizer zygote') started when the\n"
+        "slave boots rather than from the slave itself, so launching an\n"
+        "executor does not pay for copying the address space of the slave.",
+        false);
+
     add(&Flags::hadoop_home,
         "hadoop_home",
         "Path to find Hadoop installed (for\n"
@@ -155,6 +163,20 @@ public:
         "be a value between 0.0 and 1.0",
         GC_DISK_HEADROOM);
 
+    add(&Flags::gc_workers,
+        "gc_workers",
+        "Number of executor directories that are garbage collected\n"
+        "in parallel. Directories that are due for garbage collection\n"
+        "(e.g., because of disk pressure) are removed oldest first.",
+        GC_WORKERS);
+
+    add(&Flags::gc_removal_rate,
+        "gc_removal_rate",
+        "Maximum number of executor directories garbage collected per\n"
+        "second (e.g., 0.5 for one directory every 2 seconds), to limit\n"
+        "the disk I/O spent on garbage collection. If not specified,\n"
+        "directories are removed as fast as the gc workers can.");
+
     add(&Flags::disk_watch_interval,
         "disk_watch_interval",
         "Periodic time interval (e.g., 10secs, 2mins, etc)\n"
@@ -251,7 +273,14 @@ public:
     add(&Flags::perf_duration,
         "perf_duration",
         "Duration of a perf stat sample. The duration must be less\n"
-        "that the perf_interval.",
+        "that the perf_interval. Not used if all the perf_events are\n"
+        "hardware or software events, which are counted directly for\n"
+        "the whole perf_interval rather than by running perf stat.\n"
+        "Counting directly keeps one file descriptor open in the slave\n"
+        "per event and online cpu for each container (e.g., 512 for 8\n"
+        "events on 64 cpus). The containers that would take the slave\n"
+        "over half of its file descriptor limit (RLIMIT_NOFILE) are\n"
+        "sampled with perf stat instead.",
         Seconds(10));
 #endif
 
@@ -297,6 +326,13 @@ public:
         "containerizer.\n",
         "docker");
 
+    add(&Flags::docker_socket,
+        "docker_socket",
+        "The UNIX socket of the docker daemon (e.g., /var/run/docker.sock).\n"
+        "If set, the docker containerizer talks to the daemon through the\n"
+        "Docker Remote API over this socket instead of invoking the docker\n"
+        "executable for every operation.\n");
+
     add(&Flags::docker_sandbox_directory,
         "docker_sandbox_directory",
         "The absolute path for the directory in the container where the\n"
@@ -386,6 +422,16 @@ public:
         "used for the 'posix/disk' isolator.",
         Seconds(15));
 
+    add(&Flags::container_disk_watch_incremental,
+        "container_disk_watch_incremental",
+        "Whether to track the disk usage of containers incrementally using\n"
+        "inotify rather than periodically running 'du' on one container at\n"
+        "a time. The usage of every container is then reported once per\n"
+        "--container_disk_watch_interval, regardless of the number of\n"
+        "containers. Only supported on Linux. This flag is used for the\n"
+        "'posix/disk' isolator.",
+        false);
+
     add(&Flags::enforce_container_disk_quota,
         "enforce_container_disk_quota",
         "Whether to enable disk quota enforcement for containers. This flag\n"
@@ -460,6 +506,7 @@ public:
   Option<std::string> attributes;
   std::string work_dir;
   std::string launcher_dir;
+  bool launcher_zygote;
   std::string hadoop_home; // TODO(benh): Make an Option.
   bool switch_user;
   std::string frameworks_home;  // TODO(benh): Make an Option.
@@ -468,6 +515,8 @@ public:
   Duration executor_shutdown_grace_period;
   Duration gc_delay;
   double gc_disk_headroom;
+  size_t gc_workers;
+  Option<double> gc_removal_rate;
   Duration disk_watch_interval;
   Duration resource_monitoring_interval;
   // TODO(cmaloney): Remove checkpoint variable entirely, fixing tests
@@ -492,6 +541,7 @@ public:
   std::string containerizers;
   Option<std::string> default_container_image;
   std::string docker;
+  Option<std::string> docker_socket;
   std::string docker_sandbox_directory;
   Duration docker_remove_delay;
   Option<ContainerInfo> default_container_info;
@@ -505,6 +555,7 @@ public:
   bool network_enable_socket_statistics_details;
 #endif
   Duration container_disk_watch_interval;
+  bool container_disk_watch_incremental;
   bool enforce_container_disk_quota;
   Option<Modules> modules;
   std::string authenticatee;
@@ -16,16 +16,28 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <fts.h>
+#include <string.h>
+#include <unistd.h>
+
 #include <list>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
+#include <process/id.hpp>
+
+#include <process/metrics/metrics.hpp>
 
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
 #include <stout/os.hpp>
 
 #include "logging/logging.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/gc.hpp"
 
 using namespace process;
@@ -39,12 +51,152 @@ using std::string;
 namespace mesos {
 namespace slave {
 
+// Returns the disk space that is reclaimed by removing the entry.
+// NOTE: The blocks of files with other (hard) links are not freed.
+static Bytes size(const FTSENT* node)
+{
+  if (node->fts_statp == NULL ||
+      (node->fts_info != FTS_DP && node->fts_statp->st_nlink > 1)) {
+    return Bytes(0);
+  }
+
+  // NOTE: 'st_blocks' is in units of 512 bytes, not 'st_blksize'.
+  return Bytes(node->fts_statp->st_blocks * 512);
+}
+
+
+GarbageCollectorWorkerProcess::GarbageCollectorWorkerProcess()
+  : ProcessBase(ID::generate("gc-worker")) {}
+
+
+Future<Bytes> GarbageCollectorWorkerProcess::remove(const string& path)
+{
+  char* paths[] = {const_cast<char*>(path.c_str()), NULL};
+
+  FTS* tree = fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return Failure(ErrnoError("Failed to open '" + path + "'").message);
+  }
+
+  Bytes reclaimed;
+  Option<Error> error;
+
+  errno = 0;
+  FTSENT* node;
+  while (error.isNone() && (node = fts_read(tree)) != NULL) {
+    switch (node->fts_info) {
+      case FTS_DP:
+        if (::rmdir(node->fts_path) < 0) {
+          if (errno != ENOENT) {
+            error = ErrnoError(
+                "Failed to remove '" + string(node->fts_path) + "'");
+          }
+        } else {
+          reclaimed += size(node);
+        }
+        break;
+      case FTS_F:
+      case FTS_SL:
+      case FTS_SLNONE:
+      case FTS_DEFAULT:
+        if (::unlink(node->fts_path) < 0) {
+          if (errno != ENOENT) {
+            error = ErrnoError(
+                "Failed to remove '" + string(node->fts_path) + "'");
+          }
+        } else {
+          reclaimed += size(node);
+        }
+        break;
+      case FTS_DNR:
+      case FTS_ERR:
+      case FTS_NS:
+        // Entries that disappeared underneath us are fine, unless
+        // it is the path itself.
+        if (node->fts_level > FTS_ROOTLEVEL &&
+            node->fts_errno == ENOENT) {
+          break;
+        }
+        error = Error(
+            "Failed to traverse '" + string(node->fts_path) + "': " +
+            strerror(node->fts_errno));
+        break;
+      default:
+        break;
+    }
+    errno = 0;
+  }
+
+  if (error.isNone() && errno != 0) {
+    error = ErrnoError("Failed to traverse '" + path + "'");
+  }
+
+  fts_close(tree);
+
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  return reclaimed;
+}
+
+
+GarbageCollectorProcess::GarbageCollectorProcess(
+    size_t workers,
+    const Option<double>& rate)
+  : count(workers),
+    acquiring(false),
+    metrics(*this)
+{
+  CHECK_GT(count, 0u);
+
+  if (rate.isSome()) {
+    limiter.reset(new RateLimiter(rate.get()));
+  }
+}
+
 
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  foreachvalue (const PathInfo& info, queue) {
+    info.promise->discard();
+  }
+
+  foreachvalue (const PathInfo& info, removing) {
+    info.promise->discard();
+  }
+}
+
+
+void GarbageCollectorProcess::initialize()
+{
+  for (size_t i = 0; i < count; i++) {
+    GarbageCollectorWorkerProcess* worker =
+      new GarbageCollectorWorkerProcess();
+
+    // The workers are deleted by libprocess once terminated.
+    spawn(worker, true);
+
+    workers.push_back(worker);
+    idle.push_back(worker);
+  }
+}
+
+
+void GarbageCollectorProcess::finalize()
+{
+  // NOTE: A worker that is removing a path finishes doing so before
+  // it terminates, but its result is dropped.
+  foreach (GarbageCollectorWorkerProcess* worker, workers) {
+    terminate(worker);
+  }
+
+  workers.clear();
+  idle.clear();
 }
 
 
@@ -57,7 +209,7 @@ Future<Nothing> GarbageCollectorProcess::schedule(
   // If there's an existing schedule for this path, we must remove
   // it here in order to reschedule.
   if (timeouts.contains(path)) {
-    CHECK(unschedule(path));
+    CHECK(discard(path));
   }
 
   Owned<Promise<Nothing> > promise(new Promise<Nothing>());
@@ -78,25 +230,55 @@ Future<Nothing> GarbageCollectorProcess::schedule(
 }
 
 
-bool GarbageCollectorProcess::unschedule(const string& path)
+static void unscheduled(const Owned<Promise<bool> >& promise)
+{
+  promise->set(false);
+}
+
+
+Future<bool> GarbageCollectorProcess::unschedule(const string& path)
 {
   LOG(INFO) << "Unscheduling '" << path << "' from gc";
 
+  // If the path is being removed we can not stop that, but we only
+  // return once it is done, so that the caller does not (re)create
+  // anything under the path while it is being removed.
+  if (removing.contains(path)) {
+    Owned<Promise<bool> > promise(new Promise<bool>());
+
+    removing.at(path).promise->future()
+      .onAny(lambda::bind(&unscheduled, promise));
+
+    return promise->future();
+  }
+
+  return discard(path);
+}
+
+
+bool GarbageCollectorProcess::discard(const string& path)
+{
   if (!timeouts.contains(path)) {
     return false;
   }
 
   Timeout timeout = timeouts[path]; // Make a copy, as we erase() below.
-  CHECK(paths.contains(timeout));
+
+  // The path is either still scheduled or due, but not yet handed to
+  // a worker.
+  Multimap<Timeout, PathInfo>& infos =
+    paths.contains(timeout) ? paths : queue;
+
+  CHECK(infos.contains(timeout));
 
   // Locate the path.
-  foreach (const PathInfo& info, paths.get(timeout)) {
+  foreach (const PathInfo& info, infos.get(timeout)) {
     if (info.path == path) {
       // Discard the promise.
       info.promise->discard();
 
       // Clean up the maps.
-      CHECK(paths.remove(timeout, info));
+      CHECK(infos.remove(timeout, info));
       CHECK(timeouts.erase(path) > 0);
 
       return true;
@@ -125,28 +307,9 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
   if (paths.count(removalTime) > 0) {
-    foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      Try<Nothing> rmdir = os::rmdir(info.path);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
-
-      timeouts.erase(info.path);
-    }
-
-    paths.remove(removalTime);
+    enqueue(removalTime);
+    drain();
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
@@ -165,15 +328,147 @@ void GarbageCollectorProcess::prune(const Duration& d)
     if (removalTime.remaining() <= d) {
       LOG(INFO) << "Pruning directories with remaining removal time "
                 << removalTime.remaining();
-      dispatch(self(), &GarbageCollectorProcess::remove, removalTime);
+      enqueue(removalTime);
     }
   }
+
+  drain();
+
+  reset(); // Schedule the timer for next event.
+}
+
+
+void GarbageCollectorProcess::enqueue(const Timeout& removalTime)
+{
+  foreach (const PathInfo& info, paths.get(removalTime)) {
+    queue.put(removalTime, info);
+  }
+
+  paths.remove(removalTime);
+}
+
+
+void GarbageCollectorProcess::drain()
+{
+  while (!acquiring && !queue.empty() && !idle.empty()) {
+    if (limiter.get() != NULL) {
+      acquiring = true;
+      limiter->acquire()
+        .onAny(defer(self(), &Self::_drain));
+      return;
+    }
+
+    _drain();
+  }
+}
+
+
+void GarbageCollectorProcess::_drain()
+{
+  acquiring = false;
+
+  // The queue might have been emptied by unschedule() while we were
+  // waiting for the limiter, in which case the permit is wasted.
+  if (!queue.empty() && !idle.empty()) {
+    Multimap<Timeout, PathInfo>::iterator it = queue.begin();
+
+    const PathInfo info = it->second;
+    queue.erase(it);
+    timeouts.erase(info.path);
+
+    GarbageCollectorWorkerProcess* worker = idle.front();
+    idle.pop_front();
+
+    removing.put(info.path, info);
+
+    LOG(INFO) << "Deleting " << info.path;
+
+    dispatch(worker, &GarbageCollectorWorkerProcess::remove, info.path)
+      .onAny(defer(self(), &Self::removed, worker, info, lambda::_1));
+  }
+
+  if (limiter.get() != NULL) {
+    drain();
+  }
+}
+
+
+void GarbageCollectorProcess::removed(
+    GarbageCollectorWorkerProcess* worker,
+    const PathInfo& info,
+    const Future<Bytes>& future)
+{
+  // The path might have been rescheduled and handed to another worker
+  // in the meantime.
+  if (removing.contains(info.path) && removing.at(info.path) == info) {
+    removing.erase(info.path);
+  }
+
+  idle.push_back(worker);
+
+  if (!future.isReady()) {
+    const string error =
+      future.isFailed() ? future.failure() : "future discarded";
+
+    LOG(WARNING) << "Failed to delete '" << info.path << "': " << error;
+
+    ++metrics.path_removals_failed;
+    info.promise->fail(error);
+  } else {
+    LOG(INFO) << "Deleted '" << info.path << "', reclaiming "
+              << future.get();
+
+    ++metrics.paths_removed;
+    metrics.bytes_reclaimed += future.get().bytes();
+    info.promise->set(Nothing());
+  }
+
+  drain();
+}
+
+
+GarbageCollectorProcess::Metrics::Metrics(
+    const GarbageCollectorProcess& process)
+  : paths_scheduled(
+        "slave/gc_paths_scheduled",
+        defer(process, &GarbageCollectorProcess::_paths_scheduled)),
+    paths_pending(
+        "slave/gc_paths_pending",
+        defer(process, &GarbageCollectorProcess::_paths_pending)),
+    paths_removed("slave/gc_paths_removed"),
+    path_removals_failed("slave/gc_path_removals_failed"),
+    bytes_reclaimed("slave/gc_bytes_reclaimed")
+{
+  process::metrics::add(paths_scheduled);
+  process::metrics::add(paths_pending);
+
+  process::metrics::add(paths_removed);
+  process::metrics::add(path_removals_failed);
+  process::metrics::add(bytes_reclaimed);
+}
+
+
+GarbageCollectorProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(paths_scheduled);
+  process::metrics::remove(paths_pending);
+
+  process::metrics::remove(paths_removed);
+  process::metrics::remove(path_removals_failed);
+  process::metrics::remove(bytes_reclaimed);
 }
 
 
 GarbageCollector::GarbageCollector()
 {
-  process = new GarbageCollectorProcess();
+  process = new GarbageCollectorProcess(GC_WORKERS, None());
+  spawn(process);
+}
+
+
+GarbageCollector::GarbageCollector(size_t workers, const Option<double>& rate)
+{
+  process = new GarbageCollectorProcess(workers, rate);
   spawn(process);
 }
 
@@ -19,19 +19,26 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
 #include <string>
 #include <vector>
 
 #include <process/future.hpp>
+#include <process/limiter.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
 namespace mesos {
@@ -50,7 +57,11 @@ class GarbageCollectorProcess;
 class GarbageCollector
 {
 public:
+  // The paths that are due are removed by 'workers' removal actors
+  // (in parallel), starting at most 'rate' removals per second if a
+  // rate is specified.
   GarbageCollector();
+  GarbageCollector(size_t workers, const Option<double>& rate);
   virtual ~GarbageCollector();
 
   // Schedules the specified path for removal after the specified
@@ -70,12 +81,14 @@ public:
   // Unschedules the specified path for removal.
   // The future will be true if the path has been unscheduled.
   // The future will be false if the path is not scheduled for
-  // removal, or the path has already being removed.
+  // removal, or the path has already being removed. If the path is
+  // being removed, the future only becomes false once it is removed.
   // Note that you currently cannot discard a returned future.
   virtual process::Future<bool> unschedule(const std::string& path);
 
   // Deletes all the directories, whose scheduled garbage collection time
-  // is within the next 'd' duration of time.
+  // is within the next 'd' duration of time. The directories that are
+  // due the earliest are deleted first.
   virtual void prune(const Duration& d);
 
 private:
@@ -83,25 +96,78 @@ private:
 };
 
 
+// Removes paths on behalf of the garbage collector, so that the
+// removal of large directory trees does not block the garbage
+// collector from handling (un)schedule requests and from removing
+// other paths.
+class GarbageCollectorWorkerProcess
+  : public process::Process<GarbageCollectorWorkerProcess>
+{
+public:
+  GarbageCollectorWorkerProcess();
+
+  // Recursively removes the path, returning the amount of disk space
+  // that was reclaimed.
+  process::Future<Bytes> remove(const std::string& path);
+};
+
+
 class GarbageCollectorProcess :
     public process::Process<GarbageCollectorProcess>
 {
 public:
+  GarbageCollectorProcess(size_t workers, const Option<double>& rate);
+
   virtual ~GarbageCollectorProcess();
 
   process::Future<Nothing> schedule(
       const Duration& d,
       const std::string& path);
 
-  bool unschedule(const std::string& path);
+  process::Future<bool> unschedule(const std::string& path);
 
   void prune(const Duration& d);
 
+protected:
+  virtual void initialize();
+  virtual void finalize();
+
 private:
+  struct PathInfo;
+
+  // Removes the path from the scheduled or due paths, discarding its
+  // future. Returns false if the path is not scheduled.
+  bool discard(const std::string& path);
+
   void reset();
 
   void remove(const process::Timeout& removalTime);
 
+  // Moves the paths to be removed at 'removalTime' to the queue of
+  // paths that are due.
+  void enqueue(const process::Timeout& removalTime);
+
+  // Hands the paths that are due to the idle workers, for as long as
+  // the rate limit permits.
+  void drain();
+  void _drain();
+
+  void removed(
+      GarbageCollectorWorkerProcess* worker,
+      const PathInfo& info,
+      const process::Future<Bytes>& future);
+
+  // Gauge handlers.
+  double _paths_scheduled()
+  {
+    return paths.size();
+  }
+
+  double _paths_pending()
+  {
+    return queue.size() + removing.size();
+  }
+
   struct PathInfo
   {
     PathInfo(const std::string& _path,
@@ -122,11 +188,41 @@ private:
   // we need the keys of the map (deletion time) to be sorted.
   Multimap<process::Timeout, PathInfo> paths;
 
+  // The paths that are due but not yet handed to a worker, ordered
+  // by the time they were due so that under disk pressure (i.e., when
+  // a prune moves many paths here at once) the oldest ones go first.
+  Multimap<process::Timeout, PathInfo> queue;
+
   // We also need efficient lookup for a path, to determine whether
-  // it exists in our paths mapping.
+  // it exists in our paths or queue mapping.
   hashmap<std::string, process::Timeout> timeouts;
 
+  // The paths that are being removed by the workers.
+  hashmap<std::string, PathInfo> removing;
+
   process::Timer timer;
+
+  const size_t count;
+  std::vector<GarbageCollectorWorkerProcess*> workers;
+  std::list<GarbageCollectorWorkerProcess*> idle;
+
+  process::Owned<process::RateLimiter> limiter;
+
+  // Whether we are waiting for the limiter to permit a removal.
+  bool acquiring;
+
+  struct Metrics
+  {
+    explicit Metrics(const GarbageCollectorProcess& process);
+    ~Metrics();
+
+    process::metrics::Gauge paths_scheduled;
+    process::metrics::Gauge paths_pending;
+
+    process::metrics::Counter paths_removed;
+    process::metrics::Counter path_removals_failed;
+    process::metrics::Counter bytes_reclaimed;
+  } metrics;
 };
 
 } // namespace slave {
@@ -121,6 +121,15 @@ int main(int argc, char** argv)
     EXIT(1) << "Missing required option --master";
   }
 
+  if (flags.gc_workers == 0) {
+    EXIT(1) << "Invalid value '0' for option --gc_workers";
+  }
+
+  if (flags.gc_removal_rate.isSome() && flags.gc_removal_rate.get() <= 0) {
+    EXIT(1) << "Invalid value '" << flags.gc_removal_rate.get()
+            << "' for option --gc_removal_rate";
+  }
+
   // Initialize modules. Note that since other subsystems may depend
   // upon modules, we should initialize modules before anything else.
   if (flags.modules.isSome()) {
@@ -180,7 +189,7 @@ int main(int argc, char** argv)
   LOG(INFO) << "Starting Mesos slave";
 
   Files files;
-  GarbageCollector gc;
+  GarbageCollector gc(flags.gc_workers, flags.gc_removal_rate);
   StatusUpdateManager statusUpdateManager(flags);
 
   Slave* slave = new Slave(
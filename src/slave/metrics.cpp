@@ -73,6 +73,10 @@ Metrics::Metrics(const Slave& slave)
         "slave/valid_status_updates"),
     invalid_status_updates(
         "slave/invalid_status_updates"),
+    status_updates_forwarded(
+        "slave/status_updates_forwarded"),
+    status_update_messages_forwarded(
+        "slave/status_update_messages_forwarded"),
     valid_framework_messages(
         "slave/valid_framework_messages"),
     invalid_framework_messages(
@@ -101,6 +105,8 @@ Metrics::Metrics(const Slave& slave)
 
   process::metrics::add(valid_status_updates);
   process::metrics::add(invalid_status_updates);
+  process::metrics::add(status_updates_forwarded);
+  process::metrics::add(status_update_messages_forwarded);
 
   process::metrics::add(valid_framework_messages);
   process::metrics::add(invalid_framework_messages);
@@ -157,6 +163,8 @@ Metrics::~Metrics()
 
   process::metrics::remove(valid_status_updates);
   process::metrics::remove(invalid_status_updates);
+  process::metrics::remove(status_updates_forwarded);
+  process::metrics::remove(status_update_messages_forwarded);
 
   process::metrics::remove(valid_framework_messages);
   process::metrics::remove(invalid_framework_messages);
@@ -59,6 +59,11 @@ struct Metrics
   process::metrics::Counter valid_status_updates;
   process::metrics::Counter invalid_status_updates;
 
+  // Status updates forwarded to the master and the messages that
+  // carried them (several updates can share a message).
+  process::metrics::Counter status_updates_forwarded;
+  process::metrics::Counter status_update_messages_forwarded;
+
   process::metrics::Counter valid_framework_messages;
   process::metrics::Counter invalid_framework_messages;
 
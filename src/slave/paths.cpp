@@ -95,6 +95,14 @@ string getSlaveInfoPath(
 }
 
 
+string getStatusUpdateJournalPath(
+    const string& rootDir,
+    const SlaveID& slaveId)
+{
+  return path::join(getSlavePath(rootDir, slaveId), "status_updates");
+}
+
+
 Try<list<string>> getFrameworkPaths(
     const string& rootDir,
     const SlaveID& slaveId)
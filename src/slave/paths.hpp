@@ -62,6 +62,8 @@ namespace paths {
 //   |       |-- latest (symlink)
 //   |       |-- <slave_id>
 //   |           |-- slave.info
+//   |           |-- status_updates
+//   |           |   |-- <segment> (status update journal)
 //   |           |-- frameworks
 //   |               |-- <framework__id>
 //   |                   |-- framework.info
@@ -79,7 +81,7 @@ namespace paths {
 //   |                                   |-- tasks
 //   |                                       |-- <task_id>
 //   |                                           |-- task.info
-//   |                                           |-- task.updates
+//   |                                           |-- task.updates (< 0.22.0)
 //   |-- boot_id
 //   |-- resources
 //   |   |-- resources.info
@@ -114,6 +116,11 @@ std::string getSlavePath(
     const SlaveID& slaveId);
 
 
+std::string getStatusUpdateJournalPath(
+    const std::string& rootDir,
+    const SlaveID& slaveId);
+
+
 Try<std::list<std::string>> getFrameworkPaths(
     const std::string& rootDir,
     const SlaveID& slaveId);
@@ -401,6 +401,10 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements,
+      &StatusUpdateAcknowledgementsMessage::acknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
@@ -1841,6 +1845,23 @@ void Slave::statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const google::protobuf::RepeatedPtrField<
+        StatusUpdateAcknowledgementMessage>& acknowledgements)
+{
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           acknowledgements) {
+    statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
 void Slave::_statusUpdateAcknowledgement(
     const Future<bool>& future,
     const TaskID& taskId,
@@ -2523,12 +2544,57 @@ void Slave::forward(StatusUpdate update)
   // re-registration can generate updates when framework/executor/task
   // are unknown.
 
-  // Forward the update to master.
-  StatusUpdateMessage message;
-  message.mutable_update()->MergeFrom(update);
-  message.set_pid(self()); // The ACK will be first received by the slave.
+  // The updates are flushed once the slave has processed the events
+  // already in its queue, which includes any other updates the status
+  // update manager forwarded in the meantime (e.g., the pending
+  // updates of all tasks after re-registering).
+  if (forwarding.empty()) {
+    dispatch(self(), &Slave::flushStatusUpdates);
+  }
+
+  forwarding.push_back(update);
+}
+
+
+void Slave::flushStatusUpdates()
+{
+  if (forwarding.empty()) {
+    return;
+  }
+
+  // The status update manager will resend the updates if the slave
+  // got disconnected in the meantime.
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << forwarding.size() << " status update(s)"
+                 << " because the slave is in " << state << " state";
+    forwarding.clear();
+    return;
+  }
+
+  CHECK_SOME(master);
+
+  // Forward the update(s) to master. A single update is sent in a
+  // StatusUpdateMessage as before.
+  if (forwarding.size() == 1) {
+    StatusUpdateMessage message;
+    message.mutable_update()->MergeFrom(forwarding.front());
+    message.set_pid(self()); // The ACK will be first received by the slave.
+
+    send(master.get(), message);
+  } else {
+    StatusUpdatesMessage message;
+    foreach (const StatusUpdate& update, forwarding) {
+      message.add_updates()->MergeFrom(update);
+    }
+    message.set_pid(self()); // The ACKs will be first received by the slave.
+
+    send(master.get(), message);
+  }
+
+  metrics.status_updates_forwarded += forwarding.size();
+  ++metrics.status_update_messages_forwarded;
 
-  send(master.get(), message);
+  forwarding.clear();
 }
 
 
@@ -194,9 +194,13 @@ public:
 
   // This is called by status update manager to forward a status
   // update to the master. Note that the latest state of the task is
-  // added to the update before forwarding.
+  // added to the update before forwarding. The update is queued and
+  // sent along with any others forwarded before the queue is flushed.
   void forward(StatusUpdate update);
 
+  // Sends the queued status updates to the master in one message.
+  void flushStatusUpdates();
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -204,6 +208,11 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const google::protobuf::RepeatedPtrField<
+          StatusUpdateAcknowledgementMessage>& acknowledgements);
+
   void _statusUpdateAcknowledgement(
       const process::Future<bool>& future,
       const TaskID& taskId,
@@ -437,6 +446,10 @@ private:
 
   StatusUpdateManager* statusUpdateManager;
 
+  // Status updates waiting to be forwarded to the master (see
+  // 'flushStatusUpdates').
+  std::vector<StatusUpdate> forwarding;
+
   // Master detection future.
   process::Future<Option<MasterInfo> > detection;
 
@@ -9,14 +9,18 @@
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/format.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/try.hpp>
+#include <stout/uuid.hpp>
 
 #include "slave/paths.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_journal.hpp"
 
 namespace mesos {
 namespace slave {
@@ -25,6 +29,7 @@ namespace state {
 using std::list;
 using std::string;
 using std::max;
+using std::vector;
 
 
 Result<State> recover(const string& rootDir, bool strict)
@@ -162,10 +167,85 @@ Try<SlaveState> SlaveState::recover(
     state.errors += framework.get().errors;
   }
 
+  // Read the status updates in the journal (see
+  // status_update_journal.hpp) and add them to their tasks. The
+  // 'task.updates' files of the tasks checkpointed by slaves older
+  // than 0.22.0 are read by 'TaskState::recover()' and precede the
+  // records in the journal.
+  const string& directory =
+    paths::getStatusUpdateJournalPath(rootDir, slaveId);
+
+  Try<vector<StatusUpdateJournalRecord> > records =
+    StatusUpdateJournal::read(directory);
+
+  if (records.isError()) {
+    const string& message = "Failed to read status update journal '" +
+                            directory + "': " + records.error();
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+      return state;
+    }
+  }
+
+  // The UUIDs of the updates read from the journal, see the NOTE on
+  // 'StatusUpdateJournal::read()' about duplicate records.
+  hashmap<FrameworkID, hashmap<TaskID, hashset<UUID> > > received;
+
+  foreach (const StatusUpdateJournalRecord& record, records.get()) {
+    TaskState* task = state.getTaskState(record);
+
+    // Records of tasks that were not recovered are ignored, just like
+    // the 'task.updates' file of a task without a task info.
+    if (task == NULL || task->info.isNone()) {
+      continue;
+    }
+
+    if (record.record().type() == StatusUpdateRecord::UPDATE) {
+      const StatusUpdate& update = record.record().update();
+      const UUID uuid = UUID::fromBytes(update.uuid());
+
+      hashset<UUID>& uuids = received[record.framework_id()][task->id];
+      if (!uuids.contains(uuid)) {
+        uuids.insert(uuid);
+        task->updates.push_back(update);
+      }
+    } else {
+      task->acks.insert(UUID::fromBytes(record.record().uuid()));
+    }
+  }
+
   return state;
 }
 
 
+TaskState* SlaveState::getTaskState(const StatusUpdateJournalRecord& record)
+{
+  if (!frameworks.contains(record.framework_id())) {
+    return NULL;
+  }
+
+  FrameworkState& framework = frameworks[record.framework_id()];
+  if (!framework.executors.contains(record.executor_id())) {
+    return NULL;
+  }
+
+  ExecutorState& executor = framework.executors[record.executor_id()];
+  if (!executor.runs.contains(record.container_id())) {
+    return NULL;
+  }
+
+  RunState& run = executor.runs[record.container_id()];
+  if (!run.tasks.contains(record.task_id())) {
+    return NULL;
+  }
+
+  return &run.tasks[record.task_id()];
+}
+
+
 Try<FrameworkState> FrameworkState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
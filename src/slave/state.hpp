@@ -202,6 +202,9 @@ struct SlaveState
       const SlaveID& slaveId,
       bool strict);
 
+  // Returns the state of the task the record belongs to, if any.
+  TaskState* getTaskState(const StatusUpdateJournalRecord& record);
+
   SlaveID id;
   Option<SlaveInfo> info;
   hashmap<FrameworkID, FrameworkState> frameworks;
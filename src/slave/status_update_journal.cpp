@@ -0,0 +1,481 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <list>
+
+#include <glog/logging.h>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "slave/status_update_journal.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace slave {
+
+// Prefix of the temporary files written while compacting.
+static const char COMPACTION_PREFIX[] = "compact.";
+
+
+static string getSegmentPath(const string& directory, uint64_t segment)
+{
+  return path::join(directory, stringify(segment));
+}
+
+
+// Returns the sequence numbers of the segments in 'directory' in
+// increasing order.
+static Try<vector<uint64_t> > getSegments(const string& directory)
+{
+  Try<list<string> > entries = os::ls(directory);
+  if (entries.isError()) {
+    return Error("Failed to list '" + directory + "': " + entries.error());
+  }
+
+  vector<uint64_t> segments;
+  foreach (const string& entry, entries.get()) {
+    Try<uint64_t> segment = numify<uint64_t>(entry);
+    if (segment.isSome()) {
+      segments.push_back(segment.get());
+    }
+  }
+
+  std::sort(segments.begin(), segments.end());
+
+  return segments;
+}
+
+
+// Makes the creation, renaming or removal of the files in
+// 'directory' durable.
+static Try<Nothing> sync(const string& directory)
+{
+  Try<int> fd = os::open(directory, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + directory + "': " + fd.error());
+  }
+
+  if (::fsync(fd.get()) != 0) {
+    ErrnoError error("Failed to sync '" + directory + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+  return Nothing();
+}
+
+
+static Try<int> openSegment(const string& directory, uint64_t segment)
+{
+  const string path = getSegmentPath(directory, segment);
+
+  Try<int> fd = os::open(
+      path,
+      O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  Try<Nothing> synced = sync(directory);
+  if (synced.isError()) {
+    os::close(fd.get());
+    return Error(synced.error());
+  }
+
+  return fd.get();
+}
+
+
+// Appends the records in the segment at 'path' to 'records' and
+// truncates any partially written record at the end of the segment.
+static Try<Nothing> readSegment(
+    const string& path,
+    vector<StatusUpdateJournalRecord>* records)
+{
+  // Open the segment for reading and writing (for truncating).
+  Try<int> fd = os::open(path, O_RDWR | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  Result<StatusUpdateJournalRecord> record = None();
+  while (true) {
+    // Ignore errors due to partial protobuf read and enable undoing
+    // failed reads by reverting to the previous seek position.
+    record = ::protobuf::read<StatusUpdateJournalRecord>(fd.get(), true, true);
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    records->push_back(record.get());
+  }
+
+  // NOTE: 'protobuf::read()' leaves the offset at the end of the last
+  // complete record, see TaskState::recover().
+  if (ftruncate(fd.get(), lseek(fd.get(), 0, SEEK_CUR)) != 0) {
+    ErrnoError error("Failed to truncate '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+
+  if (record.isError()) {
+    return Error("Failed to read '" + path + "': " + record.error());
+  }
+
+  return Nothing();
+}
+
+
+// Writes 'data' to a new file at 'path' and syncs it to disk.
+static Try<Nothing> write(const string& path, const string& data)
+{
+  Try<int> fd = os::open(
+      path,
+      O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  Try<Nothing> write = os::write(fd.get(), data);
+  if (write.isError()) {
+    os::close(fd.get());
+    return Error("Failed to write '" + path + "': " + write.error());
+  }
+
+  if (::fsync(fd.get()) != 0) {
+    ErrnoError error("Failed to sync '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+  return Nothing();
+}
+
+
+// Appends the record to 'data' in the format of ::protobuf::write().
+static Try<Nothing> serialize(
+    const StatusUpdateJournalRecord& record,
+    string* data)
+{
+  if (!record.IsInitialized()) {
+    return Error(record.InitializationErrorString() +
+                 " is required but not initialized");
+  }
+
+  const size_t offset = data->size();
+
+  uint32_t size = record.ByteSize();
+  data->append((char*) &size, sizeof(size));
+
+  if (!record.AppendToString(data)) {
+    data->resize(offset);
+    return Error("Failed to serialize record");
+  }
+
+  return Nothing();
+}
+
+
+Try<StatusUpdateJournal*> StatusUpdateJournal::create(
+    const string& directory,
+    const Bytes& segmentSize)
+{
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    return Error("Failed to create '" + directory + "': " + mkdir.error());
+  }
+
+  // Remove the leftovers of a compaction interrupted by a restart.
+  Try<list<string> > entries = os::ls(directory);
+  if (entries.isError()) {
+    return Error("Failed to list '" + directory + "': " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    if (strings::startsWith(entry, COMPACTION_PREFIX)) {
+      os::rm(path::join(directory, entry));
+    }
+  }
+
+  Try<vector<uint64_t> > segments = getSegments(directory);
+  if (segments.isError()) {
+    return Error(segments.error());
+  }
+
+  // Records are never appended to the segments of a previous run.
+  uint64_t segment = segments.get().empty() ? 1 : segments.get().back() + 1;
+
+  Try<int> fd = openSegment(directory, segment);
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
+  return new StatusUpdateJournal(directory, segmentSize, segment, fd.get());
+}
+
+
+Try<vector<StatusUpdateJournalRecord> > StatusUpdateJournal::read(
+    const string& directory)
+{
+  vector<StatusUpdateJournalRecord> records;
+
+  if (!os::exists(directory)) {
+    return records;
+  }
+
+  Try<vector<uint64_t> > segments = getSegments(directory);
+  if (segments.isError()) {
+    return Error(segments.error());
+  }
+
+  foreach (uint64_t segment, segments.get()) {
+    Try<Nothing> read =
+      readSegment(getSegmentPath(directory, segment), &records);
+
+    if (read.isError()) {
+      return Error(read.error());
+    }
+  }
+
+  return records;
+}
+
+
+StatusUpdateJournal::StatusUpdateJournal(
+    const string& _directory,
+    const Bytes& _segmentSize,
+    uint64_t _segment,
+    int _fd)
+  : directory(_directory),
+    segmentSize(_segmentSize),
+    segment(_segment),
+    fd(_fd) {}
+
+
+StatusUpdateJournal::~StatusUpdateJournal()
+{
+  if (!buffer.empty()) {
+    LOG(WARNING) << "Dropping " << buffer.size() << " bytes of"
+                 << " uncommitted status update records in '"
+                 << directory << "'";
+  }
+
+  os::close(fd);
+}
+
+
+Try<Nothing> StatusUpdateJournal::append(
+    const StatusUpdateJournalRecord& record)
+{
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return serialize(record, &buffer);
+}
+
+
+Try<Nothing> StatusUpdateJournal::commit()
+{
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  if (buffer.empty()) {
+    return Nothing();
+  }
+
+  const string path = getSegmentPath(directory, segment);
+
+  // NOTE: A failed write can leave a partially written record at the
+  // end of the segment, hence no more records can be appended to it.
+  // The partial record is truncated when the journal is read back.
+  Try<Nothing> write = os::write(fd, buffer);
+  if (write.isError()) {
+    error = Error("Failed to write '" + path + "': " + write.error());
+    return error.get();
+  }
+
+  if (::fsync(fd) != 0) {
+    error = ErrnoError("Failed to sync '" + path + "'");
+    return error.get();
+  }
+
+  size += Bytes(buffer.size());
+  buffer.clear();
+
+  if (size >= segmentSize) {
+    Try<Nothing> roll = this->roll();
+    if (roll.isError()) {
+      // The records have been committed, we retry on the next commit.
+      LOG(WARNING) << "Failed to start a new status update journal segment"
+                   << " in '" << directory << "': " << roll.error();
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> StatusUpdateJournal::roll()
+{
+  Try<int> next = openSegment(directory, segment + 1);
+  if (next.isError()) {
+    return Error(next.error());
+  }
+
+  os::close(fd);
+
+  fd = next.get();
+  segment++;
+  size = Bytes(0);
+
+  return Nothing();
+}
+
+
+Try<Nothing> StatusUpdateJournal::compact(
+    const lambda::function<bool(const StatusUpdateJournalRecord&)>& live)
+{
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<vector<uint64_t> > segments = getSegments(directory);
+  if (segments.isError()) {
+    return Error(segments.error());
+  }
+
+  vector<uint64_t> sealed;
+  foreach (uint64_t segment_, segments.get()) {
+    if (segment_ < segment) {
+      sealed.push_back(segment_);
+    }
+  }
+
+  if (sealed.empty()) {
+    return Nothing();
+  }
+
+  vector<StatusUpdateJournalRecord> records;
+  foreach (uint64_t segment_, sealed) {
+    Try<Nothing> read =
+      readSegment(getSegmentPath(directory, segment_), &records);
+
+    if (read.isError()) {
+      return Error(read.error());
+    }
+  }
+
+  Bytes dropped;
+  string data;
+  foreach (const StatusUpdateJournalRecord& record, records) {
+    if (live(record)) {
+      Try<Nothing> serialize = mesos::slave::serialize(record, &data);
+      if (serialize.isError()) {
+        return Error(serialize.error());
+      }
+    } else {
+      dropped += Bytes(sizeof(uint32_t) + record.ByteSize());
+    }
+  }
+
+  if (dropped < Bytes(data.size())) {
+    return Nothing();
+  }
+
+  VLOG(1) << "Compacting " << sealed.size() << " status update journal"
+          << " segments in '" << directory << "', dropping " << dropped;
+
+  // The remaining records replace the newest sealed segment, so that
+  // they stay ahead of the records in the active segment. The older
+  // sealed segments are only removed afterwards, hence a restart in
+  // between leaves a copy of the remaining records behind their
+  // originals (see 'read()').
+  const uint64_t newest = sealed.back();
+  sealed.pop_back();
+
+  if (data.empty()) {
+    sealed.push_back(newest);
+  } else {
+    Try<string> temp =
+      os::mktemp(path::join(directory, string(COMPACTION_PREFIX) + "XXXXXX"));
+
+    if (temp.isError()) {
+      return Error("Failed to create temporary file: " + temp.error());
+    }
+
+    Try<Nothing> write = mesos::slave::write(temp.get(), data);
+    if (write.isError()) {
+      os::rm(temp.get());
+      return Error(write.error());
+    }
+
+    Try<Nothing> rename =
+      os::rename(temp.get(), getSegmentPath(directory, newest));
+
+    if (rename.isError()) {
+      os::rm(temp.get());
+      return Error("Failed to rename '" + temp.get() + "': " + rename.error());
+    }
+
+    Try<Nothing> synced = sync(directory);
+    if (synced.isError()) {
+      return Error(synced.error());
+    }
+  }
+
+  foreach (uint64_t segment_, sealed) {
+    const string path = getSegmentPath(directory, segment_);
+
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      return Error("Failed to remove '" + path + "': " + rm.error());
+    }
+  }
+
+  return sync(directory);
+}
+
+} // namespace slave {
+} // namespace mesos {
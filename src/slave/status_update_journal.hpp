@@ -0,0 +1,126 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_STATUS_UPDATE_JOURNAL_HPP__
+#define __SLAVE_STATUS_UPDATE_JOURNAL_HPP__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace slave {
+
+// An append-only journal holding the checkpointed status update
+// records of all the tasks of a slave, which replaces the
+// 'task.updates' file per task (and the file descriptor the status
+// update manager kept open for each of them).
+//
+// Records are buffered by 'append()' and written out by 'commit()'
+// with a single write followed by a single fsync, so that all the
+// updates and acknowledgements handled while a commit is pending
+// share the cost of the disk write (group commit).
+//
+// The journal is a directory of segments named by increasing
+// sequence numbers. Each segment holds length prefixed records in
+// the format of ::protobuf::write(). Records are only ever appended
+// to the (single) active segment, which is sealed once it grows
+// beyond 'segmentSize' or when the journal is re-opened. Sealed
+// segments are compacted by dropping the records that are no longer
+// needed (see 'compact()').
+class StatusUpdateJournal
+{
+public:
+  // Opens the journal in 'directory' (creating the directory if
+  // necessary) and starts a new active segment.
+  static Try<StatusUpdateJournal*> create(
+      const std::string& directory,
+      const Bytes& segmentSize);
+
+  // Returns the records in the journal in 'directory' in the order
+  // they were appended. Any partially written record at the end of a
+  // segment (e.g., the slave died while writing it) is truncated.
+  // NOTE: Compaction can leave a record twice in the journal if the
+  // slave dies while compacting. The copy always comes after the
+  // original and can be ignored (updates are unique by UUID and
+  // acknowledgements are idempotent).
+  static Try<std::vector<StatusUpdateJournalRecord> > read(
+      const std::string& directory);
+
+  ~StatusUpdateJournal();
+
+  // Buffers the record. It is only durable after the next
+  // successful 'commit()'.
+  Try<Nothing> append(const StatusUpdateJournalRecord& record);
+
+  // Returns true if there are buffered records to commit.
+  bool dirty() const { return !buffer.empty(); }
+
+  // Writes the buffered records to the active segment and syncs it
+  // to disk. A failed commit leaves the journal in an error state in
+  // which every subsequent call fails.
+  Try<Nothing> commit();
+
+  // Rewrites the sealed segments with only the records for which
+  // 'live' returns true. The rewrite is skipped unless at least half
+  // of the bytes in the sealed segments can be dropped.
+  Try<Nothing> compact(
+      const lambda::function<bool(const StatusUpdateJournalRecord&)>& live);
+
+  const std::string directory;
+
+private:
+  StatusUpdateJournal(
+      const std::string& directory,
+      const Bytes& segmentSize,
+      uint64_t segment,
+      int fd);
+
+  StatusUpdateJournal(const StatusUpdateJournal&);
+  StatusUpdateJournal& operator = (const StatusUpdateJournal&);
+
+  // Seals the active segment and starts the next one.
+  Try<Nothing> roll();
+
+  const Bytes segmentSize;
+
+  // The sequence number, file descriptor and size of the active
+  // segment.
+  uint64_t segment;
+  int fd;
+  Bytes size;
+
+  // Records appended since the last commit.
+  std::string buffer;
+
+  Option<Error> error;
+};
+
+} // namespace slave {
+} // namespace mesos {
+
+#endif // __SLAVE_STATUS_UPDATE_JOURNAL_HPP__
@@ -16,10 +16,16 @@
  * limitations under the License.
  */
 
+#include <process/clock.hpp>
 #include <process/delay.hpp>
+#include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
@@ -34,8 +40,10 @@
 
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_journal.hpp"
 #include "slave/status_update_manager.hpp"
 
 using lambda::function;
@@ -43,9 +51,12 @@ using lambda::function;
 using std::string;
 
 using process::wait; // Necessary on some OS's to disambiguate.
+using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
+using process::Promise;
 using process::Timeout;
 using process::UPID;
 
@@ -59,6 +70,14 @@ using state::RunState;
 using state::TaskState;
 
 
+// Returns 'value', used to complete a future once a commit is done.
+template <typename T>
+static T committed(const T& value)
+{
+  return value;
+}
+
+
 class StatusUpdateManagerProcess
   : public ProtobufProcess<StatusUpdateManagerProcess>
 {
@@ -66,8 +85,8 @@ public:
   StatusUpdateManagerProcess(const Flags& flags);
   virtual ~StatusUpdateManagerProcess();
 
-  // Explicitely use 'initialize' since we're overloading below.
-  using process::ProcessBase::initialize;
+  // ProcessBase implementation.
+  virtual void initialize();
 
   // StatusUpdateManager implementation.
   void initialize(const function<void(StatusUpdate)>& forward);
@@ -114,10 +133,24 @@ private:
   // ACK (e.g updates from the executor).
   Timeout forward(const StatusUpdate& update, const Duration& duration);
 
+  // Returns a future that is satisfied once the status update records
+  // appended to the journals so far are committed. All the records
+  // appended until the commit runs (i.e., on the next turn of the
+  // queue of this process) share a single write.
+  Future<Nothing> commit();
+  void _commit();
+
+  // Drops the records of the tasks whose executor run meta directory
+  // has been garbage collected from the journals.
+  void compact();
+
   // Helper functions.
 
-  // Creates a new status update stream (opening the updates file, if path is
-  // present) and adds it to streams.
+  // Returns the journal of the slave, opening it if necessary.
+  Try<StatusUpdateJournal*> getJournal(const SlaveID& slaveId);
+
+  // Creates a new status update stream (using the journal of the
+  // slave, if checkpointing) and adds it to streams.
   StatusUpdateStream* createStatusUpdateStream(
       const TaskID& taskId,
       const FrameworkID& frameworkId,
@@ -140,15 +173,31 @@ private:
   function<void(StatusUpdate)> forward_;
 
   hashmap<FrameworkID, hashmap<TaskID, StatusUpdateStream*> > streams;
+
+  hashmap<SlaveID, Owned<StatusUpdateJournal> > journals;
+
+  // Satisfied by the pending commit of the journals, if any.
+  Option<Owned<Promise<Nothing> > > committing;
+
+  // Time from the creation of a status update (by the executor or the
+  // slave) until the scheduler acknowledges it.
+  process::metrics::Timer<Milliseconds> latency;
 };
 
 
 StatusUpdateManagerProcess::StatusUpdateManagerProcess(const Flags& _flags)
-  : flags(_flags), paused(false) {}
+  : flags(_flags),
+    paused(false),
+    latency("slave/status_update_latency")
+{
+  process::metrics::add(latency);
+}
 
 
 StatusUpdateManagerProcess::~StatusUpdateManagerProcess()
 {
+  process::metrics::remove(latency);
+
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
       delete stream;
@@ -158,6 +207,14 @@ StatusUpdateManagerProcess::~StatusUpdateManagerProcess()
 }
 
 
+void StatusUpdateManagerProcess::initialize()
+{
+  delay(STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL,
+        self(),
+        &StatusUpdateManagerProcess::compact);
+}
+
+
 void StatusUpdateManagerProcess::initialize(
     const function<void(StatusUpdate)>& forward)
 {
@@ -339,9 +396,9 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
   }
 
   // We don't return a failed future here so that the slave can re-ack
-  // the duplicate update.
+  // the duplicate update (once the original update is committed).
   if (!result.get()) {
-    return Nothing();
+    return checkpoint ? commit() : Nothing();
   }
 
   // Forward the status update to the master if this is the first in the stream.
@@ -357,7 +414,89 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
     stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return Nothing();
+  return checkpoint ? commit() : Nothing();
+}
+
+
+Future<Nothing> StatusUpdateManagerProcess::commit()
+{
+  if (committing.isNone()) {
+    bool dirty = false;
+    foreachvalue (const Owned<StatusUpdateJournal>& journal, journals) {
+      dirty = dirty || journal->dirty();
+    }
+
+    if (!dirty) {
+      return Nothing();
+    }
+
+    committing = Owned<Promise<Nothing> >(new Promise<Nothing>());
+    dispatch(self(), &StatusUpdateManagerProcess::_commit);
+  }
+
+  return committing.get()->future();
+}
+
+
+void StatusUpdateManagerProcess::_commit()
+{
+  CHECK_SOME(committing);
+
+  Owned<Promise<Nothing> > promise = committing.get();
+  committing = None();
+
+  foreachvalue (const Owned<StatusUpdateJournal>& journal, journals) {
+    Try<Nothing> commit = journal->commit();
+    if (commit.isError()) {
+      promise->fail(
+          "Failed to commit the status update journal in '" +
+          journal->directory + "': " + commit.error());
+      return;
+    }
+  }
+
+  promise->set(Nothing());
+}
+
+
+// The records of a task are needed as long as the meta directory of
+// its executor run exists, i.e., until the slave garbage collects it
+// (or the whole framework). This mirrors the lifetime of the
+// 'task.updates' files that used to live in that directory.
+static bool live(
+    const string& rootDir,
+    const SlaveID& slaveId,
+    const StatusUpdateJournalRecord& record)
+{
+  return os::exists(paths::getExecutorRunPath(
+      rootDir,
+      slaveId,
+      record.framework_id(),
+      record.executor_id(),
+      record.container_id()));
+}
+
+
+void StatusUpdateManagerProcess::compact()
+{
+  foreachpair (const SlaveID& slaveId,
+               const Owned<StatusUpdateJournal>& journal,
+               journals) {
+    Try<Nothing> compact = journal->compact(lambda::bind(
+        &live,
+        paths::getMetaRootDir(flags.work_dir),
+        slaveId,
+        lambda::_1));
+
+    if (compact.isError()) {
+      LOG(ERROR) << "Failed to compact the status update journal in '"
+                 << journal->directory << "': " << compact.error();
+    }
+  }
+
+  delay(STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL,
+        self(),
+        &StatusUpdateManagerProcess::compact);
 }
 
 
@@ -429,12 +568,22 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
   // Reset the timeout.
   stream->timeout = None();
 
+  // The timestamp is taken from the clock of the executor (or the
+  // slave), so ignore updates that appear to come from the future.
+  Try<Duration> elapsed =
+    Duration::create(Clock::now().secs() - update.get().timestamp());
+
+  if (elapsed.isSome() && elapsed.get() >= Duration::zero()) {
+    latency.record(elapsed.get());
+  }
+
   // Get the next update in the queue.
   const Result<StatusUpdate>& next = stream->next();
   if (next.isError()) {
     return Failure(next.error());
   }
 
+  bool checkpoint = stream->checkpoint;
   bool terminated = stream->terminated;
 
   if (terminated) {
@@ -449,7 +598,11 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
     stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return !terminated;
+  if (!checkpoint) {
+    return !terminated;
+  }
+
+  return commit().then(lambda::bind(&committed<bool>, !terminated));
 }
 
 
@@ -482,6 +635,26 @@ void StatusUpdateManagerProcess::timeout(const Duration& duration)
 }
 
 
+Try<StatusUpdateJournal*> StatusUpdateManagerProcess::getJournal(
+    const SlaveID& slaveId)
+{
+  if (!journals.contains(slaveId)) {
+    Try<StatusUpdateJournal*> journal = StatusUpdateJournal::create(
+        paths::getStatusUpdateJournalPath(
+            paths::getMetaRootDir(flags.work_dir), slaveId),
+        STATUS_UPDATE_JOURNAL_SEGMENT_SIZE);
+
+    if (journal.isError()) {
+      return Error(journal.error());
+    }
+
+    journals[slaveId] = Owned<StatusUpdateJournal>(journal.get());
+  }
+
+  return journals[slaveId].get();
+}
+
+
 StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
     const TaskID& taskId,
     const FrameworkID& frameworkId,
@@ -493,8 +666,25 @@ StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
   VLOG(1) << "Creating StatusUpdate stream for task " << taskId
           << " of framework " << frameworkId;
 
+  StatusUpdateJournal* journal = NULL;
+  if (checkpoint) {
+    Try<StatusUpdateJournal*> result = getJournal(slaveId);
+    if (result.isError()) {
+      LOG(ERROR) << "Failed to open the status update journal: "
+                 << result.error();
+    } else {
+      journal = result.get();
+    }
+  }
+
   StatusUpdateStream* stream = new StatusUpdateStream(
-      taskId, frameworkId, slaveId, flags, checkpoint, executorId, containerId);
+      taskId,
+      frameworkId,
+      slaveId,
+      journal,
+      checkpoint,
+      executorId,
+      containerId);
 
   streams[frameworkId][taskId] = stream;
   return stream;
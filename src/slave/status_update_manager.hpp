@@ -48,6 +48,7 @@
 #include "messages/messages.hpp"
 
 #include "slave/flags.hpp"
+#include "slave/status_update_journal.hpp"
 
 namespace mesos {
 namespace slave {
@@ -148,62 +149,26 @@ struct StatusUpdateStream
   StatusUpdateStream(const TaskID& _taskId,
                      const FrameworkID& _frameworkId,
                      const SlaveID& _slaveId,
-                     const Flags& _flags,
+                     StatusUpdateJournal* _journal,
                      bool _checkpoint,
-                     const Option<ExecutorID>& executorId,
-                     const Option<ContainerID>& containerId)
+                     const Option<ExecutorID>& _executorId,
+                     const Option<ContainerID>& _containerId)
     : checkpoint(_checkpoint),
       terminated(false),
       taskId(_taskId),
       frameworkId(_frameworkId),
       slaveId(_slaveId),
-      flags(_flags),
+      executorId(_executorId),
+      containerId(_containerId),
+      journal(_journal),
       error(None())
   {
     if (checkpoint) {
       CHECK_SOME(executorId);
       CHECK_SOME(containerId);
 
-      path = paths::getTaskUpdatesPath(
-          paths::getMetaRootDir(flags.work_dir),
-          slaveId,
-          frameworkId,
-          executorId.get(),
-          containerId.get(),
-          taskId);
-
-      // Create the base updates directory, if it doesn't exist.
-      Try<Nothing> directory = os::mkdir(os::dirname(path.get()).get());
-      if (directory.isError()) {
-        error = "Failed to create " + os::dirname(path.get()).get();
-        return;
-      }
-
-      // Open the updates file.
-      Try<int> result = os::open(
-          path.get(),
-          O_CREAT | O_WRONLY | O_APPEND | O_SYNC | O_CLOEXEC,
-          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-
-      if (result.isError()) {
-        error = "Failed to open '" + path.get() + "' for status updates";
-        return;
-      }
-
-      // We keep the file open through the lifetime of the task, because it
-      // makes it easy to append status update records to the file.
-      fd = result.get();
-    }
-  }
-
-  ~StatusUpdateStream()
-  {
-    if (fd.isSome()) {
-      Try<Nothing> close = os::close(fd.get());
-      if (close.isError()) {
-        CHECK_SOME(path);
-        LOG(ERROR) << "Failed to close file '" << path.get() << "': "
-                   << close.error();
+      if (journal == NULL) {
+        error = "Failed to open the status update journal";
       }
     }
   }
@@ -328,12 +293,9 @@ struct StatusUpdateStream
   std::queue<StatusUpdate> pending;
 
 private:
-  // Handles the status update and writes it to disk, if necessary.
-  // TODO(vinod): The write has to be asynchronous to avoid status updates that
-  // are being checkpointed, blocking the processing of other updates.
-  // One solution is to wrap the protobuf::write inside async, but its probably
-  // too much of an overhead to spin up a new libprocess per status update?
-  // A better solution might be to be have async write capability for file io.
+  // Handles the status update and appends it to the journal, if
+  // necessary. The record is durable once the status update manager
+  // commits the journal.
   Try<Nothing> handle(
       const StatusUpdate& update,
       const StatusUpdateRecord::Type& type)
@@ -344,21 +306,25 @@ private:
     if (checkpoint) {
       LOG(INFO) << "Checkpointing " << type << " for status update " << update;
 
-      CHECK_SOME(fd);
+      CHECK_NOTNULL(journal);
 
-      StatusUpdateRecord record;
-      record.set_type(type);
+      StatusUpdateJournalRecord record;
+      record.mutable_framework_id()->CopyFrom(frameworkId);
+      record.mutable_executor_id()->CopyFrom(executorId.get());
+      record.mutable_container_id()->CopyFrom(containerId.get());
+      record.mutable_task_id()->CopyFrom(taskId);
+      record.mutable_record()->set_type(type);
 
       if (type == StatusUpdateRecord::UPDATE) {
-        record.mutable_update()->CopyFrom(update);
+        record.mutable_record()->mutable_update()->CopyFrom(update);
       } else {
-        record.set_uuid(update.uuid());
+        record.mutable_record()->set_uuid(update.uuid());
       }
 
-      Try<Nothing> write = ::protobuf::write(fd.get(), record);
-      if (write.isError()) {
-        error = "Failed to write status update " + stringify(update) +
-                " to '" + path.get() + "': " + write.error();
+      Try<Nothing> append = journal->append(record);
+      if (append.isError()) {
+        error = "Failed to checkpoint status update " + stringify(update) +
+                " to '" + journal->directory + "': " + append.error();
         return Error(error.get());
       }
     }
@@ -395,14 +361,13 @@ private:
   const TaskID taskId;
   const FrameworkID frameworkId;
   const SlaveID slaveId;
-
-  const Flags flags;
+  const Option<ExecutorID> executorId;
+  const Option<ContainerID> containerId;
 
   hashset<UUID> received;
   hashset<UUID> acknowledged;
 
-  Option<std::string> path; // File path of the update stream.
-  Option<int> fd; // File descriptor to the update stream.
+  StatusUpdateJournal* journal; // Not owned.
 
   Option<std::string> error; // Potential non-retryable error.
 };
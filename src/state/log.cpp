@@ -259,8 +259,10 @@ Future<Nothing> LogStorageProcess::_start(
     // If we've started before (i.e., have an 'index' position) we
     // should also expect know the last 'truncated' position.
     CHECK_SOME(truncated);
-    return reader.read(index.get(), position.get())
-      .then(defer(self(), &Self::apply, lambda::_1));
+    return reader.read(
+        index.get(),
+        position.get(),
+        defer(self(), &Self::apply, lambda::_1));
   }
 
   return reader.beginning()
@@ -276,8 +278,13 @@ Future<Nothing> LogStorageProcess::__start(
 
   truncated = beginning; // Cache for future truncations.
 
-  return reader.read(beginning, position)
-    .then(defer(self(), &Self::apply, lambda::_1));
+  // NOTE: The entries are streamed (i.e., applied in batches while
+  // the next batch is read) so that replaying a long log doesn't
+  // require holding all of its entries in memory at once.
+  return reader.read(
+      beginning,
+      position,
+      defer(self(), &Self::apply, lambda::_1));
 }
 
 
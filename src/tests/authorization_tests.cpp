@@ -348,3 +348,70 @@ TEST_F(AuthorizationTest, PrincipalNotOfferedAnyRoleRestrictive)
   request3.mutable_roles()->add_values("ads");
   AWAIT_EXPECT_EQ(false, authorizer.get()->authorize(request3));
 }
+
+
+// This test verifies that a batch of requests is decided in order by
+// the first ACL that matches each request, and that the (cached)
+// decisions of a repeated batch are the same.
+TEST_F(AuthorizationTest, RunTasksBatch)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  // Principal "foo" can run as "root".
+  mesos::ACL::RunTask* acl = acls.add_run_tasks();
+  acl->mutable_principals()->add_values("foo");
+  acl->mutable_users()->add_values("root");
+
+  // No other principal can run as "root".
+  acl = acls.add_run_tasks();
+  acl->mutable_principals()->set_type(mesos::ACL::Entity::NONE);
+  acl->mutable_users()->add_values("root");
+
+  // Any principal can run as any other user.
+  acl = acls.add_run_tasks();
+  acl->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  acl->mutable_users()->set_type(mesos::ACL::Entity::ANY);
+
+  // Create an Authorizer with the ACLs.
+  Try<Owned<LocalAuthorizer> > authorizer = LocalAuthorizer::create(acls);
+  ASSERT_SOME(authorizer);
+
+  std::list<mesos::ACL::RunTask> requests;
+
+  mesos::ACL::RunTask request;
+  request.mutable_principals()->add_values("foo");
+  request.mutable_users()->add_values("root");
+  requests.push_back(request);
+
+  request.mutable_principals()->set_values(0, "bar");
+  requests.push_back(request);
+
+  request.mutable_users()->set_values(0, "guest");
+  requests.push_back(request);
+
+  request.mutable_principals()->set_values(0, "foo");
+  requests.push_back(request);
+
+  // A framework without a principal cannot run as "root".
+  request.mutable_principals()->Clear();
+  request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  request.mutable_users()->set_values(0, "root");
+  requests.push_back(request);
+
+  std::list<bool> expected;
+  expected.push_back(true);
+  expected.push_back(false);
+  expected.push_back(true);
+  expected.push_back(true);
+  expected.push_back(false);
+
+  AWAIT_EXPECT_EQ(expected, authorizer.get()->authorize(requests));
+  AWAIT_EXPECT_EQ(expected, authorizer.get()->authorize(requests));
+
+  // The batch agrees with the requests authorized one at a time.
+  foreach (const mesos::ACL::RunTask& request, requests) {
+    AWAIT_EXPECT_EQ(expected.front(), authorizer.get()->authorize(request));
+    expected.pop_front();
+  }
+}
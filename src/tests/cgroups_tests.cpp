@@ -37,9 +37,11 @@
 #include <gmock/gmock.h>
 
 #include <process/gtest.hpp>
+#include <process/http.hpp>
 
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
@@ -951,6 +953,84 @@ TEST_F(CgroupsAnyHierarchyWithFreezerTest, ROOT_CGROUPS_DestroyTracedProcess)
 }
 
 
+TEST_F(CgroupsAnyHierarchyWithFreezerTest, ROOT_CGROUPS_DestroyBatch)
+{
+  std::string hierarchy = path::join(baseHierarchy, "freezer");
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  // Create a few cgroups (one of them with a nested cgroup) with a
+  // process in each of them.
+  std::vector<std::string> cgroups;
+  std::vector<pid_t> pids;
+
+  for (int i = 0; i < 4; i++) {
+    std::string cgroup = path::join(TEST_CGROUPS_ROOT, stringify(i));
+    ASSERT_SOME(cgroups::create(hierarchy, cgroup));
+
+    std::string nested = cgroup;
+    if (i == 0) {
+      nested = path::join(cgroup, "nested");
+      ASSERT_SOME(cgroups::create(hierarchy, nested));
+    }
+
+    pid_t pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+      // In child process.
+      while (true) { sleep(1); }
+
+      ABORT("Child should not reach this statement");
+    }
+
+    // In parent process.
+    ASSERT_SOME(cgroups::assign(hierarchy, nested, pid));
+
+    cgroups.push_back(cgroup);
+    pids.push_back(pid);
+  }
+
+  // Destroy the cgroups concurrently so that they are destroyed as
+  // one batch.
+  std::vector<Future<Nothing> > destroys;
+  foreach (const std::string& cgroup, cgroups) {
+    destroys.push_back(cgroups::destroy(hierarchy, cgroup));
+  }
+
+  for (size_t i = 0; i < cgroups.size(); i++) {
+    AWAIT_READY(destroys[i]);
+    EXPECT_FALSE(os::exists(path::join(hierarchy, cgroups[i])));
+  }
+
+  // The teardown latency of each of the cgroups is reported.
+  Future<http::Response> response =
+    http::get(UPID("metrics", process::node()), "snapshot");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Number> count =
+    parse.get().find<JSON::Number>("cgroups/destroy_latency_ms/count");
+
+  ASSERT_SOME(count);
+  EXPECT_LE(cgroups.size(), count.get().value);
+  EXPECT_SOME(
+      parse.get().find<JSON::Number>("cgroups/destroy_latency_ms"));
+
+  // cgroups::destroy will reap all processes in the cgroups so we
+  // should *not* be able to reap them now.
+  foreach (pid_t pid, pids) {
+    int status;
+    EXPECT_EQ(-1, ::waitpid(pid, &status, 0));
+    EXPECT_EQ(ECHILD, errno);
+  }
+
+  // The parent cgroup is left untouched.
+  EXPECT_TRUE(os::exists(path::join(hierarchy, TEST_CGROUPS_ROOT)));
+}
+
+
 class CgroupsAnyHierarchyWithPerfEventTest
   : public CgroupsAnyHierarchyTest
 {
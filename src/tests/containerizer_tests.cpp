@@ -16,15 +16,25 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
+#include <list>
 #include <map>
 #include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/owned.hpp>
+#include <process/subprocess.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
 #include <mesos/mesos.hpp>
@@ -36,6 +46,7 @@
 #include "slave/containerizer/launcher.hpp"
 
 #include "slave/containerizer/mesos/containerizer.hpp"
+#include "slave/containerizer/mesos/zygote.hpp"
 
 #include "tests/flags.hpp"
 #include "tests/isolator.hpp"
@@ -45,6 +56,7 @@
 using namespace mesos;
 using namespace mesos::slave;
 
+using std::list;
 using std::map;
 using std::string;
 using std::vector;
@@ -53,6 +65,7 @@ using testing::_;
 using testing::DoAll;
 using testing::Invoke;
 using testing::Return;
+using testing::WithParamInterface;
 
 class MesosContainerizerIsolatorPreparationTest :
   public tests::TemporaryDirectoryTest
@@ -402,3 +415,184 @@ TEST_F(MesosContainerizerDestroyTest, DestroyWhileFetching)
   // The container should still exit even if fetch didn't complete.
   AWAIT_READY(wait);
 }
+
+
+class MesosContainerizerZygoteTest : public tests::TemporaryDirectoryTest {};
+
+
+TEST_F(MesosContainerizerZygoteTest, Fork)
+{
+  Try<Zygote*> create = Zygote::create(
+      path::join(tests::flags.build_dir, "src", "mesos-containerizer"));
+  ASSERT_SOME(create);
+
+  process::Owned<Zygote> zygote(create.get());
+
+  // The child should inherit the descriptors we pass along, under
+  // the same number.
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  string out = path::join(os::getcwd(), "stdout");
+
+  vector<string> argv;
+  argv.push_back("sh");
+  argv.push_back("-c");
+  argv.push_back(
+      "echo hello; echo world >&" + stringify(pipes[1]) + "; exit 3");
+
+  vector<int> inherit;
+  inherit.push_back(pipes[1]);
+
+  Result<pid_t> pid = zygote->fork(
+      "sh",
+      argv,
+      process::Subprocess::FD(STDIN_FILENO),
+      process::Subprocess::PATH(out),
+      process::Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      inherit);
+
+  ASSERT_SOME(pid);
+
+  os::close(pipes[1]);
+
+  process::Future<Option<int> > status = zygote->status(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(3, WEXITSTATUS(status.get().get()));
+
+  EXPECT_SOME_EQ("hello\n", os::read(out));
+  EXPECT_SOME_EQ("world\n", os::read(pipes[0], 6));
+
+  os::close(pipes[0]);
+}
+
+
+// Verifies that a fork fails rather than blocking forever if the
+// helper doesn't reply, and that later forks are left to the caller.
+TEST_F(MesosContainerizerZygoteTest, Unresponsive)
+{
+  // A helper that consumes the requests without ever replying.
+  const string helper = path::join(os::getcwd(), "zygote");
+
+  ASSERT_SOME(os::write(
+      helper,
+      "#!/bin/sh\n"
+      "for arg; do\n"
+      "  case $arg in --control=*) control=${arg#--control=};; esac\n"
+      "done\n"
+      "exec cat <&$control >/dev/null\n"));
+
+  ASSERT_SOME(os::chmod(helper, S_IRWXU));
+
+  Try<Zygote*> create = Zygote::create(helper);
+  ASSERT_SOME(create);
+
+  process::Owned<Zygote> zygote(create.get());
+
+  vector<string> argv;
+  argv.push_back("true");
+
+  Result<pid_t> pid = zygote->fork(
+      "true",
+      argv,
+      process::Subprocess::FD(STDIN_FILENO),
+      process::Subprocess::FD(STDOUT_FILENO),
+      process::Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      vector<int>());
+
+  EXPECT_ERROR(pid);
+
+  pid = zygote->fork(
+      "true",
+      argv,
+      process::Subprocess::FD(STDIN_FILENO),
+      process::Subprocess::FD(STDOUT_FILENO),
+      process::Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      vector<int>());
+
+  EXPECT_NONE(pid);
+}
+
+
+class Launcher_BENCHMARK_Test
+  : public tests::TemporaryDirectoryTest,
+    public WithParamInterface<bool>
+{};
+
+
+// The launcher benchmark is parameterized by whether the children
+// are forked from the zygote or from the slave itself.
+INSTANTIATE_TEST_CASE_P(
+    Zygote,
+    Launcher_BENCHMARK_Test,
+    ::testing::Bool());
+
+
+// Measures the latency of forking executors while the slave has a
+// large resident set, which is what makes forking from the slave
+// expensive.
+TEST_P(Launcher_BENCHMARK_Test, ForkLatency)
+{
+  // Simulate the resident set of a long running slave; every page
+  // is touched so that fork() has to copy its page table entries.
+  const Bytes rss = Gigabytes(1);
+  vector<char> memory(rss.bytes(), 1);
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.launcher_zygote = GetParam();
+
+  Try<Launcher*> create = PosixLauncher::create(flags);
+  ASSERT_SOME(create);
+
+  process::Owned<Launcher> launcher(create.get());
+
+  const size_t count = 100;
+
+  vector<string> argv;
+  argv.push_back("true");
+
+  list<process::Future<Option<int> > > statuses;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    ContainerID containerId;
+    containerId.set_value("container" + stringify(i));
+
+    Try<pid_t> pid = launcher->fork(
+        containerId,
+        "true",
+        argv,
+        process::Subprocess::FD(STDIN_FILENO),
+        process::Subprocess::FD(STDOUT_FILENO),
+        process::Subprocess::FD(STDERR_FILENO),
+        None(),
+        None(),
+        vector<int>(),
+        None());
+
+    ASSERT_SOME(pid);
+
+    statuses.push_back(launcher->status(pid.get()));
+  }
+
+  Duration elapsed = watch.elapsed();
+
+  AWAIT_READY_FOR(process::collect(statuses), Minutes(1));
+
+  LOG(INFO) << "Forked " << count << " children from the "
+            << (GetParam() ? "zygote" : "slave") << " with a resident set of "
+            << rss << " in " << elapsed << " ("
+            << elapsed / count << " per fork)";
+}
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -24,13 +25,17 @@
 #include <mesos/mesos.hpp>
 #include <mesos/resources.hpp>
 
+#include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/owned.hpp>
 #include <process/pid.hpp>
+#include <process/timeout.hpp>
 
 #include <stout/fs.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/master.hpp"
 
@@ -60,6 +65,7 @@ using testing::Return;
 using mesos::master::Master;
 
 using mesos::slave::DiskUsageCollector;
+using mesos::slave::DiskUsageTracker;
 using mesos::slave::Fetcher;
 using mesos::slave::MesosContainerizer;
 using mesos::slave::Slave;
@@ -141,6 +147,177 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+#ifdef __linux__
+class DiskUsageTrackerTest : public TemporaryDirectoryTest
+{
+protected:
+  // Returns the usage of 'path' once it is at least 'min' and less
+  // than 'max', or else the last usage reported within 'timeout'.
+  static Future<Bytes> awaitUsage(
+      DiskUsageTracker* tracker,
+      const string& path,
+      const Bytes& min,
+      const Bytes& max = Bytes(std::numeric_limits<uint64_t>::max()),
+      const Duration& timeout = Seconds(15))
+  {
+    Timeout deadline = Timeout::in(timeout);
+
+    Future<Bytes> usage;
+    do {
+      // NOTE: This completes with the next report.
+      usage = tracker->usage(path);
+      if (!usage.await(deadline.remaining()) || !usage.isReady()) {
+        break;
+      }
+    } while ((usage.get() < min || usage.get() >= max) &&
+             !deadline.expired());
+
+    return usage;
+  }
+};
+
+
+// This test verifies the usage of a file.
+TEST_F(DiskUsageTrackerTest, File)
+{
+  string path = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(path, string(Kilobytes(8).bytes(), 'x')));
+
+  Try<DiskUsageTracker*> create =
+    DiskUsageTracker::create(Milliseconds(1), Minutes(15));
+  ASSERT_SOME(create);
+
+  Owned<DiskUsageTracker> tracker(create.get());
+
+  Future<Bytes> usage = tracker->usage(path);
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+  EXPECT_LT(usage.get(), Kilobytes(16));
+
+  // Changing the file should be noticed without a full re-scan.
+  ASSERT_SOME(os::write(path, string(Kilobytes(64).bytes(), 'x')));
+
+  usage = awaitUsage(tracker.get(), path, Kilobytes(64));
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(64));
+}
+
+
+// This test verifies that the usage of a directory is updated as
+// files and subdirectories come and go.
+TEST_F(DiskUsageTrackerTest, Directory)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::write(path::join(dir, "file1"), string(8192, 'x')));
+
+  Try<DiskUsageTracker*> create =
+    DiskUsageTracker::create(Milliseconds(1), Minutes(15));
+  ASSERT_SOME(create);
+
+  Owned<DiskUsageTracker> tracker(create.get());
+
+  Future<Bytes> usage = tracker->usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+  EXPECT_LT(usage.get(), Kilobytes(64));
+
+  // Create a new (nested) subdirectory with a large file.
+  string nested = path::join(os::getcwd(), "a", "b");
+  ASSERT_SOME(os::mkdir(nested));
+  ASSERT_SOME(os::write(
+      path::join(nested, "file2"),
+      string(Kilobytes(128).bytes(), 'y')));
+
+  usage = awaitUsage(tracker.get(), os::getcwd(), Kilobytes(136));
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(136));
+
+  // Remove the subdirectory again.
+  ASSERT_SOME(os::rmdir(path::join(os::getcwd(), "a")));
+
+  usage =
+    awaitUsage(tracker.get(), os::getcwd(), Bytes(0), Kilobytes(64));
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+  EXPECT_LT(usage.get(), Kilobytes(64));
+}
+
+
+// This test verifies that symbolic links are not followed.
+TEST_F(DiskUsageTrackerTest, SymbolicLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  // Create a symbolic link to the current directory.
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_SOME(fs::symlink(os::getcwd(), link));
+
+  Try<DiskUsageTracker*> create =
+    DiskUsageTracker::create(Milliseconds(1), Minutes(15));
+  ASSERT_SOME(create);
+
+  Owned<DiskUsageTracker> tracker(create.get());
+
+  Future<Bytes> usage1 = tracker->usage(os::getcwd());
+  Future<Bytes> usage2 = tracker->usage(link);
+
+  AWAIT_READY(usage1);
+  EXPECT_GE(usage1.get(), Kilobytes(64));
+  EXPECT_LT(usage1.get(), Kilobytes(128));
+
+  AWAIT_READY(usage2);
+  EXPECT_LT(usage2.get(), Kilobytes(64));
+}
+
+// This test verifies that the usage stays up to date while paths are
+// continuously re-scanned in the background.
+TEST_F(DiskUsageTrackerTest, Reconciliation)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  ASSERT_SOME(os::mkdir(path::join(dir, "a", "b")));
+  ASSERT_SOME(os::write(path::join(dir, "file1"), string(8192, 'x')));
+
+  Try<DiskUsageTracker*> create =
+    DiskUsageTracker::create(Milliseconds(1), Milliseconds(1));
+  ASSERT_SOME(create);
+
+  Owned<DiskUsageTracker> tracker(create.get());
+
+  Future<Bytes> usage = tracker->usage(dir);
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+  EXPECT_LT(usage.get(), Kilobytes(64));
+
+  for (int i = 0; i < 16; i++) {
+    ASSERT_SOME(os::write(
+        path::join(dir, "a", "b", "file" + stringify(i)),
+        string(Kilobytes(8).bytes(), 'y')));
+  }
+
+  usage = awaitUsage(tracker.get(), dir, Kilobytes(136));
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(136));
+
+  ASSERT_SOME(os::rmdir(path::join(dir, "a")));
+
+  usage = awaitUsage(tracker.get(), dir, Bytes(0), Kilobytes(64));
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+  EXPECT_LT(usage.get(), Kilobytes(64));
+}
+#endif // __linux__
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
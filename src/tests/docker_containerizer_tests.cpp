@@ -21,10 +21,13 @@
 
 #include <process/future.hpp>
 #include <process/gmock.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/json.hpp>
+#include <stout/option.hpp>
 
 #include "linux/cgroups.hpp"
 
@@ -150,6 +153,33 @@ public:
   }
 
 
+  // Returns the value of the specified metric, if it is present.
+  static Option<double> metric(const string& name)
+  {
+    Future<process::http::Response> response =
+      process::http::get(UPID("metrics", process::node()), "snapshot");
+
+    if (!response.await(Seconds(15)) || !response.isReady()) {
+      return None();
+    }
+
+    Try<JSON::Object> parse =
+      JSON::parse<JSON::Object>(response.get().body);
+
+    if (parse.isError()) {
+      return None();
+    }
+
+    Result<JSON::Number> value = parse.get().find<JSON::Number>(name);
+
+    if (!value.isSome()) {
+      return None();
+    }
+
+    return value.get().value;
+  }
+
+
   virtual void TearDown()
   {
     Try<Docker*> docker = Docker::create(tests::flags.docker, false);
@@ -1128,6 +1158,142 @@ TEST_F(DockerContainerizerTest, ROOT_DOCKER_Update)
 #endif //__linux__
 
 
+#ifdef __linux__
+// This test verifies that updating a container with the resources it
+// already has doesn't touch its cgroups, and that the cgroups and
+// limits cached for the container are dropped once it is destroyed.
+TEST_F(DockerContainerizerTest, ROOT_DOCKER_UpdateSkipped)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+
+  MockDocker* mockDocker = new MockDocker(tests::flags.docker);
+  Shared<Docker> docker(mockDocker);
+
+  // We need to capture and await on the logs process's future so that
+  // we can ensure there is no child process at the end of the test.
+  // The logs future is being awaited at teardown.
+  Future<Nothing> logs;
+  EXPECT_CALL(*mockDocker, logs(_, _))
+    .WillOnce(FutureResult(&logs,
+                           Invoke((MockDocker*) docker.get(),
+                                  &MockDocker::_logs)));
+
+  Fetcher fetcher;
+
+  MockDockerContainerizer dockerContainerizer(flags, &fetcher, docker);
+
+  Try<PID<Slave> > slave = StartSlave(&dockerContainerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  const Offer& offer = offers.get()[0];
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("1");
+  task.mutable_slave_id()->CopyFrom(offer.slave_id());
+  task.mutable_resources()->CopyFrom(offer.resources());
+
+  CommandInfo command;
+  command.set_value("sleep 1000");
+
+  ContainerInfo containerInfo;
+  containerInfo.set_type(ContainerInfo::DOCKER);
+
+  ContainerInfo::DockerInfo dockerInfo;
+  dockerInfo.set_image("busybox");
+  containerInfo.mutable_docker()->CopyFrom(dockerInfo);
+
+  task.mutable_command()->CopyFrom(command);
+  task.mutable_container()->CopyFrom(containerInfo);
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  Future<ContainerID> containerId;
+  EXPECT_CALL(dockerContainerizer, launch(_, _, _, _, _, _, _, _))
+    .WillOnce(DoAll(FutureArg<0>(&containerId),
+                    Invoke(&dockerContainerizer,
+                           &MockDockerContainerizer::_launch)));
+
+  Future<TaskStatus> statusRunning;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning))
+    .WillRepeatedly(DoDefault());
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(containerId);
+
+  AWAIT_READY_FOR(statusRunning, Seconds(60));
+  EXPECT_EQ(TASK_RUNNING, statusRunning.get().state());
+
+  Try<Resources> resources = Resources::parse("cpus:1;mem:128");
+  ASSERT_SOME(resources);
+
+  // The first update changes the limits of the container.
+  AWAIT_READY(dockerContainerizer.update(containerId.get(), resources.get()));
+
+  Option<double> skipped = metric("containerizer/docker/updates_skipped");
+  ASSERT_SOME(skipped);
+
+  EXPECT_SOME(metric("containerizer/docker/update_ms"));
+
+  // The second update with the same resources is skipped.
+  AWAIT_READY(dockerContainerizer.update(containerId.get(), resources.get()));
+
+  EXPECT_SOME_EQ(
+      skipped.get() + 1,
+      metric("containerizer/docker/updates_skipped"));
+
+  Future<containerizer::Termination> termination =
+    dockerContainerizer.wait(containerId.get());
+
+  dockerContainerizer.destroy(containerId.get());
+
+  AWAIT_READY(termination);
+
+  // Once the container is destroyed nothing is left to compare the
+  // resources with, so the update is ignored rather than skipped.
+  AWAIT_READY(dockerContainerizer.update(containerId.get(), resources.get()));
+
+  EXPECT_SOME_EQ(
+      skipped.get() + 1,
+      metric("containerizer/docker/updates_skipped"));
+
+  driver.stop();
+  driver.join();
+
+  // See above where we assign logs future for more comments.
+  AWAIT_READY_FOR(logs, Seconds(30));
+
+  Shutdown();
+}
+#endif //__linux__
+
+
 // Disabling recover test as the docker rm in recover is async.
 // Even though we wait for the container to finish, when the wait
 // returns docker rm might still be in progress.
@@ -16,23 +16,45 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include <gtest/gtest.h>
 
+#include <boost/shared_array.hpp>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/io.hpp>
 #include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
+#include <stout/os.hpp>
 #include <stout/gtest.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
 
 #include "docker/docker.hpp"
+#include "docker/remote.hpp"
 
 #include "mesos/resources.hpp"
 
 #include "tests/environment.hpp"
 #include "tests/flags.hpp"
+#include "tests/utils.hpp"
 
 using namespace mesos;
 using namespace mesos::tests;
@@ -41,6 +63,7 @@ using namespace process;
 
 using std::list;
 using std::string;
+using std::vector;
 
 
 // This test tests the functionality of the docker's interfaces.
@@ -315,3 +338,481 @@ TEST(DockerTest, ROOT_DOCKER_CancelPull)
 
   AWAIT_DISCARDED(future);
 }
+
+
+// A fake Docker daemon that serves a canned subset of the Docker
+// Remote API on a UNIX socket, used to test RemoteDocker without a
+// docker daemon. It records every request it receives.
+class FakeDockerDaemonProcess : public Process<FakeDockerDaemonProcess>
+{
+public:
+  explicit FakeDockerDaemonProcess(int _s) : s(_s), accepted(0) {}
+
+  virtual ~FakeDockerDaemonProcess() {}
+
+  void add(const string& id, const string& name, pid_t pid)
+  {
+    JSON::Object container;
+    container.values["Id"] = id;
+    container.values["Name"] = "/" + name;
+
+    JSON::Object state;
+    state.values["Pid"] = pid;
+    container.values["State"] = state;
+
+    containers[id] = container;
+    containers[name] = container;
+    names[id] = name;
+  }
+
+  // Returns the received requests, e.g., 'GET /v1.15/version'.
+  vector<string> requests() { return received; }
+
+  // Returns the body of the last request to 'request'.
+  string body(const string& request) { return bodies[request]; }
+
+  int connections() { return accepted; }
+
+  // Returns a future satisfied once a client closed a connection.
+  Future<Nothing> disconnected() { return closed.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    accept();
+  }
+
+  virtual void finalize()
+  {
+    os::close(s);
+  }
+
+private:
+  void accept()
+  {
+    io::poll(s, io::READ)
+      .onAny(defer(self(), &FakeDockerDaemonProcess::_accept));
+  }
+
+  void _accept()
+  {
+    int c = ::accept(s, NULL, NULL);
+    if (c >= 0) {
+      CHECK_SOME(os::nonblock(c));
+      accepted++;
+
+      read(c, "");
+    }
+
+    accept();
+  }
+
+  void read(int c, const string& buffer)
+  {
+    boost::shared_array<char> data(new char[io::BUFFERED_READ_SIZE]);
+
+    io::read(c, data.get(), io::BUFFERED_READ_SIZE)
+      .onAny(defer(self(),
+                   &FakeDockerDaemonProcess::_read,
+                   c,
+                   buffer,
+                   data,
+                   lambda::_1));
+  }
+
+  void _read(
+      int c,
+      string buffer,
+      const boost::shared_array<char>& data,
+      const Future<size_t>& length)
+  {
+    if (!length.isReady() || length.get() == 0) {
+      os::close(c);
+      closed.set(Nothing());
+      return;
+    }
+
+    buffer.append(data.get(), length.get());
+
+    // Respond to every complete (possibly pipelined) request.
+    string responses;
+
+    // Whether to send the responses in two parts.
+    bool split = false;
+
+    while (true) {
+      size_t end = buffer.find("\r\n\r\n");
+      if (end == string::npos) {
+        break;
+      }
+
+      vector<string> lines = strings::split(buffer.substr(0, end), "\r\n");
+
+      size_t contentLength = 0;
+      foreach (const string& line, lines) {
+        if (strings::startsWith(line, "Content-Length: ")) {
+          contentLength = numify<size_t>(
+              line.substr(strlen("Content-Length: "))).get();
+        }
+      }
+
+      if (buffer.size() < end + 4 + contentLength) {
+        break;
+      }
+
+      // Strip the 'HTTP/1.1' from the request line.
+      const string request = lines[0].substr(0, lines[0].rfind(' '));
+
+      received.push_back(request);
+      bodies[request] = buffer.substr(end + 4, contentLength);
+
+      responses += respond(request);
+
+      if (strings::contains(request, "/mesos-split/")) {
+        split = true;
+      }
+
+      buffer.erase(0, end + 4 + contentLength);
+    }
+
+    if (responses.empty()) {
+      read(c, buffer);
+      return;
+    }
+
+    if (split) {
+      // End the first part in the middle of the status line and give
+      // the client some time to read it on its own.
+      io::write(c, responses.substr(0, 11))
+        .onAny(defer(self(),
+                     &FakeDockerDaemonProcess::write,
+                     c,
+                     responses.substr(11),
+                     buffer,
+                     Milliseconds(50)));
+      return;
+    }
+
+    write(c, responses, buffer, Duration::zero());
+  }
+
+  void write(
+      int c,
+      const string& responses,
+      const string& buffer,
+      const Duration& after)
+  {
+    if (after > Duration::zero()) {
+      delay(after,
+            self(),
+            &FakeDockerDaemonProcess::write,
+            c,
+            responses,
+            buffer,
+            Duration::zero());
+      return;
+    }
+
+    io::write(c, responses)
+      .onAny(defer(self(), &FakeDockerDaemonProcess::read, c, buffer));
+  }
+
+  static string response(const string& status, const string& body = "")
+  {
+    return "HTTP/1.1 " + status + "\r\n" +
+      "Content-Type: application/json\r\n" +
+      "Content-Length: " + stringify(body.size()) + "\r\n" +
+      "\r\n" + body;
+  }
+
+  string respond(const string& request)
+  {
+    const string prefix = "/" + DOCKER_API_VERSION;
+
+    vector<string> tokens = strings::split(request, " ");
+    const string& method = tokens[0];
+    const string path = strings::remove(tokens[1], prefix, strings::PREFIX);
+
+    if (method == "GET" && strings::startsWith(path, "/containers/json")) {
+      JSON::Array array;
+      foreachpair (const string& id, const string& name, names) {
+        JSON::Object container;
+        container.values["Id"] = id;
+
+        JSON::Array names;
+        names.values.push_back("/" + name);
+        container.values["Names"] = names;
+
+        array.values.push_back(container);
+      }
+      return response("200 OK", stringify(array));
+    }
+
+    if (method == "GET" && strings::contains(path, "/logs?follow=1") &&
+        strings::contains(path, "/mesos-follow/")) {
+      // A stream that is never closed, see docker#7020.
+      return string("HTTP/1.1 200 OK\r\n") +
+        "Transfer-Encoding: chunked\r\n" +
+        "\r\n" +
+        "c\r\n" +
+        string("\x01\x00\x00\x00\x00\x00\x00\x04", 8) + "out\n" +
+        "\r\n";
+    }
+
+    if (method == "GET" && strings::contains(path, "/logs?follow=1")) {
+      // Chunked, multiplexed stream of one stdout and one stderr
+      // frame, with the chunks not aligned to the frames.
+      string frames;
+      frames += string("\x01\x00\x00\x00\x00\x00\x00\x04", 8) + "out\n";
+      frames += string("\x02\x00\x00\x00\x00\x00\x00\x04", 8) + "err\n";
+
+      return string("HTTP/1.1 200 OK\r\n") +
+        "Transfer-Encoding: chunked\r\n" +
+        "\r\n" +
+        "a\r\n" + frames.substr(0, 10) + "\r\n" +
+        "e\r\n" + frames.substr(10) + "\r\n" +
+        "0\r\n" +
+        "\r\n";
+    }
+
+    if (method == "GET" && strings::startsWith(path, "/containers/")) {
+      const string id = strings::tokenize(path, "/")[1];
+      if (!containers.contains(id)) {
+        return response("404 Not Found", "No such container: " + id);
+      }
+      return response("200 OK", stringify(containers[id]));
+    }
+
+    if (method == "POST" && strings::startsWith(path, "/containers/create")) {
+      return response("201 Created", "{\"Id\":\"4444\"}");
+    }
+
+    if (method == "POST" && strings::endsWith(path, "/start")) {
+      return response("204 No Content");
+    }
+
+    if (method == "POST" && strings::endsWith(path, "/wait")) {
+      return response("200 OK", "{\"StatusCode\":0}");
+    }
+
+    if (method == "DELETE" && strings::startsWith(path, "/containers/")) {
+      return response("204 No Content");
+    }
+
+    return response("404 Not Found", "page not found");
+  }
+
+  const int s;
+  int accepted;
+  Promise<Nothing> closed;
+
+  hashmap<string, JSON::Object> containers;
+  hashmap<string, string> names;
+
+  vector<string> received;
+  hashmap<string, string> bodies;
+};
+
+
+class RemoteDockerTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    socket = path::join(os::getcwd(), "docker.sock");
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    ASSERT_LT(socket.size(), sizeof(addr.sun_path));
+
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket.c_str(), sizeof(addr.sun_path) - 1);
+
+    Try<int> s = network::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_SOME(s);
+
+    ASSERT_EQ(0, ::bind(s.get(), (sockaddr*) &addr, sizeof(addr)));
+    ASSERT_EQ(0, ::listen(s.get(), 16));
+    ASSERT_SOME(os::nonblock(s.get()));
+
+    daemon = new FakeDockerDaemonProcess(s.get());
+    spawn(daemon);
+
+    Try<Docker*> create = RemoteDocker::create("docker", socket, false);
+    ASSERT_SOME(create);
+
+    docker.reset(create.get());
+  }
+
+  virtual void TearDown()
+  {
+    docker.reset();
+
+    terminate(daemon);
+    process::wait(daemon);
+    delete daemon;
+
+    // NOTE: os::rmdir does not remove sockets.
+    ASSERT_SOME(os::rm(socket));
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  string socket;
+  FakeDockerDaemonProcess* daemon;
+  Owned<Docker> docker;
+};
+
+
+// Tests that 'ps' lists the containers and inspects the matching
+// ones over a single pipelined connection.
+TEST_F(RemoteDockerTest, Ps)
+{
+  dispatch(daemon, &FakeDockerDaemonProcess::add, "1111", "mesos-1", 101);
+  dispatch(daemon, &FakeDockerDaemonProcess::add, "2222", "mesos-2", 102);
+  dispatch(daemon, &FakeDockerDaemonProcess::add, "3333", "other", 103);
+
+  Future<list<Docker::Container> > containers = docker->ps(true, "mesos-");
+  AWAIT_READY(containers);
+
+  ASSERT_EQ(2u, containers.get().size());
+
+  foreach (const Docker::Container& container, containers.get()) {
+    ASSERT_SOME(container.pid);
+
+    if (container.id == "1111") {
+      EXPECT_EQ("/mesos-1", container.name);
+      EXPECT_EQ(101, container.pid.get());
+    } else {
+      EXPECT_EQ("2222", container.id);
+      EXPECT_EQ("/mesos-2", container.name);
+      EXPECT_EQ(102, container.pid.get());
+    }
+  }
+
+  Future<vector<string> > requests =
+    dispatch(daemon, &FakeDockerDaemonProcess::requests);
+  AWAIT_READY(requests);
+
+  ASSERT_EQ(3u, requests.get().size());
+  EXPECT_EQ("GET /v1.15/containers/json?all=1", requests.get()[0]);
+
+  AWAIT_EXPECT_EQ(1, dispatch(daemon, &FakeDockerDaemonProcess::connections));
+
+  AWAIT_FAILED(docker->inspect("unknown"));
+}
+
+
+TEST_F(RemoteDockerTest, RunAndRemove)
+{
+  ContainerInfo containerInfo;
+  containerInfo.set_type(ContainerInfo::DOCKER);
+  containerInfo.mutable_docker()->set_image("busybox");
+
+  CommandInfo commandInfo;
+  commandInfo.set_shell(false);
+  commandInfo.set_value("sleep");
+  commandInfo.add_arguments("120");
+
+  AWAIT_READY(docker->run(
+      containerInfo,
+      commandInfo,
+      "mesos-run",
+      "/sandbox",
+      "/mnt/mesos/sandbox",
+      Resources::parse("cpus:1;mem:512").get()));
+
+  const string create = "POST /v1.15/containers/create?name=mesos-run";
+
+  Future<string> body =
+    dispatch(daemon, &FakeDockerDaemonProcess::body, create);
+  AWAIT_READY(body);
+
+  Try<JSON::Object> config = JSON::parse<JSON::Object>(body.get());
+  ASSERT_SOME(config);
+
+  EXPECT_SOME_EQ(
+      JSON::String("busybox"),
+      config.get().find<JSON::String>("Image"));
+  EXPECT_SOME_EQ(
+      JSON::Number(1024),
+      config.get().find<JSON::Number>("CpuShares"));
+  EXPECT_SOME_EQ(
+      JSON::Number(Megabytes(512).bytes()),
+      config.get().find<JSON::Number>("Memory"));
+  EXPECT_SOME_EQ(
+      JSON::String("sleep"),
+      config.get().find<JSON::String>("Cmd[0]"));
+  EXPECT_SOME_EQ(
+      JSON::String("/sandbox:/mnt/mesos/sandbox"),
+      config.get().find<JSON::String>("HostConfig.Binds[0]"));
+
+  AWAIT_READY(docker->rm("mesos-run", true));
+
+  Future<vector<string> > requests =
+    dispatch(daemon, &FakeDockerDaemonProcess::requests);
+  AWAIT_READY(requests);
+
+  ASSERT_EQ(3u, requests.get().size());
+  EXPECT_EQ(create, requests.get()[0]);
+  EXPECT_EQ("POST /v1.15/containers/mesos-run/start", requests.get()[1]);
+  EXPECT_EQ("DELETE /v1.15/containers/mesos-run?force=1", requests.get()[2]);
+}
+
+
+// Tests that the multiplexed logs stream is written into the
+// 'stdout' and 'stderr' files of the sandbox.
+TEST_F(RemoteDockerTest, Logs)
+{
+  AWAIT_READY(docker->logs("mesos-logs", os::getcwd()));
+
+  EXPECT_SOME_EQ("out\n", os::read(path::join(os::getcwd(), "stdout")));
+  EXPECT_SOME_EQ("err\n", os::read(path::join(os::getcwd(), "stderr")));
+}
+
+
+// Tests that following the logs copes with reads that end before the
+// status line and headers of the response are complete.
+TEST_F(RemoteDockerTest, LogsPartialResponse)
+{
+  AWAIT_READY(docker->logs("mesos-split", os::getcwd()));
+
+  EXPECT_SOME_EQ("out\n", os::read(path::join(os::getcwd(), "stdout")));
+  EXPECT_SOME_EQ("err\n", os::read(path::join(os::getcwd(), "stderr")));
+}
+
+
+// Tests that we stop following the logs of a container once it has
+// terminated and the flush delay has passed, even if the daemon never
+// closes the stream.
+TEST_F(RemoteDockerTest, LogsStreamNotClosed)
+{
+  Clock::pause();
+
+  Future<Nothing> logs = docker->logs("mesos-follow", os::getcwd());
+
+  // The connection used to wait for the container is closed once the
+  // container has terminated.
+  AWAIT_READY(dispatch(daemon, &FakeDockerDaemonProcess::disconnected));
+
+  EXPECT_TRUE(logs.isPending());
+
+  Clock::advance(DOCKER_LOGS_FLUSH_DELAY);
+
+  AWAIT_DISCARDED(logs);
+
+  EXPECT_SOME_EQ("out\n", os::read(path::join(os::getcwd(), "stdout")));
+
+  Future<vector<string> > requests =
+    dispatch(daemon, &FakeDockerDaemonProcess::requests);
+  AWAIT_READY(requests);
+
+  EXPECT_NE(requests.get().end(),
+            std::find(requests.get().begin(),
+                      requests.get().end(),
+                      "POST /v1.15/containers/mesos-follow/wait"));
+
+  Clock::resume();
+}
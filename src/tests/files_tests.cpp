@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <list>
 #include <string>
 
 #include <gmock/gmock.h>
@@ -25,11 +26,16 @@
 #include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include "files/files.hpp"
 
@@ -40,6 +46,8 @@ using namespace mesos::tests;
 
 using process::Future;
 
+using process::network::Socket;
+
 using process::http::BadRequest;
 using process::http::NotFound;
 using process::http::OK;
@@ -297,3 +305,144 @@ TEST_F(FilesTest, DownloadTest)
   AWAIT_EXPECT_RESPONSE_HEADER_EQ("image/gif", "Content-Type", response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(data, response);
 }
+
+
+// Receives from the socket until the received data contains the
+// expected string.
+static void receive(
+    const Socket& socket,
+    string* received,
+    const string& expected)
+{
+  while (!strings::contains(*received, expected)) {
+    char buffer[1024];
+    Future<size_t> length = socket.recv(buffer, sizeof(buffer));
+    AWAIT_READY(length);
+    ASSERT_NE(0u, length.get());
+    received->append(buffer, length.get());
+  }
+}
+
+
+TEST_F(FilesTest, StreamTest)
+{
+  Files files;
+  process::UPID upid("files", process::node());
+
+  ASSERT_SOME(os::write("file", "hello"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "stream"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "stream", "path=myname&offset=hello"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      NotFound().status,
+      process::http::get(upid, "stream", "path=missing"));
+
+  // Stream the file from the beginning and follow it, observing the
+  // chunks as they are received.
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket socket = create.get();
+
+  AWAIT_READY(socket.connect(upid.node));
+
+  const string request =
+    "GET /files/stream?path=myname&offset=0 HTTP/1.1\r\n"
+    "Host: " + stringify(upid.node) + "\r\n"
+    "\r\n";
+
+  AWAIT_READY(socket.send(request.data(), request.size()));
+
+  string received;
+
+  ASSERT_NO_FATAL_FAILURE(receive(socket, &received, "hello"));
+
+  EXPECT_TRUE(strings::startsWith(received, "HTTP/1.1 200 OK\r\n"));
+  EXPECT_TRUE(strings::contains(received, "Transfer-Encoding: chunked\r\n"));
+
+  // Appended data is streamed as well.
+  Try<int> fd = os::open("file", O_WRONLY | O_APPEND | O_CLOEXEC);
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::write(fd.get(), " world"));
+  os::close(fd.get());
+
+  ASSERT_NO_FATAL_FAILURE(receive(socket, &received, " world"));
+
+  // Removing the file ends the stream.
+  ASSERT_SOME(os::rm("file"));
+
+  ASSERT_NO_FATAL_FAILURE(receive(socket, &received, "0\r\n\r\n"));
+}
+
+
+#ifdef __linux__
+// Returns whether this process has 'path' open.
+static bool opened(const string& path)
+{
+  Try<std::list<string> > fds = os::ls("/proc/self/fd");
+  CHECK_SOME(fds);
+
+  foreach (const string& fd, fds.get()) {
+    Result<string> realpath = os::realpath(path::join("/proc/self/fd", fd));
+    if (realpath.isSome() && realpath.get() == path) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// Tests that a file stops being followed once the client went away,
+// even if the file doesn't change anymore.
+TEST_F(FilesTest, StreamClientGoneTest)
+{
+  Files files;
+  process::UPID upid("files", process::node());
+
+  ASSERT_SOME(os::write("file", "hello"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Result<string> path = os::realpath("file");
+  ASSERT_SOME(path);
+
+  {
+    Try<Socket> create = Socket::create();
+    ASSERT_SOME(create);
+
+    Socket socket = create.get();
+
+    AWAIT_READY(socket.connect(upid.node));
+
+    const string request =
+      "GET /files/stream?path=myname&offset=0 HTTP/1.1\r\n"
+      "Host: " + stringify(upid.node) + "\r\n"
+      "\r\n";
+
+    AWAIT_READY(socket.send(request.data(), request.size()));
+
+    string received;
+
+    ASSERT_NO_FATAL_FAILURE(receive(socket, &received, "hello"));
+
+    EXPECT_TRUE(opened(path.get()));
+
+    // Destroying the socket closes the connection.
+  }
+
+  Duration waited = Duration::zero();
+  while (opened(path.get()) && waited < Seconds(15)) {
+    os::sleep(Milliseconds(10));
+    waited += Milliseconds(10);
+  }
+
+  EXPECT_FALSE(opened(path.get()));
+}
+#endif // __linux__
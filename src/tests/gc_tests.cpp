@@ -36,8 +36,10 @@
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 
 #include "logging/logging.hpp"
 
@@ -64,6 +66,7 @@ using mesos::master::Master;
 
 using mesos::slave::GarbageCollector;
 using mesos::slave::GarbageCollectorProcess;
+using mesos::slave::GarbageCollectorWorkerProcess;
 using mesos::slave::Slave;
 
 using process::Clock;
@@ -246,6 +249,110 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
+// This test verifies that unscheduling a path that is being removed
+// only returns once the removal is done, so that nothing is created
+// under the path while it is being removed.
+TEST_F(GarbageCollectorTest, UnscheduleWhileRemoving)
+{
+  GarbageCollector gc;
+
+  const string& directory = "directory";
+
+  ASSERT_SOME(os::mkdir(directory));
+  ASSERT_SOME(os::touch(path::join(directory, "file")));
+
+  Clock::pause();
+
+  // Keep the removal of the directory from ever completing.
+  Future<Nothing> remove =
+    DROP_DISPATCH(_, &GarbageCollectorWorkerProcess::remove);
+
+  Future<Nothing> schedule = gc.schedule(Seconds(10), directory);
+
+  gc.prune(Seconds(10));
+
+  AWAIT_READY(remove);
+
+  Future<bool> unschedule = gc.unschedule(directory);
+
+  Clock::settle();
+
+  // The directory is being removed, so it can not be unscheduled
+  // anymore, but neither should the caller be told so before the
+  // removal is done.
+  EXPECT_TRUE(unschedule.isPending());
+  EXPECT_TRUE(schedule.isPending());
+
+  Clock::resume();
+}
+
+
+// This test verifies that the paths that are due the earliest are
+// removed first when pruning, that removals are rate limited and
+// that the reclaimed disk space is reported.
+TEST_F(GarbageCollectorTest, PruneRateLimited)
+{
+  // A single worker, removing at most one path per second.
+  GarbageCollector gc(1, 1.0);
+
+  // Make a directory and a file to prune.
+  const string& directory = "directory";
+  const string& file = "file";
+
+  ASSERT_SOME(os::mkdir(directory));
+  ASSERT_SOME(os::write(path::join(directory, "file"), string(8192, 'x')));
+  ASSERT_SOME(os::touch(file));
+
+  Clock::pause();
+
+  Future<Nothing> schedule1 = gc.schedule(Seconds(15), directory);
+  Future<Nothing> schedule2 = gc.schedule(Seconds(10), file);
+
+  // Prune both paths, the file being due the earliest.
+  gc.prune(Seconds(15));
+
+  AWAIT_READY(schedule2);
+  Clock::settle();
+
+  EXPECT_FALSE(os::exists(file));
+  EXPECT_TRUE(os::exists(directory));
+  ASSERT_TRUE(schedule1.isPending());
+
+  // The removal of the directory is permitted a second later.
+  Clock::advance(Seconds(1));
+
+  AWAIT_READY(schedule1);
+
+  EXPECT_FALSE(os::exists(directory));
+
+  Clock::resume();
+
+  process::UPID upid("metrics", process::node());
+
+  Future<process::http::Response> response =
+    process::http::get(upid, "snapshot");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  JSON::Object stats = parse.get();
+
+  EXPECT_SOME_EQ(
+      JSON::Number(2),
+      stats.find<JSON::Number>("slave/gc_paths_removed"));
+  EXPECT_SOME_EQ(
+      JSON::Number(0),
+      stats.find<JSON::Number>("slave/gc_paths_pending"));
+
+  Result<JSON::Number> reclaimed =
+    stats.find<JSON::Number>("slave/gc_bytes_reclaimed");
+
+  ASSERT_SOME(reclaimed);
+  EXPECT_LT(0, reclaimed.get().value);
+}
+
+
 class GarbageCollectorIntegrationTest : public MesosTest {};
 
 
@@ -21,7 +21,17 @@
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/gmock.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/node.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
+
+#include "health-check/health_checker.hpp"
+
+#include "messages/messages.hpp"
 
 #include "slave/slave.hpp"
 
@@ -45,7 +55,14 @@ using mesos::slave::Slave;
 
 using process::Clock;
 using process::Future;
+using process::Node;
 using process::PID;
+using process::Process;
+
+using process::http::OK;
+using process::http::Response;
+
+using process::network::Socket;
 
 using testing::_;
 using testing::AtMost;
@@ -98,14 +115,6 @@ public:
     CommandInfo command;
     command.set_value(cmd);
 
-    Environment::Variable* variable =
-      command.mutable_environment()->add_variables();
-
-    // We need to set the correct directory to launch health check process
-    // instead of the default for tests.
-    variable->set_name("MESOS_LAUNCHER_DIR");
-    variable->set_value(path::join(tests::flags.build_dir, "src"));
-
     task.mutable_command()->CopyFrom(command);
 
     HealthCheck healthCheck;
@@ -614,3 +623,132 @@ TEST_F(HealthCheckTest, DISABLED_GracePeriod)
 
   Shutdown();
 }
+
+
+// Serves the endpoint that the HTTP health checks are run against.
+class HealthProcess : public Process<HealthProcess>
+{
+public:
+  HealthProcess() : ProcessBase(process::ID::generate("health")) {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/ok", None(), &HealthProcess::ok);
+  }
+
+private:
+  Future<Response> ok(const process::http::Request& request)
+  {
+    return OK();
+  }
+};
+
+
+// Tests that HTTP health checks are performed in-process, against the
+// port on localhost, and that unexpected response statuses fail them.
+TEST(HealthCheckerTest, HTTP)
+{
+  HealthProcess process;
+  PID<HealthProcess> pid = spawn(process);
+
+  HealthChecker checker;
+
+  HealthCheck check;
+  check.mutable_http()->set_port(pid.node.port);
+  check.mutable_http()->set_path("/" + pid.id + "/ok");
+  check.mutable_http()->add_statuses(200);
+  check.set_delay_seconds(0);
+  check.set_grace_period_seconds(0);
+  check.set_consecutive_failures(1);
+
+  TaskID taskId;
+  taskId.set_value("1");
+
+  Future<TaskHealthStatus> healthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  Future<Nothing> checking = checker.start(taskId, check, pid);
+
+  AWAIT_READY(healthy);
+  EXPECT_EQ(taskId, healthy.get().task_id());
+  EXPECT_TRUE(healthy.get().healthy());
+
+  // The health of a task can only be checked once.
+  AWAIT_FAILED(checker.start(taskId, check, pid));
+
+  check.mutable_http()->set_statuses(0, 404);
+  taskId.set_value("2");
+
+  Future<TaskHealthStatus> unhealthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  Future<Nothing> failing = checker.start(taskId, check, pid);
+
+  AWAIT_READY(unhealthy);
+  EXPECT_EQ(taskId, unhealthy.get().task_id());
+  EXPECT_FALSE(unhealthy.get().healthy());
+  EXPECT_TRUE(unhealthy.get().kill_task());
+
+  AWAIT_FAILED(failing);
+
+  checker.stop(TaskID(healthy.get().task_id()));
+  AWAIT_DISCARDED(checking);
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that TCP health checks pass as long as a connection to the
+// port on localhost can be established.
+TEST(HealthCheckerTest, TCP)
+{
+  HealthProcess process;
+  PID<HealthProcess> pid = spawn(process);
+
+  // A bound socket that is not listening refuses the connections.
+  Try<Socket> closed = Socket::create();
+  ASSERT_SOME(closed);
+
+  Try<Node> node = Socket(closed.get()).bind(Node(0, 0));
+  ASSERT_SOME(node);
+
+  HealthChecker checker;
+
+  HealthCheck check;
+  check.mutable_tcp()->set_port(pid.node.port);
+  check.set_delay_seconds(0);
+  check.set_grace_period_seconds(0);
+  check.set_consecutive_failures(1);
+
+  TaskID taskId;
+  taskId.set_value("1");
+
+  Future<TaskHealthStatus> healthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  checker.start(taskId, check, pid);
+
+  AWAIT_READY(healthy);
+  EXPECT_TRUE(healthy.get().healthy());
+
+  checker.stop(taskId);
+
+  check.mutable_tcp()->set_port(node.get().port);
+  taskId.set_value("2");
+
+  Future<TaskHealthStatus> unhealthy =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, pid);
+
+  Future<Nothing> failing = checker.start(taskId, check, pid);
+
+  AWAIT_READY(unhealthy);
+  EXPECT_FALSE(unhealthy.get().healthy());
+  EXPECT_TRUE(unhealthy.get().kill_task());
+
+  AWAIT_FAILED(failing);
+
+  terminate(process);
+  wait(process);
+}
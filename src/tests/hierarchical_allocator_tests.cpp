@@ -743,7 +743,8 @@ TEST_F(HierarchicalAllocatorTest, UpdateAllocation)
 
 // Checks that a slave that is not whitelisted will not have its
 // resources get offered, and that if the whitelist is updated so
-// that it is whitelisted, its resources will then be offered.
+// that it is whitelisted, its resources will then be offered right
+// away.
 TEST_F(HierarchicalAllocatorTest, Whitelist)
 {
   Clock::pause();
@@ -773,15 +774,61 @@ TEST_F(HierarchicalAllocatorTest, Whitelist)
   ASSERT_TRUE(allocation.isPending());
 
   // Updating the whitelist to include the slave should
-  // trigger an allocation in the next batch.
+  // trigger an allocation without waiting for the next batch.
   whitelist.insert(slave.hostname());
   allocator->updateWhitelist(whitelist);
 
-  Clock::advance(flags.allocation_interval);
-
   AWAIT_READY(allocation);
   EXPECT_EQ(framework.id(), allocation.get().frameworkId);
   EXPECT_EQ(1u, allocation.get().resources.size());
   EXPECT_TRUE(allocation.get().resources.contains(slave.id()));
   EXPECT_EQ(slave.resources(), sum(allocation.get().resources.values()));
 }
+
+
+// Checks that removing the host of a slave from the whitelist stops
+// its resources from being offered, while the slaves on the hosts
+// that stay in the whitelist are not affected.
+TEST_F(HierarchicalAllocatorTest, WhitelistRemoval)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:2;mem:1024");
+  allocator->addSlave(slave1.id(), slave1, slave1.resources(), EMPTY);
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024");
+  allocator->addSlave(slave2.id(), slave2, slave2.resources(), EMPTY);
+
+  hashset<string> whitelist;
+  whitelist.insert(slave1.hostname());
+  whitelist.insert(slave2.hostname());
+
+  allocator->updateWhitelist(whitelist);
+
+  whitelist.erase(slave1.hostname());
+  allocator->updateWhitelist(whitelist);
+
+  FrameworkInfo framework = createFrameworkInfo("*");
+  allocator->addFramework(framework.id(), framework, Resources());
+
+  // Only the resources of the slave that is still whitelisted
+  // should be offered.
+  Future<Allocation> allocation = queue.get();
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave2.id()));
+
+  allocation = queue.get();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  // There should be no allocation for the removed slave!
+  ASSERT_TRUE(allocation.isPending());
+}
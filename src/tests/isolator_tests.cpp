@@ -191,6 +191,7 @@ TYPED_TEST(CpuIsolatorTest, UserCpuUsage)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       lambda::bind(&childSetup, pipes));
 
   ASSERT_SOME(pid);
@@ -298,6 +299,7 @@ TYPED_TEST(CpuIsolatorTest, SystemCpuUsage)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       lambda::bind(&childSetup, pipes));
 
   ASSERT_SOME(pid);
@@ -413,6 +415,7 @@ TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_Cfs)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       lambda::bind(&childSetup, pipes));
 
   ASSERT_SOME(pid);
@@ -511,6 +514,7 @@ TEST_F(LimitedCpuIsolatorTest, ROOT_CGROUPS_Cfs_Big_Quota)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       lambda::bind(&childSetup, pipes));
 
   ASSERT_SOME(pid);
@@ -641,6 +645,7 @@ TYPED_TEST(MemIsolatorTest, MemUsage)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       lambda::bind(&consumeMemory, Megabytes(256), Seconds(10), pipes));
 
   ASSERT_SOME(pid);
@@ -831,6 +836,7 @@ TEST_F(SharedFilesystemIsolatorTest, ROOT_RelativeVolume)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       None());
   ASSERT_SOME(pid);
 
@@ -924,6 +930,7 @@ TEST_F(SharedFilesystemIsolatorTest, ROOT_AbsoluteVolume)
       Subprocess::FD(STDERR_FILENO),
       None(),
       None(),
+      vector<int>(),
       None());
   ASSERT_SOME(pid);
 
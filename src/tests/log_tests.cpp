@@ -20,9 +20,12 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
@@ -34,8 +37,12 @@
 #include <process/protobuf.hpp>
 #include <process/shared.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -43,6 +50,7 @@
 #include <stout/try.hpp>
 
 #include "log/catchup.hpp"
+#include "log/consensus.hpp"
 #include "log/coordinator.hpp"
 #include "log/leveldb.hpp"
 #include "log/log.hpp"
@@ -65,13 +73,17 @@ using namespace mesos::tests;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
 using testing::Return;
+using testing::WithParamInterface;
 
 
 TEST(NetworkTest, Watch)
@@ -314,6 +326,64 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+TYPED_TEST(LogStorageTest, ReadRange)
+{
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  // Append to positions 0 to 9, leaving a hole at position 5.
+  for (uint64_t i = 0; i < 10; i++) {
+    if (i == 5) {
+      continue;
+    }
+
+    Action action;
+    action.set_position(i);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(i));
+
+    ASSERT_SOME(storage.persist(action));
+  }
+
+  Try<list<Action> > actions = storage.read(2, 7);
+  ASSERT_SOME(actions);
+
+  // Positions 2, 3, 4, 6 and 7 in order, skipping the hole.
+  ASSERT_EQ(5u, actions.get().size());
+
+  uint64_t position = 2;
+  foreach (const Action& action, actions.get()) {
+    if (position == 5) {
+      position++;
+    }
+
+    EXPECT_EQ(position, action.position());
+    EXPECT_EQ(Action::APPEND, action.type());
+    ASSERT_TRUE(action.has_append());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+
+    position++;
+  }
+
+  // Reading past the end returns only the positions that exist.
+  actions = storage.read(8, 100);
+  ASSERT_SOME(actions);
+  ASSERT_EQ(2u, actions.get().size());
+  EXPECT_EQ(8u, actions.get().front().position());
+  EXPECT_EQ(9u, actions.get().back().position());
+
+  // An empty range returns nothing.
+  actions = storage.read(7, 2);
+  ASSERT_SOME(actions);
+  EXPECT_TRUE(actions.get().empty());
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1663,6 +1733,10 @@ TEST_F(RecoverTest, CatchupRetry)
 
   Shared<Network> network2(new Network(pids));
 
+  // Drop the catch-up requests to replica1 so that the positions it
+  // has learned can not be transferred, i.e., they have to be filled.
+  DROP_MESSAGES(Eq(CatchUpRequest().GetTypeName()), _, Eq(replica1->pid()));
+
   // Drop a promise request to replica1 so that the catch-up process
   // won't be able to get a quorum of explicit promises. Also, since
   // learned messages are blocked from being sent replica2, the
@@ -1676,6 +1750,11 @@ TEST_F(RecoverTest, CatchupRetry)
 
   Clock::pause();
 
+  // Wait for the catch-up request to time out as replica1 does not
+  // respond to it.
+  Clock::settle();
+  Clock::advance(Seconds(10));
+
   // Wait for the retry timer in 'catchup' to be setup.
   Clock::settle();
 
@@ -1697,6 +1776,145 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// Verifies that positions learned by other replicas are caught-up
+// by transferring the learned actions, without running Paxos.
+TEST_F(RecoverTest, CatchupLearned)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+  EXPECT_NO_FUTURE_MESSAGES(Eq(WriteRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action> > actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+
+  AWAIT_EXPECT_EQ(IntervalSet<uint64_t>(), replica3->missing(1, 10));
+}
+
+
+// This test verifies that the learned actions are still caught-up
+// without Paxos when they do not all fit in one catch-up response.
+TEST_F(RecoverTest, CatchupLearnedLarge)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  // Each entry is larger than half of the size that a replica puts
+  // in one catch-up response.
+  for (uint64_t position = 1; position <= 5; position++) {
+    const string data(Megabytes(3).bytes(), '0' + position);
+
+    Future<Option<uint64_t> > appending = coord.append(data);
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+  EXPECT_NO_FUTURE_MESSAGES(Eq(WriteRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action> > actions = replica3->read(1, 5);
+  AWAIT_READY(actions);
+  ASSERT_EQ(5u, actions.get().size());
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(string(Megabytes(3).bytes(), '0' + action.position()),
+              action.append().bytes());
+  }
+
+  AWAIT_EXPECT_EQ(IntervalSet<uint64_t>(), replica3->missing(1, 5));
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1835,6 +2053,109 @@ TEST_F(RecoverTest, AutoInitializationRetry)
 }
 
 
+class CatchUp_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t>
+{
+protected:
+  // For initializing the log.
+  tool::Initialize initializer;
+};
+
+
+// The number of positions to catch-up.
+INSTANTIATE_TEST_CASE_P(
+    Positions,
+    CatchUp_BENCHMARK_Test,
+    ::testing::Values(1000U, 10000U, 50000U));
+
+
+// Measures how fast a replica catches up the positions that the
+// other replicas have learned. For comparison, the first (at most)
+// 1000 of these positions are also filled one at a time using Paxos,
+// which is how each of them used to be caught-up.
+TEST_P(CatchUp_BENCHMARK_Test, LearnedPositions)
+{
+  const size_t positions = GetParam();
+
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+  const string path4 = os::getcwd() + "/.log4";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Have replica1 and replica2 learn the positions directly, rather
+  // than through a coordinator, to keep the set up time down.
+  list<Action> actions;
+  for (uint64_t position = 1; position <= positions; position++) {
+    Action action;
+    action.set_position(position);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(string(1024, 'a'));
+    actions.push_back(action);
+
+    if (actions.size() == 1000 || position == positions) {
+      AWAIT_EXPECT_EQ(true, replica1->learn(actions));
+      AWAIT_EXPECT_EQ(true, replica2->learn(actions));
+      actions.clear();
+    }
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+  Shared<Replica> replica4(new Replica(path4));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+  pids.insert(replica3->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  const uint64_t filled = std::min(positions, (size_t) 1000);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (uint64_t position = 1; position <= filled; position++) {
+    AWAIT_READY(fill(2, network1, 2, position));
+  }
+
+  cout << "Filled " << filled << " positions one at a time in "
+       << watch.elapsed() << endl;
+
+  pids.erase(replica3->pid());
+  pids.insert(replica4->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  IntervalSet<uint64_t> missing;
+  missing += (Bound<uint64_t>::closed(1),
+              Bound<uint64_t>::closed(positions));
+
+  watch.start();
+
+  AWAIT_READY_FOR(
+      catchup(2, replica4, network2, None(), missing),
+      Minutes(10));
+
+  cout << "Caught-up " << positions << " learned positions in "
+       << watch.elapsed() << endl;
+
+  AWAIT_EXPECT_EQ(IntervalSet<uint64_t>(), replica4->missing(1, positions));
+}
+
+
 class LogTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1885,6 +2206,89 @@ TEST_F(LogTest, WriteRead)
 }
 
 
+// Helper for streaming the entries of the log which collects the
+// batches of entries that are read.
+static Future<Nothing> stash(
+    vector<list<Log::Entry> >* batches,
+    const list<Log::Entry>& entries)
+{
+  batches->push_back(entries);
+  return Nothing();
+}
+
+
+// This test verifies that streaming the entries of the log applies
+// all of them in order, across several batches.
+TEST_F(LogTest, StreamRead)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  // Enough entries to span more than one batch, which are learned
+  // by the local replica directly (rather than appended one at a
+  // time) to keep the test fast.
+  const uint64_t count = 2500;
+
+  list<Action> actions;
+  for (uint64_t position = 0; position < count; position++) {
+    Action action;
+    action.set_position(position);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(position));
+    actions.push_back(action);
+  }
+
+  {
+    Replica replica2(path2);
+    AWAIT_EXPECT_EQ(true, replica2.learn(actions));
+  }
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids);
+
+  Log::Reader reader(&log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  AWAIT_READY(beginning);
+
+  Future<Log::Position> ending = reader.ending();
+  AWAIT_READY(ending);
+
+  vector<list<Log::Entry> > batches;
+
+  Future<Nothing> read = reader.read(
+      beginning.get(),
+      ending.get(),
+      lambda::bind(&stash, &batches, lambda::_1));
+
+  AWAIT_READY(read);
+
+  EXPECT_LT(2u, batches.size());
+
+  // The entries are applied in order.
+  uint64_t position = 0;
+  foreach (const list<Log::Entry>& entries, batches) {
+    foreach (const Log::Entry& entry, entries) {
+      EXPECT_EQ(stringify(position++), entry.data);
+    }
+  }
+
+  EXPECT_EQ(count, position);
+}
+
+
 TEST_F(LogTest, Position)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -20,6 +20,7 @@
 
 #include <gmock/gmock.h>
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -27,11 +28,14 @@
 #include <mesos/scheduler.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/owned.hpp>
 #include <process/pid.hpp>
+#include <process/protobuf.hpp>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
@@ -40,6 +44,7 @@
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 #include "master/allocator.hpp"
@@ -75,6 +80,7 @@ using process::Owned;
 using process::PID;
 using process::UPID;
 
+using std::list;
 using std::string;
 using std::vector;
 
@@ -84,6 +90,7 @@ using testing::DoAll;
 using testing::Eq;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 // Those of the overall Mesos master/slave/scheduler/driver tests
 // that seem vaguely more master than slave-related are in this file.
@@ -632,6 +639,117 @@ TEST_F(MasterTest, StatusUpdateAck)
 }
 
 
+// This test verifies that the master holds back the status update
+// acknowledgements it forwards until it flushes them, and then sends
+// them to the slave in a single StatusUpdateAcknowledgementsMessage.
+TEST_F(MasterTest, BatchStatusUpdateAcknowledgements)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  // Launch two tasks on the same executor.
+  Resources resources = Resources::parse("cpus:1;mem:128").get();
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  // Pause the clock to prevent status update retries on the slave.
+  Clock::pause();
+
+  // Hold back the flush triggered by the first acknowledgement.
+  Future<Nothing> flushAcknowledgements =
+    DROP_DISPATCH(master.get(), &Master::flushAcknowledgements);
+
+  // The acknowledgements of the scheduler.
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement1 =
+    FUTURE_PROTOBUF(StatusUpdateAcknowledgementMessage(), _, master.get());
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement2 =
+    FUTURE_PROTOBUF(StatusUpdateAcknowledgementMessage(), _, master.get());
+
+  Future<StatusUpdateAcknowledgementsMessage> acknowledgements =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementsMessage(), master.get(), slave.get());
+
+  Future<Nothing> _statusUpdateAcknowledgement1 =
+    FUTURE_DISPATCH(slave.get(), &Slave::_statusUpdateAcknowledgement);
+  Future<Nothing> _statusUpdateAcknowledgement2 =
+    FUTURE_DISPATCH(slave.get(), &Slave::_statusUpdateAcknowledgement);
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  AWAIT_READY(acknowledgement1);
+  AWAIT_READY(acknowledgement2);
+  AWAIT_READY(flushAcknowledgements);
+
+  // Nothing is sent to the slave until the acknowledgements are
+  // flushed.
+  Clock::settle();
+  EXPECT_TRUE(acknowledgements.isPending());
+
+  process::dispatch(master.get(), &Master::flushAcknowledgements);
+
+  AWAIT_READY(acknowledgements);
+  EXPECT_EQ(2, acknowledgements.get().acknowledgements_size());
+
+  // Ensure the slave handles both acknowledgements.
+  AWAIT_READY(_statusUpdateAcknowledgement1);
+  AWAIT_READY(_statusUpdateAcknowledgement2);
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 TEST_F(MasterTest, RecoverResources)
 {
   Try<PID<Master> > master = StartMaster();
@@ -2213,6 +2331,69 @@ TEST_F(MasterTest, OfferTimeout)
 }
 
 
+// This test verifies that an offer removed before it expires does
+// not affect the expiration of the offers made after it.
+TEST_F(MasterTest, OfferTimeoutAfterDecline)
+{
+  master::Flags masterFlags = MesosTest::CreateMasterFlags();
+  masterFlags.offer_timeout = Seconds(30);
+  Try<PID<Master> > master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  // Decline the first offer without filtering the resources so that
+  // they are offered again right away.
+  Filters filters;
+  filters.set_refuse_seconds(0);
+
+  Future<vector<Offer> > offers1;
+  Future<vector<Offer> > offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(DoAll(FutureArg<1>(&offers1),
+                    DeclineOffers(filters)))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  // Expect only the second offer to be rescinded.
+  Future<OfferID> offerRescinded;
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .WillOnce(FutureArg<1>(&offerRescinded));
+
+  driver.start();
+
+  AWAIT_READY(registered);
+  AWAIT_READY(offers1);
+  ASSERT_EQ(1u, offers1.get().size());
+
+  AWAIT_READY(offers2);
+  ASSERT_EQ(1u, offers2.get().size());
+
+  // Now advance the clock past the expiration of both offers.
+  Clock::pause();
+  Clock::advance(masterFlags.offer_timeout.get());
+  Clock::settle();
+  Clock::resume();
+
+  AWAIT_READY(offerRescinded);
+  EXPECT_EQ(offers2.get()[0].id(), offerRescinded.get());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // Offer should not be rescinded if it's accepted.
 TEST_F(MasterTest, OfferNotRescindedOnceUsed)
 {
@@ -2936,3 +3117,174 @@ TEST_F(MasterTest, TaskDiscoveryInfo)
 
   Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
 }
+
+
+// A fake slave that only (re-)registers with the master and answers
+// its pings, used to simulate a large number of slaves.
+class TestSlaveProcess : public ProtobufProcess<TestSlaveProcess>
+{
+public:
+  TestSlaveProcess(const UPID& _master, const SlaveInfo& _info)
+    : ProcessBase(process::ID::generate("test-slave")),
+      master(_master),
+      info(_info) {}
+
+  Future<Nothing> register_()
+  {
+    RegisterSlaveMessage message;
+    message.mutable_slave()->CopyFrom(info);
+    message.set_version(MESOS_VERSION);
+    send(master, message);
+
+    return registered.future();
+  }
+
+  // Re-registers with the (failed over) master, reporting
+  // 'taskCount' running tasks.
+  Future<Nothing> reregister(const UPID& _master, size_t taskCount)
+  {
+    master = _master;
+
+    ReregisterSlaveMessage message;
+    message.mutable_slave()->CopyFrom(info);
+    message.set_version(MESOS_VERSION);
+
+    FrameworkID frameworkId;
+    frameworkId.set_value("test-framework");
+
+    for (size_t i = 0; i < taskCount; i++) {
+      Task* task = message.add_tasks();
+      task->set_name("test-task");
+      task->mutable_task_id()->set_value(
+          info.id().value() + "-" + stringify(i));
+      task->mutable_framework_id()->CopyFrom(frameworkId);
+      task->mutable_slave_id()->CopyFrom(info.id());
+      task->set_state(TASK_RUNNING);
+      task->mutable_resources()->MergeFrom(
+          Resources::parse("cpus:0.1;mem:32").get());
+    }
+
+    send(master, message);
+
+    return reregistered.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<SlaveRegisteredMessage>(
+        &TestSlaveProcess::_registered,
+        &SlaveRegisteredMessage::slave_id);
+
+    install<SlaveReregisteredMessage>(
+        &TestSlaveProcess::_reregistered,
+        &SlaveReregisteredMessage::slave_id);
+
+    install("PING", &TestSlaveProcess::ping);
+  }
+
+private:
+  void _registered(const SlaveID& slaveId)
+  {
+    info.mutable_id()->CopyFrom(slaveId);
+    registered.set(Nothing());
+  }
+
+  void _reregistered(const SlaveID& slaveId)
+  {
+    reregistered.set(Nothing());
+  }
+
+  void ping(const UPID& from, const string& body)
+  {
+    send(from, "PONG");
+  }
+
+  UPID master;
+  SlaveInfo info;
+
+  process::Promise<Nothing> registered;
+  process::Promise<Nothing> reregistered;
+};
+
+
+class MasterFailover_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t>
+{};
+
+
+// The master failover benchmark is parameterized by the number of
+// slaves that re-register with the failed over master.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCount,
+    MasterFailover_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U, 20000U));
+
+
+// Measures the time it takes a failed over master to readmit all the
+// slaves (and their tasks) that were registered with the previous
+// master, i.e., until all of them are told they are re-registered.
+TEST_P(MasterFailover_BENCHMARK_Test, SlaveReregistration)
+{
+  const size_t slaveCount = GetParam();
+  const size_t tasksPerSlave = 10;
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master> > master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  SlaveInfo info;
+  info.set_hostname("localhost");
+  info.mutable_resources()->MergeFrom(
+      Resources::parse("cpus:16;mem:32768;disk:1048576").get());
+
+  vector<Owned<TestSlaveProcess> > slaves;
+  list<Future<Nothing> > registered;
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    Owned<TestSlaveProcess> slave(new TestSlaveProcess(master.get(), info));
+    process::spawn(slave.get());
+
+    registered.push_back(
+        process::dispatch(slave.get(), &TestSlaveProcess::register_));
+
+    slaves.push_back(slave);
+  }
+
+  AWAIT_READY_FOR(process::collect(registered), Minutes(10));
+
+  // Fail over the master; the registry persists in the replicated
+  // log in 'masterFlags.work_dir'.
+  Stop(master.get());
+
+  master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Stopwatch watch;
+  watch.start();
+
+  list<Future<Nothing> > reregistered;
+  foreach (const Owned<TestSlaveProcess>& slave, slaves) {
+    reregistered.push_back(process::dispatch(
+        slave.get(),
+        &TestSlaveProcess::reregister,
+        master.get(),
+        tasksPerSlave));
+  }
+
+  AWAIT_READY_FOR(process::collect(reregistered), Minutes(10));
+
+  LOG(INFO) << "Re-registered " << slaveCount << " slaves with "
+            << tasksPerSlave << " tasks each with the failed over master in "
+            << watch.elapsed();
+
+  foreach (const Owned<TestSlaveProcess>& slave, slaves) {
+    process::terminate(slave.get());
+    process::wait(slave.get());
+  }
+
+  Shutdown();
+}
@@ -103,6 +103,7 @@ TEST_F(MetricsTest, Master)
   EXPECT_EQ(1u, stats.values.count("master/messages_reregister_slave"));
   EXPECT_EQ(1u, stats.values.count("master/messages_unregister_slave"));
   EXPECT_EQ(1u, stats.values.count("master/messages_status_update"));
+  EXPECT_EQ(1u, stats.values.count("master/messages_status_updates"));
   EXPECT_EQ(1u, stats.values.count("master/messages_exited_executor"));
 
   // Messages from both schedulers and slaves.
@@ -196,6 +197,10 @@ TEST_F(MetricsTest, Slave)
   EXPECT_EQ(1u, stats.values.count("slave/valid_status_updates"));
   EXPECT_EQ(1u, stats.values.count("slave/invalid_status_updates"));
 
+  EXPECT_EQ(1u, stats.values.count("slave/status_updates_forwarded"));
+  EXPECT_EQ(1u, stats.values.count(
+      "slave/status_update_messages_forwarded"));
+
   EXPECT_EQ(1u, stats.values.count("slave/valid_framework_messages"));
   EXPECT_EQ(1u, stats.values.count("slave/invalid_framework_messages"));
 
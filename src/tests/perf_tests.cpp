@@ -16,6 +16,11 @@
  * limitations under the License.
  */
 
+#include <signal.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+
 #include <set>
 
 #include <gmock/gmock.h>
@@ -24,8 +29,10 @@
 #include <process/gtest.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
 #include <stout/stringify.hpp>
 
+#include "linux/cgroups.hpp"
 #include "linux/perf.hpp"
 
 using std::set;
@@ -145,3 +152,123 @@ TEST_F(PerfTest, ROOT_SampleInit)
   ASSERT_TRUE(statistics.get().has_task_clock());
   EXPECT_LT(0.0, statistics.get().task_clock());
 }
+
+
+TEST_F(PerfTest, Native)
+{
+  set<string> events;
+  events.insert("cycles");
+  events.insert("task-clock");
+  events.insert("page-faults");
+  EXPECT_TRUE(perf::native(events));
+
+  // Hardware cache events are not counted natively.
+  events.insert("L1-dcache-loads");
+  EXPECT_FALSE(perf::native(events));
+}
+
+
+TEST_F(PerfTest, ROOT_Counters)
+{
+  // Software events are available on any host, including virtual
+  // machines without access to the hardware counters.
+  set<string> events;
+  events.insert("task-clock");
+  events.insert("page-faults");
+  events.insert("context-switches");
+
+  Try<perf::Counters*> counters = perf::Counters::create(events, getpid());
+  ASSERT_SOME(counters);
+
+  // Fault in some fresh pages and spin for a bit.
+  const size_t size = 16 * 1024 * 1024;
+  char* data = new char[size];
+  for (size_t i = 0; i < size; i += 4096) {
+    data[i] = 1;
+  }
+  delete[] data;
+
+  Time start = Clock::now();
+  while (Clock::now() - start < Milliseconds(100));
+
+  Try<mesos::PerfStatistics> statistics = counters.get()->sample();
+  ASSERT_SOME(statistics);
+
+  // The sample starts when the counters were opened.
+  EXPECT_GE(start.secs(), statistics.get().timestamp());
+  EXPECT_LE(Milliseconds(100).secs(), statistics.get().duration());
+
+  // The task clock counts CPU time rather than wall-clock time, so on
+  // a loaded host it can lag behind the time spent spinning.
+  ASSERT_TRUE(statistics.get().has_task_clock());
+  EXPECT_LT(0.0, statistics.get().task_clock()); // In milliseconds.
+
+  ASSERT_TRUE(statistics.get().has_page_faults());
+  EXPECT_LT(0u, statistics.get().page_faults());
+
+  ASSERT_TRUE(statistics.get().has_context_switches());
+
+  // The next sample only includes what happened since.
+  statistics = counters.get()->sample();
+  ASSERT_SOME(statistics);
+
+  ASSERT_TRUE(statistics.get().has_task_clock());
+  EXPECT_GT(100.0, statistics.get().task_clock());
+
+  delete counters.get();
+
+  // Unsupported events are rejected.
+  events.insert("this-is-an-invalid-event");
+  EXPECT_ERROR(perf::Counters::create(events, getpid()));
+}
+
+
+TEST_F(PerfTest, ROOT_CGROUPS_Counters)
+{
+  Result<string> hierarchy = cgroups::hierarchy("perf_event");
+  ASSERT_SOME(hierarchy);
+
+  const string cgroup = "mesos_test_perf_counters";
+  ASSERT_SOME(cgroups::create(hierarchy.get(), cgroup));
+
+  // The software events on each cpu are counted as a group.
+  set<string> events;
+  events.insert("task-clock");
+  events.insert("page-faults");
+  events.insert("context-switches");
+
+  EXPECT_SOME_NE(0u, perf::descriptors(events));
+
+  Try<perf::Counters*> counters =
+    perf::Counters::create(events, hierarchy.get(), cgroup);
+  ASSERT_SOME(counters);
+
+  // Spin in the cgroup for a bit.
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    while (true);
+  }
+
+  ASSERT_SOME(cgroups::assign(hierarchy.get(), cgroup, pid));
+
+  os::sleep(Milliseconds(100));
+
+  Try<mesos::PerfStatistics> statistics = counters.get()->sample();
+
+  ::kill(pid, SIGKILL);
+  ::waitpid(pid, NULL, 0);
+
+  ASSERT_SOME(statistics);
+
+  ASSERT_TRUE(statistics.get().has_task_clock());
+  EXPECT_LT(0.0, statistics.get().task_clock()); // In milliseconds.
+
+  ASSERT_TRUE(statistics.get().has_page_faults());
+  ASSERT_TRUE(statistics.get().has_context_switches());
+
+  delete counters.get();
+
+  AWAIT_READY(cgroups::destroy(hierarchy.get(), cgroup));
+}
@@ -293,6 +293,10 @@ protected:
     argv[0] = "mesos-containerizer";
     argv[1] = MesosContainerizerLaunch::NAME;
 
+    vector<int> inherit;
+    inherit.push_back(pipes[0]);
+    inherit.push_back(pipes[1]);
+
     Try<pid_t> pid = launcher->fork(
         containerId,
         path::join(flags.launcher_dir, "mesos-containerizer"),
@@ -302,6 +306,7 @@ protected:
         Subprocess::FD(STDERR_FILENO),
         launchFlags,
         None(),
+        inherit,
         None());
 
     return pid;
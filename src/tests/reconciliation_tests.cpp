@@ -28,9 +28,11 @@
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/json.hpp>
 #include <stout/uuid.hpp>
 
 #include "common/protobuf_utils.hpp"
@@ -533,6 +535,112 @@ TEST_F(ReconciliationTest, ImplicitNonTerminalTask)
 }
 
 
+// This test ensures that the master packs the states of the tasks
+// sent back for an implicit reconciliation request into a single
+// StatusUpdatesMessage for the scheduler driver and records the
+// duration of the reconciliation.
+TEST_F(ReconciliationTest, ImplicitBatched)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave> > slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  // Launch a framework and get two tasks running.
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 2, 1, 64, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> update1;
+  Future<TaskStatus> update2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update1))
+    .WillOnce(FutureArg<1>(&update2));
+
+  driver.start();
+
+  // Wait until the framework is registered.
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(update1);
+  EXPECT_EQ(TASK_RUNNING, update1.get().state());
+
+  AWAIT_READY(update2);
+  EXPECT_EQ(TASK_RUNNING, update2.get().state());
+
+  // Both tasks should be sent back in a single message.
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), master.get(), _);
+
+  Future<TaskStatus> update3;
+  Future<TaskStatus> update4;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update3))
+    .WillOnce(FutureArg<1>(&update4));
+
+  vector<TaskStatus> statuses;
+  driver.reconcileTasks(statuses);
+
+  AWAIT_READY(statusUpdatesMessage);
+  EXPECT_EQ(2, statusUpdatesMessage.get().updates_size());
+
+  AWAIT_READY(update3);
+  EXPECT_EQ(TASK_RUNNING, update3.get().state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, update3.get().reason());
+
+  AWAIT_READY(update4);
+  EXPECT_EQ(TASK_RUNNING, update4.get().state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, update4.get().reason());
+
+  EXPECT_FALSE(update3.get().task_id() == update4.get().task_id());
+
+  // The duration of the reconciliation is recorded for the master
+  // and the principal of the framework.
+  process::UPID upid("metrics", process::node());
+
+  Future<process::http::Response> response =
+    process::http::get(upid, "snapshot");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  JSON::Object metrics = parse.get();
+
+  EXPECT_EQ(1u, metrics.values.count("master/implicit_reconciliation_ms"));
+  EXPECT_EQ(
+      1u,
+      metrics.values.count("frameworks/" + DEFAULT_CREDENTIAL.principal() +
+                           "/implicit_reconciliation_ms"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This test ensures that the master does not send updates for
 // terminal tasks during an implicit reconciliation request.
 // TODO(bmahler): Soon the master will keep non-acknowledged
@@ -441,6 +441,32 @@ TEST_P(RegistrarTest, abort)
 }
 
 
+// This test ensures that the registrar does not store the registry
+// for a batch of operations that leaves it unchanged, e.g., when
+// readmitting a slave that is already in the registry.
+TEST_P(RegistrarTest, readmitWithoutStore)
+{
+  MockStorage storage;
+  State state(&storage);
+
+  Registrar registrar(flags, &state);
+
+  EXPECT_CALL(storage, get(_))
+    .WillOnce(Return(None()));
+
+  // Only the recovery and the admission store the registry.
+  EXPECT_CALL(storage, set(_, _))
+    .Times(2)
+    .WillRepeatedly(Return(Future<bool>(true)));
+
+  AWAIT_READY(registrar.recover(master));
+
+  AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+
+  AWAIT_EQ(true, registrar.apply(Owned<Operation>(new ReadmitSlave(slave))));
+}
+
+
 class Registrar_BENCHMARK_Test : public RegistrarTestBase,
                                  public WithParamInterface<size_t>
 {};
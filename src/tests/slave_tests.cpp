@@ -807,6 +807,124 @@ TEST_F(SlaveTest, IgnoreNonLeaderStatusUpdateAcknowledgement)
 }
 
 
+// This test verifies that the slave holds back the status updates
+// it forwards until it flushes them, and then sends them to the
+// master in a single StatusUpdatesMessage.
+TEST_F(SlaveTest, BatchStatusUpdates)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  // Launch two tasks on the same executor.
+  Resources resources = Resources::parse("cpus:1;mem:128").get();
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // Pause the clock to prevent status update retries on the slave.
+  Clock::pause();
+
+  // Hold back the flush triggered by the first update.
+  Future<Nothing> flushStatusUpdates =
+    DROP_DISPATCH(slave.get(), &Slave::flushStatusUpdates);
+
+  Future<Nothing> forward1 = FUTURE_DISPATCH(slave.get(), &Slave::forward);
+  Future<Nothing> forward2 = FUTURE_DISPATCH(slave.get(), &Slave::forward);
+
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), slave.get(), master.get());
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(forward1);
+  AWAIT_READY(forward2);
+  AWAIT_READY(flushStatusUpdates);
+
+  // Nothing is sent to the master until the updates are flushed.
+  Clock::settle();
+  EXPECT_TRUE(statusUpdatesMessage.isPending());
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  dispatch(slave.get(), &Slave::flushStatusUpdates);
+
+  AWAIT_READY(statusUpdatesMessage);
+  ASSERT_EQ(2, statusUpdatesMessage.get().updates_size());
+
+  foreach (const StatusUpdate& update, statusUpdatesMessage.get().updates()) {
+    EXPECT_EQ(TASK_RUNNING, update.status().state());
+  }
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  Clock::resume();
+
+  // Both updates were sent in a single message.
+  Future<http::Response> response =
+    http::get(UPID("metrics", process::node()), "snapshot");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::Number(2),
+      parse.get().find<JSON::Number>("slave/status_updates_forwarded"));
+  EXPECT_SOME_EQ(
+      JSON::Number(1),
+      parse.get().find<JSON::Number>(
+          "slave/status_update_messages_forwarded"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 TEST_F(SlaveTest, MetricsInStatsEndpoint)
 {
   Try<PID<Master> > master = StartMaster();
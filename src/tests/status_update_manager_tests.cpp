@@ -30,11 +30,15 @@
 #include <process/gmock.hpp>
 #include <process/pid.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
+#include <stout/uuid.hpp>
 
 #include "master/master.hpp"
 
@@ -42,6 +46,7 @@
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_journal.hpp"
 
 #include "messages/messages.hpp"
 
@@ -856,3 +861,192 @@ TEST_F(StatusUpdateManagerTest, LatestTaskState)
 
   Shutdown();
 }
+
+
+class StatusUpdateJournalTest : public TemporaryDirectoryTest {};
+
+
+// Returns a journal record of an update (or of its acknowledgement)
+// of the given task.
+static StatusUpdateJournalRecord createRecord(
+    const string& taskId,
+    const UUID& uuid,
+    StatusUpdateRecord::Type type = StatusUpdateRecord::UPDATE)
+{
+  StatusUpdateJournalRecord record;
+  record.mutable_framework_id()->set_value("framework");
+  record.mutable_executor_id()->set_value("executor");
+  record.mutable_container_id()->set_value("container");
+  record.mutable_task_id()->set_value(taskId);
+  record.mutable_record()->set_type(type);
+
+  if (type == StatusUpdateRecord::UPDATE) {
+    StatusUpdate* update = record.mutable_record()->mutable_update();
+    update->mutable_framework_id()->CopyFrom(record.framework_id());
+    update->mutable_status()->mutable_task_id()->CopyFrom(record.task_id());
+    update->mutable_status()->set_state(TASK_RUNNING);
+    update->set_timestamp(0);
+    update->set_uuid(uuid.toBytes());
+  } else {
+    record.mutable_record()->set_uuid(uuid.toBytes());
+  }
+
+  return record;
+}
+
+
+static bool isTask(
+    const string& taskId,
+    const StatusUpdateJournalRecord& record)
+{
+  return record.task_id().value() == taskId;
+}
+
+
+// This test verifies that records are only written out when the
+// journal is committed and that they are read back in order.
+TEST_F(StatusUpdateJournalTest, Commit)
+{
+  const string directory = path::join(os::getcwd(), "journal");
+
+  Try<slave::StatusUpdateJournal*> journal =
+    slave::StatusUpdateJournal::create(directory, Megabytes(1));
+
+  ASSERT_SOME(journal);
+
+  const UUID uuid1 = UUID::random();
+  const UUID uuid2 = UUID::random();
+
+  ASSERT_SOME(journal.get()->append(createRecord("1", uuid1)));
+  ASSERT_SOME(journal.get()->append(createRecord("2", uuid2)));
+
+  EXPECT_TRUE(journal.get()->dirty());
+
+  Try<vector<StatusUpdateJournalRecord> > records =
+    slave::StatusUpdateJournal::read(directory);
+
+  ASSERT_SOME(records);
+  EXPECT_TRUE(records.get().empty());
+
+  ASSERT_SOME(journal.get()->commit());
+  ASSERT_SOME(journal.get()->append(
+      createRecord("1", uuid1, StatusUpdateRecord::ACK)));
+  ASSERT_SOME(journal.get()->commit());
+
+  EXPECT_FALSE(journal.get()->dirty());
+
+  delete journal.get();
+
+  records = slave::StatusUpdateJournal::read(directory);
+
+  ASSERT_SOME(records);
+  ASSERT_EQ(3u, records.get().size());
+
+  EXPECT_EQ("1", records.get()[0].task_id().value());
+  EXPECT_EQ("2", records.get()[1].task_id().value());
+  EXPECT_EQ("1", records.get()[2].task_id().value());
+
+  EXPECT_EQ(uuid1,
+            UUID::fromBytes(records.get()[0].record().update().uuid()));
+  EXPECT_EQ(uuid2,
+            UUID::fromBytes(records.get()[1].record().update().uuid()));
+  EXPECT_EQ(StatusUpdateRecord::ACK, records.get()[2].record().type());
+  EXPECT_EQ(uuid1, UUID::fromBytes(records.get()[2].record().uuid()));
+}
+
+
+// This test verifies that a partially written record at the end of a
+// segment (e.g., the slave died while committing) is truncated.
+TEST_F(StatusUpdateJournalTest, TruncatePartialRecord)
+{
+  const string directory = path::join(os::getcwd(), "journal");
+
+  Try<slave::StatusUpdateJournal*> journal =
+    slave::StatusUpdateJournal::create(directory, Megabytes(1));
+
+  ASSERT_SOME(journal);
+
+  ASSERT_SOME(journal.get()->append(createRecord("1", UUID::random())));
+  ASSERT_SOME(journal.get()->commit());
+
+  delete journal.get();
+
+  Try<list<string> > segments = os::ls(directory);
+  ASSERT_SOME(segments);
+  ASSERT_EQ(1u, segments.get().size());
+
+  const string segment = path::join(directory, segments.get().front());
+
+  Try<string> contents = os::read(segment);
+  ASSERT_SOME(contents);
+
+  // Append the length of a record followed by only part of it.
+  ASSERT_SOME(os::write(
+      segment, contents.get() + string("\x10\0\0\0\x08", 5)));
+
+  Try<vector<StatusUpdateJournalRecord> > records =
+    slave::StatusUpdateJournal::read(directory);
+
+  ASSERT_SOME(records);
+  EXPECT_EQ(1u, records.get().size());
+
+  EXPECT_SOME_EQ(contents.get(), os::read(segment));
+}
+
+
+// This test verifies that compaction drops the records that are no
+// longer live from the sealed segments, keeping the order of the
+// remaining records with respect to the active segment.
+TEST_F(StatusUpdateJournalTest, Compact)
+{
+  const string directory = path::join(os::getcwd(), "journal");
+
+  // Every commit starts a new segment.
+  Try<slave::StatusUpdateJournal*> journal =
+    slave::StatusUpdateJournal::create(directory, Bytes(1));
+
+  ASSERT_SOME(journal);
+
+  const UUID uuid1 = UUID::random();
+  const UUID uuid2 = UUID::random();
+  const UUID uuid3 = UUID::random();
+
+  ASSERT_SOME(journal.get()->append(createRecord("1", uuid1)));
+  ASSERT_SOME(journal.get()->commit());
+  ASSERT_SOME(journal.get()->append(createRecord("2", UUID::random())));
+  ASSERT_SOME(journal.get()->append(createRecord("2", UUID::random())));
+  ASSERT_SOME(journal.get()->commit());
+  ASSERT_SOME(journal.get()->append(createRecord("1", uuid2)));
+  ASSERT_SOME(journal.get()->commit());
+
+  // Four segments, the last one is active (and empty).
+  Try<list<string> > segments = os::ls(directory);
+  ASSERT_SOME(segments);
+  EXPECT_EQ(4u, segments.get().size());
+
+  // Half of the records belong to task 2, hence compaction rewrites
+  // the three sealed segments into one.
+  ASSERT_SOME(journal.get()->compact(lambda::bind(&isTask, "1", lambda::_1)));
+
+  segments = os::ls(directory);
+  ASSERT_SOME(segments);
+  EXPECT_EQ(2u, segments.get().size());
+
+  ASSERT_SOME(journal.get()->append(createRecord("1", uuid3)));
+  ASSERT_SOME(journal.get()->commit());
+
+  delete journal.get();
+
+  Try<vector<StatusUpdateJournalRecord> > records =
+    slave::StatusUpdateJournal::read(directory);
+
+  ASSERT_SOME(records);
+  ASSERT_EQ(3u, records.get().size());
+
+  EXPECT_EQ(uuid1,
+            UUID::fromBytes(records.get()[0].record().update().uuid()));
+  EXPECT_EQ(uuid2,
+            UUID::fromBytes(records.get()[1].record().update().uuid()));
+  EXPECT_EQ(uuid3,
+            UUID::fromBytes(records.get()[2].record().update().uuid()));
+}
@@ -16,13 +16,23 @@
  * limitations under the License.
  */
 
+#ifdef __linux__
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <string>
 #include <vector>
 
 #include <glog/logging.h>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
@@ -41,6 +51,15 @@ using process::Process;
 using lambda::function;
 
 
+#ifdef __linux__
+// The number of watch intervals after which the whitelist file is
+// read again even if inotify reported no change. Inotify does not
+// report every change, e.g., one made on another host to a file on
+// NFS, or swapping a symbolic link in a parent directory of the file.
+static const int RELOAD_INTERVALS = 12;
+#endif // __linux__
+
+
 WhitelistWatcher::WhitelistWatcher(
     const string& path,
     const Duration& watchInterval,
@@ -66,12 +85,66 @@ void WhitelistWatcher::initialize()
       subscriber(None());
     }
   } else {
+#ifdef __linux__
+    // Watch the directory rather than the file, so that we also
+    // notice the file being created or replaced (e.g., by renaming a
+    // new file over it, as many editors and tools do).
+    const string file = strings::remove(path, "file://", strings::PREFIX);
+
+    Try<string> directory = os::dirname(file);
+    if (directory.isError()) {
+      LOG(WARNING) << "Failed to determine the directory of whitelist "
+                   << path << ": " << directory.error();
+    } else {
+      int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (fd == -1) {
+        PLOG(WARNING) << "Failed to initialize inotify, whitelist " << path
+                      << " will be read every " << watchInterval;
+      } else if (::inotify_add_watch(
+                     fd,
+                     directory.get().c_str(),
+                     IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        PLOG(WARNING) << "Failed to watch '" << directory.get()
+                      << "', whitelist " << path << " will be read every "
+                      << watchInterval;
+        os::close(fd);
+      } else {
+        inotify = fd;
+        load();
+        notify();
+
+        delay(watchInterval * RELOAD_INTERVALS,
+              self(),
+              &WhitelistWatcher::reload);
+        return;
+      }
+    }
+#endif // __linux__
+
     watch();
   }
 }
 
 
+void WhitelistWatcher::finalize()
+{
+  if (inotify.isSome()) {
+    notifying.discard();
+    os::close(inotify.get());
+  }
+}
+
+
 void WhitelistWatcher::watch()
+{
+  load();
+
+  // Schedule the next check.
+  delay(watchInterval, self(), &WhitelistWatcher::watch);
+}
+
+
+void WhitelistWatcher::load()
 {
   // Read the list of white listed nodes from local file.
   // TODO(vinod): Add support for reading from ZooKeeper.
@@ -101,9 +174,98 @@ void WhitelistWatcher::watch()
     subscriber(whitelist);
   }
 
-  // Schedule the next check.
   lastWhitelist = whitelist;
-  delay(watchInterval, self(), &WhitelistWatcher::watch);
 }
 
+
+#ifdef __linux__
+void WhitelistWatcher::notify()
+{
+  CHECK_SOME(inotify);
+
+  notifying = process::io::poll(inotify.get(), process::io::READ);
+  notifying.onAny(process::defer(self(), &WhitelistWatcher::_notify));
+}
+
+
+void WhitelistWatcher::_notify()
+{
+  CHECK_SOME(inotify);
+
+  Try<string> name = os::basename(
+      strings::remove(path, "file://", strings::PREFIX));
+  CHECK_SOME(name);
+
+  // Large enough for at least one event with the longest name.
+  char buffer[64 * 1024] __attribute__((aligned(8)));
+
+  bool changed = false;
+  bool ignored = false;
+
+  while (true) {
+    ssize_t length = ::read(inotify.get(), buffer, sizeof(buffer));
+
+    if (length == -1 && errno == EINTR) {
+      continue;
+    } else if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else if (length <= 0) {
+      LOG(ERROR) << "Failed to read inotify events: "
+                 << (length == 0 ? "EOF" : strerror(errno));
+      ignored = true;
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < length;) {
+      const struct inotify_event* event =
+        (const struct inotify_event*) (buffer + offset);
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        changed = true;
+      } else if (event->mask & IN_IGNORED) {
+        // The directory got removed (or unmounted).
+        ignored = true;
+      } else if (event->len > 0 && name.get() == event->name) {
+        changed = true;
+      }
+
+      offset += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  if (ignored) {
+    LOG(WARNING) << "Can no longer watch whitelist " << path
+                 << ", reading it every " << watchInterval;
+
+    os::close(inotify.get());
+    inotify = None();
+
+    watch();
+    return;
+  }
+
+  if (changed) {
+    load();
+  }
+
+  notify();
+}
+
+
+void WhitelistWatcher::reload()
+{
+  // The file is read every 'watchInterval' instead once it can no
+  // longer be watched (see 'watch').
+  if (inotify.isNone()) {
+    return;
+  }
+
+  load();
+
+  delay(watchInterval * RELOAD_INTERVALS,
+        self(),
+        &WhitelistWatcher::reload);
+}
+#endif // __linux__
+
 } // namespace mesos {
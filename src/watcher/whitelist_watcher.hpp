@@ -21,6 +21,7 @@
 
 #include <string>
 
+#include <process/future.hpp>
 #include <process/process.hpp>
 
 #include <stout/duration.hpp>
@@ -34,6 +35,11 @@ namespace mesos {
 // watcher notifies the subscriber if the state of the whitelist
 // changes or if the contents changes in case the whitelist is in
 // state (3) non-empty.
+// On Linux the whitelist file is read again once inotify reports
+// that it was written or replaced, and otherwise only every few
+// 'watchInterval's in case a change goes unreported. If inotify is
+// not available (or the file can not be watched) the file is read
+// again every 'watchInterval'.
 class WhitelistWatcher : public process::Process<WhitelistWatcher>
 {
 public:
@@ -59,14 +65,35 @@ public:
 
 protected:
   virtual void initialize();
+  virtual void finalize();
   void watch();
 
 private:
+  // Reads the whitelist file and notifies the subscriber if the
+  // whitelist changed.
+  void load();
+
+#ifdef __linux__
+  // Waits for and handles the inotify events for the directory of
+  // the whitelist file.
+  void notify();
+  void _notify();
+
+  // Reads the whitelist file periodically while it is watched using
+  // inotify, see 'RELOAD_INTERVALS'.
+  void reload();
+#endif // __linux__
+
   const std::string path;
   const Duration watchInterval;
   lambda::function<void(const Option<hashset<std::string>>& whitelist)>
     subscriber;
   Option<hashset<std::string>> lastWhitelist;
+
+  // The inotify instance watching the directory of the whitelist
+  // file, if the file is not polled for changes.
+  Option<int> inotify;
+  process::Future<short> notifying;
 };
 
 } // namespace mesos {